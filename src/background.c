@@ -25,8 +25,9 @@
 
 #include <pthread.h> /* PTHREAD_* pthread_*() */
 
-#include <fcntl.h> /* open() */
-#include <unistd.h> /* select() */
+#include <fcntl.h> /* F_GETFL F_SETFD F_SETFL FD_CLOEXEC O_NONBLOCK fcntl()
+                       open() */
+#include <unistd.h> /* close() pipe() read() write() */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
@@ -36,18 +37,20 @@
 #include <sys/stat.h> /* O_RDONLY */
 #include <sys/types.h> /* pid_t ssize_t */
 #ifndef _WIN32
-#include <sys/select.h> /* FD_* select */
-#include <sys/time.h> /* timeval */
-#include <sys/wait.h> /* WEXITSTATUS() waitpid() */
+#include <poll.h> /* POLLIN poll() pollfd */
+#include <sys/wait.h> /* WEXITSTATUS() WIFEXITED() waitpid() */
 #endif
 
 #include "cfg/config.h"
+#include "compat/os.h"
+#include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "ui/cancellation.h"
 #include "ui/statusline.h"
 #include "utils/env.h"
 #include "utils/fs.h"
 #include "utils/log.h"
+#include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/utils.h"
@@ -88,17 +91,32 @@
 #define NO_JOB_ID INVALID_HANDLE_VALUE
 #endif
 
-/* Structure with passed to background_task_bootstrap() so it can perform
- * correct initialization/cleanup. */
-typedef struct
+/* Maximum number of threads that execute background tasks. */
+#define MAX_WORKERS 8
+
+/* Task that waits in the queue or is being run by one of workers. */
+typedef struct background_task_args
 {
 	bg_task_func func; /* Function to execute in a background thread. */
 	void *args;        /* Argument to pass. */
 	job_t *job;        /* Job identifier that corresponds to the task. */
+	dev_t src_dev;     /* Device that is read by the task. */
+	dev_t dst_dev;     /* Device that is written to by the task. */
+	int suspended;     /* Whether task is paused and doesn't occupy a slot. */
+	struct background_task_args *next; /* Next task in the queue or list. */
 }
 background_task_args;
 
+#ifndef _WIN32
+static void reap_if_requested(void);
+static void reap_children(void);
+static void read_job_errors(job_t *head);
+static int read_job_error(job_t *job);
+static void drain_job_errors(job_t *job);
+#else
 static void job_check(job_t *const job);
+#endif
+static void show_job_errors(job_t *head);
 static void job_free(job_t *const job);
 #ifndef _WIN32
 static job_t * add_background_job(pid_t pid, const char cmd[], int fd,
@@ -107,7 +125,15 @@ static job_t * add_background_job(pid_t pid, const char cmd[], int fd,
 static job_t * add_background_job(pid_t pid, const char cmd[], HANDLE hprocess,
 		BgJobType type);
 #endif
-static void * background_task_bootstrap(void *arg);
+static dev_t get_dev(const char path[]);
+static int enqueue_task(background_task_args *task);
+static void schedule_tasks(void);
+static int start_worker(void);
+static void * worker_main(void *arg);
+static background_task_args * take_task(void);
+static int count_active(dev_t src_dev, dev_t dst_dev);
+static void run_task(background_task_args *task);
+static void wait_while_paused(job_t *job);
 static void set_current_job(job_t *job);
 static void make_current_job_key(void);
 
@@ -116,11 +142,70 @@ job_t *jobs;
 static pthread_key_t current_job;
 static pthread_once_t current_job_once = PTHREAD_ONCE_INIT;
 
+/* Guards state of the pool of workers and pause flags of jobs. */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signaled when some of the tasks might have become allowed to run. */
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+/* Tasks that weren't started yet in order of their priority. */
+static background_task_args *queue;
+/* Tasks that are being run by workers. */
+static background_task_args *active;
+/* Number of worker threads. */
+static int nworkers;
+/* Number of worker threads that wait for tasks. */
+static int idle_workers;
+/* Number of worker threads whose tasks are paused. */
+static int suspended_workers;
+
+/* Whether check_background_jobs() is running, which means that the list of jobs
+ * isn't available. */
+static int checking_jobs;
+
+#ifndef _WIN32
+/* Self-pipe, which is written to on SIGCHLD.  Wakes up the event loop and
+ * requests reaping of finished processes outside of signal handler. */
+static int sigchld_pipe[2] = { -1, -1 };
+#endif
+
 void
 init_background(void)
 {
 	/* Initialize state for the main thread. */
 	set_current_job(NULL);
+
+#ifndef _WIN32
+	if(pipe(sigchld_pipe) == 0)
+	{
+		int i;
+		for(i = 0; i < 2; ++i)
+		{
+			(void)fcntl(sigchld_pipe[i], F_SETFL,
+					fcntl(sigchld_pipe[i], F_GETFL) | O_NONBLOCK);
+			(void)fcntl(sigchld_pipe[i], F_SETFD, FD_CLOEXEC);
+		}
+	}
+	else
+	{
+		sigchld_pipe[0] = -1;
+		sigchld_pipe[1] = -1;
+	}
+#endif
+}
+
+void
+bg_sigchld_received(void)
+{
+#ifndef _WIN32
+	if(sigchld_pipe[1] >= 0)
+	{
+		const char c = '\0';
+		/* Failure means that pipe is full, so reaping was already requested. */
+		(void)write(sigchld_pipe[1], &c, 1);
+		return;
+	}
+
+	reap_children();
+#endif
 }
 
 void
@@ -145,13 +230,13 @@ add_finished_job(pid_t pid, int exit_code)
 void
 check_background_jobs(void)
 {
-	job_t *head = jobs;
+	job_t *head;
 	job_t *prev;
 	job_t *p;
 
-	/* Quit if there is no jobs or list is unavailable (e.g. used by another
-	 * invocation of this function). */
-	if(head == NULL)
+	/* Quit if list is unavailable (e.g. used by another invocation of this
+	 * function, which shows a dialog). */
+	if(checking_jobs)
 	{
 		return;
 	}
@@ -161,14 +246,32 @@ check_background_jobs(void)
 		return;
 	}
 
+#ifndef _WIN32
+	reap_if_requested();
+#endif
+
+	if(jobs == NULL)
+	{
+		bg_jobs_unfreeze();
+		return;
+	}
+
+	checking_jobs = 1;
 	head = jobs;
 	jobs = NULL;
 
+#ifndef _WIN32
+	read_job_errors(head);
+#endif
+	show_job_errors(head);
+
 	p = head;
 	prev = NULL;
 	while(p != NULL)
 	{
+#ifdef _WIN32
 		job_check(p);
+#endif
 
 		/* Remove job if it is finished now. */
 		if(!p->running)
@@ -197,55 +300,169 @@ check_background_jobs(void)
 
 	assert(jobs == NULL && "Job list shouldn't be used by anyone.");
 	jobs = head;
+	checking_jobs = 0;
 
 	bg_jobs_unfreeze();
 }
 
-/* Checks status of the job.  Processes error stream or checks whether process
- * is still running. */
+#ifndef _WIN32
+
+/* Reaps finished processes if SIGCHLD was received since the last call. */
 static void
-job_check(job_t *const job)
+reap_if_requested(void)
 {
-#ifndef _WIN32
-	fd_set ready;
-	int max_fd = 0;
-	struct timeval ts = { .tv_sec = 0, .tv_usec = 1000 };
+	char buf[64];
+	int requested = 0;
+
+	if(sigchld_pipe[0] < 0)
+	{
+		return;
+	}
 
-	/* Setup pipe for reading */
-	FD_ZERO(&ready);
-	if(job->fd >= 0)
+	while(read(sigchld_pipe[0], buf, sizeof(buf)) > 0)
 	{
-		FD_SET(job->fd, &ready);
-		max_fd = job->fd;
+		requested = 1;
 	}
 
-	if(job->error != NULL)
+	if(requested)
 	{
-		if(!job->skip_errors)
+		reap_children();
+	}
+}
+
+/* Reaps all finished child processes and marks corresponding jobs as
+ * finished. */
+static void
+reap_children(void)
+{
+	int status;
+	pid_t pid;
+
+	/* This needs to be a loop in case of multiple blocked signals. */
+	while((pid = waitpid(-1, &status, WNOHANG)) > 0)
+	{
+		add_finished_job(pid, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+	}
+}
+
+/* Collects available error output of all external commands at once.  Running
+ * commands are read once per call to not block on verbose ones, finished
+ * commands are drained. */
+static void
+read_job_errors(job_t *head)
+{
+	job_t *job;
+	job_t **polled;
+	struct pollfd *fds;
+	int count = 0;
+	int i;
+
+	for(job = head; job != NULL; job = job->next)
+	{
+		count += (job->fd >= 0);
+	}
+
+	if(count == 0)
+	{
+		return;
+	}
+
+	fds = reallocarray(NULL, count, sizeof(*fds));
+	polled = reallocarray(NULL, count, sizeof(*polled));
+	if(fds == NULL || polled == NULL)
+	{
+		free(fds);
+		free(polled);
+		return;
+	}
+
+	i = 0;
+	for(job = head; job != NULL; job = job->next)
+	{
+		if(job->fd >= 0)
 		{
-			job->skip_errors = prompt_error_msg("Background Process Error",
-					job->error);
+			fds[i].fd = job->fd;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+			polled[i++] = job;
 		}
-		free(job->error);
-		job->error = NULL;
 	}
 
-	while(select(max_fd + 1, &ready, NULL, NULL, &ts) > 0)
+	if(poll(fds, count, 0) > 0)
 	{
-		char err_msg[ERR_MSG_LEN];
+		for(i = 0; i < count; ++i)
+		{
+			if(fds[i].revents != 0)
+			{
+				(void)read_job_error(polled[i]);
+			}
+		}
+	}
 
-		const ssize_t nread = read(job->fd, err_msg, sizeof(err_msg) - 1);
-		if(nread == 0)
+	for(i = 0; i < count; ++i)
+	{
+		if(!polled[i]->running)
 		{
-			break;
+			drain_job_errors(polled[i]);
+		}
+	}
+
+	free(fds);
+	free(polled);
+}
+
+/* Reads a piece of error stream of the job, which must be ready for reading.
+ * Returns non-zero if more data might be available, otherwise zero is
+ * returned. */
+static int
+read_job_error(job_t *job)
+{
+	char err_msg[ERR_MSG_LEN];
+
+	const ssize_t nread = read(job->fd, err_msg, sizeof(err_msg) - 1);
+	if(nread <= 0)
+	{
+		if(nread < 0 && errno == EINTR)
+		{
+			return 1;
 		}
-		else if(nread > 0 && !job->skip_errors)
+
+		/* Stream is at its end and would be always reported as ready, which
+		 * must not happen to descriptors that the main loop waits on. */
+		close(job->fd);
+		job->fd = NO_JOB_ID;
+		return 0;
+	}
+
+	if(!job->skip_errors)
+	{
+		size_t len = (job->error == NULL) ? 0U : strlen(job->error);
+		err_msg[nread] = '\0';
+		(void)strappend(&job->error, &len, err_msg);
+	}
+	return 1;
+}
+
+/* Reads whatever is left in error stream of a finished job. */
+static void
+drain_job_errors(job_t *job)
+{
+	while(job->fd >= 0)
+	{
+		struct pollfd pfd = { .fd = job->fd, .events = POLLIN };
+		if(poll(&pfd, 1, 0) <= 0 || !read_job_error(job))
 		{
-			err_msg[nread] = '\0';
-			job->skip_errors = prompt_error_msg("Background Process Error", err_msg);
+			break;
 		}
 	}
+}
+
 #else
+
+/* Checks whether process of the job is still running. */
+static void
+job_check(job_t *const job)
+{
 	DWORD retcode;
 	if(GetExitCodeProcess(job->hprocess, &retcode) != 0)
 	{
@@ -254,7 +471,68 @@ job_check(job_t *const job)
 			job->running = 0;
 		}
 	}
+}
+
 #endif
+
+/* Displays errors accumulated by jobs in a single dialog and resets them.  If
+ * user chooses to skip errors, that applies to all reported jobs. */
+static void
+show_job_errors(job_t *head)
+{
+	job_t *job;
+	char *msg = NULL;
+	size_t len = 0U;
+	int count = 0;
+	int skip;
+
+	for(job = head; job != NULL; job = job->next)
+	{
+		if(job->error != NULL && job->skip_errors)
+		{
+			free(job->error);
+			job->error = NULL;
+		}
+		count += (job->error != NULL);
+	}
+
+	if(count == 0)
+	{
+		return;
+	}
+
+	for(job = head; job != NULL; job = job->next)
+	{
+		if(job->error == NULL)
+		{
+			continue;
+		}
+
+		/* Tell errors of different jobs apart. */
+		if(count > 1)
+		{
+			if(len != 0U && msg[len - 1] != '\n')
+			{
+				(void)strappendch(&msg, &len, '\n');
+			}
+			(void)strappend(&msg, &len, job->cmd);
+			(void)strappend(&msg, &len, ":\n");
+		}
+		(void)strappend(&msg, &len, job->error);
+	}
+
+	skip = prompt_error_msg("Background Process Error", (msg == NULL) ? "" : msg);
+	free(msg);
+
+	for(job = head; job != NULL; job = job->next)
+	{
+		if(job->error != NULL)
+		{
+			job->skip_errors |= skip;
+			free(job->error);
+			job->error = NULL;
+		}
+	}
 }
 
 /* Frees resources allocated by the job as well as the job_t structure itself.
@@ -764,12 +1042,8 @@ start_background_job(const char *cmd, int skip_errors)
 
 int
 bg_execute(const char descr[], const char op_descr[], int total, int important,
-		bg_task_func task_func, void *args)
+		const char src[], const char dst[], bg_task_func task_func, void *args)
 {
-	pthread_t id;
-	pthread_attr_t attr;
-	int ret;
-
 	background_task_args *const task_args = malloc(sizeof(*task_args));
 	if(task_args == NULL)
 	{
@@ -778,6 +1052,10 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 
 	task_args->func = task_func;
 	task_args->args = args;
+	task_args->src_dev = get_dev(src);
+	task_args->dst_dev = (dst == NULL) ? task_args->src_dev : get_dev(dst);
+	task_args->suspended = 0;
+	task_args->next = NULL;
 	task_args->job = add_background_job(WRONG_PID, descr, NO_JOB_ID,
 			important ? BJT_OPERATION : BJT_TASK);
 
@@ -787,42 +1065,385 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 		return 1;
 	}
 
-	if(pthread_attr_init(&attr) != 0)
+	replace_string(&task_args->job->bg_op.descr, op_descr);
+	task_args->job->bg_op.total = total;
+
+	if(task_args->job->type == BJT_OPERATION)
 	{
+		ui_stat_job_bar_add(&task_args->job->bg_op);
+	}
+
+	if(enqueue_task(task_args) != 0)
+	{
+		/* Mark job as finished with error. */
+		task_args->job->running = 0;
+		task_args->job->exit_code = 1;
+
 		free(task_args);
 		return 1;
 	}
 
-	if(pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0)
+	return 0;
+}
+
+/* Retrieves device on which file or its closest existing parent resides.
+ * Returns the device or zero if it can't be determined. */
+static dev_t
+get_dev(const char path[])
+{
+	char dir[PATH_MAX];
+	struct stat st;
+
+	if(path == NULL)
+	{
+		return 0;
+	}
+
+	copy_str(dir, sizeof(dir), path);
+	while(os_stat(dir, &st) != 0)
 	{
-		free(task_args);
-		(void)pthread_attr_destroy(&attr);
+		if(dir[0] == '\0' || is_root_dir(dir) || strchr(dir, '/') == NULL)
+		{
+			return 0;
+		}
+		remove_last_path_component(dir);
+	}
+	return st.st_dev;
+}
+
+/* Adds task to the end of the queue making sure that there is a worker to run
+ * it.  Returns zero on success, otherwise non-zero is returned. */
+static int
+enqueue_task(background_task_args *task)
+{
+	background_task_args **last;
+
+	pthread_mutex_lock(&pool_lock);
+
+	if(nworkers == 0 && start_worker() != 0)
+	{
+		pthread_mutex_unlock(&pool_lock);
 		return 1;
 	}
 
-	replace_string(&task_args->job->bg_op.descr, op_descr);
-	task_args->job->bg_op.total = total;
+	last = &queue;
+	while(*last != NULL)
+	{
+		last = &(*last)->next;
+	}
+	*last = task;
 
-	if(task_args->job->type == BJT_OPERATION)
+	schedule_tasks();
+
+	pthread_mutex_unlock(&pool_lock);
+	return 0;
+}
+
+void
+bg_limits_changed(void)
+{
+	pthread_mutex_lock(&pool_lock);
+	schedule_tasks();
+	pthread_mutex_unlock(&pool_lock);
+}
+
+/* Wakes up workers to check for tasks that can be started and adds new worker
+ * if all of them are busy.  Workers of paused tasks don't count against the
+ * limit of workers.  Must be called with pool_lock held. */
+static void
+schedule_tasks(void)
+{
+	background_task_args *task;
+
+	pthread_cond_broadcast(&pool_cond);
+
+	if(idle_workers != 0 || nworkers - suspended_workers >= MAX_WORKERS)
 	{
-		ui_stat_job_bar_add(&task_args->job->bg_op);
+		return;
 	}
 
-	ret = 0;
-	if(pthread_create(&id, &attr, &background_task_bootstrap, task_args) != 0)
+	for(task = queue; task != NULL; task = task->next)
 	{
-		/* Mark job as finished with error. */
-		task_args->job->running = 0;
-		task_args->job->exit_code = 1;
+		if(!task->job->paused &&
+				count_active(task->src_dev, task->dst_dev) < cfg.io_jobs)
+		{
+			/* Failure isn't critical, existing workers will get to the task
+			 * eventually. */
+			(void)start_worker();
+			break;
+		}
+	}
+}
 
-		free(task_args);
-		ret = 1;
+/* Starts new detached worker thread.  Must be called with pool_lock held.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+start_worker(void)
+{
+	pthread_t id;
+	pthread_attr_t attr;
+	int ret;
+
+	if(pthread_attr_init(&attr) != 0)
+	{
+		return 1;
+	}
+
+	ret = 1;
+	if(pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) == 0 &&
+			pthread_create(&id, &attr, &worker_main, NULL) == 0)
+	{
+		++nworkers;
+		ret = 0;
 	}
 
 	(void)pthread_attr_destroy(&attr);
 	return ret;
 }
 
+/* pthreads entry point of a worker.  Runs tasks from the queue as long as
+ * limits allow.  Returns result for this thread. */
+static void *
+worker_main(void *arg)
+{
+	(void)arg;
+
+	pthread_mutex_lock(&pool_lock);
+	while(1)
+	{
+		background_task_args **p;
+		background_task_args *const task = take_task();
+		if(task == NULL)
+		{
+			++idle_workers;
+			pthread_cond_wait(&pool_cond, &pool_lock);
+			--idle_workers;
+			continue;
+		}
+
+		/* There might be more tasks that can be run in parallel. */
+		schedule_tasks();
+		pthread_mutex_unlock(&pool_lock);
+
+		run_task(task);
+
+		pthread_mutex_lock(&pool_lock);
+		for(p = &active; *p != task; p = &(*p)->next)
+		{
+			/* Do nothing. */
+		}
+		*p = task->next;
+		free(task);
+
+		/* Tasks that work with the same devices might be allowed to run now. */
+		schedule_tasks();
+	}
+
+	return NULL;
+}
+
+/* Picks the first task in the queue that isn't paused and whose devices aren't
+ * busy, moves it to the list of active tasks.  Must be called with pool_lock
+ * held.  Returns the task or NULL if there is nothing to run. */
+static background_task_args *
+take_task(void)
+{
+	background_task_args **p;
+
+	for(p = &queue; *p != NULL; p = &(*p)->next)
+	{
+		background_task_args *const task = *p;
+		if(task->job->paused ||
+				count_active(task->src_dev, task->dst_dev) >= cfg.io_jobs)
+		{
+			continue;
+		}
+
+		*p = task->next;
+		task->next = active;
+		active = task;
+		task->job->started = 1;
+		return task;
+	}
+
+	return NULL;
+}
+
+/* Counts running tasks that work with the same pair of devices.  Paused tasks
+ * aren't counted.  Must be called with pool_lock held.  Returns the number. */
+static int
+count_active(dev_t src_dev, dev_t dst_dev)
+{
+	int count = 0;
+	const background_task_args *task;
+	for(task = active; task != NULL; task = task->next)
+	{
+		count += (!task->suspended && task->src_dev == src_dev &&
+				task->dst_dev == dst_dev);
+	}
+	return count;
+}
+
+/* Executes the task in context of current thread.  Performs correct
+ * startup/exit with related updates of internal data structures. */
+static void
+run_task(background_task_args *task)
+{
+	set_current_job(task->job);
+
+	task->func(&task->job->bg_op, task->args);
+
+	set_current_job(NULL);
+
+	/* Mark task as finished normally. */
+	task->job->running = 0;
+	task->job->exit_code = 0;
+}
+
+BgJobState
+bg_job_get_state(job_t *job, int *pos)
+{
+	BgJobState state;
+	const background_task_args *task;
+
+	*pos = 0;
+	if(job->type == BJT_COMMAND)
+	{
+		return BJS_RUNNING;
+	}
+
+	pthread_mutex_lock(&pool_lock);
+
+	if(job->paused)
+	{
+		state = BJS_PAUSED;
+	}
+	else
+	{
+		state = job->started ? BJS_RUNNING : BJS_QUEUED;
+	}
+
+	if(!job->started)
+	{
+		int i = 1;
+		for(task = queue; task != NULL && task->job != job; task = task->next)
+		{
+			++i;
+		}
+		*pos = (task == NULL) ? 0 : i;
+	}
+
+	pthread_mutex_unlock(&pool_lock);
+	return state;
+}
+
+int
+bg_job_set_paused(job_t *job, int paused)
+{
+	if(job->type == BJT_COMMAND || !job->running)
+	{
+		return 1;
+	}
+
+	pthread_mutex_lock(&pool_lock);
+	job->paused = paused;
+	schedule_tasks();
+	pthread_mutex_unlock(&pool_lock);
+	return 0;
+}
+
+int
+bg_job_move(job_t *job, int by)
+{
+	background_task_args **p;
+	background_task_args *task;
+	int pos;
+
+	pthread_mutex_lock(&pool_lock);
+
+	pos = 0;
+	for(p = &queue; *p != NULL && (*p)->job != job; p = &(*p)->next)
+	{
+		++pos;
+	}
+
+	if(*p == NULL)
+	{
+		pthread_mutex_unlock(&pool_lock);
+		return 1;
+	}
+
+	task = *p;
+	*p = task->next;
+
+	pos = MAX(pos + by, 0);
+	for(p = &queue; *p != NULL && pos != 0; p = &(*p)->next)
+	{
+		--pos;
+	}
+	task->next = *p;
+	*p = task;
+
+	schedule_tasks();
+
+	pthread_mutex_unlock(&pool_lock);
+	return 0;
+}
+
+/* Blocks current thread while the job is paused if it's the job of this
+ * thread.  Paused task frees its slot for other tasks and waits for a free slot
+ * after being resumed. */
+static void
+wait_while_paused(job_t *job)
+{
+	background_task_args *task;
+
+	pthread_once(&current_job_once, &make_current_job_key);
+	if(pthread_getspecific(current_job) != job)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&pool_lock);
+
+	if(!job->paused)
+	{
+		pthread_mutex_unlock(&pool_lock);
+		return;
+	}
+
+	for(task = active; task != NULL && task->job != job; task = task->next)
+	{
+		/* Do nothing. */
+	}
+
+	if(task == NULL)
+	{
+		while(job->paused)
+		{
+			pthread_cond_wait(&pool_cond, &pool_lock);
+		}
+		pthread_mutex_unlock(&pool_lock);
+		return;
+	}
+
+	task->suspended = 1;
+	++suspended_workers;
+	/* Tasks that work with the same devices might be allowed to run now. */
+	schedule_tasks();
+
+	while(job->paused ||
+			count_active(task->src_dev, task->dst_dev) >= cfg.io_jobs)
+	{
+		pthread_cond_wait(&pool_cond, &pool_lock);
+	}
+
+	task->suspended = 0;
+	--suspended_workers;
+
+	pthread_mutex_unlock(&pool_lock);
+}
+
 /* Creates structure that describes background job and registers it in the list
  * of jobs. */
 #ifndef _WIN32
@@ -860,32 +1481,13 @@ add_background_job(pid_t pid, const char cmd[], HANDLE hprocess, BgJobType type)
 	new->bg_op.done = 0;
 	new->bg_op.progress = -1;
 	new->bg_op.descr = NULL;
+	new->started = 0;
+	new->paused = 0;
 
 	jobs = new;
 	return new;
 }
 
-/* pthreads entry point for a new background task.  Performs correct
- * startup/exit with related updates of internal data structures.  Returns
- * result for this thread. */
-static void *
-background_task_bootstrap(void *arg)
-{
-	background_task_args *const task_args = arg;
-
-	set_current_job(task_args->job);
-
-	task_args->func(&task_args->job->bg_op, task_args->args);
-
-	/* Mark task as finished normally. */
-	task_args->job->running = 0;
-	task_args->job->exit_code = 0;
-
-	free(task_args);
-
-	return NULL;
-}
-
 /* Stores pointer to the job in a thread-local storage. */
 static void
 set_current_job(job_t *job)
@@ -928,6 +1530,67 @@ bg_has_active_jobs(void)
 	return bg_op_count > 0;
 }
 
+int
+bg_get_error_fds(int fds[], int len, int *polled)
+{
+	const job_t *job;
+	int count = 0;
+
+	*polled = 0;
+
+	if(checking_jobs)
+	{
+		return 0;
+	}
+
+#ifndef _WIN32
+	if(sigchld_pipe[0] >= 0 && count < len)
+	{
+		fds[count++] = sigchld_pipe[0];
+	}
+#endif
+
+	if(jobs == NULL)
+	{
+		return count;
+	}
+
+	if(bg_jobs_freeze() != 0)
+	{
+		*polled = 1;
+		return count;
+	}
+
+	for(job = jobs; job != NULL; job = job->next)
+	{
+		if(job->type != BJT_COMMAND)
+		{
+			*polled |= job->running;
+			continue;
+		}
+
+#ifndef _WIN32
+		if(job->running && job->fd >= 0)
+		{
+			if(count < len)
+			{
+				fds[count++] = job->fd;
+			}
+			else
+			{
+				*polled = 1;
+			}
+		}
+#else
+		/* Processes can't be waited on along with file descriptors. */
+		*polled |= job->running;
+#endif
+	}
+
+	bg_jobs_unfreeze();
+	return count;
+}
+
 int
 bg_jobs_freeze(void)
 {
@@ -963,6 +1626,7 @@ void
 bg_op_changed(bg_op_t *bg_op)
 {
 	ui_stat_job_bar_changed(bg_op);
+	wait_while_paused(STRUCT_FROM_FIELD(job_t, bg_op, bg_op));
 }
 
 void
@@ -44,6 +44,15 @@ typedef enum
 }
 BgJobType;
 
+/* State of internal background job. */
+typedef enum
+{
+	BJS_QUEUED,  /* Waits for a free worker or for its turn on the devices. */
+	BJS_RUNNING, /* Is being executed by a worker. */
+	BJS_PAUSED,  /* Won't be started or continued until it's resumed. */
+}
+BgJobState;
+
 /* Auxiliary structure to be updated by background tasks while they progress. */
 typedef struct bg_op_t
 {
@@ -70,6 +79,9 @@ typedef struct job_t
 	/* For background operations and tasks. */
 	pthread_mutex_t bg_op_guard;
 	bg_op_t bg_op;
+	/* These two are guarded by the pool of workers, use bg_job_*() functions. */
+	int started; /* Whether task was taken out of the queue by a worker. */
+	int paused;  /* Whether task shouldn't be started or continued. */
 
 #ifndef _WIN32
 	int fd;
@@ -111,17 +123,53 @@ pid_t background_and_capture(char cmd[], int user_sh, FILE **out, FILE **err);
  * exit_code. */
 void add_finished_job(pid_t pid, int exit_code);
 
+/* Notifies the unit that SIGCHLD was received.  Safe to call from signal
+ * handler, actual reaping of processes happens in check_background_jobs(). */
+void bg_sigchld_received(void);
+
+/* Reaps finished processes, collects error output of all jobs with a single
+ * poll and reports it in one dialog, removes finished jobs from the list. */
 void check_background_jobs(void);
 
-/* Starts new background task, which is run in a separate thread.  Returns zero
- * on success, otherwise non-zero is returned. */
+/* Queues new background task, which is run by one of worker threads.  Tasks
+ * that work with the same pair of source and destination devices are limited
+ * to 'iojobs' simultaneously running ones.  The src and dst are paths that
+ * identify the devices, dst can be NULL for tasks that work with a single
+ * device and src can be NULL if it's unknown.  Returns zero on success,
+ * otherwise non-zero is returned. */
 int bg_execute(const char descr[], const char op_descr[], int total,
-		int important, bg_task_func task_func, void *args);
+		int important, const char src[], const char dst[], bg_task_func task_func,
+		void *args);
+
+/* Starts queued tasks that became allowed to run after 'iojobs' option has
+ * changed. */
+void bg_limits_changed(void);
+
+/* Retrieves state of the job.  *pos is set to position of queued task in the
+ * queue (starting with one) and to zero otherwise.  Returns the state. */
+BgJobState bg_job_get_state(job_t *job, int *pos);
+
+/* Pauses or resumes internal job.  Running task is paused on its next progress
+ * update and lets queued tasks run in its place until it's resumed.  Returns
+ * zero on success, otherwise non-zero is returned. */
+int bg_job_set_paused(job_t *job, int paused);
+
+/* Moves queued task by the specified number of positions in the queue, negative
+ * values move it closer to the start.  Returns zero on success, otherwise
+ * non-zero is returned. */
+int bg_job_move(job_t *job, int by);
 
 /* Checks whether there are any internal jobs (not external applications tracked
  * by vifm) running in background. */
 int bg_has_active_jobs(void);
 
+/* Collects file descriptors of error streams of running external applications
+ * into the fds array, which has room for len elements.  Sets *polled to
+ * non-zero if there are jobs that report their progress without descriptors
+ * (internal ones) and thus need to be checked periodically.  Returns number of
+ * collected descriptors. */
+int bg_get_error_fds(int fds[], int len, int *polled);
+
 /* Performs preparations necessary for safe access of the jobs list.  Effect of
  * calling this function must be reverted by calling bg_jobs_unfreeze().
  * Returns zero on success, otherwise non-zero is returned. */
@@ -139,7 +187,7 @@ void bg_op_lock(bg_op_t *bg_op);
 void bg_op_unlock(bg_op_t *bg_op);
 
 /* Callback-like function to report that state of background operation
- * changed. */
+ * changed.  Blocks calling task while its job is paused. */
 void bg_op_changed(bg_op_t *bg_op);
 
 /* Conveniece method to update description of background job, use
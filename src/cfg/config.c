@@ -196,6 +196,10 @@ cfg_init(void)
 	cfg.timeout_len = 1000;
 	cfg.min_timeout_len = 150;
 
+	cfg.stat_threads = 1;
+	cfg.io_jobs = 1;
+	cfg.cv_quick_reload = 0;
+
 	/* Fill cfg.word_chars as if it was initialized from isspace() fuction. */
 	memset(&cfg.word_chars, 1, sizeof(cfg.word_chars));
 	cfg.word_chars['\x00'] = 0; cfg.word_chars['\x09'] = 0;
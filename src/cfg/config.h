@@ -160,6 +160,18 @@ typedef struct config_t
 	int timeout_len;     /* Maximum period on waiting for the input. */
 	int min_timeout_len; /* Minimum period on waiting for the input. */
 
+	/* Number of threads that query information about files while directory is
+	 * being loaded. */
+	int stat_threads;
+
+	/* Maximum number of background operations that are run simultaneously on the
+	 * same pair of source and destination devices. */
+	int io_jobs;
+
+	/* Whether reload of custom view checks only files of directories that
+	 * changed since the previous check. */
+	int cv_quick_reload;
+
 	char word_chars[256]; /* Whether corresponding character is a word char. */
 }
 config_t;
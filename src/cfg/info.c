@@ -53,6 +53,7 @@
 #include "../registers.h"
 #include "../status.h"
 #include "../trash.h"
+#include "../undo.h"
 #include "config.h"
 #include "hist.h"
 #include "info_chars.h"
@@ -478,6 +479,25 @@ write_info_file(void)
 	}
 }
 
+void
+update_undo_journal(void)
+{
+	char journal_file[PATH_MAX + sizeof("/undo")];
+
+	if(!(cfg.vifm_info & VIFMINFO_UNDO))
+	{
+		undo_journal_close();
+		return;
+	}
+
+	(void)snprintf(journal_file, sizeof(journal_file), "%s/undo",
+			cfg.config_dir);
+	if(undo_journal_open(journal_file) != 0)
+	{
+		LOG_ERROR_MSG("Can't open undo journal: %s", journal_file);
+	}
+}
+
 /* Copies the src file to the dst location.  Returns zero on success. */
 static int
 copy_file(const char src[], const char dst[])
@@ -1052,6 +1072,8 @@ write_options(FILE *const fp)
 		fprintf(fp, ",dirstack");
 	if(cfg.vifm_info & VIFMINFO_REGISTERS)
 		fprintf(fp, ",registers");
+	if(cfg.vifm_info & VIFMINFO_UNDO)
+		fprintf(fp, ",undo");
 	fprintf(fp, "\n");
 
 	fprintf(fp, "=%svimhelp\n", cfg.use_vim_help ? "" : "no");
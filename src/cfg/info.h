@@ -28,6 +28,10 @@ void read_info_file(int reread);
 /* Writes vifminfo file updating it with state of the current instance. */
 void write_info_file(void);
 
+/* Starts or stops keeping undo list in $VIFM/undo file according to value of
+ * 'vifminfo' option. */
+void update_undo_journal(void);
+
 #endif /* VIFM__CFG__INFO_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -28,7 +28,7 @@
 #include <curses.h>
 
 #include <sys/stat.h> /* gid_t uid_t */
-#include <unistd.h> /* unlink() */
+#include <unistd.h> /* _SC_ARG_MAX sysconf() unlink() */
 
 #include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() isspace() */
@@ -159,6 +159,10 @@ static char * skip_command_beginning(const char cmd[]);
 static int repeat_command(FileView *view, CmdInputType type);
 static int goto_cmd(const cmd_info_t *cmd_info);
 static int emark_cmd(const cmd_info_t *cmd_info);
+static char ** split_long_command(const cmd_info_t *cmd_info, const char com[],
+		int *count);
+static size_t get_shell_cmd_limit(void);
+static void run_in_shell(const char com[], ShellPause pause, int use_term_mux);
 static int alink_cmd(const cmd_info_t *cmd_info);
 static int apropos_cmd(const cmd_info_t *cmd_info);
 static int bmark_cmd(const cmd_info_t *cmd_info);
@@ -1608,30 +1612,34 @@ emark_cmd(const cmd_info_t *cmd_info)
 	{
 		return save_msg;
 	}
-	else if(cmd_info->bg)
-	{
-		start_background_job(com, 0);
-	}
 	else
 	{
-		const int use_term_mux = flags != MF_NO_TERM_MUX;
+		int i;
+		int ncoms;
+		char **const coms = split_long_command(cmd_info, com, &ncoms);
 
-		clean_selected_files(curr_view);
-		if(cfg.fast_run)
+		if(cmd_info->bg)
 		{
-			char *const buf = fast_run_complete(com);
-			if(buf != NULL)
+			/* Parts of the command run in parallel. */
+			for(i = 0; i < ncoms; ++i)
 			{
-				(void)shellout(buf, cmd_info->emark ? PAUSE_ALWAYS : PAUSE_ON_ERROR,
-						use_term_mux);
-				free(buf);
+				start_background_job(coms[i], 0);
 			}
 		}
 		else
 		{
-			(void)shellout(com, cmd_info->emark ? PAUSE_ALWAYS : PAUSE_ON_ERROR,
-					use_term_mux);
+			const int use_term_mux = flags != MF_NO_TERM_MUX;
+			const ShellPause pause = cmd_info->emark ? PAUSE_ALWAYS : PAUSE_ON_ERROR;
+
+			clean_selected_files(curr_view);
+			for(i = 0; i < ncoms; ++i)
+			{
+				run_in_shell(coms[i], (i == ncoms - 1) ? pause : PAUSE_ON_ERROR,
+						use_term_mux);
+			}
 		}
+
+		free_string_array(coms, ncoms);
 	}
 
 	snprintf(buf, sizeof(buf), "in %s: !%s",
@@ -1643,6 +1651,81 @@ emark_cmd(const cmd_info_t *cmd_info)
 	return save_msg;
 }
 
+/* Splits command that is too long to be passed to the shell into several ones
+ * by distributing selected files among them.  Sets *count to number of
+ * elements in the returned array.  Returns array of commands to run. */
+static char **
+split_long_command(const cmd_info_t *cmd_info, const char com[], int *count)
+{
+	char **coms = NULL;
+
+	if(strlen(com) > get_shell_cmd_limit())
+	{
+		int i;
+
+		coms = ma_expand_batched(cmd_info->raw_args, NULL, NULL, 1,
+				get_shell_cmd_limit(), count);
+		for(i = 0; i < *count; ++i)
+		{
+			const char *const part = skip_whitespace(coms[i]);
+			memmove(coms[i], part, strlen(part) + 1U);
+		}
+	}
+
+	if(coms == NULL)
+	{
+		*count = add_to_string_array(&coms, 0, 1, com);
+	}
+
+	return coms;
+}
+
+/* Computes maximum length of a command that is passed to the shell leaving
+ * some room for the way the shell is invoked.  Returns the length. */
+static size_t
+get_shell_cmd_limit(void)
+{
+	enum { HEADROOM = 1024 };
+
+#ifndef _WIN32
+	/* The command is passed to the shell as single argument, which on Linux
+	 * can't exceed 32 pages. */
+	size_t limit = 32U*4096U;
+#ifdef _SC_ARG_MAX
+	/* Half of the space is left for the environment. */
+	const long arg_max = sysconf(_SC_ARG_MAX);
+	if(arg_max > 0 && (size_t)arg_max/2U < limit)
+	{
+		limit = arg_max/2U;
+	}
+#endif
+#else
+	/* Maximum length of command-line of cmd.exe. */
+	const size_t limit = 8191U;
+#endif
+
+	return (limit > 2*HEADROOM) ? limit - HEADROOM : limit/2U;
+}
+
+/* Runs command in the shell possibly completing it first. */
+static void
+run_in_shell(const char com[], ShellPause pause, int use_term_mux)
+{
+	if(cfg.fast_run)
+	{
+		char *const buf = fast_run_complete(com);
+		if(buf != NULL)
+		{
+			(void)shellout(buf, pause, use_term_mux);
+			free(buf);
+		}
+	}
+	else
+	{
+		(void)shellout(com, pause, use_term_mux);
+	}
+}
+
 /* Creates symbolic links with absolute paths to files. */
 static int
 alink_cmd(const cmd_info_t *cmd_info)
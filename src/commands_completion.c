@@ -38,7 +38,8 @@
 #include <stddef.h> /* NULL size_t */
 #include <stdlib.h> /* free() */
 #include <stdio.h> /* snprintf() */
-#include <string.h> /* strdup() strlen() strncasecmp() strncmp() strrchr() */
+#include <string.h> /* strdup() strlen() strncasecmp() strncmp() strpbrk()
+                       strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -85,6 +86,7 @@ static void complete_winrun(const char str[]);
 static void complete_from_string_list(const char str[], const char *list[],
 		size_t list_len);
 static void complete_command_name(const char beginning[]);
+static void add_exec_match(const char dir[], const char name[], void *arg);
 static void filename_completion_in_dir(const char *path, const char *str,
 		CompletionType type);
 static void filename_completion_internal(DIR *dir, const char dirname[],
@@ -674,10 +676,19 @@ complete_command_name(const char beginning[])
 	size_t paths_count;
 	char *const cwd = save_cwd();
 
+	/* Cached lists of files can't be used if beginning needs to be expanded or
+	 * refers to a subdirectory. */
+	const int use_cache = (strpbrk(beginning, "/~$") == NULL);
+
 	paths = get_paths(&paths_count);
 	for(i = 0U; i < paths_count; ++i)
 	{
-		if(vifm_chdir(paths[i]) == 0)
+		if(use_cache &&
+				list_path_dir(i, beginning, &add_exec_match, NULL) == 0)
+		{
+			vle_compl_finish_group();
+		}
+		else if(vifm_chdir(paths[i]) == 0)
 		{
 			filename_completion(beginning, CT_EXECONLY);
 		}
@@ -687,6 +698,18 @@ complete_command_name(const char beginning[])
 	restore_cwd(cwd);
 }
 
+/* Adds name of the file as completion match if it's an executable. */
+static void
+add_exec_match(const char dir[], const char name[], void *arg)
+{
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	if(executable_exists(path))
+	{
+		vle_compl_add_path_match(name);
+	}
+}
+
 static void
 filename_completion_in_dir(const char *path, const char *str,
 		CompletionType type)
@@ -0,0 +1 @@
+const char GIT_INFO[] = "5465da4f1cf7-dirty";
@@ -0,0 +1,149 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "dcache.h"
+
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_* */
+
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* malloc() */
+#include <time.h> /* time_t */
+
+#include "utils/tree.h"
+
+/* Cached information about a directory. */
+typedef struct
+{
+	uint64_t size; /* Size of the directory. */
+	uint64_t own;  /* Size of files right in the directory or DCACHE_UNKNOWN. */
+	time_t mtime;  /* Modification time of the directory at calculation. */
+}
+dcache_entry_t;
+
+static int get_entry(const char path[], dcache_entry_t *entry);
+
+/* Protects the cache from concurrent accesses. */
+static pthread_mutex_t dcache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Maps paths to dcache_entry_t elements, which are owned by the tree. */
+static tree_t dcache = NULL_TREE;
+
+int
+dcache_reset(void)
+{
+	tree_t new_cache = tree_create(0, 1);
+	tree_t old_cache;
+
+	if(new_cache == NULL_TREE)
+	{
+		return 1;
+	}
+
+	pthread_mutex_lock(&dcache_lock);
+	old_cache = dcache;
+	dcache = new_cache;
+	pthread_mutex_unlock(&dcache_lock);
+
+	tree_free(old_cache);
+	return 0;
+}
+
+int
+dcache_get(const char path[], uint64_t *size)
+{
+	dcache_entry_t entry;
+	if(get_entry(path, &entry) != 0)
+	{
+		return 1;
+	}
+
+	*size = entry.size;
+	return 0;
+}
+
+int
+dcache_get_own_at(const char path[], time_t mtime, uint64_t *own)
+{
+	dcache_entry_t entry;
+	if(get_entry(path, &entry) != 0 || entry.mtime != mtime ||
+			entry.own == DCACHE_UNKNOWN)
+	{
+		return 1;
+	}
+
+	*own = entry.own;
+	return 0;
+}
+
+/* Copies out cached information about the path.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+get_entry(const char path[], dcache_entry_t *entry)
+{
+	union
+	{
+		tree_val_t l;
+		dcache_entry_t *p;
+	}
+	u;
+	int result = 1;
+
+	pthread_mutex_lock(&dcache_lock);
+	if(dcache != NULL_TREE && tree_get_data(dcache, path, &u.l) == 0)
+	{
+		*entry = *u.p;
+		result = 0;
+	}
+	pthread_mutex_unlock(&dcache_lock);
+
+	return result;
+}
+
+int
+dcache_set_at(const char path[], time_t mtime, uint64_t size, uint64_t own)
+{
+	union
+	{
+		tree_val_t l;
+		dcache_entry_t *p;
+	}
+	u = { .l = 0 };
+	int result;
+
+	u.p = malloc(sizeof(*u.p));
+	if(u.p == NULL)
+	{
+		return 1;
+	}
+	u.p->size = size;
+	u.p->own = own;
+	u.p->mtime = mtime;
+
+	pthread_mutex_lock(&dcache_lock);
+	result = (dcache == NULL_TREE || tree_set_data(dcache, path, u.l) != 0);
+	pthread_mutex_unlock(&dcache_lock);
+
+	if(result != 0)
+	{
+		free(u.p);
+	}
+	return result;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
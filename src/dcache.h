@@ -0,0 +1,56 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__DCACHE_H__
+#define VIFM__DCACHE_H__
+
+#include <stdint.h> /* uint64_t */
+#include <time.h> /* time_t */
+
+/* Cache of calculated directory sizes.  Each size is stored along with
+ * modification time of the directory at the moment of calculation, which
+ * allows detecting outdated entries.  All functions are thread-safe. */
+
+/* Value of size of files of a directory, which marks it as unknown. */
+#define DCACHE_UNKNOWN ((uint64_t)-1)
+
+/* Drops all cached data.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int dcache_reset(void);
+
+/* Retrieves cached size of the directory regardless of whether it's
+ * up-to-date.  Returns zero and sets *size on success, otherwise non-zero is
+ * returned and *size isn't changed. */
+int dcache_get(const char path[], uint64_t *size);
+
+/* Retrieves cached total size of files located right in the directory (not in
+ * its subdirectories) only if it was calculated when modification time of the
+ * directory was equal to mtime.  Returns zero and sets *own on success,
+ * otherwise non-zero is returned and *own isn't changed. */
+int dcache_get_own_at(const char path[], time_t mtime, uint64_t *own);
+
+/* Stores size of the directory and size of files right in it (can be
+ * DCACHE_UNKNOWN) along with modification time of the directory.  Returns zero
+ * on success, otherwise non-zero is returned. */
+int dcache_set_at(const char path[], time_t mtime, uint64_t size,
+		uint64_t own);
+
+#endif /* VIFM__DCACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
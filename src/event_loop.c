@@ -21,21 +21,29 @@
 
 #include <curses.h>
 
-#include <unistd.h>
+#ifndef _WIN32
+#include <poll.h> /* POLLIN poll() pollfd */
+#endif
+#include <unistd.h> /* STDIN_FILENO */
 
 #include <assert.h> /* assert() */
 #include <signal.h> /* signal() */
 #include <stddef.h> /* NULL size_t wchar_t */
 #include <string.h> /* memmove() strncpy() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() timespec */
 #include <wchar.h> /* wint_t wcslen() wcscmp() */
 
 #include "cfg/config.h"
 #include "compat/curses.h"
 #include "engine/keys.h"
 #include "engine/mode.h"
+#include "menus/menus.h"
 #include "modes/dialogs/msg_dialog.h"
+#include "modes/menu.h"
 #include "modes/modes.h"
+#include "modes/view.h"
 #include "ui/fileview.h"
+#include "ui/quickview.h"
 #include "ui/statusbar.h"
 #include "ui/statusline.h"
 #include "ui/ui.h"
@@ -45,10 +53,18 @@
 #include "background.h"
 #include "filelist.h"
 #include "ipc.h"
+#include "signals.h"
 #include "status.h"
 
 static int ensure_term_is_ready(void);
 static int get_char_async_loop(WINDOW *win, wint_t *c, int timeout);
+static void check_for_events(void);
+#ifndef _WIN32
+static void wait_for_events(int timeout);
+static int add_view_fd(struct pollfd fds[], int *nfds, const FileView *view);
+static void add_fd(struct pollfd fds[], int *nfds, int fd);
+static long long get_ms(void);
+#endif
 static void process_scheduled_updates(void);
 static int process_scheduled_updates_of_view(FileView *view);
 static int should_check_views_for_changes(void);
@@ -101,14 +117,12 @@ event_loop(const int *quit)
 		modes_pre();
 
 		/* Waits for timeout then skips if no keypress.  Short-circuit if we're not
-		 * waiting for the next key after timeout. */
+		 * waiting for the next key after timeout.  There is nothing to time out
+		 * on empty input buffer, so wait without a limit in that case. */
 		do
 		{
-			modes_periodic();
-
-			check_background_jobs();
-
-			got_input = get_char_async_loop(status_bar, &c, timeout) != ERR;
+			got_input = get_char_async_loop(status_bar, &c,
+					(input_buf_pos == 0) ? -1 : timeout) != ERR;
 			if(!got_input && input_buf_pos == 0)
 			{
 				timeout = cfg.timeout_len;
@@ -275,25 +289,56 @@ ensure_term_is_ready(void)
  * performing the following tasks while waiting for input:
  *  - checks for new IPC messages;
  *  - checks whether contents of displayed directories changed;
+ *  - checks state of background jobs;
  *  - redraws UI if requested.
- * Returns KEY_CODE_YES for functional keys, OK for wide character and ERR
- * otherwise (e.g. after timeout). */
+ * Negative timeout means waiting for input without a limit.  Returns
+ * KEY_CODE_YES for functional keys, OK for wide character and ERR otherwise
+ * (e.g. after timeout). */
 static int
 get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 {
-	const int IPC_F = ipc_enabled() ? 10 : 1;
+#ifndef _WIN32
+	const long long deadline = (timeout < 0) ? -1 : get_ms() + timeout;
 
-	do
+	while(1)
 	{
-		int i;
+		int result;
+
+		check_for_events();
 
-		if(should_check_views_for_changes())
+		/* Curses might have already read some input, so query it before waiting
+		 * on the terminal. */
+		wtimeout(win, 0);
+		result = compat_wget_wch(win, c);
+		if(result != ERR)
 		{
-			check_view_for_changes(curr_view);
-			check_view_for_changes(other_view);
+			return result;
 		}
 
-		process_scheduled_updates();
+		if(deadline >= 0)
+		{
+			timeout = deadline - get_ms();
+			if(timeout <= 0)
+			{
+				return ERR;
+			}
+		}
+
+		wait_for_events(timeout);
+	}
+#else
+	const int IPC_F = ipc_enabled() ? 10 : 1;
+
+	if(timeout < 0)
+	{
+		timeout = cfg.timeout_len;
+	}
+
+	do
+	{
+		int i;
+
+		check_for_events();
 
 		for(i = 0; i < IPC_F; ++i)
 		{
@@ -316,8 +361,136 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 	while(timeout > 0);
 
 	return ERR;
+#endif
 }
 
+/* Processes events from all sources except for the terminal. */
+static void
+check_for_events(void)
+{
+	signals_clear_wakeup();
+
+	modes_periodic();
+
+	check_background_jobs();
+
+	if(should_check_views_for_changes())
+	{
+		check_view_for_changes(curr_view);
+		check_view_for_changes(other_view);
+	}
+
+	ipc_check();
+
+	process_scheduled_updates();
+}
+
+#ifndef _WIN32
+
+/* Blocks until terminal or any other source of events becomes ready, timeout
+ * (in milliseconds) expires or a signal arrives.  Negative timeout means no
+ * limit, which gets replaced with a short one if some sources can't be waited
+ * on and need to be checked periodically. */
+static void
+wait_for_events(int timeout)
+{
+	enum { MAX_FDS = 32 };
+
+	struct pollfd fds[MAX_FDS];
+	int job_fds[MAX_FDS];
+	int nfds = 0;
+	int njobs;
+	int i;
+	int polled;
+	int jobs_polled;
+
+	add_fd(fds, &nfds, STDIN_FILENO);
+	add_fd(fds, &nfds, signals_get_wakeup_fd());
+
+	polled = 0;
+	if(ipc_enabled())
+	{
+		const int fd = ipc_get_fd();
+		polled |= (fd < 0);
+		add_fd(fds, &nfds, fd);
+	}
+
+	if(should_check_views_for_changes())
+	{
+		polled |= add_view_fd(fds, &nfds, curr_view);
+		polled |= add_view_fd(fds, &nfds, other_view);
+	}
+
+	if(vle_mode_get_primary() == MENU_MODE)
+	{
+		add_fd(fds, &nfds, menu_get_loading_fd());
+	}
+
+	njobs = bg_get_error_fds(job_fds, MAX_FDS - nfds, &jobs_polled);
+	polled |= jobs_polled;
+	for(i = 0; i < njobs; ++i)
+	{
+		add_fd(fds, &nfds, job_fds[i]);
+	}
+
+	/* Background threads, previews and auto-forwarding of files don't have
+	 * anything to wait on. */
+	polled |= qv_is_loading() || view_is_forwarding();
+
+	if(polled)
+	{
+		timeout = (timeout < 0) ? cfg.min_timeout_len
+		                        : MIN(timeout, cfg.min_timeout_len);
+	}
+
+	/* Errors including interruption by signals are handled by the caller on
+	 * processing events. */
+	(void)poll(fds, nfds, timeout);
+}
+
+/* Adds file descriptor of the view to the set if its contents is tracked.
+ * Returns non-zero if the view needs to be checked periodically, otherwise
+ * zero is returned. */
+static int
+add_view_fd(struct pollfd fds[], int *nfds, const FileView *view)
+{
+	int fd;
+
+	if(!window_shows_dirlist(view) || !flist_get_watch_fd(view, &fd))
+	{
+		return 0;
+	}
+
+	add_fd(fds, nfds, fd);
+	return (fd < 0);
+}
+
+/* Adds file descriptor to the set for waiting on input.  Negative descriptors
+ * are ignored. */
+static void
+add_fd(struct pollfd fds[], int *nfds, int fd)
+{
+	if(fd >= 0)
+	{
+		fds[*nfds].fd = fd;
+		fds[*nfds].events = POLLIN;
+		fds[*nfds].revents = 0;
+		++*nfds;
+	}
+}
+
+/* Retrieves current time of monotonic clock.  Returns the time in
+ * milliseconds. */
+static long long
+get_ms(void)
+{
+	struct timespec ts;
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000LL + ts.tv_nsec/1000000;
+}
+
+#endif
+
 /* Updates TUI or its elements if something is scheduled. */
 static void
 process_scheduled_updates(void)
@@ -326,6 +499,15 @@ process_scheduled_updates(void)
 
 	ui_stat_job_bar_check_for_updates();
 
+	if(vle_mode_get_primary() != MENU_MODE)
+	{
+		qv_check_for_updates();
+	}
+	else
+	{
+		menu_check_for_updates();
+	}
+
 	if(vle_mode_get_primary() != MENU_MODE)
 	{
 		need_redraw += (process_scheduled_updates_of_view(curr_view) != 0);
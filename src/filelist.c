@@ -27,19 +27,21 @@
 #endif
 
 #include <curses.h>
+#include <pthread.h> /* PTHREAD_* pthread_*() */
 
 #include <sys/stat.h> /* stat */
 #include <unistd.h> /* close() fork() pipe() */
 
 #include <assert.h> /* assert() */
+#include <ctype.h> /* tolower() */
 #include <errno.h> /* errno */
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
 #include <stdio.h> /* snprintf() */
-#include <stdlib.h> /* abs() calloc() free() */
+#include <stdlib.h> /* abs() calloc() free() qsort() */
 #include <string.h> /* memcmp() memcpy() memset() strcat() strcmp() strcpy()
                        strdup() strlen() */
-#include <time.h> /* localtime() */
+#include <time.h> /* localtime() time() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -62,11 +64,12 @@
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
+#include "utils/string_pool.h"
 #include "utils/test_helpers.h"
-#include "utils/tree.h"
 #include "utils/trie.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
+#include "dcache.h"
 #include "filtering.h"
 #include "macros.h"
 #include "opt_handlers.h"
@@ -75,6 +78,16 @@
 #include "status.h"
 #include "types.h"
 
+/* Slot of name index of a view. */
+struct name_slot_t
+{
+	int pos;           /* Position of entry plus one, zero for empty slot. */
+	unsigned int hash; /* Hash of the name of the entry. */
+};
+
+/* Predicate for entries found in name index. */
+typedef int (*entry_matcher)(const dir_entry_t *entry, const void *arg);
+
 /* Custom argument for is_in_list() function. */
 typedef struct
 {
@@ -87,6 +100,50 @@ list_t;
  * if particular property holds and zero otherwise. */
 typedef int (*predicate_func)(const dir_entry_t *entry);
 
+/* Type of functions that process items of a job in range [first, last). */
+typedef void (*chunk_func)(void *arg, int first, int last);
+
+/* State shared among threads that process items of a job in chunks. */
+typedef struct
+{
+	chunk_func func;      /* Processor of chunks of items. */
+	void *arg;            /* Argument for the processor. */
+	int count;            /* Number of items. */
+	int chunk;            /* Number of items in a chunk. */
+	int next;             /* Index of the first item that isn't taken yet. */
+	pthread_mutex_t lock; /* Protects the next field. */
+}
+par_job_t;
+
+#ifndef _WIN32
+/* State of querying information about files of a directory. */
+typedef struct
+{
+	dir_entry_t *entries; /* Entries to fill in. */
+	int *errors;          /* Results of querying information about entries. */
+}
+stat_job_t;
+#endif
+
+/* Group of entries of custom view that share directory. */
+typedef struct
+{
+	const char *path; /* Path to the directory. */
+	int first;        /* Index of the first entry of the group. */
+	int count;        /* Number of entries in the group. */
+	time_t mtime;     /* Modification time of the directory or -1. */
+}
+dir_group_t;
+
+/* State of revalidation of custom view entries. */
+typedef struct
+{
+	dir_entry_t *entries; /* Entries of the view. */
+	dir_entry_t **todo;   /* Entries that need to be checked. */
+	char *dead;           /* Whether file of an entry (by its index) is gone. */
+}
+revalidate_job_t;
+
 static void init_view(FileView *view);
 static void init_flist(FileView *view);
 static void reset_view(FileView *view);
@@ -103,7 +160,13 @@ static int fill_dir_entry_by_path(dir_entry_t *entry, const char path[]);
 #ifndef _WIN32
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const struct dirent *d);
+static int lstat_dir_entry(dir_entry_t *entry, const char path[],
+		FileType hint);
+static void log_lstat_error(const char path[], int error);
+static void query_link_target_mode(dir_entry_t *entry, const char path[]);
 static int data_is_dir_entry(const struct dirent *d);
+static void fill_entries_in_parallel(FileView *view, int nthreads);
+static void stat_entries(void *arg, int first, int last);
 #else
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const WIN32_FIND_DATAW *ffd);
@@ -113,10 +176,30 @@ static int is_in_list(FileView *view, const dir_entry_t *entry, void *arg);
 static void load_dir_list_internal(FileView *view, int reload, int draw_only);
 static int populate_dir_list_internal(FileView *view, int reload);
 static int update_dir_watcher(FileView *view);
+static void record_watch_change(const char name[], FSWatchEvent event,
+		void *arg);
+static void reset_watch_changes(FileView *view);
+static int watch_changes_applicable(const FileView *view);
+static int apply_watch_changes(FileView *view);
+static void insert_entry_sorted(FileView *view, dir_entry_t *entry);
 static int custom_list_is_incomplete(const FileView *view);
 static int is_dead_or_filtered(FileView *view, const dir_entry_t *entry,
 		void *arg);
 static void update_entries_data(FileView *view);
+static void revalidate_custom_entries(FileView *view);
+static int compare_origins(const void *a, const void *b);
+static int group_by_origin(dir_entry_t *order[], int count,
+		dir_group_t groups[]);
+static void stat_dirs(void *arg, int first, int last);
+static int dir_is_unchanged(const FileView *view, const dir_group_t *group);
+static void revalidate_entries(void *arg, int first, int last);
+static void save_dirs(FileView *view, const dir_group_t groups[], int ngroups,
+		dir_entry_t *order[], const char dead[], time_t start);
+static void free_cv_dirs(FileView *view);
+static int is_alive(FileView *view, const dir_entry_t *entry, void *arg);
+static void run_in_parallel(chunk_func func, void *arg, int count, int chunk,
+		int nthreads);
+static void * par_job_thread(void *arg);
 static int is_dir_big(const char path[]);
 static void free_view_entries(FileView *view);
 static int update_dir_list(FileView *view, int reload);
@@ -133,6 +216,10 @@ static int rescue_from_empty_filelist(FileView *view);
 static void init_dir_entry(FileView *view, dir_entry_t *entry,
 		const char name[]);
 static void free_dir_entries(FileView *view, dir_entry_t **entries, int *count);
+static char * copy_entry_str(FileView *view, const char str[], int in_pool,
+		int intern, int *pooled);
+static void free_entry_str(char str[], int pooled);
+static strpool_t * get_strings(FileView *view);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
 static int file_can_be_displayed(const char directory[], const char filename[]);
 TSTATIC void pick_cd_path(FileView *view, const char base_dir[],
@@ -144,6 +231,13 @@ static int iter_entries(FileView *view, dir_entry_t **entry,
 static int is_entry_selected(const dir_entry_t *entry);
 static int is_entry_marked(const dir_entry_t *entry);
 static void clear_marking(FileView *view);
+static int find_by_name(const FileView *view, const char name[],
+		entry_matcher matcher, const void *arg);
+static int ensure_name_index(FileView *view);
+static unsigned int hash_name(const char name[]);
+static int origin_matches(const dir_entry_t *entry, const void *arg);
+static int path_matches(const dir_entry_t *entry, const void *arg);
+static int is_watchable(const FileView *view);
 
 void
 init_filelists(void)
@@ -186,6 +280,8 @@ init_flist(FileView *view)
 	view->custom.entry_count = 0;
 	view->custom.orig_dir = NULL;
 	view->custom.title = NULL;
+	view->custom.dirs = NULL;
+	view->custom.dir_count = 0;
 
 	/* Load fake empty element to make dir_entry valid. */
 	view->dir_entry = dynarray_extend(NULL, sizeof(dir_entry_t));
@@ -297,22 +393,140 @@ find_file_pos_in_list(const FileView *const view, const char file[])
 int
 flist_find_entry(const FileView *view, const char file[], const char dir[])
 {
-	int i;
-	for(i = 0; i < view->list_rows; ++i)
+	return find_by_name(view, file, &origin_matches, dir);
+}
+
+/* Implements entry_matcher for flist_find_entry().  arg is NULL or directory
+ * the entry should be in.  Returns non-zero on match. */
+static int
+origin_matches(const dir_entry_t *entry, const void *arg)
+{
+	const char *const dir = arg;
+	return dir == NULL || stroscmp(entry->origin, dir) == 0;
+}
+
+/* Finds first entry of the view with the name that also satisfies the matcher.
+ * Returns position of the entry or -1 if there is none. */
+static int
+find_by_name(const FileView *view, const char name[], entry_matcher matcher,
+		const void *arg)
+{
+	unsigned int hash, mask, i;
+	const struct name_slot_t *slots;
+
+	/* Index is a cache, updating it doesn't change observable state of the
+	 * view. */
+	if(ensure_name_index((FileView *)view) != 0)
 	{
-		if(dir != NULL && stroscmp(view->dir_entry[i].origin, dir) != 0)
+		int pos;
+		for(pos = 0; pos < view->list_rows; ++pos)
 		{
-			continue;
+			const dir_entry_t *const entry = &view->dir_entry[pos];
+			if(stroscmp(entry->name, name) == 0 && matcher(entry, arg))
+			{
+				return pos;
+			}
 		}
+		return -1;
+	}
+
+	hash = hash_name(name);
+	mask = view->name_index.size - 1;
+	slots = view->name_index.slots;
 
-		if(stroscmp(view->dir_entry[i].name, file) == 0)
+	/* Entries with equal names are placed into consecutive slots in the order of
+	 * their positions, so the first match is the first entry in the list. */
+	for(i = hash & mask; slots[i].pos != 0; i = (i + 1) & mask)
+	{
+		const dir_entry_t *const entry = &view->dir_entry[slots[i].pos - 1];
+		if(slots[i].hash == hash && stroscmp(entry->name, name) == 0 &&
+				matcher(entry, arg))
 		{
-			return i;
+			return slots[i].pos - 1;
 		}
 	}
 	return -1;
 }
 
+/* (Re)builds name index of the view if it's out of date.  Returns zero on
+ * success and non-zero if index is unavailable. */
+static int
+ensure_name_index(FileView *view)
+{
+	int size;
+	int i;
+	struct name_slot_t *slots;
+
+	if(view->name_index.slots != NULL &&
+			view->name_index.entries == view->dir_entry &&
+			view->name_index.count == view->list_rows)
+	{
+		return 0;
+	}
+
+	/* Keep load factor at or below one half to have short probe sequences. */
+	size = 16;
+	while(size/2 < view->list_rows)
+	{
+		size *= 2;
+	}
+
+	slots = view->name_index.slots;
+	if(size != view->name_index.size)
+	{
+		slots = reallocarray(slots, size, sizeof(*slots));
+		if(slots == NULL)
+		{
+			flist_invalidate_index(view);
+			return 1;
+		}
+	}
+	memset(slots, 0, size*sizeof(*slots));
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		const unsigned int hash = hash_name(view->dir_entry[i].name);
+		unsigned int j = hash & (size - 1);
+		while(slots[j].pos != 0)
+		{
+			j = (j + 1) & (size - 1);
+		}
+		slots[j].pos = i + 1;
+		slots[j].hash = hash;
+	}
+
+	view->name_index.slots = slots;
+	view->name_index.size = size;
+	view->name_index.entries = view->dir_entry;
+	view->name_index.count = view->list_rows;
+	return 0;
+}
+
+/* Computes FNV-1a hash of the name in a way that agrees with stroscmp().
+ * Returns the hash. */
+static unsigned int
+hash_name(const char name[])
+{
+	unsigned int hash = 2166136261U;
+	while(*name != '\0')
+	{
+#ifndef _WIN32
+		hash ^= (unsigned char)*name++;
+#else
+		hash ^= (unsigned char)tolower((unsigned char)*name++);
+#endif
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+void
+flist_invalidate_index(FileView *view)
+{
+	view->name_index.entries = NULL;
+	view->name_index.count = -1;
+}
+
 void
 invert_sorting_order(FileView *view)
 {
@@ -933,7 +1147,7 @@ navigate_to_file_in_custom_view(FileView *view, const char dir[],
 		}
 	}
 
-	entry = entry_from_path(view->dir_entry, view->list_rows, full_path);
+	entry = flist_entry_from_path(view, full_path);
 	if(entry == NULL)
 	{
 		/* File might not exist anymore at that location. */
@@ -1249,6 +1463,7 @@ void
 flist_custom_start(FileView *view, const char title[])
 {
 	free_dir_entries(view, &view->custom.entries, &view->custom.entry_count);
+	free_cv_dirs(view);
 	(void)replace_string(&view->custom.title, title);
 
 	view->custom.paths_cache = trie_create();
@@ -1279,10 +1494,19 @@ flist_custom_add(FileView *view, const char path[])
 
 	init_dir_entry(view, dir_entry, get_last_path_component(canonic_path));
 
-	dir_entry->origin = strdup(canonic_path);
-	remove_last_path_component(dir_entry->origin);
+	/* Files of custom views tend to come from a small number of directories, so
+	 * all entries share one copy of each of them. */
+	{
+		char origin[PATH_MAX];
+		int pooled;
+		copy_str(origin, sizeof(origin), canonic_path);
+		remove_last_path_component(origin);
+		dir_entry->origin = copy_entry_str(view, origin, 0, 1, &pooled);
+		dir_entry->origin_pooled = pooled;
+	}
 
-	if(fill_dir_entry_by_path(dir_entry, canonic_path) != 0)
+	if(dir_entry->name == NULL || dir_entry->origin == NULL ||
+			fill_dir_entry_by_path(dir_entry, canonic_path) != 0)
 	{
 		free_dir_entry(view, dir_entry);
 		return;
@@ -1306,25 +1530,46 @@ fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
  * non-zero is returned. */
 static int
 fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
+{
+	const FileType hint = (d == NULL) ? FT_UNK : type_from_dir_entry(d);
+	const int error = lstat_dir_entry(entry, path, hint);
+	if(error != 0)
+	{
+		log_lstat_error(path, error);
+		return 1;
+	}
+
+	if(entry->type == FT_LINK)
+	{
+		query_link_target_mode(entry, path);
+	}
+	return 0;
+}
+
+/* Fills fields of the entry from lstat() information of the file specified by
+ * its path.  hint is type of the file to use when it can't be deduced from
+ * file mode.  This function is thread-safe, so it doesn't log errors, see
+ * log_lstat_error().  Returns zero on success, errno value if lstat() failed
+ * and -1 if type of the file is unknown. */
+static int
+lstat_dir_entry(dir_entry_t *entry, const char path[], FileType hint)
 {
 	struct stat s;
 
 	/* Load the inode information or leave blank values in the entry. */
 	if(os_lstat(path, &s) != 0)
 	{
-		LOG_SERROR_MSG(errno, "Can't lstat() \"%s\"", path);
-		return 1;
+		return (errno == 0) ? -1 : errno;
 	}
 
 	entry->type = get_type_from_mode(s.st_mode);
 	if(entry->type == FT_UNK)
 	{
-		entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d);
+		entry->type = hint;
 	}
 	if(entry->type == FT_UNK)
 	{
-		LOG_ERROR_MSG("Can't determine type of \"%s\"", path);
-		return 1;
+		return -1;
 	}
 
 	entry->size = (uintmax_t)s.st_size;
@@ -1335,20 +1580,45 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 	entry->atime = s.st_atime;
 	entry->ctime = s.st_ctime;
 
-	if(entry->type == FT_LINK)
+	return 0;
+}
+
+/* Logs error returned by lstat_dir_entry() for the path.  Must be called from
+ * the main thread. */
+static void
+log_lstat_error(const char path[], int error)
+{
+	if(error > 0)
+	{
+		LOG_SERROR_MSG(error, "Can't lstat() \"%s\"", path);
+	}
+	else
 	{
-		/* Query mode of symbolic link target. */
+		LOG_ERROR_MSG("Can't determine type of \"%s\"", path);
+	}
+}
 
-		struct stat s;
+/* Queries mode and status of symbolic link target specified by the path and
+ * stores them in the entry. */
+static void
+query_link_target_mode(dir_entry_t *entry, const char path[])
+{
+	struct stat s;
 
-		const SymLinkType symlink_type = get_symlink_type(entry->name);
-		if(symlink_type != SLT_SLOW && os_stat(entry->name, &s) == 0)
-		{
-			entry->mode = s.st_mode;
-		}
+	const SymLinkType symlink_type = get_symlink_type(path);
+	if(symlink_type == SLT_SLOW)
+	{
+		entry->link_status = LS_SLOW;
+	}
+	else if(os_stat(path, &s) == 0)
+	{
+		entry->mode = s.st_mode;
+		entry->link_status = S_ISDIR(s.st_mode) ? LS_DIR : LS_FILE;
+	}
+	else
+	{
+		entry->link_status = LS_BROKEN;
 	}
-
-	return 0;
 }
 
 /* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
@@ -1359,6 +1629,72 @@ data_is_dir_entry(const struct dirent *d)
 	return is_dirent_targets_dir(d);
 }
 
+/* Queries information about files of the view using at most nthreads threads
+ * (including current one).  Entries are expected to have file type hints
+ * stored in their type field.  Entries for which the query fails are removed
+ * from the list. */
+static void
+fill_entries_in_parallel(FileView *view, int nthreads)
+{
+	stat_job_t job = {
+		.entries = view->dir_entry,
+		.errors = calloc(view->list_rows, sizeof(*job.errors)),
+	};
+	int i, j;
+
+	if(job.errors != NULL)
+	{
+		run_in_parallel(&stat_entries, &job, view->list_rows, 64, nthreads);
+	}
+
+	/* Information about symbolic links is queried sequentially as it involves
+	 * functions that aren't thread-safe. */
+	j = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+
+		const int error = (job.errors == NULL)
+		                ? lstat_dir_entry(entry, entry->name, entry->type)
+		                : job.errors[i];
+		if(error != 0)
+		{
+			log_lstat_error(entry->name, error);
+			free_dir_entry(view, entry);
+			continue;
+		}
+
+		if(entry->type == FT_LINK)
+		{
+			query_link_target_mode(entry, entry->name);
+		}
+
+		if(i != j)
+		{
+			view->dir_entry[j] = view->dir_entry[i];
+		}
+		++j;
+	}
+	view->list_rows = j;
+
+	free(job.errors);
+}
+
+/* Queries information about files in range [first, last) of entries of the
+ * stat_job_t. */
+static void
+stat_entries(void *arg, int first, int last)
+{
+	stat_job_t *const job = arg;
+	int i;
+
+	for(i = first; i < last; ++i)
+	{
+		dir_entry_t *const entry = &job->entries[i];
+		job->errors[i] = lstat_dir_entry(entry, entry->name, entry->type);
+	}
+}
+
 #else
 
 /* Fills directory entry with information about file specified by the path.
@@ -1473,6 +1809,7 @@ flist_custom_finish(FileView *view, int very)
 	view->custom.entries = NULL;
 	view->custom.entry_count = 0;
 	view->dir_entry = dynarray_shrink(view->dir_entry);
+	flist_invalidate_index(view);
 
 	/* view->custom.unsorted must be set before load_sort_option() so that it
 	 * skips sort array normalization. */
@@ -1564,7 +1901,7 @@ flist_goto_by_path(FileView *view, const char path[])
 		return;
 	}
 
-	entry = entry_from_path(view->dir_entry, view->list_rows, path);
+	entry = flist_entry_from_path(view, path);
 	if(entry != NULL)
 	{
 		view->list_pos = entry_to_pos(view, entry);
@@ -1604,6 +1941,32 @@ entry_from_path(dir_entry_t *entries, int count, const char path[])
 	return NULL;
 }
 
+dir_entry_t *
+flist_entry_from_path(const FileView *view, const char path[])
+{
+	char canonic_path[PATH_MAX];
+	int pos;
+
+	if(to_canonic_path(path, canonic_path, sizeof(canonic_path)) != 0)
+	{
+		return NULL;
+	}
+
+	pos = find_by_name(view, get_last_path_component(canonic_path),
+			&path_matches, canonic_path);
+	return (pos < 0) ? NULL : &view->dir_entry[pos];
+}
+
+/* Implements entry_matcher for flist_entry_from_path().  arg is canonicalized
+ * path.  Returns non-zero on match. */
+static int
+path_matches(const dir_entry_t *entry, const void *arg)
+{
+	char full_path[PATH_MAX];
+	get_full_path_of(entry, sizeof(full_path), full_path);
+	return stroscmp(full_path, arg) == 0;
+}
+
 void
 populate_dir_list(FileView *view, int reload)
 {
@@ -1652,6 +2015,9 @@ load_dir_list_internal(FileView *view, int reload, int draw_only)
 static int
 populate_dir_list_internal(FileView *view, int reload)
 {
+	/* Patching list in place needs to know how many files are hidden. */
+	const int prev_filtered = view->filtered;
+
 	view->filtered = 0;
 
 	if(flist_custom_active(view))
@@ -1663,9 +2029,7 @@ populate_dir_list_internal(FileView *view, int reload)
 					view->custom.entries, view->custom.entry_count);
 		}
 
-		(void)zap_entries(view, view->dir_entry, &view->list_rows,
-				&is_dead_or_filtered, NULL, 0);
-		update_entries_data(view);
+		revalidate_custom_entries(view);
 		sort_dir_list(!reload, view);
 		fview_list_updated(view);
 		return 0;
@@ -1691,6 +2055,20 @@ populate_dir_list_internal(FileView *view, int reload)
 		return 1;
 	}
 
+	/* Reload caused only by changes reported by directory watcher doesn't need
+	 * to re-read whole directory. */
+	if(reload && watch_changes_applicable(view))
+	{
+		view->filtered = prev_filtered;
+		if(apply_watch_changes(view) == 0)
+		{
+			view->column_count = calculate_columns_count(view);
+			fview_list_updated(view);
+			return 0;
+		}
+		view->filtered = 0;
+	}
+
 	if(update_dir_list(view, reload) != 0)
 	{
 		/* We don't have read access, only execute, or there were other problems. */
@@ -1750,6 +2128,8 @@ update_dir_watcher(FileView *view)
 			fswatch_free(view->watch);
 		}
 
+		reset_watch_changes(view);
+
 		view->watch = fswatch_create(curr_dir);
 		if(view->watch == NULL)
 		{
@@ -1766,79 +2146,737 @@ update_dir_watcher(FileView *view)
 	return error;
 }
 
-/* Checks whether currently loaded custom list of files is missing some files
- * compared to the original custom list.  Returns non-zero if so, otherwise zero
- * is returned. */
-static int
-custom_list_is_incomplete(const FileView *view)
+/* fswatch_poll() callback that remembers names of changed entries. */
+static void
+record_watch_change(const char name[], FSWatchEvent event, void *arg)
 {
-	if(view->custom.entry_count == 0)
+	/* Number of changes after which re-reading whole directory is preferred. */
+	enum { MAX_WATCH_CHANGES = 1024 };
+
+	FileView *const view = arg;
+	char *existed;
+
+	if(view->watch_changes.overflow)
 	{
-		return 0;
+		return;
 	}
 
-	if(view->list_rows == 1 && is_parent_dir(view->dir_entry[0].name) &&
-			!(view->custom.entry_count == 1 &&
-				is_parent_dir(view->custom.entries[0].name)))
+	if(view->watch_changes.set == NULL_TRIE)
 	{
-		return 1;
+		view->watch_changes.set = trie_create();
+		if(view->watch_changes.set == NULL_TRIE)
+		{
+			view->watch_changes.overflow = 1;
+			return;
+		}
 	}
 
-	return view->list_rows != view->custom.entry_count;
-}
+	/* Only the first change of an entry tells whether it existed before. */
+	if(trie_put(view->watch_changes.set, name) != 0)
+	{
+		return;
+	}
 
-/* zap_entries() filter to filter-out inexistent files or files which names
- * match local filter. */
-static int
-is_dead_or_filtered(FileView *view, const dir_entry_t *entry, void *arg)
-{
-	if(!path_exists_at(entry->origin, entry->name, NODEREF))
+	if(view->watch_changes.count >= MAX_WATCH_CHANGES)
 	{
-		return 0;
+		view->watch_changes.overflow = 1;
+		return;
 	}
 
-	if(local_filter_matches(view, entry))
+	existed = reallocarray(view->watch_changes.existed,
+			view->watch_changes.count + 1, sizeof(*existed));
+	if(existed == NULL)
 	{
-		return 1;
+		view->watch_changes.overflow = 1;
+		return;
 	}
+	view->watch_changes.existed = existed;
 
-	++view->filtered;
-	return 0;
+	if(add_to_string_array(&view->watch_changes.names, view->watch_changes.count,
+				1, name) == view->watch_changes.count)
+	{
+		view->watch_changes.overflow = 1;
+		return;
+	}
+
+	existed[view->watch_changes.count++] = (event != FSWE_CREATED &&
+			event != FSWE_MOVED_TO);
 }
 
-/* Re-read meta-data for each entry (does nothing for entries on which querying
- * fails). */
+/* Forgets about all changes collected by the directory watcher. */
 static void
-update_entries_data(FileView *view)
+reset_watch_changes(FileView *view)
+{
+	free_string_array(view->watch_changes.names, view->watch_changes.count);
+	view->watch_changes.names = NULL;
+	free(view->watch_changes.existed);
+	view->watch_changes.existed = NULL;
+	view->watch_changes.count = 0;
+	trie_free(view->watch_changes.set);
+	view->watch_changes.set = NULL_TRIE;
+	view->watch_changes.stamp = 0U;
+	view->watch_changes.overflow = 0;
+}
+
+/* Checks whether reload which is being performed can be done by applying
+ * changes collected by the directory watcher.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+watch_changes_applicable(const FileView *view)
 {
-	int i;
-	for(i = 0; i < view->list_rows; ++i)
-	{
-		dir_entry_t *const entry = &view->dir_entry[i];
-
-		char full_path[PATH_MAX];
-		get_full_path_of(entry, sizeof(full_path), full_path);
-
-		/* Do not care about possible failure, just use previous meta-data. */
-		(void)fill_dir_entry_by_path(entry, full_path);
-	}
+	/* Any other reload request issued after the watcher's one might require
+	 * full reload. */
+	return view->watch_changes.count != 0
+	    && !view->watch_changes.overflow
+	    && view->watch_changes.stamp == view->last_reload
+	    && view->watch_changes.stamp == view->postponed_reload;
 }
 
-int
-zap_entries(FileView *view, dir_entry_t *entries, int *count, zap_filter filter,
-		void *arg, int allow_empty_list)
-{
+/* Updates list of files by re-reading only entries reported as changed by
+ * directory watcher.  Returns zero on success, otherwise non-zero is returned
+ * and full reload is needed. */
+static int
+apply_watch_changes(FileView *view)
+{
+	char **const names = view->watch_changes.names;
+	const int count = view->watch_changes.count;
+	dir_entry_t *prev_entries;
+	char *found;
+	char *cursor_name = NULL;
+	trie_t positions;
 	int i, j;
 
-	j = 0;
-	for(i = 0; i < *count; ++i)
+	/* Lonely ".." might be shown just because the list was empty. */
+	if(view->list_rows == 1 && is_parent_dir(view->dir_entry[0].name) &&
+			!cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)))
 	{
-		dir_entry_t *const entry = &entries[i];
-		if(!filter(view, entry, arg))
-		{
-			free_dir_entry(view, entry);
-			continue;
-		}
+		return 1;
+	}
+
+	positions = trie_create();
+	prev_entries = calloc(count, sizeof(*prev_entries));
+	found = calloc(count, sizeof(*found));
+	if(positions == NULL_TRIE || prev_entries == NULL || found == NULL)
+	{
+		trie_free(positions);
+		free(prev_entries);
+		free(found);
+		return 1;
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		(void)trie_set(positions, names[i], &names[i]);
+	}
+
+	if(view->list_pos < view->list_rows)
+	{
+		cursor_name = strdup(view->dir_entry[view->list_pos].name);
+	}
+
+	/* Take changed entries out of the list. */
+	j = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		void *data;
+		dir_entry_t *const entry = &view->dir_entry[i];
+
+		if(trie_get(positions, entry->name, &data) == 0)
+		{
+			const int pos = (char **)data - names;
+			prev_entries[pos] = *entry;
+			found[pos] = 1;
+
+			view->selected_files -= (entry->selected != 0);
+			view->matches -= (entry->search_match != 0);
+			continue;
+		}
+
+		if(i != j)
+		{
+			view->dir_entry[j] = view->dir_entry[i];
+		}
+		++j;
+	}
+	view->list_rows = j;
+
+	/* And put their current state back. */
+	for(i = 0; i < count; ++i)
+	{
+		dir_entry_t entry;
+		const int was_filtered = view->watch_changes.existed[i] && !found[i];
+		int is_visible;
+
+		init_dir_entry(view, &entry, names[i]);
+		if(entry.name == NULL || fill_dir_entry_by_path(&entry, entry.name) != 0)
+		{
+			/* The file is gone. */
+			view->filtered -= was_filtered;
+			free_dir_entry(view, &entry);
+			if(found[i])
+			{
+				free_dir_entry(view, &prev_entries[i]);
+			}
+			continue;
+		}
+
+		is_visible = !(view->hide_dot && entry.name[0] == '.')
+		          && file_is_visible(view, entry.name, is_directory_entry(&entry));
+		view->filtered += !is_visible - was_filtered;
+
+		if(found[i])
+		{
+			merge_entries(&entry, &prev_entries[i]);
+			entry.search_match = prev_entries[i].search_match;
+			entry.match_left = prev_entries[i].match_left;
+			entry.match_right = prev_entries[i].match_right;
+			free_dir_entry(view, &prev_entries[i]);
+		}
+
+		if(!is_visible)
+		{
+			free_dir_entry(view, &entry);
+			continue;
+		}
+
+		view->selected_files += (entry.selected != 0);
+		view->matches += (entry.search_match != 0);
+		insert_entry_sorted(view, &entry);
+	}
+
+	trie_free(positions);
+	free(prev_entries);
+	free(found);
+	reset_watch_changes(view);
+
+	/* Entries were moved around without changing their number. */
+	flist_invalidate_index(view);
+
+	if(view->list_rows == 0)
+	{
+		add_parent_dir(view);
+	}
+
+	/* Keep cursor on the same file if it's still there. */
+	if(cursor_name != NULL)
+	{
+		const int pos = find_file_pos_in_list(view, cursor_name);
+		if(pos >= 0)
+		{
+			view->list_pos = pos;
+		}
+		free(cursor_name);
+	}
+	flist_ensure_pos_is_valid(view);
+
+	return 0;
+}
+
+/* Inserts the entry into list of files of the view keeping the list sorted.
+ * On failure entry is freed. */
+static void
+insert_entry_sorted(FileView *view, dir_entry_t *entry)
+{
+	int lo = 0, hi = view->list_rows;
+	dir_entry_t *const new_entry = alloc_dir_entry(&view->dir_entry,
+			view->list_rows);
+	if(new_entry == NULL)
+	{
+		free_dir_entry(view, entry);
+		return;
+	}
+
+	/* Unsorted list gets new entries appended. */
+	if(view->sort[0] > SK_LAST)
+	{
+		lo = view->list_rows;
+	}
+
+	/* Look for the position after all entries that are not greater. */
+	while(lo < hi)
+	{
+		const int mid = lo + (hi - lo)/2;
+		if(sort_compare_entries(view, entry, &view->dir_entry[mid]) < 0)
+		{
+			hi = mid;
+		}
+		else
+		{
+			lo = mid + 1;
+		}
+	}
+
+	memmove(&view->dir_entry[lo + 1], &view->dir_entry[lo],
+			sizeof(*view->dir_entry)*(view->list_rows - lo));
+	view->dir_entry[lo] = *entry;
+	++view->list_rows;
+}
+
+/* Checks whether currently loaded custom list of files is missing some files
+ * compared to the original custom list.  Returns non-zero if so, otherwise zero
+ * is returned. */
+static int
+custom_list_is_incomplete(const FileView *view)
+{
+	if(view->custom.entry_count == 0)
+	{
+		return 0;
+	}
+
+	if(view->list_rows == 1 && is_parent_dir(view->dir_entry[0].name) &&
+			!(view->custom.entry_count == 1 &&
+				is_parent_dir(view->custom.entries[0].name)))
+	{
+		return 1;
+	}
+
+	return view->list_rows != view->custom.entry_count;
+}
+
+/* zap_entries() filter to filter-out inexistent files or files which names
+ * match local filter. */
+static int
+is_dead_or_filtered(FileView *view, const dir_entry_t *entry, void *arg)
+{
+	if(!path_exists_at(entry->origin, entry->name, NODEREF))
+	{
+		return 0;
+	}
+
+	if(local_filter_matches(view, entry))
+	{
+		return 1;
+	}
+
+	++view->filtered;
+	return 0;
+}
+
+/* Re-read meta-data for each entry (does nothing for entries on which querying
+ * fails). */
+static void
+update_entries_data(FileView *view)
+{
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+
+		char full_path[PATH_MAX];
+		get_full_path_of(entry, sizeof(full_path), full_path);
+
+		/* Do not care about possible failure, just use previous meta-data. */
+		(void)fill_dir_entry_by_path(entry, full_path);
+	}
+}
+
+/* Checks whether files of custom view still exist and re-reads their meta-data
+ * using at most 'statthreads' threads.  Entries are processed grouped by their
+ * directories.  With 'cvquickreload' files of directories that didn't change
+ * since the previous check are skipped.  Removes entries of inexistent and
+ * filtered out files. */
+static void
+revalidate_custom_entries(FileView *view)
+{
+	/* Size of a chunk of directories to stat.  Small to make checks of few
+	 * directories on slow file systems parallel. */
+	enum { DIRS_CHUNK = 4 };
+	/* Size of a chunk of entries to check. */
+	enum { ENTRIES_CHUNK = 64 };
+
+	const int count = view->list_rows;
+	const time_t start = time(NULL);
+	dir_entry_t **order;
+	dir_group_t *groups;
+	revalidate_job_t job;
+	int ngroups;
+	int ntodo;
+	int i;
+
+	order = reallocarray(NULL, count, sizeof(*order));
+	groups = reallocarray(NULL, count, sizeof(*groups));
+	job.entries = view->dir_entry;
+	job.todo = reallocarray(NULL, count, sizeof(*job.todo));
+	job.dead = calloc(count, sizeof(*job.dead));
+	if(order == NULL || groups == NULL || job.todo == NULL || job.dead == NULL)
+	{
+		free(order);
+		free(groups);
+		free(job.todo);
+		free(job.dead);
+
+		(void)zap_entries(view, view->dir_entry, &view->list_rows,
+				&is_dead_or_filtered, NULL, 0);
+		update_entries_data(view);
+		return;
+	}
+
+	/* Order entries by their directories to check each directory once and to
+	 * access file system in a friendlier way. */
+	for(i = 0; i < count; ++i)
+	{
+		order[i] = &view->dir_entry[i];
+	}
+	qsort(order, count, sizeof(*order), &compare_origins);
+	ngroups = group_by_origin(order, count, groups);
+
+	if(cfg.cv_quick_reload)
+	{
+		run_in_parallel(&stat_dirs, groups, ngroups, DIRS_CHUNK, cfg.stat_threads);
+	}
+
+	ntodo = 0;
+	for(i = 0; i < ngroups; ++i)
+	{
+		const dir_group_t *const group = &groups[i];
+		if(!cfg.cv_quick_reload || !dir_is_unchanged(view, group))
+		{
+			memcpy(&job.todo[ntodo], &order[group->first],
+					group->count*sizeof(*job.todo));
+			ntodo += group->count;
+		}
+	}
+
+	run_in_parallel(&revalidate_entries, &job, ntodo, ENTRIES_CHUNK,
+			cfg.stat_threads);
+
+#ifndef _WIN32
+	/* Information about symbolic links is queried sequentially as it involves
+	 * functions that aren't thread-safe. */
+	for(i = 0; i < ntodo; ++i)
+	{
+		dir_entry_t *const entry = job.todo[i];
+		if(entry->type == FT_LINK && !job.dead[entry - view->dir_entry])
+		{
+			char full_path[PATH_MAX];
+			get_full_path_of(entry, sizeof(full_path), full_path);
+			query_link_target_mode(entry, full_path);
+		}
+	}
+#endif
+
+	for(i = 0; i < count; ++i)
+	{
+		if(!job.dead[i] && !local_filter_matches(view, &view->dir_entry[i]))
+		{
+			job.dead[i] = 1;
+			++view->filtered;
+		}
+	}
+
+	if(cfg.cv_quick_reload)
+	{
+		save_dirs(view, groups, ngroups, order, job.dead, start);
+	}
+	else
+	{
+		free_cv_dirs(view);
+	}
+
+	(void)zap_entries(view, view->dir_entry, &view->list_rows, &is_alive,
+			job.dead, 0);
+
+	free(order);
+	free(groups);
+	free(job.todo);
+	free(job.dead);
+}
+
+/* qsort() comparer that orders pointers to entries by origins of entries
+ * keeping relative order of entries with the same origin.  Returns standard
+ * -1, 0, 1 for comparisons. */
+static int
+compare_origins(const void *a, const void *b)
+{
+	const dir_entry_t *const x = *(dir_entry_t *const *)a;
+	const dir_entry_t *const y = *(dir_entry_t *const *)b;
+
+	/* Interned origins are often the same string. */
+	if(x->origin != y->origin)
+	{
+		const int cmp = strcmp(x->origin, y->origin);
+		if(cmp != 0)
+		{
+			return cmp;
+		}
+	}
+
+	return (x < y) ? -1 : (x > y);
+}
+
+/* Splits entries ordered by origins into groups by their origins.  Returns
+ * number of groups. */
+static int
+group_by_origin(dir_entry_t *order[], int count, dir_group_t groups[])
+{
+	int ngroups = 0;
+	int i;
+
+	for(i = 0; i < count; ++i)
+	{
+		const char *const origin = order[i]->origin;
+
+		if(ngroups != 0 && (groups[ngroups - 1].path == origin ||
+					strcmp(groups[ngroups - 1].path, origin) == 0))
+		{
+			++groups[ngroups - 1].count;
+			continue;
+		}
+
+		groups[ngroups].path = origin;
+		groups[ngroups].first = i;
+		groups[ngroups].count = 1;
+		groups[ngroups].mtime = (time_t)-1;
+		++ngroups;
+	}
+
+	return ngroups;
+}
+
+/* Queries modification times of directories in range [first, last) of an
+ * array of dir_group_t. */
+static void
+stat_dirs(void *arg, int first, int last)
+{
+	dir_group_t *const groups = arg;
+	int i;
+
+	for(i = first; i < last; ++i)
+	{
+		struct stat s;
+		if(os_stat(groups[i].path, &s) == 0)
+		{
+			groups[i].mtime = s.st_mtime;
+		}
+	}
+}
+
+/* Checks whether directory of the group and set of its entries are the same as
+ * they were during the previous check.  Returns non-zero if so, otherwise zero
+ * is returned. */
+static int
+dir_is_unchanged(const FileView *view, const dir_group_t *group)
+{
+	int l = 0, u = view->custom.dir_count - 1;
+
+	if(group->mtime == (time_t)-1)
+	{
+		return 0;
+	}
+
+	while(l <= u)
+	{
+		const int m = l + (u - l)/2;
+		const cv_dir_t *const dir = &view->custom.dirs[m];
+		const int cmp = strcmp(dir->path, group->path);
+		if(cmp == 0)
+		{
+			return dir->mtime == group->mtime && dir->entry_count == group->count;
+		}
+
+		if(cmp < 0)
+		{
+			l = m + 1;
+		}
+		else
+		{
+			u = m - 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Checks existence and re-reads meta-data of entries in range [first, last) of
+ * todo list of revalidate_job_t. */
+static void
+revalidate_entries(void *arg, int first, int last)
+{
+	revalidate_job_t *const job = arg;
+	int i;
+
+	for(i = first; i < last; ++i)
+	{
+		dir_entry_t *const entry = job->todo[i];
+
+		char full_path[PATH_MAX];
+		get_full_path_of(entry, sizeof(full_path), full_path);
+
+#ifndef _WIN32
+		if(lstat_dir_entry(entry, full_path, entry->type) != 0)
+#else
+		if(fill_dir_entry_by_path(entry, full_path) != 0)
+#endif
+		{
+			/* Failure to query information about the file doesn't necessarily mean
+			 * that it doesn't exist, keep previous meta-data in such cases. */
+			job->dead[entry - job->entries] =
+				!path_exists_at(entry->origin, entry->name, NODEREF);
+		}
+	}
+}
+
+/* Remembers modification times of directories along with number of entries
+ * that remain in them to be able to skip the directories on the next check.
+ * Directories modified after the check has started aren't remembered. */
+static void
+save_dirs(FileView *view, const dir_group_t groups[], int ngroups,
+		dir_entry_t *order[], const char dead[], time_t start)
+{
+	int i;
+
+	free_cv_dirs(view);
+
+	view->custom.dirs = reallocarray(NULL, ngroups, sizeof(*view->custom.dirs));
+	if(view->custom.dirs == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < ngroups; ++i)
+	{
+		const dir_group_t *const group = &groups[i];
+		cv_dir_t *const dir = &view->custom.dirs[view->custom.dir_count];
+		int j;
+
+		/* Modification time has granularity of a second, so changes made during
+		 * the second in which the check started might have been missed. */
+		if(group->mtime == (time_t)-1 || group->mtime >= start)
+		{
+			continue;
+		}
+
+		dir->path = strdup(group->path);
+		if(dir->path == NULL)
+		{
+			continue;
+		}
+
+		dir->mtime = group->mtime;
+		dir->entry_count = 0;
+		for(j = group->first; j < group->first + group->count; ++j)
+		{
+			dir->entry_count += !dead[order[j] - view->dir_entry];
+		}
+
+		++view->custom.dir_count;
+	}
+}
+
+/* Frees information about directories of custom view. */
+static void
+free_cv_dirs(FileView *view)
+{
+	int i;
+	for(i = 0; i < view->custom.dir_count; ++i)
+	{
+		free(view->custom.dirs[i].path);
+	}
+	free(view->custom.dirs);
+	view->custom.dirs = NULL;
+	view->custom.dir_count = 0;
+}
+
+/* zap_entries() filter to filter-out entries marked as dead in array passed in
+ * arg.  Returns non-zero if entry is to be kept and zero otherwise. */
+static int
+is_alive(FileView *view, const dir_entry_t *entry, void *arg)
+{
+	const char *const dead = arg;
+	return !dead[entry - view->dir_entry];
+}
+
+/* Calls the func for chunks of count items using at most nthreads threads
+ * (including current one). */
+static void
+run_in_parallel(chunk_func func, void *arg, int count, int chunk, int nthreads)
+{
+	par_job_t job = {
+		.func = func,
+		.arg = arg,
+		.count = count,
+		.chunk = chunk,
+		.next = 0,
+	};
+	pthread_t *threads;
+	int nstarted;
+	int i;
+
+	/* Don't bother creating threads for small jobs. */
+	nthreads = MIN(nthreads, 1 + count/(4*chunk));
+	if(nthreads <= 1 || pthread_mutex_init(&job.lock, NULL) != 0)
+	{
+		func(arg, 0, count);
+		return;
+	}
+
+	threads = reallocarray(NULL, nthreads - 1, sizeof(*threads));
+
+	nstarted = 0;
+	while(threads != NULL && nstarted < nthreads - 1)
+	{
+		if(pthread_create(&threads[nstarted], NULL, &par_job_thread, &job) != 0)
+		{
+			break;
+		}
+		++nstarted;
+	}
+
+	/* Current thread does its share of work as well. */
+	(void)par_job_thread(&job);
+
+	for(i = 0; i < nstarted; ++i)
+	{
+		(void)pthread_join(threads[i], NULL);
+	}
+	free(threads);
+
+	pthread_mutex_destroy(&job.lock);
+}
+
+/* Entry point of a thread that processes items of par_job_t.  Takes chunks of
+ * items until all of them are processed.  Returns NULL. */
+static void *
+par_job_thread(void *arg)
+{
+	par_job_t *const job = arg;
+
+	while(1)
+	{
+		int first, last;
+
+		pthread_mutex_lock(&job->lock);
+		first = job->next;
+		last = MIN(first + job->chunk, job->count);
+		job->next = last;
+		pthread_mutex_unlock(&job->lock);
+
+		if(first == last)
+		{
+			break;
+		}
+
+		job->func(job->arg, first, last);
+	}
+
+	return NULL;
+}
+
+int
+zap_entries(FileView *view, dir_entry_t *entries, int *count, zap_filter filter,
+		void *arg, int allow_empty_list)
+{
+	int i, j;
+
+	j = 0;
+	for(i = 0; i < *count; ++i)
+	{
+		dir_entry_t *const entry = &entries[i];
+		if(!filter(view, entry, arg))
+		{
+			free_dir_entry(view, entry);
+			continue;
+		}
 
 		if(i != j)
 		{
@@ -1850,6 +2888,11 @@ zap_entries(FileView *view, dir_entry_t *entries, int *count, zap_filter filter,
 
 	*count = j;
 
+	if(entries == view->dir_entry)
+	{
+		flist_invalidate_index(view);
+	}
+
 	if(*count == 0 && !allow_empty_list)
 	{
 		add_parent_dir(view);
@@ -1907,6 +2950,9 @@ update_dir_list(FileView *view, int reload)
 	view->matches = 0;
 	view->selected_files = 0;
 
+	/* Whole directory is read, so all pending changes will be accounted for. */
+	reset_watch_changes(view);
+
 #ifdef _WIN32
 	if(is_unc_root(view->curr_dir))
 	{
@@ -1923,6 +2969,13 @@ update_dir_list(FileView *view, int reload)
 		return 1;
 	}
 
+#ifndef _WIN32
+	if(cfg.stat_threads > 1)
+	{
+		fill_entries_in_parallel(view, cfg.stat_threads);
+	}
+#endif
+
 	if(cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)) ||
 			view->list_rows == 0)
 	{
@@ -1941,6 +2994,9 @@ update_dir_list(FileView *view, int reload)
 
 	view->dir_entry = dynarray_shrink(view->dir_entry);
 
+	/* New list might have been allocated at the address of the old one. */
+	flist_invalidate_index(view);
+
 	return 0;
 }
 
@@ -1979,6 +3035,17 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 
 	init_dir_entry(view, entry, name);
 
+#ifndef _WIN32
+	if(cfg.stat_threads > 1)
+	{
+		/* Information is queried later by fill_entries_in_parallel(), for now
+		 * just remember type hint. */
+		entry->type = type_from_dir_entry(data);
+		++view->list_rows;
+		return 0;
+	}
+#endif
+
 	if(fill_dir_entry(entry, entry->name, data) == 0)
 	{
 		++view->list_rows;
@@ -2042,7 +3109,9 @@ merge_lists(FileView *view, dir_entry_t *entries, int len)
 		add_to_trie(prev_names, view, &entries[i]);
 
 		/* We won't use the name later, so free some memory. */
-		update_string(&entries[i].name, NULL);
+		free_entry_str(entries[i].name, entries[i].name_pooled);
+		entries[i].name = NULL;
+		entries[i].name_pooled = 0;
 	}
 
 	closes_dist = INT_MIN;
@@ -2224,8 +3293,12 @@ add_parent_dir(FileView *view)
 static void
 init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 {
-	entry->name = strdup(name);
+	int pooled;
+
+	entry->name = copy_entry_str(view, name, 0, 0, &pooled);
+	entry->name_pooled = pooled;
 	entry->origin = &view->curr_dir[0];
+	entry->origin_pooled = 0;
 
 	entry->size = 0ULL;
 #ifndef _WIN32
@@ -2242,6 +3315,7 @@ init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 
 	entry->type = FT_UNK;
 	entry->hi_num = -1;
+	entry->link_status = LS_UNKNOWN;
 
 	/* All files start as unselected, unmatched and unmarked. */
 	entry->selected = 0;
@@ -2270,9 +3344,16 @@ replace_dir_entries(FileView *view, dir_entry_t **entries, int *count,
 	for(i = 0; i < with_count; ++i)
 	{
 		dir_entry_t *const entry = &new[i];
+		int pooled;
 
-		entry->name = strdup(entry->name);
-		entry->origin = strdup(entry->origin);
+		/* Strings that are already in a pool are shared instead of being
+		 * copied. */
+		entry->name = copy_entry_str(view, entry->name, entry->name_pooled, 0,
+				&pooled);
+		entry->name_pooled = pooled;
+		entry->origin = copy_entry_str(view, entry->origin, entry->origin_pooled, 1,
+				&pooled);
+		entry->origin_pooled = pooled;
 
 		if(entry->name == NULL || entry->origin == NULL)
 		{
@@ -2306,14 +3387,65 @@ free_dir_entries(FileView *view, dir_entry_t **entries, int *count)
 void
 free_dir_entry(const FileView *view, dir_entry_t *entry)
 {
-	free(entry->name);
+	free_entry_str(entry->name, entry->name_pooled);
 	entry->name = NULL;
+	entry->name_pooled = 0;
 
 	if(entry->origin != &view->curr_dir[0])
 	{
-		free(entry->origin);
+		free_entry_str(entry->origin, entry->origin_pooled);
 		entry->origin = NULL;
+		entry->origin_pooled = 0;
+	}
+}
+
+/* Makes copy of a string for an entry of the view.  Strings that are in_pool
+ * are shared, others are either copied or interned.  *pooled is set to
+ * non-zero if result is in a string pool.  Returns the copy or NULL on
+ * error. */
+static char *
+copy_entry_str(FileView *view, const char str[], int in_pool, int intern,
+		int *pooled)
+{
+	strpool_t *const pool = get_strings(view);
+	char *copy;
+
+	if(in_pool)
+	{
+		*pooled = 1;
+		return strpool_ref(str);
 	}
+
+	copy = (pool == NULL) ? NULL
+	     : intern ? strpool_intern(pool, str) : strpool_dup(pool, str);
+	*pooled = (copy != NULL);
+	return (copy == NULL) ? strdup(str) : copy;
+}
+
+/* Frees string of an entry, which is either in a string pool or on heap. */
+static void
+free_entry_str(char str[], int pooled)
+{
+	if(pooled)
+	{
+		strpool_release(str);
+	}
+	else
+	{
+		free(str);
+	}
+}
+
+/* Retrieves string pool of the view creating it on first use.  Returns the
+ * pool or NULL on error. */
+static strpool_t *
+get_strings(FileView *view)
+{
+	if(view->strings == NULL)
+	{
+		view->strings = strpool_create();
+	}
+	return view->strings;
 }
 
 int
@@ -2350,9 +3482,9 @@ void
 check_if_filelist_have_changed(FileView *view)
 {
 	int failed, changed;
+	FSWatchState state = FSWS_REPLACED;
 
-	if(view->on_slow_fs || flist_custom_active(view) ||
-			is_unc_root(view->curr_dir))
+	if(!is_watchable(view))
 	{
 		return;
 	}
@@ -2367,7 +3499,8 @@ check_if_filelist_have_changed(FileView *view)
 	}
 	else
 	{
-		changed = fswatch_changed(view->watch, &failed);
+		state = fswatch_poll(view->watch, &failed, &record_watch_change, view);
+		changed = (state != FSWS_UNCHANGED);
 	}
 
 	/* Check if we still have permission to visit this directory. */
@@ -2389,10 +3522,34 @@ check_if_filelist_have_changed(FileView *view)
 
 	if(changed)
 	{
+		view->watch_changes.overflow |= (state == FSWS_REPLACED);
 		ui_view_schedule_reload(view);
+		view->watch_changes.stamp = view->postponed_reload;
 	}
 }
 
+int
+flist_get_watch_fd(const FileView *view, int *fd)
+{
+	if(!is_watchable(view))
+	{
+		return 0;
+	}
+
+	*fd = (view->watch == NULL) ? -1 : fswatch_get_fd(view->watch);
+	return 1;
+}
+
+/* Checks whether changes of the view's directory are tracked.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+is_watchable(const FileView *view)
+{
+	return !view->on_slow_fs
+	    && !flist_custom_active(view)
+	    && !is_unc_root(view->curr_dir);
+}
+
 int
 cd_is_possible(const char *path)
 {
@@ -2690,7 +3847,7 @@ get_file_size_by_entry(const FileView *view, size_t pos)
 	{
 		char full_path[PATH_MAX];
 		get_full_path_of(entry, sizeof(full_path), full_path);
-		tree_get_data(curr_stats.dirsize_cache, full_path, &size);
+		(void)dcache_get(full_path, &size);
 	}
 
 	return (size == 0) ? entry->size : size;
@@ -2699,9 +3856,17 @@ get_file_size_by_entry(const FileView *view, size_t pos)
 int
 is_directory_entry(const dir_entry_t *entry)
 {
-	return (entry->type == FT_DIR)
-	    || (entry->type == FT_LINK &&
-	        get_symlink_type(entry->name) != SLT_UNKNOWN);
+	if(entry->type != FT_LINK)
+	{
+		return (entry->type == FT_DIR);
+	}
+
+	if(entry->link_status != LS_UNKNOWN)
+	{
+		return (entry->link_status == LS_DIR || entry->link_status == LS_SLOW);
+	}
+
+	return (get_symlink_type(entry->name) != SLT_UNKNOWN);
 }
 
 int
@@ -2963,12 +4128,22 @@ flist_end_custom(FileView *view, int very)
 }
 
 void
-fentry_rename(dir_entry_t *entry, const char to[])
+fentry_rename(FileView *view, dir_entry_t *entry, const char to[])
 {
+	int pooled;
+	char *name;
+
 	/* Rename file in internal structures for correct positioning of cursor
 	 * after reloading, as cursor will be positioned on the file with the same
 	 * name. */
-	(void)replace_string(&entry->name, to);
+	name = copy_entry_str(view, to, 0, 0, &pooled);
+	if(name != NULL)
+	{
+		free_entry_str(entry->name, entry->name_pooled);
+		entry->name = name;
+		entry->name_pooled = pooled;
+	}
+	flist_invalidate_index(view);
 	/* Name change can affect name specific highlight, so reset the cache. */
 	entry->hi_num = -1;
 }
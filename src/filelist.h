@@ -58,6 +58,10 @@ int find_file_pos_in_list(const FileView *const view, const char file[]);
  * Always matches file name and can optionally match directory if dir is not
  * NULL.  Returns file entry index or -1, if file wasn't found. */
 int flist_find_entry(const FileView *view, const char file[], const char dir[]);
+/* Marks name index of the view as outdated.  Should be called after changing
+ * order or names of entries in place, other changes of the list are detected
+ * automatically. */
+void flist_invalidate_index(FileView *view);
 /* Tries to move cursor by pos_delta positions.  A wrapper for
  * correct_list_pos_on_scroll_up() and correct_list_pos_on_scroll_down()
  * functions. */
@@ -211,6 +215,11 @@ dir_entry_t * get_current_entry(FileView *view);
 /* Checks whether content in the current directory of the view changed and
  * reloads the view if so. */
 void check_if_filelist_have_changed(FileView *view);
+/* Retrieves file descriptor that becomes readable when contents of the view
+ * might have changed.  Sets *fd to -1 if the view needs to be checked
+ * periodically instead.  Returns non-zero if the view is checked for changes
+ * at all, otherwise zero is returned. */
+int flist_get_watch_fd(const FileView *view, int *fd);
 /* Checks whether cd'ing into path is possible. Shows cd errors to a user.
  * Returns non-zero if it's possible, zero otherwise. */
 int cd_is_possible(const char *path);
@@ -271,8 +280,11 @@ void mark_selection_or_current(FileView *view);
  * entries. */
 int zap_entries(FileView *view, dir_entry_t *entries, int *count,
 		zap_filter filter, void *arg, int allow_empty_list);
-/* Finds directory entry in the list of entries by the path.  Returns pointer to
- * the found entry or NULL. */
+/* Finds directory entry of the view by the path.  Returns pointer to the found
+ * entry or NULL. */
+dir_entry_t * flist_entry_from_path(const FileView *view, const char path[]);
+/* Same as flist_entry_from_path(), but for arbitrary list of entries, which
+ * is searched linearly. */
 dir_entry_t * entry_from_path(dir_entry_t *entries, int count,
 		const char path[]);
 /* Replaces all entries of the *entries with copy of with_entries elements. */
@@ -296,7 +308,7 @@ void flist_add_custom_line(FileView *view, const char line[]);
  * handling and cursor position. */
 void flist_end_custom(FileView *view, int very);
 /* Changes name of a file entry, performing additional required updates. */
-void fentry_rename(dir_entry_t *entry, const char to[]);
+void fentry_rename(FileView *view, dir_entry_t *entry, const char to[]);
 
 TSTATIC_DEFS(
 	TSTATIC void pick_cd_path(FileView *view, const char base_dir[],
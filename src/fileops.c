@@ -41,6 +41,7 @@
 #include <stdlib.h> /* calloc() free() malloc() realloc() strtol() */
 #include <string.h> /* memcmp() memset() strcat() strcmp() strcpy() strdup()
                        strerror() */
+#include <time.h> /* time() time_t */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -63,11 +64,12 @@
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
-#include "utils/tree.h"
+#include "utils/trie.h"
 #include "utils/test_helpers.h"
 #include "utils/utils.h"
 #include "background.h"
 #include "commands_completion.h"
+#include "dcache.h"
 #include "filelist.h"
 #include "ops.h"
 #include "registers.h"
@@ -139,11 +141,41 @@ bg_args_t;
 /* Arguments pack for dir_size_bg() background function. */
 typedef struct
 {
-	char *path; /* Full path to directory to process, will be freed. */
-	int force;  /* Whether cached values should be ignored. */
+	char **paths; /* Full paths to directories to process, will be freed. */
+	int npaths;   /* Number of elements in the paths array. */
+	int force;    /* Whether cached values should be ignored. */
 }
 dir_size_args_t;
 
+/* Directory visited during calculation of directory size. */
+typedef struct dir_size_node_t
+{
+	struct dir_size_node_t *parent; /* Containing directory or NULL for root. */
+	struct dir_size_node_t *next;   /* Next directory waiting to be listed. */
+	char *path;                     /* Full path to the directory. */
+	time_t mtime;                   /* Modification time of the directory. */
+	uint64_t size;                  /* Size accumulated so far. */
+	uint64_t own;                   /* Size of files right in the directory. */
+	int pending;   /* One for listing plus number of unfinished subdirectories. */
+	int has_links; /* Whether some files have several hard links. */
+	int failed;    /* Whether the directory couldn't be listed. */
+}
+dir_size_node_t;
+
+/* State shared by threads calculating size of a directory. */
+typedef struct
+{
+	pthread_mutex_t lock;   /* Protects this structure and all the nodes. */
+	pthread_cond_t cond;    /* Signals new nodes in the queue or completion. */
+	dir_size_node_t *queue; /* Stack of directories waiting to be listed. */
+	trie_t inodes;          /* Counted files that have several hard links. */
+	uint64_t total;         /* Size of the root directory once it's done. */
+	int done;               /* Whether the whole tree has been processed. */
+	int force;              /* Whether cached sizes should be ignored. */
+	time_t started;         /* When the calculation has started. */
+}
+dir_size_calc_t;
+
 static void io_progress_changed(const io_progress_t *const state);
 static int calc_io_progress(const io_progress_t *const state, int *skip);
 static void io_progress_fg(const io_progress_t *const state, int progress);
@@ -227,16 +259,26 @@ static int cp_file_f(const char src[], const char dst[], CopyMoveLikeOp op,
 		int bg, int cancellable, ops_t *ops);
 static void free_bg_args(bg_args_t *args);
 static void general_prepare_for_bg_task(FileView *view, bg_args_t *args);
+static const char * get_bg_src(const bg_args_t *args);
 static void append_marked_files(FileView *view, char buf[], char **fnames);
 static void append_fname(char buf[], size_t len, const char fname[]);
 static const char * get_cancellation_suffix(void);
 static int can_add_files_to_view(const FileView *view);
 static int check_if_dir_writable(DirRole dir_role, const char path[]);
-static void update_dir_entry_size(const FileView *view, int index, int force);
-static void start_dir_size_calc(const char path[], int force);
+static void start_dir_size_calc(char *paths[], int npaths, int force);
 static void dir_size_bg(bg_op_t *bg_op, void *arg);
 static void dir_size(char path[], int force);
-static void set_dir_size(const char path[], uint64_t size);
+static int get_dir_size_threads(void);
+static void * dir_size_worker(void *arg);
+static dir_size_node_t * take_dir_node(dir_size_calc_t *calc);
+static void process_dir_node(dir_size_calc_t *calc, dir_size_node_t *node);
+static void add_dir_node(dir_size_calc_t *calc, dir_size_node_t *parent,
+		const char path[]);
+static void finish_dir_node(dir_size_calc_t *calc, dir_size_node_t *node,
+		uint64_t size);
+#ifndef _WIN32
+static int was_counted(dir_size_calc_t *calc, const struct stat *st);
+#endif
 static void redraw_after_path_change(FileView *view, const char path[]);
 
 /* Temporary storage for extension of file being renamed in name-only mode. */
@@ -779,8 +821,8 @@ delete_files_bg(FileView *view, int use_trash)
 
 	append_marked_files(view, task_desc, NULL);
 
-	if(bg_execute(task_desc, "...", args->sel_list_len, 1, &delete_files_in_bg,
-				args) != 0)
+	if(bg_execute(task_desc, "...", args->sel_list_len, 1, get_bg_src(args), NULL,
+				&delete_files_in_bg, args) != 0)
 	{
 		free_bg_args(args);
 
@@ -892,7 +934,7 @@ rename_file_cb(const char new_name[])
 
 	/* Rename file in internal structures for correct positioning of cursor after
 	 * reloading, as cursor will be positioned on the file with the same name. */
-	fentry_rename(entry, new);
+	fentry_rename(curr_view, entry, new);
 
 	ui_view_schedule_reload(curr_view);
 }
@@ -1061,7 +1103,7 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 			++renamed;
 
 			make_full_path(curr_dir, files[i], path, sizeof(path));
-			entry = entry_from_path(view->dir_entry, view->list_rows, path);
+			entry = flist_entry_from_path(view, path);
 			if(entry == NULL)
 			{
 				continue;
@@ -1075,7 +1117,7 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 				/* For regular views rename file in internal structures for correct
 				 * positioning of cursor after reloading. For custom views rename to
 				 * prevent files from disappearing. */
-				fentry_rename(entry, new_name);
+				fentry_rename(view, entry, new_name);
 
 				if(flist_custom_active(view))
 				{
@@ -1083,7 +1125,7 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 							view->custom.entry_count, path);
 					if(entry != NULL)
 					{
-						fentry_rename(entry, new_name);
+						fentry_rename(view, entry, new_name);
 					}
 				}
 			}
@@ -2192,8 +2234,8 @@ put_files_bg(FileView *view, int reg_name, int move)
 
 	/* Initiate the operation. */
 
-	if(bg_execute(task_desc, "...", args->sel_list_len, 1, &put_files_in_bg,
-				args) != 0)
+	if(bg_execute(task_desc, "...", args->sel_list_len, 1, get_bg_src(args),
+				args->path, &put_files_in_bg, args) != 0)
 	{
 		free_bg_args(args);
 
@@ -3105,7 +3147,7 @@ fixup_entry_after_rename(FileView *view, dir_entry_t *entry,
 {
 	if(entry_to_pos(view, entry) == view->list_pos || flist_custom_active(view))
 	{
-		fentry_rename(entry, new_fname);
+		fentry_rename(view, entry, new_fname);
 	}
 }
 
@@ -3373,8 +3415,8 @@ cpmv_files_bg(FileView *view, char **list, int nlines, int move, int force)
 
 	general_prepare_for_bg_task(view, args);
 
-	if(bg_execute(task_desc, "...", args->sel_list_len, 1, &cpmv_files_in_bg,
-				args) != 0)
+	if(bg_execute(task_desc, "...", args->sel_list_len, 1, get_bg_src(args),
+				args->path, &cpmv_files_in_bg, args) != 0)
 	{
 		free_bg_args(args);
 
@@ -3663,6 +3705,13 @@ get_bg_ops(OPS main_op, const char descr[], const char dir[], bg_op_t *bg_op)
 	pdata = alloc_progress_data(1, bg_op);
 	ops->estim = ioeta_alloc(pdata);
 
+	/* Background copying and moving start right away and reuse results of
+	 * estimation, which is done in parallel. */
+	if(main_op == OP_COPY || main_op == OP_MOVE)
+	{
+		ioeta_use_manifest(ops->estim);
+	}
+
 	return ops;
 }
 
@@ -3883,6 +3932,14 @@ general_prepare_for_bg_task(FileView *view, bg_args_t *args)
 	ui_view_reset_selection_and_reload(view);
 }
 
+/* Picks path that identifies source device of background operation.  Returns
+ * the path or NULL if there are no files to process. */
+static const char *
+get_bg_src(const bg_args_t *args)
+{
+	return (args->sel_list_len == 0) ? NULL : args->sel_list[0];
+}
+
 static void
 go_to_first_file(FileView *view, char **names, int count)
 {
@@ -4193,51 +4250,64 @@ void
 calculate_size_bg(const FileView *view, int force)
 {
 	int i;
-
-	if(!view->dir_entry[view->list_pos].selected && view->user_selection)
-	{
-		update_dir_entry_size(view, view->list_pos, force);
-		return;
-	}
+	char **paths = NULL;
+	int npaths = 0;
+	const int current_only = !view->dir_entry[view->list_pos].selected
+	                      && view->user_selection;
 
 	for(i = 0; i < view->list_rows; i++)
 	{
 		const dir_entry_t *const entry = &view->dir_entry[i];
 
-		if(entry->selected && entry->type == FT_DIR)
+		if(current_only ? (i == view->list_pos)
+		                : (entry->selected && entry->type == FT_DIR))
 		{
-			update_dir_entry_size(view, i, force);
+			char full_path[PATH_MAX];
+			get_full_path_at(view, i, sizeof(full_path), full_path);
+			npaths = add_to_string_array(&paths, npaths, 1, full_path);
 		}
 	}
-}
-
-/* Initiates background size calculation for view entry. */
-static void
-update_dir_entry_size(const FileView *view, int index, int force)
-{
-	char full_path[PATH_MAX];
 
-	get_full_path_at(view, index, sizeof(full_path), full_path);
-	start_dir_size_calc(full_path, force);
+	if(npaths != 0)
+	{
+		start_dir_size_calc(paths, npaths, force);
+	}
 }
 
-/* Initiates background directory size calculation. */
+/* Initiates single background task that calculates sizes of the directories.
+ * Takes ownership of the paths array. */
 static void
-start_dir_size_calc(const char path[], int force)
+start_dir_size_calc(char *paths[], int npaths, int force)
 {
 	char task_desc[PATH_MAX];
 	dir_size_args_t *args;
 
 	args = malloc(sizeof(*args));
-	args->path = strdup(path);
+	if(args == NULL)
+	{
+		free_string_array(paths, npaths);
+		show_error_msg("Can't calculate size", "Not enough memory");
+		return;
+	}
+
+	args->paths = paths;
+	args->npaths = npaths;
 	args->force = force;
 
-	snprintf(task_desc, sizeof(task_desc), "Calculating size: %s", path);
+	if(npaths == 1)
+	{
+		snprintf(task_desc, sizeof(task_desc), "Calculating size: %s", paths[0]);
+	}
+	else
+	{
+		snprintf(task_desc, sizeof(task_desc),
+				"Calculating size of %d directories", npaths);
+	}
 
-	if(bg_execute(task_desc, path, BG_UNDEFINED_TOTAL, 0, &dir_size_bg,
+	if(bg_execute(task_desc, "...", npaths, 0, paths[0], NULL, &dir_size_bg,
 				args) != 0)
 	{
-		free(args->path);
+		free_string_array(args->paths, args->npaths);
 		free(args);
 
 		show_error_msg("Can't calculate size",
@@ -4245,15 +4315,20 @@ start_dir_size_calc(const char path[], int force)
 	}
 }
 
-/* Entry point for a background task that calculates size of a directory. */
+/* Entry point for a background task that calculates size of directories. */
 static void
 dir_size_bg(bg_op_t *bg_op, void *arg)
 {
 	dir_size_args_t *const args = arg;
+	int i;
 
-	dir_size(args->path, args->force);
+	for(i = 0; i < args->npaths; ++i, ++bg_op->done)
+	{
+		bg_op_set_descr(bg_op, args->paths[i]);
+		dir_size(args->paths[i], args->force);
+	}
 
-	free(args->path);
+	free_string_array(args->paths, args->npaths);
 	free(args);
 }
 
@@ -4270,69 +4345,319 @@ dir_size(char path[], int force)
 	redraw_after_path_change(&rwin, path);
 }
 
-/* Calculates size of a directory possibly using cache of known sizes.  Returns
- * size of a directory or zero on error. */
+/* Calculates size of a directory possibly using cache of known sizes.  The
+ * tree is traversed by several threads, which take directories to list from a
+ * shared queue.  Returns size of a directory or zero on error. */
 uint64_t
 calculate_dir_size(const char path[], int force_update)
 {
-	DIR* dir;
-	struct dirent* dentry;
-	const char* slash = "";
-	uint64_t size;
+	enum { MAX_THREADS = 8 };
 
-	dir = os_opendir(path);
-	if(dir == NULL)
+	pthread_t threads[MAX_THREADS];
+	int nthreads;
+	int i;
+	dir_size_calc_t calc = {
+		.queue = NULL,
+		.inodes = trie_create(),
+		.total = 0U,
+		.done = 0,
+		.force = force_update,
+		.started = time(NULL),
+	};
+
+	pthread_mutex_init(&calc.lock, NULL);
+	pthread_cond_init(&calc.cond, NULL);
+
+	add_dir_node(&calc, NULL, path);
+
+	if(calc.queue != NULL)
 	{
-		return 0;
+		/* Current thread is a worker as well. */
+		nthreads = MIN(get_dir_size_threads(), MAX_THREADS) - 1;
+		for(i = 0; i < nthreads; ++i)
+		{
+			if(pthread_create(&threads[i], NULL, &dir_size_worker, &calc) != 0)
+			{
+				nthreads = i;
+				break;
+			}
+		}
+
+		(void)dir_size_worker(&calc);
+
+		for(i = 0; i < nthreads; ++i)
+		{
+			(void)pthread_join(threads[i], NULL);
+		}
 	}
 
-	if(!ends_with_slash(path))
+	trie_free(calc.inodes);
+	pthread_cond_destroy(&calc.cond);
+	pthread_mutex_destroy(&calc.lock);
+
+	return calc.total;
+}
+
+/* Determines how many threads should traverse directory tree.  Returns the
+ * number. */
+static int
+get_dir_size_threads(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	const long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return (ncpus > 0) ? ncpus : 1;
+#else
+	return 1;
+#endif
+}
+
+/* Entry point of a thread that lists directories until whole tree is
+ * processed.  Returns NULL. */
+static void *
+dir_size_worker(void *arg)
+{
+	dir_size_calc_t *const calc = arg;
+	dir_size_node_t *node;
+
+	while((node = take_dir_node(calc)) != NULL)
 	{
-		slash = "/";
+		process_dir_node(calc, node);
+	}
+
+	return NULL;
+}
+
+/* Waits for a directory to list.  Returns the directory or NULL when there is
+ * nothing more to do. */
+static dir_size_node_t *
+take_dir_node(dir_size_calc_t *calc)
+{
+	dir_size_node_t *node = NULL;
+
+	pthread_mutex_lock(&calc->lock);
+	while(calc->queue == NULL && !calc->done)
+	{
+		pthread_cond_wait(&calc->cond, &calc->lock);
+	}
+	if(calc->queue != NULL)
+	{
+		node = calc->queue;
+		calc->queue = node->next;
+	}
+	pthread_mutex_unlock(&calc->lock);
+
+	return node;
+}
+
+/* Lists directory summing up sizes of files and queueing subdirectories. */
+static void
+process_dir_node(dir_size_calc_t *calc, dir_size_node_t *node)
+{
+	const char *const slash = ends_with_slash(node->path) ? "" : "/";
+	struct stat st;
+	DIR *dir;
+	struct dirent *dentry;
+	uint64_t size = 0U;
+	int cached;
+
+	dir = os_opendir(node->path);
+	if(dir == NULL || os_stat(node->path, &st) != 0)
+	{
+		if(dir != NULL)
+		{
+			os_closedir(dir);
+		}
+		node->failed = 1;
+		finish_dir_node(calc, node, 0U);
+		return;
 	}
 
-	size = 0;
+	node->mtime = st.st_mtime;
+
+	/* Modification time of a directory doesn't reflect changes of its
+	 * subdirectories, so they are always visited.  Sizes of files are reused
+	 * while list of files is the same, root is always recalculated. */
+	cached = !calc->force && node->parent != NULL
+	      && dcache_get_own_at(node->path, node->mtime, &size) == 0;
+
 	while((dentry = os_readdir(dir)) != NULL)
 	{
-		char buf[PATH_MAX];
+		char path[PATH_MAX];
 
 		if(is_builtin_dir(dentry->d_name))
 		{
 			continue;
 		}
 
-		snprintf(buf, sizeof(buf), "%s%s%s", path, slash, dentry->d_name);
-		if(is_dir_entry(buf, dentry))
+		snprintf(path, sizeof(path), "%s%s%s", node->path, slash, dentry->d_name);
+
+#ifndef _WIN32
+		/* Type of entry is often known without calling lstat(). */
+		if(dentry->d_type == DT_DIR)
+		{
+			add_dir_node(calc, node, path);
+			continue;
+		}
+
+		if(cached && dentry->d_type != DT_UNKNOWN)
+		{
+			continue;
+		}
+
+		if(os_lstat(path, &st) != 0)
 		{
-			uint64_t dir_size = 0;
-			if(tree_get_data(curr_stats.dirsize_cache, buf, &dir_size) != 0
-					|| force_update)
-				dir_size = calculate_dir_size(buf, force_update);
-			size += dir_size;
+			continue;
+		}
+
+		if(S_ISDIR(st.st_mode))
+		{
+			add_dir_node(calc, node, path);
+		}
+		else if(cached)
+		{
+			continue;
+		}
+		else if(st.st_nlink <= 1)
+		{
+			size += st.st_size;
 		}
 		else
 		{
-			size += get_file_size(buf);
+			node->has_links = 1;
+			if(!was_counted(calc, &st))
+			{
+				size += st.st_size;
+			}
+		}
+#else
+		if(is_dir(path))
+		{
+			add_dir_node(calc, node, path);
 		}
+		else if(!cached)
+		{
+			size += get_file_size(path);
+		}
+#endif
 	}
 
 	os_closedir(dir);
 
-	set_dir_size(path, size);
-	return size;
+	finish_dir_node(calc, node, size);
 }
 
-/* Updates cached directory size in a thread-safe way. */
+/* Queues directory for listing.  parent can be NULL for the root. */
 static void
-set_dir_size(const char path[], uint64_t size)
+add_dir_node(dir_size_calc_t *calc, dir_size_node_t *parent,
+		const char path[])
 {
-	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	dir_size_node_t *const node = malloc(sizeof(*node));
+	if(node == NULL)
+	{
+		return;
+	}
 
-	pthread_mutex_lock(&mutex);
-	tree_set_data(curr_stats.dirsize_cache, path, size);
-	pthread_mutex_unlock(&mutex);
+	node->path = strdup(path);
+	if(node->path == NULL)
+	{
+		free(node);
+		return;
+	}
+
+	node->parent = parent;
+	node->mtime = 0;
+	node->size = 0U;
+	node->own = 0U;
+	node->pending = 1;
+	node->has_links = 0;
+	node->failed = 0;
+
+	pthread_mutex_lock(&calc->lock);
+	if(parent != NULL)
+	{
+		++parent->pending;
+	}
+	node->next = calc->queue;
+	calc->queue = node;
+	pthread_cond_signal(&calc->cond);
+	pthread_mutex_unlock(&calc->lock);
 }
 
+/* Accounts for size of files of the directory after it has been listed and
+ * propagates sizes of complete directories to their parents. */
+static void
+finish_dir_node(dir_size_calc_t *calc, dir_size_node_t *node, uint64_t size)
+{
+	pthread_mutex_lock(&calc->lock);
+
+	node->own = size;
+	node->size += size;
+	while(--node->pending == 0)
+	{
+		dir_size_node_t *const parent = node->parent;
+
+		if(!node->failed)
+		{
+			/* Files with several links are counted only once per calculation, so
+			 * their sizes can't be reused.  Neither can sizes of directories changed
+			 * within the same second as the calculation, as they might be changed
+			 * again without affecting the modification time. */
+			const int reusable = !node->has_links && node->mtime < calc->started;
+			(void)dcache_set_at(node->path, node->mtime, node->size,
+					reusable ? node->own : DCACHE_UNKNOWN);
+		}
+
+		if(parent == NULL)
+		{
+			calc->total = node->size;
+			calc->done = 1;
+			pthread_cond_broadcast(&calc->cond);
+		}
+		else
+		{
+			parent->size += node->size;
+		}
+
+		free(node->path);
+		free(node);
+
+		if(parent == NULL)
+		{
+			break;
+		}
+		node = parent;
+	}
+
+	pthread_mutex_unlock(&calc->lock);
+}
+
+#ifndef _WIN32
+
+/* Checks whether file with several hard links has already been counted and
+ * marks it as such.  Returns non-zero if so, otherwise zero is returned. */
+static int
+was_counted(dir_size_calc_t *calc, const struct stat *st)
+{
+	char key[64];
+	int result;
+
+	if(calc->inodes == NULL_TRIE)
+	{
+		return 0;
+	}
+
+	snprintf(key, sizeof(key), "%llx:%llx", (unsigned long long)st->st_dev,
+			(unsigned long long)st->st_ino);
+
+	pthread_mutex_lock(&calc->lock);
+	result = trie_put(calc->inodes, key);
+	pthread_mutex_unlock(&calc->lock);
+
+	return result > 0;
+}
+
+#endif
+
 /* Schedules view redraw in case path change might have affected it. */
 static void
 redraw_after_path_change(FileView *view, const char path[])
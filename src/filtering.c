@@ -19,25 +19,53 @@
 
 #include "filtering.h"
 
+#include <pthread.h> /* pthread_create() pthread_join() pthread_t */
+#include <unistd.h> /* _SC_NPROCESSORS_ONLN sysconf() */
+
 #include <assert.h> /* assert() */
+#include <stdlib.h> /* free() malloc() */
 #include <string.h> /* strdup() */
 
 #include "cfg/config.h"
 #include "compat/reallocarray.h"
 #include "ui/ui.h"
 #include "utils/dynarray.h"
+#include "utils/filter.h"
+#include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/utils.h"
 #include "filelist.h"
 
+/* Part of the list of candidates matched against local filter by a thread. */
+typedef struct
+{
+	filter_t *filter;            /* Filter to match against. */
+	filter_t own;                /* Copy of the filter owned by the thread. */
+	const dir_entry_t *entries;  /* Unfiltered entries. */
+	const char *is_dir;          /* Whether unfiltered entries are directories. */
+	const int *candidates;       /* Indexes of entries to check. */
+	char *matched;               /* Results for candidates. */
+	size_t first;                /* Index of the first candidate to check. */
+	size_t last;                 /* Index past the last candidate to check. */
+}
+match_job_t;
+
 static void reset_filter(filter_t *filter);
 static int is_newly_filtered(FileView *view, const dir_entry_t *entry,
 		void *arg);
 static int get_unfiltered_pos(const FileView *const view, int pos);
 static int load_unfiltered_list(FileView *const view);
+static void index_unfiltered_list(FileView *view);
 static void store_local_filter_position(FileView *const view, int pos);
-static void update_filtering_lists(FileView *view, int add, int clear);
+static void update_matches(FileView *view, int narrow);
+static void match_in_parallel(FileView *view, int nthreads);
+static void * match_candidates(void *arg);
+static int get_filter_threads(void);
+static int entry_matches(filter_t *filter, const dir_entry_t *entry,
+		int is_dir);
+static void build_visible_list(FileView *view);
+static void free_unmatched_entries(FileView *view);
 static void ensure_filtered_list_not_empty(FileView *view,
 		dir_entry_t *parent_entry);
 static int extract_previously_selected_pos(FileView *const view);
@@ -63,6 +91,10 @@ filters_view_reset(FileView *view)
 	view->local_filter.saved = NULL;
 	view->local_filter.poshist = NULL;
 	view->local_filter.poshist_len = 0U;
+	view->local_filter.is_dir = NULL;
+	view->local_filter.matches = NULL;
+	view->local_filter.match_count = 0U;
+	view->local_filter.parent_pos = -1;
 }
 
 /* Resets filter to empty state (either initializes or clears it). */
@@ -267,6 +299,9 @@ filters_dir_updated(FileView *view)
 void
 local_filter_set(FileView *view, const char filter[])
 {
+	filter_t *const lf = &view->local_filter.filter;
+	int matched_all, was_literal, was_case_sensitive, extends;
+
 	const int current_file_pos = view->local_filter.in_progress
 		? get_unfiltered_pos(view, view->list_pos)
 		: load_unfiltered_list(view);
@@ -276,10 +311,19 @@ local_filter_set(FileView *view, const char filter[])
 		store_local_filter_position(view, current_file_pos);
 	}
 
-	(void)filter_change(&view->local_filter.filter, filter,
-			!regexp_should_ignore_case(filter));
+	matched_all = !lf->is_regex_valid;
+	was_literal = lf->is_literal;
+	was_case_sensitive = !(lf->cflags & REG_ICASE);
+	extends = starts_with(filter, lf->raw);
 
-	update_filtering_lists(view, 1, 0);
+	(void)filter_change(lf, filter, !regexp_should_ignore_case(filter));
+
+	/* Anything that contains a string also contains its prefix, so matches of a
+	 * literal filter include all matches of its extensions unless they are
+	 * looked up ignoring case. */
+	update_matches(view, matched_all || (was_literal && lf->is_literal &&
+				extends && !(was_case_sensitive && (lf->cflags & REG_ICASE))));
+	build_visible_list(view);
 }
 
 /* Gets position of an item in dir_entry list at position pos in the unfiltered
@@ -323,7 +367,7 @@ load_unfiltered_list(FileView *const view)
 		populate_dir_list(view, 1);
 
 		/* Resolve current file position in updated list. */
-		entry = entry_from_path(view->dir_entry, view->list_rows, full_path);
+		entry = flist_entry_from_path(view, full_path);
 		if(entry != NULL)
 		{
 			current_file_pos = entry_to_pos(view, entry);
@@ -346,9 +390,40 @@ load_unfiltered_list(FileView *const view)
 	view->local_filter.prefiltered_count = view->filtered;
 	view->dir_entry = NULL;
 
+	index_unfiltered_list(view);
+
 	return current_file_pos;
 }
 
+/* Collects information about unfiltered entries that doesn't depend on value of
+ * the filter, so that it's not recomputed on every change of the filter. */
+static void
+index_unfiltered_list(FileView *view)
+{
+	const size_t count = view->local_filter.unfiltered_count;
+	size_t i;
+
+	view->local_filter.matches = NULL;
+	view->local_filter.match_count = 0U;
+	view->local_filter.parent_pos = -1;
+	view->local_filter.is_dir = malloc(count + 1U);
+
+	for(i = 0U; i < count; ++i)
+	{
+		const dir_entry_t *const entry = &view->local_filter.unfiltered[i];
+
+		if(view->local_filter.parent_pos < 0 && is_parent_dir(entry->name))
+		{
+			view->local_filter.parent_pos = i;
+		}
+
+		if(view->local_filter.is_dir != NULL)
+		{
+			view->local_filter.is_dir[i] = is_directory_entry(entry);
+		}
+	}
+}
+
 /* Adds local filter position (in unfiltered list) to position history. */
 static void
 store_local_filter_position(FileView *const view, int pos)
@@ -363,64 +438,275 @@ store_local_filter_position(FileView *const view, int pos)
 	}
 }
 
-/* Copies/moves elements of the unfiltered list into dir_entry list.  add
- * parameter controls whether entries matching filter are copied into dir_entry
- * list.  clear parameter controls whether entries not matching filter are
- * cleared in unfiltered list. */
+/* Updates list of unfiltered entries that match local filter.  When narrow is
+ * set, only entries that matched previous value of the filter are checked. */
 static void
-update_filtering_lists(FileView *view, int add, int clear)
+update_matches(FileView *view, int narrow)
 {
-	size_t i;
-	size_t list_size = 0U;
-	dir_entry_t *parent_entry = NULL;
+	/* Don't bother creating threads for lists smaller than this. */
+	enum { MIN_PER_THREAD = 32*1024 };
 
-	for(i = 0; i < view->local_filter.unfiltered_count; i++)
-	{
-		/* FIXME: some very long file names won't be matched against some
-		 * regexps. */
-		char name_with_slash[NAME_MAX + 1 + 1];
+	const size_t count = view->local_filter.unfiltered_count;
+	int nthreads;
 
-		dir_entry_t *const entry = &view->local_filter.unfiltered[i];
-		const char *name = entry->name;
+	if(view->local_filter.matches == NULL)
+	{
+		view->local_filter.matches = reallocarray(NULL, count + 1U, sizeof(int));
+		if(view->local_filter.matches == NULL)
+		{
+			view->local_filter.match_count = 0U;
+			return;
+		}
+		narrow = 0;
+	}
 
-		if(is_parent_dir(name))
+	if(!narrow)
+	{
+		size_t i;
+		view->local_filter.match_count = 0U;
+		for(i = 0U; i < count; ++i)
 		{
-			parent_entry = entry;
-			if(add && cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)))
+			if((int)i != view->local_filter.parent_pos)
 			{
-				(void)add_dir_entry(&view->dir_entry, &list_size, entry);
+				view->local_filter.matches[view->local_filter.match_count++] = i;
 			}
-			continue;
 		}
+	}
 
-		if(is_directory_entry(entry))
-		{
-			append_slash(name, name_with_slash, sizeof(name_with_slash));
-			name = name_with_slash;
-		}
+	nthreads = MIN(get_filter_threads(),
+			(int)(view->local_filter.match_count/MIN_PER_THREAD));
+	if(view->local_filter.is_dir == NULL)
+	{
+		/* Not thread-safe is_directory_entry() is used in this case. */
+		nthreads = 1;
+	}
+	match_in_parallel(view, nthreads);
+}
 
-		if(filter_matches(&view->local_filter.filter, name) != 0)
+/* Removes entries that don't match local filter from the list of matches using
+ * at most nthreads threads (including current one). */
+static void
+match_in_parallel(FileView *view, int nthreads)
+{
+	enum { MAX_THREADS = 8 };
+
+	pthread_t threads[MAX_THREADS];
+	match_job_t jobs[MAX_THREADS];
+	int *const matches = view->local_filter.matches;
+	const size_t count = view->local_filter.match_count;
+	char *matched;
+	size_t i, j;
+	int nstarted;
+	int t;
+
+	nthreads = MIN(nthreads, MAX_THREADS);
+	matched = (nthreads > 1) ? malloc(count) : NULL;
+	if(matched == NULL)
+	{
+		/* Check candidates one by one without storing results. */
+		j = 0U;
+		for(i = 0U; i < count; ++i)
 		{
-			if(add)
+			const int pos = matches[i];
+			const dir_entry_t *const entry = &view->local_filter.unfiltered[pos];
+			const int is_dir = (view->local_filter.is_dir == NULL)
+			                 ? is_directory_entry(entry)
+			                 : view->local_filter.is_dir[pos];
+			if(entry_matches(&view->local_filter.filter, entry, is_dir))
 			{
-				(void)add_dir_entry(&view->dir_entry, &list_size, entry);
+				matches[j++] = pos;
 			}
 		}
-		else
+		view->local_filter.match_count = j;
+		return;
+	}
+
+	for(t = 0; t < nthreads; ++t)
+	{
+		match_job_t *const job = &jobs[t];
+		job->filter = &view->local_filter.filter;
+		job->entries = view->local_filter.unfiltered;
+		job->is_dir = view->local_filter.is_dir;
+		job->candidates = matches;
+		job->matched = matched;
+		job->first = count*t/nthreads;
+		job->last = count*(t + 1)/nthreads;
+
+		/* Matching of regular expressions might be serialized by a lock, so give
+		 * each thread its own copy. */
+		if(t != 0 && !job->filter->is_literal &&
+				filter_init(&job->own, 1) == 0)
 		{
-			if(clear)
+			if(filter_assign(&job->own, job->filter) == 0)
+			{
+				job->filter = &job->own;
+			}
+			else
 			{
-				free_dir_entry(view, entry);
+				filter_dispose(&job->own);
 			}
 		}
 	}
 
-	if(add)
+	nstarted = 1;
+	while(nstarted < nthreads && pthread_create(&threads[nstarted], NULL,
+				&match_candidates, &jobs[nstarted]) == 0)
 	{
-		view->list_rows = list_size;
-		view->filtered = view->local_filter.prefiltered_count
-		               + view->local_filter.unfiltered_count - list_size;
-		ensure_filtered_list_not_empty(view, parent_entry);
+		++nstarted;
+	}
+
+	/* Current thread does its share of work along with shares of threads that
+	 * failed to start. */
+	(void)match_candidates(&jobs[0]);
+	for(t = nstarted; t < nthreads; ++t)
+	{
+		(void)match_candidates(&jobs[t]);
+	}
+
+	for(t = 1; t < nstarted; ++t)
+	{
+		(void)pthread_join(threads[t], NULL);
+	}
+
+	for(t = 1; t < nthreads; ++t)
+	{
+		if(jobs[t].filter == &jobs[t].own)
+		{
+			filter_dispose(&jobs[t].own);
+		}
+	}
+
+	j = 0U;
+	for(i = 0U; i < count; ++i)
+	{
+		if(matched[i])
+		{
+			matches[j++] = matches[i];
+		}
+	}
+	view->local_filter.match_count = j;
+
+	free(matched);
+}
+
+/* Entry point of a thread that matches its part of candidates against the
+ * filter.  Returns NULL. */
+static void *
+match_candidates(void *arg)
+{
+	match_job_t *const job = arg;
+	size_t i;
+
+	for(i = job->first; i < job->last; ++i)
+	{
+		const int pos = job->candidates[i];
+		job->matched[i] = entry_matches(job->filter, &job->entries[pos],
+				job->is_dir[pos]);
+	}
+
+	return NULL;
+}
+
+/* Determines how many threads should match entries against local filter.
+ * Returns the number. */
+static int
+get_filter_threads(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	const long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return (ncpus > 0) ? ncpus : 1;
+#else
+	return 1;
+#endif
+}
+
+/* Checks whether the entry matches the filter.  is_dir specifies whether entry
+ * is a directory, for which slash is appended to its name.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+entry_matches(filter_t *filter, const dir_entry_t *entry, int is_dir)
+{
+	/* FIXME: some very long file names won't be matched against some
+	 * regexps. */
+	char name_with_slash[NAME_MAX + 1 + 1];
+	const char *name = entry->name;
+
+	if(is_dir)
+	{
+		append_slash(name, name_with_slash, sizeof(name_with_slash));
+		name = name_with_slash;
+	}
+
+	return filter_matches(filter, name) != 0;
+}
+
+/* Fills dir_entry list with copies of matching unfiltered entries. */
+static void
+build_visible_list(FileView *view)
+{
+	const int parent_pos = view->local_filter.parent_pos;
+	const int *const matches = view->local_filter.matches;
+	const size_t match_count = view->local_filter.match_count;
+	const int show_parent = parent_pos >= 0
+	                     && cfg_parent_dir_is_visible(is_root_dir(view->curr_dir));
+	dir_entry_t *const unfiltered = view->local_filter.unfiltered;
+	size_t list_size = match_count + (show_parent ? 1U : 0U);
+	size_t i, j;
+
+	dynarray_free(view->dir_entry);
+	view->dir_entry = (list_size == 0U)
+	                ? NULL
+	                : dynarray_extend(NULL, list_size*sizeof(*view->dir_entry));
+	if(view->dir_entry == NULL)
+	{
+		list_size = 0U;
+	}
+
+	j = 0U;
+	for(i = 0U; i < match_count && j < list_size; ++i)
+	{
+		if(show_parent && j == i && parent_pos < matches[i])
+		{
+			view->dir_entry[j++] = unfiltered[parent_pos];
+		}
+		view->dir_entry[j++] = unfiltered[matches[i]];
+	}
+	if(j < list_size)
+	{
+		view->dir_entry[j++] = unfiltered[parent_pos];
+	}
+
+	view->list_rows = list_size;
+	view->filtered = view->local_filter.prefiltered_count
+	               + view->local_filter.unfiltered_count - list_size;
+	ensure_filtered_list_not_empty(view,
+			(parent_pos >= 0) ? &unfiltered[parent_pos] : NULL);
+	flist_invalidate_index(view);
+}
+
+/* Frees unfiltered entries that don't match local filter. */
+static void
+free_unmatched_entries(FileView *view)
+{
+	const int *const matches = view->local_filter.matches;
+	const size_t match_count = view->local_filter.match_count;
+	size_t next_match = 0U;
+	size_t i;
+
+	for(i = 0U; i < view->local_filter.unfiltered_count; ++i)
+	{
+		if((int)i == view->local_filter.parent_pos)
+		{
+			continue;
+		}
+
+		if(next_match < match_count && matches[next_match] == (int)i)
+		{
+			++next_match;
+			continue;
+		}
+
+		free_dir_entry(view, &view->local_filter.unfiltered[i]);
 	}
 }
 
@@ -437,11 +723,11 @@ ensure_filtered_list_not_empty(FileView *view, dir_entry_t *parent_entry)
 	if(parent_entry == NULL)
 	{
 		add_parent_dir(view);
-		if(view->list_rows > 0)
-		{
-			(void)add_dir_entry(&view->local_filter.unfiltered,
+		if(view->list_rows > 0 && add_dir_entry(&view->local_filter.unfiltered,
 					&view->local_filter.unfiltered_count,
-					&view->dir_entry[view->list_rows - 1]);
+					&view->dir_entry[view->list_rows - 1]) == 0)
+		{
+			view->local_filter.parent_pos = view->local_filter.unfiltered_count - 1;
 		}
 	}
 	else
@@ -537,7 +823,7 @@ local_filter_accept(FileView *view)
 		return;
 	}
 
-	update_filtering_lists(view, 0, 1);
+	free_unmatched_entries(view);
 
 	local_filter_finish(view);
 
@@ -571,11 +857,9 @@ local_filter_cancel(FileView *view)
 
 	(void)filter_set(&view->local_filter.filter, view->local_filter.saved);
 
-	dynarray_free(view->dir_entry);
-	view->dir_entry = NULL;
-	view->list_rows = 0;
-
-	update_filtering_lists(view, 1, 1);
+	update_matches(view, 0);
+	build_visible_list(view);
+	free_unmatched_entries(view);
 	local_filter_finish(view);
 }
 
@@ -590,6 +874,13 @@ local_filter_finish(FileView *view)
 	free(view->local_filter.poshist);
 	view->local_filter.poshist = NULL;
 	view->local_filter.poshist_len = 0U;
+
+	free(view->local_filter.is_dir);
+	view->local_filter.is_dir = NULL;
+	free(view->local_filter.matches);
+	view->local_filter.matches = NULL;
+	view->local_filter.match_count = 0U;
+	view->local_filter.parent_pos = -1;
 }
 
 void
@@ -610,17 +901,8 @@ local_filter_restore(FileView *view)
 int
 local_filter_matches(FileView *view, const dir_entry_t *entry)
 {
-	/* FIXME: some very long file names won't be matched against some
-	 * regexps. */
-	char name_with_slash[NAME_MAX + 1 + 1];
-	const char *filename = entry->name;
-	if(is_directory_entry(entry))
-	{
-		append_slash(filename, name_with_slash, sizeof(name_with_slash));
-		filename = name_with_slash;
-	}
-
-	return filter_matches(&view->local_filter.filter, filename) != 0;
+	return entry_matches(&view->local_filter.filter, entry,
+			is_directory_entry(entry));
 }
 
 /* Appends slash to the name and stores result in the buffer. */
@@ -21,17 +21,60 @@
 #if defined(ENABLE_DESKTOP_FILES)
 
 #include <dirent.h>
+#include <sys/stat.h> /* stat */
 
-#include <stdio.h> /* snprintf() */
-#include <string.h> /* strstr() strchr() strlen() strcpy() */
+#include <stdio.h> /* FILE fclose() fgets() snprintf() */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* strcmp() strcpy() strdup() strlen() strtok_r() */
+#include <time.h> /* time_t */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "../utils/fs.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/trie.h"
 #include "../utils/utils.h"
 #include "../filetype.h"
 
+/* Application described by a .desktop file. */
+typedef struct
+{
+	char *command; /* Command with macros already expanded. */
+	char *name;    /* Name of the application. */
+}
+desktop_app_t;
+
+/* List of applications that handle particular mime type. */
+typedef struct
+{
+	int count;  /* Number of elements in the apps array. */
+	int apps[]; /* Indexes of applications. */
+}
+app_list_t;
+
+/* Directory or file that was read to build an index and its modification
+ * time. */
+typedef struct
+{
+	char *path;   /* Path to the directory or file. */
+	time_t mtime; /* Modification time at the moment of reading. */
+}
+scanned_path_t;
+
+/* Index of .desktop files found in a directory tree. */
+typedef struct
+{
+	char *root;           /* Root of the directory tree. */
+	scanned_path_t *paths; /* Directories and .desktop files that were read. */
+	int npaths;            /* Number of elements in the paths array. */
+	desktop_app_t *apps;   /* Applications found in .desktop files. */
+	int napps;             /* Number of elements in the apps array. */
+	trie_t mimes;          /* Mime type -> app_list_t. */
+}
+desktop_index_t;
+
 static const char EXEC_KEY[] = "Exec=";
 static const char MIMETYPE_KEY[] = "MimeType=";
 static const char NAME_KEY[] = "Name=";
@@ -39,33 +82,174 @@ static const char NAME_KEY[] = "Name=";
 static const char CAPTION_MACRO = 'c';
 static const char FILE_MACROS[] = "Uuf";
 
-static void parse_desktop_files_internal(const char *path,
-		const char *mime_type, assoc_records_t *result);
-static void process_file(const char *path, const char *file_mime_type,
-		assoc_records_t *result);
+/* Indexes of directory trees that were requested so far. */
+static desktop_index_t *indexes;
+/* Number of elements in the indexes array. */
+static int nindexes;
+
+static desktop_index_t * get_index(const char path[]);
+static int index_is_outdated(const desktop_index_t *index);
+static void build_index(desktop_index_t *index);
+static void free_index(desktop_index_t *index);
+static void index_dir(desktop_index_t *index, const char path[]);
+static void index_file(desktop_index_t *index, const char path[]);
+static void remember_path(desktop_index_t *index, const char path[],
+		time_t mtime);
+static void add_app_to_mime(desktop_index_t *index, const char mime_type[],
+		int app);
 static void expand_desktop(const char *str, char *buf);
 
 assoc_records_t
 parse_desktop_files(const char *path, const char *mime_type)
 {
 	assoc_records_t result = {};
-	parse_desktop_files_internal(path, mime_type, &result);
+	void *data;
+	desktop_index_t *const index = get_index(path);
+
+	if(index != NULL && trie_get(index->mimes, mime_type, &data) == 0)
+	{
+		const app_list_t *const list = data;
+		int i;
+		for(i = 0; i < list->count; ++i)
+		{
+			const desktop_app_t *const app = &index->apps[list->apps[i]];
+			ft_assoc_record_add(&result, app->command, app->name);
+		}
+	}
+
 	return result;
 }
 
+/* Retrieves up to date index of the directory tree, building it if needed.
+ * Returns the index or NULL on error. */
+static desktop_index_t *
+get_index(const char path[])
+{
+	desktop_index_t *index;
+	int i;
+
+	for(i = 0; i < nindexes; ++i)
+	{
+		if(strcmp(indexes[i].root, path) == 0)
+		{
+			break;
+		}
+	}
+
+	if(i == nindexes)
+	{
+		char *const root = strdup(path);
+		void *const p = reallocarray(indexes, nindexes + 1, sizeof(*indexes));
+		if(root == NULL || p == NULL)
+		{
+			free(root);
+			return NULL;
+		}
+		indexes = p;
+		++nindexes;
+
+		index = &indexes[i];
+		index->root = root;
+		index->paths = NULL;
+		index->npaths = 0;
+		index->apps = NULL;
+		index->napps = 0;
+		index->mimes = NULL_TRIE;
+	}
+	else
+	{
+		index = &indexes[i];
+		if(!index_is_outdated(index))
+		{
+			return index;
+		}
+		free_index(index);
+	}
+
+	build_index(index);
+	return (index->mimes == NULL_TRIE) ? NULL : index;
+}
+
+/* Checks whether any of indexed directories or files was changed since it was
+ * read.  Returns non-zero if so, otherwise zero is returned. */
+static int
+index_is_outdated(const desktop_index_t *index)
+{
+	int i;
+
+	if(index->mimes == NULL_TRIE)
+	{
+		return 1;
+	}
+
+	for(i = 0; i < index->npaths; ++i)
+	{
+		struct stat st;
+		if(os_stat(index->paths[i].path, &st) != 0 ||
+				st.st_mtime != index->paths[i].mtime)
+		{
+			return 1;
+		}
+	}
+
+	/* Root that didn't exist before might have appeared. */
+	return index->npaths == 0 && path_exists(index->root, DEREF);
+}
+
+/* Reads all .desktop files of the directory tree of the index. */
 static void
-parse_desktop_files_internal(const char *path, const char *mime_type,
-		assoc_records_t *result)
+build_index(desktop_index_t *index)
+{
+	index->mimes = trie_create();
+	if(index->mimes != NULL_TRIE)
+	{
+		index_dir(index, index->root);
+	}
+}
+
+/* Frees everything except for the root path of the index. */
+static void
+free_index(desktop_index_t *index)
+{
+	int i;
+
+	for(i = 0; i < index->npaths; ++i)
+	{
+		free(index->paths[i].path);
+	}
+	free(index->paths);
+	index->paths = NULL;
+	index->npaths = 0;
+
+	for(i = 0; i < index->napps; ++i)
+	{
+		free(index->apps[i].command);
+		free(index->apps[i].name);
+	}
+	free(index->apps);
+	index->apps = NULL;
+	index->napps = 0;
+
+	trie_free_with_data(index->mimes);
+	index->mimes = NULL_TRIE;
+}
+
+/* Adds .desktop files of the directory and its subdirectories to the index. */
+static void
+index_dir(desktop_index_t *index, const char path[])
 {
 	DIR *dir;
 	struct dirent *dentry;
 	const char *slash;
+	struct stat st;
 
-	if((dir = os_opendir(path)) == NULL)
+	if(os_stat(path, &st) != 0 || (dir = os_opendir(path)) == NULL)
 	{
 		return;
 	}
 
+	remember_path(index, path, st.st_mtime);
+
 	slash = ends_with_slash(path) ? "" : "/";
 
 	while((dentry = os_readdir(dir)) != NULL)
@@ -80,30 +264,38 @@ parse_desktop_files_internal(const char *path, const char *mime_type,
 		snprintf(buf, sizeof (buf), "%s%s%s", path, slash, dentry->d_name);
 		if(dentry->d_type == DT_DIR)
 		{
-			parse_desktop_files(buf, mime_type);
+			index_dir(index, buf);
 		}
 		else
 		{
-			process_file(buf, mime_type, result);
+			index_file(index, buf);
 		}
 	}
 
 	os_closedir(dir);
 }
 
+/* Parses .desktop file and adds application it describes to the index. */
 static void
-process_file(const char *path, const char *file_mime_type,
-		assoc_records_t *result)
+index_file(desktop_index_t *index, const char path[])
 {
 	FILE *f;
 	char exec[1024] = "", mime_type[2048] = "", name[2048] = "";
 	char buf[2048];
+	char *mime, *state;
+	desktop_app_t *app;
+	struct stat st;
+	void *p;
 
-	if(!ends_with(path, ".desktop") || (f = os_fopen(path, "r")) == NULL)
+	if(!ends_with(path, ".desktop") || os_stat(path, &st) != 0 ||
+			(f = os_fopen(path, "r")) == NULL)
 	{
 		return;
 	}
 
+	/* Files can be edited in place without affecting mtime of their parent. */
+	remember_path(index, path, st.st_mtime);
+
 	while(fgets(buf, sizeof(buf), f) != NULL)
 	{
 		chomp(buf);
@@ -125,13 +317,92 @@ process_file(const char *path, const char *file_mime_type,
 
 	fclose(f);
 
-	if(strstr(mime_type, file_mime_type) == NULL || exec[0] == '\0')
+	if(mime_type[0] == '\0' || exec[0] == '\0')
 	{
 		return;
 	}
 
+	p = reallocarray(index->apps, index->napps + 1, sizeof(*index->apps));
+	if(p == NULL)
+	{
+		return;
+	}
+	index->apps = p;
+
 	expand_desktop(exec, buf);
-	ft_assoc_record_add(result, buf, name);
+	app = &index->apps[index->napps];
+	app->command = strdup(buf);
+	app->name = strdup(name);
+	if(app->command == NULL || app->name == NULL)
+	{
+		free(app->command);
+		free(app->name);
+		return;
+	}
+
+	for(mime = strtok_r(mime_type, ";", &state); mime != NULL;
+			mime = strtok_r(NULL, ";", &state))
+	{
+		add_app_to_mime(index, mime, index->napps);
+	}
+
+	++index->napps;
+}
+
+/* Adds path to the list of paths the index depends on. */
+static void
+remember_path(desktop_index_t *index, const char path[], time_t mtime)
+{
+	void *const p = reallocarray(index->paths, index->npaths + 1,
+			sizeof(*index->paths));
+	if(p == NULL)
+	{
+		return;
+	}
+
+	index->paths = p;
+	index->paths[index->npaths].path = strdup(path);
+	index->paths[index->npaths].mtime = mtime;
+	if(index->paths[index->npaths].path != NULL)
+	{
+		++index->npaths;
+	}
+}
+
+/* Registers application as a handler of the mime type. */
+static void
+add_app_to_mime(desktop_index_t *index, const char mime_type[], int app)
+{
+	void *data;
+	app_list_t *list = NULL;
+	int count = 0;
+
+	if(trie_get(index->mimes, mime_type, &data) == 0)
+	{
+		list = data;
+		count = list->count;
+
+		/* Mime type can be listed several times. */
+		if(list->apps[count - 1] == app)
+		{
+			return;
+		}
+	}
+
+	list = realloc(list, sizeof(*list) + (count + 1)*sizeof(list->apps[0]));
+	if(list == NULL)
+	{
+		return;
+	}
+
+	list->apps[count] = app;
+	list->count = count + 1;
+	/* Updating data of an existing key can't fail, so only a new list can be
+	 * left unreferenced. */
+	if(trie_set(index->mimes, mime_type, list) < 0)
+	{
+		free(list);
+	}
 }
 
 static void
@@ -21,6 +21,10 @@
 
 #include "../filetype.h"
 
+/* Looks up applications that handle the mime type among .desktop files in the
+ * path directory and its subdirectories.  Files are parsed once, index is
+ * rebuilt after modification time of any of the directories changes.  Caller
+ * should free the result with ft_assoc_records_free(). */
 assoc_records_t parse_desktop_files(const char *path, const char *mime_type);
 
 #endif /* VIFM__INT__DESKTOP_H__ */
@@ -28,20 +28,50 @@
 #include <magic.h>
 #endif
 
+#include <sys/types.h> /* mode_t */
+#include <sys/stat.h> /* S_IS*() stat */
+
 #include <stddef.h> /* size_t */
-#include <stdio.h> /* popen() */
-#include <string.h> /* strcpy() */
+#include <stdio.h> /* FILE fclose() fread() popen() snprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memchr() memcmp() strcpy() */
+#include <time.h> /* time_t */
 
+#include "../compat/os.h"
 #include "../utils/str.h"
+#include "../utils/trie.h"
+#include "../utils/macros.h"
 #include "../filetype.h"
 #include "../status.h"
 #include "desktop.h"
 
+/* Maximum number of entries in cache of mime types after which it's reset. */
+#define MIME_CACHE_MAX 4096
+
+/* Mime type detected for a particular state of a file. */
+typedef struct
+{
+	time_t mtime;       /* Modification time of the file at detection time. */
+	mode_t type;        /* Type of the file at detection time. */
+	char mimetype[128]; /* The mime type. */
+}
+mime_cache_entry_t;
+
 static assoc_records_t handlers;
 
+/* Cache of detected mime types, maps "dev:ino" to mime_cache_entry_t. */
+static trie_t mime_cache = NULL_TRIE;
+/* Number of entries in the mime_cache. */
+static int mime_cache_size;
+
+static int get_cached_mimetype(const struct stat *st, char buf[]);
+static void cache_mimetype(const struct stat *st, const char mimetype[]);
+static void format_cache_key(const struct stat *st, char buf[], size_t buf_sz);
 static int get_gtk_mimetype(const char *filename, char *buf);
 static int get_magic_mimetype(const char *filename, char *buf);
 static int get_file_mimetype(const char *filename, char *buf, size_t buf_sz);
+static int sniff_mimetype(const char filename[], int generic, char buf[]);
+static const char * get_inode_type(mode_t mode);
 static assoc_records_t get_handlers(const char *mime_type);
 #if !defined(_WIN32) && defined(ENABLE_DESKTOP_FILES)
 static void parse_app_dir(const char *directory, const char *mime_type,
@@ -60,16 +90,114 @@ get_mimetype(const char *file)
 {
 	static char mimetype[128];
 
-	if(get_gtk_mimetype(file, mimetype) == -1)
+	struct stat st;
+#ifndef _WIN32
+	const int have_stat = (os_stat(file, &st) == 0);
+#else
+	/* Inode numbers aren't meaningful here, so results aren't cached. */
+	const int have_stat = 0;
+#endif
+
+	if(have_stat && get_cached_mimetype(&st, mimetype) == 0)
+	{
+		return mimetype;
+	}
+
+	/* External program is the last resort as it requires spawning a process,
+	 * so it's tried only if file doesn't have a signature we know about. */
+	if(get_gtk_mimetype(file, mimetype) == -1 &&
+			get_magic_mimetype(file, mimetype) == -1 &&
+			sniff_mimetype(file, 0, mimetype) == -1 &&
+			get_file_mimetype(file, mimetype, sizeof(mimetype)) == -1 &&
+			sniff_mimetype(file, 1, mimetype) == -1)
+	{
+		return NULL;
+	}
+
+	if(have_stat)
+	{
+		cache_mimetype(&st, mimetype);
+	}
+
+	return mimetype;
+}
+
+/* Looks up mime type of the file in the cache.  Returns zero and fills the buf
+ * if result of previous detection is still valid, otherwise non-zero is
+ * returned. */
+static int
+get_cached_mimetype(const struct stat *st, char buf[])
+{
+	char key[64];
+	void *data;
+	const mime_cache_entry_t *entry;
+
+	format_cache_key(st, key, sizeof(key));
+	if(trie_get(mime_cache, key, &data) != 0)
+	{
+		return 1;
+	}
+
+	entry = data;
+	/* Inode number might be reused by a file of different kind. */
+	if(entry->mtime != st->st_mtime ||
+			entry->type != (st->st_mode & S_IFMT))
+	{
+		return 1;
+	}
+
+	strcpy(buf, entry->mimetype);
+	return 0;
+}
+
+/* Remembers mime type of the file. */
+static void
+cache_mimetype(const struct stat *st, const char mimetype[])
+{
+	char key[64];
+	void *data;
+	mime_cache_entry_t *entry;
+
+	format_cache_key(st, key, sizeof(key));
+
+	if(trie_get(mime_cache, key, &data) == 0)
+	{
+		entry = data;
+	}
+	else
 	{
-		if(get_magic_mimetype(file, mimetype) == -1)
+		if(mime_cache == NULL_TRIE || mime_cache_size >= MIME_CACHE_MAX)
 		{
-			if(get_file_mimetype(file, mimetype, sizeof(mimetype)) == -1)
-				return NULL;
+			trie_free_with_data(mime_cache);
+			mime_cache = trie_create();
+			mime_cache_size = 0;
 		}
+
+		entry = malloc(sizeof(*entry));
+		if(entry == NULL)
+		{
+			return;
+		}
+
+		if(trie_set(mime_cache, key, entry) < 0)
+		{
+			free(entry);
+			return;
+		}
+		++mime_cache_size;
 	}
 
-	return mimetype;
+	entry->mtime = st->st_mtime;
+	entry->type = st->st_mode & S_IFMT;
+	copy_str(entry->mimetype, sizeof(entry->mimetype), mimetype);
+}
+
+/* Formats key for the cache that identifies the file. */
+static void
+format_cache_key(const struct stat *st, char buf[], size_t buf_sz)
+{
+	snprintf(buf, buf_sz, "%llx:%llx", (unsigned long long)st->st_dev,
+			(unsigned long long)st->st_ino);
 }
 
 static int
@@ -106,21 +234,32 @@ static int
 get_magic_mimetype(const char *filename, char *buf)
 {
 #ifdef HAVE_LIBMAGIC
-	magic_t magic;
+	/* Loading database is expensive, so it's done only once. */
+	static magic_t magic;
+	static int failed;
+
 	const char *descr;
 
+	if(magic == NULL && !failed)
+	{
 #if HAVE_DECL_MAGIC_MIME_TYPE
-	magic = magic_open(MAGIC_MIME_TYPE);
+		magic = magic_open(MAGIC_MIME_TYPE);
 #else
-	magic = magic_open(MAGIC_MIME);
+		magic = magic_open(MAGIC_MIME);
 #endif
+		if(magic != NULL && magic_load(magic, NULL) != 0)
+		{
+			magic_close(magic);
+			magic = NULL;
+		}
+		failed = (magic == NULL);
+	}
+
 	if(magic == NULL)
 	{
 		return -1;
 	}
 
-	magic_load(magic, NULL);
-
 	descr = magic_file(magic, filename);
 	if(descr == NULL)
 	{
@@ -132,7 +271,6 @@ get_magic_mimetype(const char *filename, char *buf)
 	break_atr(buf, ';');
 #endif
 
-	magic_close(magic);
 	return 0;
 #else /* #ifdef HAVE_LIBMAGIC */
 	return -1;
@@ -169,6 +307,120 @@ get_file_mimetype(const char *filename, char *buf, size_t buf_sz)
 #endif /* #ifdef HAVE_FILE_PROG */
 }
 
+/* Determines mime type of the file by looking at its first bytes.  When
+ * generic is zero, only well-known signatures are recognized, otherwise file
+ * is classified as either text or binary data.  Returns zero on success and -1
+ * on failure. */
+static int
+sniff_mimetype(const char filename[], int generic, char buf[])
+{
+	static const struct
+	{
+		const char *magic; /* Signature at the beginning of the file. */
+		size_t len;        /* Length of the signature. */
+		const char *type;  /* Corresponding mime type. */
+	}
+	signatures[] = {
+		{ "\x89PNG\r\n\x1a\n",     8, "image/png" },
+		{ "\xff\xd8\xff",           3, "image/jpeg" },
+		{ "GIF87a",                6, "image/gif" },
+		{ "GIF89a",                6, "image/gif" },
+		{ "%PDF-",                 5, "application/pdf" },
+		{ "PK\x03\x04",            4, "application/zip" },
+		{ "\x1f\x8b",              2, "application/gzip" },
+		{ "BZh",                   3, "application/x-bzip2" },
+		{ "\xfd" "7zXZ\0",         6, "application/x-xz" },
+		{ "7z\xbc\xaf\x27\x1c",     6, "application/x-7z-compressed" },
+		{ "\x7f" "ELF",            4, "application/x-executable" },
+	};
+
+	char data[512];
+	size_t len;
+	size_t i;
+	struct stat st;
+	FILE *f;
+
+	if(os_stat(filename, &st) != 0)
+	{
+		return -1;
+	}
+
+	/* Only regular files are read, reading others might block or have side
+	 * effects. */
+	if(!S_ISREG(st.st_mode))
+	{
+		strcpy(buf, get_inode_type(st.st_mode));
+		return 0;
+	}
+
+	f = os_fopen(filename, "rb");
+	if(f == NULL)
+	{
+		return -1;
+	}
+	len = fread(data, 1, sizeof(data), f);
+	fclose(f);
+
+	for(i = 0U; i < ARRAY_LEN(signatures); ++i)
+	{
+		if(len >= signatures[i].len &&
+				memcmp(data, signatures[i].magic, signatures[i].len) == 0)
+		{
+			strcpy(buf, signatures[i].type);
+			return 0;
+		}
+	}
+
+	if(!generic)
+	{
+		return -1;
+	}
+
+	if(len == 0U)
+	{
+		strcpy(buf, "inode/x-empty");
+	}
+	else if(memchr(data, '\0', len) == NULL)
+	{
+		strcpy(buf, "text/plain");
+	}
+	else
+	{
+		strcpy(buf, "application/octet-stream");
+	}
+	return 0;
+}
+
+/* Maps type of a file that isn't a regular one to a mime type.  Returns the
+ * mime type. */
+static const char *
+get_inode_type(mode_t mode)
+{
+	if(S_ISDIR(mode))
+	{
+		return "inode/directory";
+	}
+#ifndef _WIN32
+	if(S_ISCHR(mode))
+	{
+		return "inode/chardevice";
+	}
+	if(S_ISBLK(mode))
+	{
+		return "inode/blockdevice";
+	}
+	if(S_ISFIFO(mode))
+	{
+		return "inode/fifo";
+	}
+	if(S_ISSOCK(mode))
+	{
+		return "inode/socket";
+	}
+#endif
+	return "application/octet-stream";
+}
+
 static assoc_records_t
 get_handlers(const char *mime_type)
 {
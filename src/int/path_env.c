@@ -18,9 +18,10 @@
 
 #include "path_env.h"
 
+#include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* snprintf() sprintf() */
-#include <stdlib.h> /* malloc() free() */
-#include <string.h> /* strchr() strlen() */
+#include <stdlib.h> /* calloc() free() malloc() qsort() */
+#include <string.h> /* strchr() strcmp() strlen() strncmp() */
 
 #include "../cfg/config.h"
 #include "../compat/fs_limits.h"
@@ -29,19 +30,40 @@
 #include "../engine/variables.h"
 #include "../utils/env.h"
 #include "../utils/fs.h"
+#include "../utils/filemon.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
 
+/* Cached list of files of a directory from PATH. */
+typedef struct
+{
+	filemon_t mon; /* Timestamp of the directory at the moment of reading. */
+	char **names;  /* Names of files in the directory sorted by strcmp(). */
+	int count;     /* Number of elements in the names array. */
+	int valid;     /* Whether names reflect contents of the directory. */
+}
+dir_listing_t;
+
 static int path_env_was_changed(int force);
 static void append_scripts_dirs(void);
 static void add_dirs_to_path(const char *path);
 static void add_to_path(const char *path);
 static void split_path_list(void);
+static void reset_listings(void);
+static dir_listing_t * get_listing(size_t i);
+static int list_dir(const char path[], dir_listing_t *listing);
+static int name_cmp(const void *a, const void *b);
+static int find_name(const dir_listing_t *listing, const char prefix[],
+		size_t len);
 
 static char **paths;
 static int paths_count;
 
+/* Listings of directories of PATH, which are in sync with the paths array.
+ * Elements are filled on demand. */
+static dir_listing_t *listings;
+
 static char *clean_path;
 static char *real_path;
 
@@ -160,6 +182,8 @@ split_path_list(void)
 
 	path = env_get("PATH");
 
+	reset_listings();
+
 	if(paths != NULL)
 		free_string_array(paths, paths_count);
 
@@ -234,6 +258,209 @@ split_path_list(void)
 	}
 	while(q[0] != '\0');
 	paths_count = i;
+
+	listings = calloc(paths_count, sizeof(*listings));
+}
+
+/* Frees listings of directories of PATH. */
+static void
+reset_listings(void)
+{
+	int i;
+
+	if(listings == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < paths_count; ++i)
+	{
+		free_string_array(listings[i].names, listings[i].count);
+	}
+	free(listings);
+	listings = NULL;
+}
+
+int
+path_dir_lacks(size_t i, const char name[])
+{
+	const dir_listing_t *listing;
+
+	if(strchr(name, '/') != NULL)
+	{
+		return 0;
+	}
+
+	listing = get_listing(i);
+	return listing != NULL && find_name(listing, name, (size_t)-1) == -1;
+}
+
+int
+list_path_dir(size_t i, const char prefix[], path_dir_cb cb, void *arg)
+{
+	const size_t len = strlen(prefix);
+	int pos;
+	const dir_listing_t *const listing = get_listing(i);
+	if(listing == NULL)
+	{
+		return 1;
+	}
+
+	pos = find_name(listing, prefix, len);
+	if(pos == -1)
+	{
+		return 0;
+	}
+
+	/* Names that start with the prefix form a range that begins at the found
+	 * one or before it. */
+	while(pos > 0 && strncmp(listing->names[pos - 1], prefix, len) == 0)
+	{
+		--pos;
+	}
+
+	for(; pos < listing->count; ++pos)
+	{
+		const char *const name = listing->names[pos];
+		if(strncmp(name, prefix, len) != 0)
+		{
+			break;
+		}
+
+		if(prefix[0] == '\0' && name[0] == '.')
+		{
+			continue;
+		}
+
+		cb(paths[i], name, arg);
+	}
+
+	return 0;
+}
+
+/* Retrieves up-to-date listing of i-th directory of PATH.  Returns the listing
+ * or NULL if it's not available. */
+static dir_listing_t *
+get_listing(size_t i)
+{
+#ifndef _WIN32
+	dir_listing_t *listing;
+	filemon_t mon;
+
+	if(listings == NULL || i >= (size_t)paths_count)
+	{
+		return NULL;
+	}
+
+	/* Timestamp is taken before reading the directory to not miss changes.
+	 * Watchers aren't used as there can be quite a lot of directories in PATH
+	 * and each of them would require an inotify instance. */
+	listing = &listings[i];
+	if(filemon_from_file(paths[i], &mon) != 0)
+	{
+		listing->valid = 0;
+		return NULL;
+	}
+
+	if(listing->valid && filemon_equal(&listing->mon, &mon))
+	{
+		return listing;
+	}
+
+	filemon_assign(&listing->mon, &mon);
+	if(list_dir(paths[i], listing) != 0)
+	{
+		listing->valid = 0;
+		return NULL;
+	}
+
+	return listing;
+#else
+	/* Names of executables don't include their extensions on Windows, so they
+	 * can't be looked up that easily. */
+	return NULL;
+#endif
+}
+
+/* Reads names of files of the directory into the listing.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+list_dir(const char path[], dir_listing_t *listing)
+{
+	DIR *dir;
+	struct dirent *dentry;
+
+	free_string_array(listing->names, listing->count);
+	listing->names = NULL;
+	listing->count = 0;
+
+	dir = os_opendir(path);
+	if(dir == NULL)
+	{
+		return 1;
+	}
+
+	while((dentry = os_readdir(dir)) != NULL)
+	{
+		const int count = listing->count;
+		if(is_builtin_dir(dentry->d_name))
+		{
+			continue;
+		}
+
+		listing->count = add_to_string_array(&listing->names, count, 1,
+				dentry->d_name);
+		if(listing->count == count)
+		{
+			os_closedir(dir);
+			return 1;
+		}
+	}
+	os_closedir(dir);
+
+	qsort(listing->names, listing->count, sizeof(*listing->names), &name_cmp);
+	listing->valid = 1;
+	return 0;
+}
+
+/* Comparer of names for qsort().  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+name_cmp(const void *a, const void *b)
+{
+	return strcmp(*(const char **)a, *(const char **)b);
+}
+
+/* Finds name in the listing.  When len isn't (size_t)-1, it's the length of
+ * the prefix, which is used for comparison instead of the whole name.  Returns
+ * index of some matching name or -1 if there is none. */
+static int
+find_name(const dir_listing_t *listing, const char prefix[], size_t len)
+{
+	int l = 0, r = listing->count - 1;
+
+	while(l <= r)
+	{
+		const int m = l + (r - l)/2;
+		const int cmp = (len == (size_t)-1)
+		              ? strcmp(listing->names[m], prefix)
+		              : strncmp(listing->names[m], prefix, len);
+		if(cmp == 0)
+		{
+			return m;
+		}
+
+		if(cmp < 0)
+		{
+			l = m + 1;
+		}
+		else
+		{
+			r = m - 1;
+		}
+	}
+
+	return -1;
 }
 
 void
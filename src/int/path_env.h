@@ -21,6 +21,9 @@
 
 #include <stddef.h> /* size_t */
 
+/* Callback for list_path_dir() that receives directory and name of a file. */
+typedef void (*path_dir_cb)(const char dir[], const char name[], void *arg);
+
 /* Asks for updating of PATH if needed (or if force parameters is true). */
 void update_path_env(int force);
 
@@ -29,6 +32,18 @@ void update_path_env(int force);
  * the count argument. */
 char ** get_paths(size_t *count);
 
+/* Checks cached list of files of i-th directory returned by get_paths() for the
+ * name.  The list is re-read when the directory changes.  Returns non-zero if
+ * there is certainly no such file in the directory, otherwise zero is
+ * returned. */
+int path_dir_lacks(size_t i, const char name[]);
+
+/* Calls the cb for each file of i-th directory returned by get_paths() which
+ * name starts with the prefix using cached list of files.  Dot files are
+ * skipped for empty prefix.  Returns zero on success, otherwise non-zero is
+ * returned, which means that the directory should be read directly. */
+int list_path_dir(size_t i, const char prefix[], path_dir_cb cb, void *arg);
+
 /* Sets PATH to its value that was set by user or another program. Use
  * load_real_path_env() function to revert this effect. */
 void load_clean_path_env(void);
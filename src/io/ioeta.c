@@ -25,6 +25,7 @@
 
 #include "../ui/cancellation.h"
 #include "private/ioeta.h"
+#include "private/manifest.h"
 #include "private/traverser.h"
 
 static VisitResult eta_visitor(const char full_path[], VisitAction action,
@@ -43,12 +44,22 @@ ioeta_free(ioeta_estim_t *estim)
 {
 	if(estim != NULL)
 	{
+		manifest_free(estim->manifest);
 		free(estim->item);
 		free(estim->target);
 		free(estim);
 	}
 }
 
+void
+ioeta_use_manifest(ioeta_estim_t *estim)
+{
+	if(estim->manifest == NULL)
+	{
+		estim->manifest = manifest_create(estim);
+	}
+}
+
 void
 ioeta_calculate(ioeta_estim_t *estim, const char path[], int shallow)
 {
@@ -56,7 +67,7 @@ ioeta_calculate(ioeta_estim_t *estim, const char path[], int shallow)
 	{
 		ioeta_add_item(estim, path);
 	}
-	else
+	else if(estim->manifest == NULL || manifest_add(estim->manifest, path) != 0)
 	{
 		(void)traverse(path, &eta_visitor, estim);
 	}
@@ -56,11 +56,21 @@ typedef struct
 	 * removal). */
 	char *target;
 
+	/* Sizes of buffers allocated for item and target, they are reused to avoid
+	 * reallocations on every update. */
+	size_t item_size, target_size;
+
+	/* Time of the last progress notification in milliseconds or zero. */
+	uint64_t last_notified;
+
 	/* Progress reported while this flag is on is ignored. */
 	int silent;
 
 	/* Custom parameter for notification callbacks. */
 	void *param;
+
+	/* Entries of subtrees collected for the operation or NULL. */
+	struct manifest_t *manifest;
 }
 ioeta_estim_t;
 
@@ -70,6 +80,11 @@ ioeta_estim_t * ioeta_alloc(void *param);
 /* Frees ioeta_estim_t.  The estim can be NULL. */
 void ioeta_free(ioeta_estim_t *estim);
 
+/* Makes future estimations scan subtrees in background and record their
+ * entries to be reused by the operation instead of traversing file system once
+ * again.  Totals grow while scanning is in progress. */
+void ioeta_use_manifest(ioeta_estim_t *estim);
+
 /* Calculates estimates for a subtree rooted at path.  Adds them up to values
  * already present in the estim.  Shallow estimation doesn't recur into
  * directories. */
@@ -24,15 +24,24 @@
 
 #include "iop.h"
 
-#include <sys/stat.h> /* stat */
-#include <sys/types.h> /* mode_t */
-#include <unistd.h> /* rmdir() symlink() unlink() */
+#ifdef __linux__
+#include <linux/fs.h> /* FICLONE */
+#include <sys/ioctl.h> /* ioctl() */
+#include <sys/sendfile.h> /* sendfile() */
+#include <sys/syscall.h> /* SYS_copy_file_range */
+#endif
+
+#include <sys/stat.h> /* stat fstat() */
+#include <sys/types.h> /* mode_t off_t ssize_t */
+#include <fcntl.h> /* F_GETFL F_SETFL O_APPEND fcntl() */
+#include <unistd.h> /* ftruncate() lseek() pread() pwrite() read() rmdir()
+                       symlink() syscall() sysconf() unlink() write() */
 
 #include <errno.h> /* EEXIST ENOENT EISDIR errno */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE fpos_t fclose() fgetpos() fread() fseek() fsetpos()
-                      fwrite() snprintf() */
-#include <stdlib.h> /* free() */
+#include <stdio.h> /* FILE fpos_t fclose() fgetpos() fileno() fread() fseek()
+                      fsetpos() fwrite() snprintf() */
+#include <stdlib.h> /* free() malloc() posix_memalign() */
 #include <string.h> /* strchr() strerror() */
 
 #include "../compat/fs_limits.h"
@@ -50,14 +59,50 @@
 #include "private/ioeta.h"
 #include "ioc.h"
 
+#ifdef _WIN32
+
 /* Amount of data to transfer at once. */
 #define BLOCK_SIZE 32*1024
 
+#else
+
+/* Amount of data to transfer at once.  Progress is reported and cancellation
+ * is checked after each block. */
+#define COPY_BLOCK_SIZE 1024*1024
+
+/* Methods of copying data between files, from the fastest to the slowest. */
+typedef enum
+{
+	CM_COPY_FILE_RANGE, /* copy_file_range(), in-kernel and possibly reflink. */
+	CM_SENDFILE,        /* sendfile(), in-kernel. */
+	CM_BUFFER,          /* pread()/pwrite() through user-space buffer. */
+}
+copy_method_t;
+
+/* State of copying file contents. */
+typedef struct
+{
+	copy_method_t method; /* Method that is currently in use. */
+	char *buf;            /* Buffer for CM_BUFFER method or NULL. */
+}
+copy_state_t;
+
+#endif
+
 #ifdef _WIN32
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		LARGE_INTEGER transferred, LARGE_INTEGER stream_size,
 		LARGE_INTEGER stream_transfered, DWORD stream_num, DWORD reason,
 		HANDLE src_file, HANDLE dst_file, LPVOID param);
+#else
+static int copy_contents(io_args_t *args, int in_fd, int out_fd, int append);
+static int copy_till_eof(io_args_t *args, int in_fd, int out_fd);
+static off_t find_data(int fd, off_t from, off_t size, off_t *data_end);
+static ssize_t copy_block(copy_state_t *state, int in_fd, off_t *in_off,
+		int out_fd, off_t *out_off, size_t len);
+static ssize_t copy_via_buffer(copy_state_t *state, int in_fd, off_t *in_off,
+		int out_fd, off_t *out_off, size_t len);
+static int is_unsupported_error(int error);
 #endif
 
 int
@@ -237,9 +282,11 @@ iop_cp(io_args_t *const args)
 	const int cancellable = args->cancellable;
 	struct stat st;
 
+#ifdef _WIN32
 	char block[BLOCK_SIZE];
-	FILE *in, *out;
 	size_t nread;
+#endif
+	FILE *in, *out;
 	int error;
 	struct stat src_st;
 	const char *open_mode = "wb";
@@ -469,8 +516,13 @@ iop_cp(io_args_t *const args)
 		}
 	}
 
-	/* TODO: use sendfile() if platform supports it. */
-
+#ifndef _WIN32
+	if(!error)
+	{
+		error = copy_contents(args, fileno(in), fileno(out),
+				crs == IO_CRS_APPEND_TO_FILES);
+	}
+#else
 	while((nread = fread(&block, 1, sizeof(block), in)) != 0U)
 	{
 		if(cancellable && ui_cancellation_requested())
@@ -493,6 +545,7 @@ iop_cp(io_args_t *const args)
 	{
 		(void)ioe_errlst_append(&args->result.errors, src, errno, strerror(errno));
 	}
+#endif
 
 	if(fclose(in) != 0)
 	{
@@ -523,7 +576,341 @@ iop_cp(io_args_t *const args)
 	return error;
 }
 
-#ifdef _WIN32
+#ifndef _WIN32
+
+/* Copies contents of the file starting at current position of in_fd to the end
+ * of out_fd.  Tries to clone the file first, then uses in-kernel copying and
+ * falls back to copying through a buffer.  Holes of sparse files are
+ * preserved.  Returns zero on success, otherwise non-zero is returned. */
+static int
+copy_contents(io_args_t *args, int in_fd, int out_fd, int append)
+{
+	const char *const src = args->arg1.src;
+	const char *const dst = args->arg2.dst;
+
+	struct stat st;
+	off_t in_off, out_off;
+	copy_state_t state = { .method = CM_COPY_FILE_RANGE, .buf = NULL };
+	int error = 0;
+
+	in_off = lseek(in_fd, 0, SEEK_CUR);
+	if(fstat(in_fd, &st) != 0 || in_off == (off_t)-1)
+	{
+		(void)ioe_errlst_append(&args->result.errors, src, errno, strerror(errno));
+		return 1;
+	}
+
+	/* Size of pseudo files (like those in /proc or /sys) can't be relied upon. */
+	if(!S_ISREG(st.st_mode) || st.st_size == 0)
+	{
+		return copy_till_eof(args, in_fd, out_fd);
+	}
+
+	out_off = lseek(out_fd, 0, SEEK_END);
+	if(out_off == (off_t)-1)
+	{
+		(void)ioe_errlst_append(&args->result.errors, dst, errno, strerror(errno));
+		return 1;
+	}
+
+	if(append)
+	{
+		/* Writes use explicit offsets, which in-kernel copying doesn't allow in
+		 * combination with O_APPEND. */
+		const int flags = fcntl(out_fd, F_GETFL);
+		if(flags != -1)
+		{
+			(void)fcntl(out_fd, F_SETFL, flags & ~O_APPEND);
+		}
+	}
+#if defined(__linux__) && defined(FICLONE)
+	/* Sharing extents of the source is the cheapest way to copy a whole file. */
+	else if(in_off == 0 && ioctl(out_fd, FICLONE, in_fd) == 0)
+	{
+		ioeta_update(args->estim, NULL, NULL, 0, st.st_size);
+		return 0;
+	}
+#endif
+
+	while(in_off < st.st_size && !error)
+	{
+		off_t data_end;
+		const off_t data = find_data(in_fd, in_off, st.st_size, &data_end);
+
+		/* Skip hole by leaving corresponding part of destination unwritten. */
+		if(data > in_off)
+		{
+			ioeta_update(args->estim, NULL, NULL, 0, data - in_off);
+			out_off += data - in_off;
+			in_off = data;
+			continue;
+		}
+
+		while(in_off < data_end)
+		{
+			ssize_t ncopied;
+
+			if(args->cancellable && ui_cancellation_requested())
+			{
+				error = 1;
+				break;
+			}
+
+			ncopied = copy_block(&state, in_fd, &in_off, out_fd, &out_off,
+					MIN(data_end - in_off, COPY_BLOCK_SIZE));
+			if(ncopied < 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, dst, errno,
+						strerror(errno));
+				error = 1;
+				break;
+			}
+			if(ncopied == 0)
+			{
+				/* The file got shorter while it was being copied. */
+				st.st_size = in_off;
+				break;
+			}
+
+			ioeta_update(args->estim, NULL, NULL, 0, ncopied);
+		}
+	}
+
+	free(state.buf);
+
+	/* Trailing hole isn't created by writes. */
+	if(!error && ftruncate(out_fd, out_off) != 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, dst, errno, strerror(errno));
+		error = 1;
+	}
+
+	return error;
+}
+
+/* Copies contents of the file starting at current position of in_fd to the
+ * current position of out_fd by reading until end of file is reached.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+copy_till_eof(io_args_t *args, int in_fd, int out_fd)
+{
+	ssize_t nread;
+	int error = 0;
+
+	char *const buf = malloc(COPY_BLOCK_SIZE);
+	if(buf == NULL)
+	{
+		(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, ENOMEM,
+				strerror(ENOMEM));
+		return 1;
+	}
+
+	while((nread = read(in_fd, buf, COPY_BLOCK_SIZE)) != 0)
+	{
+		ssize_t nwritten = 0;
+
+		if(nread < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
+					strerror(errno));
+			error = 1;
+			break;
+		}
+
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			error = 1;
+			break;
+		}
+
+		while(nwritten < nread)
+		{
+			const ssize_t n = write(out_fd, buf + nwritten, nread - nwritten);
+			if(n < 0 && errno != EINTR)
+			{
+				(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+						strerror(errno));
+				error = 1;
+				break;
+			}
+			nwritten += MAX(n, 0);
+		}
+		if(error)
+		{
+			break;
+		}
+
+		ioeta_update(args->estim, NULL, NULL, 0, nread);
+	}
+
+	free(buf);
+	return error;
+}
+
+/* Finds next region of data in the file at or after the from offset.  Sets
+ * *data_end to the end of that region.  Returns beginning of the region, which
+ * is equal to size if there is no more data. */
+static off_t
+find_data(int fd, off_t from, off_t size, off_t *data_end)
+{
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+	const off_t data = lseek(fd, from, SEEK_DATA);
+	if(data == (off_t)-1)
+	{
+		*data_end = size;
+		/* ENXIO means that there is only a hole till the end of the file,
+		 * otherwise holes are just not supported. */
+		return (errno == ENXIO) ? size : from;
+	}
+
+	*data_end = lseek(fd, data, SEEK_HOLE);
+	if(*data_end == (off_t)-1 || *data_end > size)
+	{
+		*data_end = size;
+	}
+	return MIN(data, size);
+#else
+	*data_end = size;
+	return from;
+#endif
+}
+
+/* Copies at most len bytes between files at specified offsets, which are
+ * advanced.  Switches to the next copying method if current one isn't
+ * supported for these files.  Returns number of copied bytes, zero on end of
+ * file and -1 on error with errno set. */
+static ssize_t
+copy_block(copy_state_t *state, int in_fd, off_t *in_off, int out_fd,
+		off_t *out_off, size_t len)
+{
+	switch(state->method)
+	{
+		case CM_COPY_FILE_RANGE:
+#if defined(__linux__) && defined(SYS_copy_file_range)
+			{
+				loff_t in = *in_off, out = *out_off;
+				const ssize_t ncopied = syscall(SYS_copy_file_range, in_fd, &in, out_fd,
+						&out, len, 0U);
+				/* Pseudo files can report zero bytes copied before end of file, let
+				 * the next method handle them. */
+				if(ncopied > 0)
+				{
+					*in_off = in;
+					*out_off = out;
+					return ncopied;
+				}
+				if(ncopied < 0 && !is_unsupported_error(errno))
+				{
+					return -1;
+				}
+			}
+#endif
+			state->method = CM_SENDFILE;
+			/* Fall through. */
+		case CM_SENDFILE:
+#ifdef __linux__
+			{
+				ssize_t ncopied;
+
+				if(lseek(out_fd, *out_off, SEEK_SET) == (off_t)-1)
+				{
+					return -1;
+				}
+
+				ncopied = sendfile(out_fd, in_fd, in_off, len);
+				if(ncopied > 0)
+				{
+					*out_off += ncopied;
+					return ncopied;
+				}
+				if(ncopied < 0 && !is_unsupported_error(errno))
+				{
+					return -1;
+				}
+			}
+#endif
+			state->method = CM_BUFFER;
+			/* Fall through. */
+		case CM_BUFFER:
+			return copy_via_buffer(state, in_fd, in_off, out_fd, out_off, len);
+	}
+
+	return -1;
+}
+
+/* Copies at most len bytes between files at specified offsets through a buffer
+ * in memory.  Returns number of copied bytes, zero on end of file and -1 on
+ * error with errno set. */
+static ssize_t
+copy_via_buffer(copy_state_t *state, int in_fd, off_t *in_off, int out_fd,
+		off_t *out_off, size_t len)
+{
+	ssize_t nread;
+	ssize_t nwritten;
+
+	if(state->buf == NULL)
+	{
+		/* Page-aligned buffer lets kernel avoid some unnecessary work. */
+		long page_size = sysconf(_SC_PAGESIZE);
+		void *buf;
+		if(page_size <= 0)
+		{
+			page_size = 4096;
+		}
+
+		errno = posix_memalign(&buf, page_size, COPY_BLOCK_SIZE);
+		if(errno != 0)
+		{
+			return -1;
+		}
+		state->buf = buf;
+	}
+
+	do
+	{
+		nread = pread(in_fd, state->buf, MIN(len, COPY_BLOCK_SIZE), *in_off);
+	}
+	while(nread < 0 && errno == EINTR);
+	if(nread <= 0)
+	{
+		return nread;
+	}
+
+	nwritten = 0;
+	while(nwritten < nread)
+	{
+		const ssize_t n = pwrite(out_fd, state->buf + nwritten, nread - nwritten,
+				*out_off + nwritten);
+		if(n < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return -1;
+		}
+		nwritten += n;
+	}
+
+	*in_off += nread;
+	*out_off += nread;
+	return nread;
+}
+
+/* Checks whether error code signals that copying method isn't supported for
+ * particular files.  Returns non-zero if so, otherwise zero is returned. */
+static int
+is_unsupported_error(int error)
+{
+	return error == ENOSYS || error == EXDEV || error == EINVAL
+	    || error == EOPNOTSUPP || error == ENOTSUP || error == EBADF;
+}
+
+#else
 
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		LARGE_INTEGER transferred, LARGE_INTEGER stream_size,
@@ -37,6 +37,7 @@
 #include "../background.h"
 #include "private/ioe.h"
 #include "private/ioeta.h"
+#include "private/manifest.h"
 #include "private/traverser.h"
 #include "ioc.h"
 #include "iop.h"
@@ -45,6 +46,7 @@ static VisitResult rm_visitor(const char full_path[], VisitAction action,
 		void *param);
 static VisitResult cp_visitor(const char full_path[], VisitAction action,
 		void *param);
+static int traverse_src(io_args_t *args, subtree_visitor visitor);
 static int is_file(const char path[]);
 static VisitResult mv_visitor(const char full_path[], VisitAction action,
 		void *param);
@@ -149,7 +151,7 @@ ior_cp(io_args_t *const args)
 		}
 	}
 
-	return traverse(src, &cp_visitor, args);
+	return traverse_src(args, &cp_visitor);
 }
 
 /* Implementation of traverse() visitor for subtree copying.  Returns 0 on
@@ -160,6 +162,22 @@ cp_visitor(const char full_path[], VisitAction action, void *param)
 	return cp_mv_visitor(full_path, action, param, 1);
 }
 
+/* Traverses source of copying/moving reusing entries collected during
+ * estimation when they are available.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+traverse_src(io_args_t *args, subtree_visitor visitor)
+{
+	int result;
+	if(args->estim != NULL &&
+			manifest_traverse(args->estim->manifest, args->arg1.src, visitor, args,
+				&result))
+	{
+		return result;
+	}
+	return traverse(args->arg1.src, visitor, args);
+}
+
 int
 ior_mv(io_args_t *const args)
 {
@@ -297,7 +315,7 @@ ior_mv(io_args_t *const args)
 					}
 				}
 
-				return traverse(src, &mv_visitor, args);
+				return traverse_src(args, &mv_visitor);
 			}
 			/* Break is intentionally omitted. */
 
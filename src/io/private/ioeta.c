@@ -18,20 +18,37 @@
 
 #include "ioeta.h"
 
-#include <stddef.h> /* NULL */
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() timespec */
+#endif
+
+#include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* realloc() */
+#include <string.h> /* memcpy() strcmp() strlen() */
 
 #include "../../utils/fs.h"
-#include "../../utils/str.h"
 #include "../ioeta.h"
 #include "ionotif.h"
+#include "manifest.h"
+
+/* Minimal interval between progress notifications in milliseconds.  Updates
+ * happen after every block of data, reporting each of them is just a waste of
+ * time. */
+#define NOTIFY_INTERVAL 100
+
+static void set_path(char **field, size_t *size, const char path[]);
+static int should_notify(ioeta_estim_t *estim);
+static uint64_t get_ms(void);
 
 void
 ioeta_add_item(ioeta_estim_t *estim, const char path[])
 {
 	++estim->total_items;
 
-	replace_string(&estim->item, path);
+	set_path(&estim->item, &estim->item_size, path);
 
 	ionotif_notify(IO_PS_ESTIMATING, estim);
 }
@@ -50,7 +67,7 @@ ioeta_add_file(ioeta_estim_t *estim, const char path[])
 void
 ioeta_add_dir(ioeta_estim_t *estim, const char path[])
 {
-	replace_string(&estim->item, path);
+	set_path(&estim->item, &estim->item_size, path);
 
 	ionotif_notify(IO_PS_ESTIMATING, estim);
 }
@@ -64,6 +81,9 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 		return;
 	}
 
+	/* Totals might be updated by scanner of the manifest. */
+	manifest_lock(estim->manifest);
+
 	estim->current_byte += bytes;
 	estim->current_file_byte += bytes;
 	if(estim->current_byte > estim->total_bytes)
@@ -91,15 +111,20 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 
 	if(path != NULL)
 	{
-		replace_string(&estim->item, path);
+		set_path(&estim->item, &estim->item_size, path);
 	}
 
 	if(target != NULL)
 	{
-		replace_string(&estim->target, target);
+		set_path(&estim->target, &estim->target_size, target);
 	}
 
-	ionotif_notify(IO_PS_IN_PROGRESS, estim);
+	if(should_notify(estim))
+	{
+		ionotif_notify(IO_PS_IN_PROGRESS, estim);
+	}
+
+	manifest_unlock(estim->manifest);
 }
 
 int
@@ -126,5 +151,62 @@ ioeta_silent_set(ioeta_estim_t *estim, int silent)
 	}
 }
 
+/* Updates path stored in the estimation reusing its buffer when possible. */
+static void
+set_path(char **field, size_t *size, const char path[])
+{
+	const size_t len = strlen(path) + 1U;
+
+	if(*field != NULL && strcmp(*field, path) == 0)
+	{
+		return;
+	}
+
+	if(len > *size)
+	{
+		char *const buf = realloc(*field, len);
+		if(buf == NULL)
+		{
+			return;
+		}
+		*field = buf;
+		*size = len;
+	}
+
+	memcpy(*field, path, len);
+}
+
+/* Rate-limits progress notifications, but never skips the first and the last
+ * ones.  Returns non-zero if progress should be reported now. */
+static int
+should_notify(ioeta_estim_t *estim)
+{
+	const uint64_t now = get_ms();
+
+	if(estim->last_notified != 0U && estim->current_item < estim->total_items &&
+			now - estim->last_notified < NOTIFY_INTERVAL)
+	{
+		return 0;
+	}
+
+	/* Zero is reserved for "never". */
+	estim->last_notified = (now == 0U) ? 1U : now;
+	return 1;
+}
+
+/* Retrieves current time of monotonic clock.  Returns the time in
+ * milliseconds. */
+static uint64_t
+get_ms(void)
+{
+#ifndef _WIN32
+	struct timespec ts;
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000ULL + ts.tv_nsec/1000000;
+#else
+	return GetTickCount64();
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
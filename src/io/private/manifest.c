@@ -0,0 +1,662 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "manifest.h"
+
+#include <pthread.h> /* PTHREAD_* pthread_* */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcpy() strdup() strlen() */
+
+#include "../../compat/fs_limits.h"
+#include "../../compat/os.h"
+#include "../../utils/fs.h"
+#include "../../utils/path.h"
+#include "../../utils/str.h"
+#include "../ioeta.h"
+#include "traverser.h"
+
+/* Manifest stores entries of each subtree in the order in which traverse()
+ * would visit them.  Entries are packed into blocks, which are appended by the
+ * scanner and released by the reader as soon as it's done with them, so memory
+ * is only occupied by the part of the tree that was scanned but not processed
+ * yet.  Directory entry is followed by entries of its children and an end
+ * marker, which is enough to restore full paths during replay. */
+
+/* Maximum number of entries in a block. */
+#define BLOCK_ENTRIES 1024
+
+/* Size of storage for names in a block, must fit a path. */
+#define BLOCK_NAMES (16*1024)
+
+/* Kinds of manifest entries. */
+typedef enum
+{
+	EK_FILE,   /* File, symbolic link or anything that isn't traversed. */
+	EK_DIR,    /* Directory, its entries and EK_END follow it. */
+	EK_END,    /* End of entries of a directory. */
+	EK_FAILED, /* Directory that couldn't be opened. */
+}
+EntryKind;
+
+/* Single entry of a manifest. */
+typedef struct
+{
+	uint64_t size;      /* Size of a file. */
+	unsigned int name;  /* Offset of the name in storage of the block. */
+	unsigned char kind; /* Kind of the entry (EntryKind). */
+}
+entry_t;
+
+/* Chunk of entries of a subtree. */
+typedef struct block_t
+{
+	struct block_t *next;           /* Next block of the subtree. */
+	int count;                      /* Number of published entries. */
+	size_t names_len;               /* Used part of the storage of names. */
+	entry_t entries[BLOCK_ENTRIES]; /* Entries of the block. */
+	char names[BLOCK_NAMES];        /* Storage for names of entries. */
+}
+block_t;
+
+/* Subtree queued for scanning. */
+typedef struct root_t
+{
+	struct root_t *next; /* Next queued subtree. */
+	char *path;          /* Path to the root of the subtree. */
+	block_t *head;       /* First block that wasn't consumed yet. */
+	block_t *tail;       /* Block that is being filled by the scanner. */
+	int done;            /* Whether scanner is done with this subtree. */
+	int dropped;         /* Whether entries of this subtree are not needed. */
+	int replaying;       /* Whether this subtree is being replayed. */
+}
+root_t;
+
+/* Manifest of all subtrees queued for an operation. */
+struct manifest_t
+{
+	ioeta_estim_t *estim; /* Estimation to update totals of. */
+	root_t *roots;        /* Queue of subtrees in order of addition. */
+	root_t *last;         /* Last element of the queue. */
+	root_t *to_scan;      /* Next subtree to be scanned. */
+	int stop;             /* Signals scanner to finish. */
+	int started;          /* Whether scanner thread was started. */
+	int waiters;          /* Number of threads waiting on the condition. */
+	pthread_t scanner;    /* Thread that scans subtrees. */
+	pthread_mutex_t lock; /* Protects this structure and published entries. */
+	pthread_cond_t cond;  /* Signals changes of this structure. */
+};
+
+static void * scanner_main(void *arg);
+static void scan_root(manifest_t *m, root_t *r);
+static int scan_dir(manifest_t *m, root_t *r, char path[], size_t len,
+		const char name[]);
+static int append_entry(manifest_t *m, root_t *r, EntryKind kind,
+		const char name[], uint64_t size);
+static int replay_dir(manifest_t *m, root_t *r, int *pos, char path[],
+		size_t len, subtree_visitor visitor, void *param);
+static int replay_file(manifest_t *m, const char path[], uint64_t size,
+		subtree_visitor visitor, void *param);
+static int next_entry(manifest_t *m, root_t *r, int *pos, char path[],
+		size_t len, uint64_t *size);
+static root_t * find_root(manifest_t *m, const char path[]);
+static void release_root(manifest_t *m, root_t *r);
+static void free_root(root_t *r);
+
+manifest_t *
+manifest_create(ioeta_estim_t *estim)
+{
+	manifest_t *const m = malloc(sizeof(*m));
+	if(m == NULL)
+	{
+		return NULL;
+	}
+
+	m->estim = estim;
+	m->roots = NULL;
+	m->last = NULL;
+	m->to_scan = NULL;
+	m->stop = 0;
+	m->started = 0;
+	m->waiters = 0;
+	pthread_mutex_init(&m->lock, NULL);
+	pthread_cond_init(&m->cond, NULL);
+	return m;
+}
+
+void
+manifest_free(manifest_t *m)
+{
+	if(m == NULL)
+	{
+		return;
+	}
+
+	if(m->started)
+	{
+		pthread_mutex_lock(&m->lock);
+		m->stop = 1;
+		pthread_cond_broadcast(&m->cond);
+		pthread_mutex_unlock(&m->lock);
+
+		(void)pthread_join(m->scanner, NULL);
+	}
+
+	while(m->roots != NULL)
+	{
+		root_t *const next = m->roots->next;
+		free_root(m->roots);
+		m->roots = next;
+	}
+
+	pthread_cond_destroy(&m->cond);
+	pthread_mutex_destroy(&m->lock);
+	free(m);
+}
+
+int
+manifest_add(manifest_t *m, const char path[])
+{
+	root_t *r;
+
+	if(!m->started)
+	{
+		if(pthread_create(&m->scanner, NULL, &scanner_main, m) != 0)
+		{
+			return 1;
+		}
+		m->started = 1;
+	}
+
+	r = malloc(sizeof(*r));
+	if(r == NULL)
+	{
+		return 1;
+	}
+
+	r->path = strdup(path);
+	if(r->path == NULL)
+	{
+		free(r);
+		return 1;
+	}
+
+	r->next = NULL;
+	r->head = NULL;
+	r->tail = NULL;
+	r->done = 0;
+	r->dropped = 0;
+	r->replaying = 0;
+
+	pthread_mutex_lock(&m->lock);
+	if(m->last == NULL)
+	{
+		m->roots = r;
+	}
+	else
+	{
+		m->last->next = r;
+	}
+	m->last = r;
+	if(m->to_scan == NULL)
+	{
+		m->to_scan = r;
+	}
+	pthread_cond_broadcast(&m->cond);
+	pthread_mutex_unlock(&m->lock);
+
+	return 0;
+}
+
+int
+manifest_traverse(manifest_t *m, const char path[], subtree_visitor visitor,
+		void *param, int *result)
+{
+	char full_path[PATH_MAX];
+	uint64_t size;
+	int pos = 0;
+	root_t *r;
+
+	if(m == NULL)
+	{
+		return 0;
+	}
+
+	r = find_root(m, path);
+	if(r == NULL)
+	{
+		return 0;
+	}
+
+	copy_str(full_path, sizeof(full_path), path);
+	switch(next_entry(m, r, &pos, full_path, strlen(full_path), &size))
+	{
+		case EK_FILE:
+			*result = replay_file(m, full_path, size, visitor, param);
+			break;
+		case EK_DIR:
+			*result = replay_dir(m, r, &pos, full_path, strlen(full_path), visitor,
+					param);
+			break;
+		case EK_FAILED:
+			*result = 1;
+			break;
+
+		default:
+			/* Scanning was aborted before reaching this subtree. */
+			release_root(m, r);
+			return 0;
+	}
+
+	release_root(m, r);
+	return 1;
+}
+
+void
+manifest_lock(manifest_t *m)
+{
+	if(m != NULL)
+	{
+		pthread_mutex_lock(&m->lock);
+	}
+}
+
+void
+manifest_unlock(manifest_t *m)
+{
+	if(m != NULL)
+	{
+		pthread_mutex_unlock(&m->lock);
+	}
+}
+
+/* Entry point of the scanner thread, which processes queued subtrees one by
+ * one.  Returns NULL. */
+static void *
+scanner_main(void *arg)
+{
+	manifest_t *const m = arg;
+
+	pthread_mutex_lock(&m->lock);
+	while(!m->stop)
+	{
+		root_t *const r = m->to_scan;
+		if(r == NULL)
+		{
+			++m->waiters;
+			pthread_cond_wait(&m->cond, &m->lock);
+			--m->waiters;
+			continue;
+		}
+
+		m->to_scan = r->next;
+		if(!r->dropped)
+		{
+			pthread_mutex_unlock(&m->lock);
+			scan_root(m, r);
+			pthread_mutex_lock(&m->lock);
+		}
+		r->done = 1;
+		pthread_cond_broadcast(&m->cond);
+	}
+	pthread_mutex_unlock(&m->lock);
+
+	return NULL;
+}
+
+/* Records entries of a subtree the same way traverse() would visit them. */
+static void
+scan_root(manifest_t *m, root_t *r)
+{
+	char path[PATH_MAX];
+	copy_str(path, sizeof(path), r->path);
+
+	if(is_symlink(path))
+	{
+		(void)append_entry(m, r, EK_FILE, "", 0U);
+	}
+	else if(is_dir(path))
+	{
+		(void)scan_dir(m, r, path, strlen(path), "");
+	}
+	else
+	{
+		(void)append_entry(m, r, EK_FILE, "", get_file_size(path));
+	}
+}
+
+/* Records directory at the path (len is its length) with the name along with
+ * all its entries.  Returns non-zero if scanning should be stopped. */
+static int
+scan_dir(manifest_t *m, root_t *r, char path[], size_t len, const char name[])
+{
+	struct dirent *d;
+	int stop;
+	DIR *const dir = os_opendir(path);
+	if(dir == NULL)
+	{
+		return append_entry(m, r, EK_FAILED, name, 0U);
+	}
+
+	stop = append_entry(m, r, EK_DIR, name, 0U);
+	while(!stop && (d = os_readdir(dir)) != NULL)
+	{
+		const size_t name_len = strlen(d->d_name);
+
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		if(len + 1U + name_len >= PATH_MAX)
+		{
+			/* Let the operation report the error. */
+			stop = append_entry(m, r, EK_FILE, d->d_name, 0U);
+			continue;
+		}
+
+		path[len] = '/';
+		memcpy(path + len + 1U, d->d_name, name_len + 1U);
+
+		if(entry_is_link(path, d))
+		{
+			stop = append_entry(m, r, EK_FILE, d->d_name, 0U);
+		}
+		else if(entry_is_dir(path, d))
+		{
+			stop = scan_dir(m, r, path, len + 1U + name_len, d->d_name);
+		}
+		else
+		{
+			stop = append_entry(m, r, EK_FILE, d->d_name, get_file_size(path));
+		}
+
+		path[len] = '\0';
+	}
+	(void)os_closedir(dir);
+
+	return stop || append_entry(m, r, EK_END, "", 0U);
+}
+
+/* Appends entry to the subtree and publishes it.  Returns non-zero if scanning
+ * should be stopped. */
+static int
+append_entry(manifest_t *m, root_t *r, EntryKind kind, const char name[],
+		uint64_t size)
+{
+	const size_t len = strlen(name) + 1U;
+	block_t *b = r->tail;
+	entry_t *e;
+	int stop;
+
+	if(b == NULL || b->count == BLOCK_ENTRIES ||
+			b->names_len + len > BLOCK_NAMES)
+	{
+		block_t *const new_block = malloc(sizeof(*new_block));
+		if(new_block == NULL)
+		{
+			return 1;
+		}
+		new_block->next = NULL;
+		new_block->count = 0;
+		new_block->names_len = 0U;
+
+		pthread_mutex_lock(&m->lock);
+		if(b == NULL)
+		{
+			r->head = new_block;
+		}
+		else
+		{
+			b->next = new_block;
+		}
+		r->tail = new_block;
+		pthread_mutex_unlock(&m->lock);
+
+		b = new_block;
+	}
+
+	/* Only published entries are read by other threads, so this doesn't need
+	 * locking. */
+	e = &b->entries[b->count];
+	e->size = size;
+	e->name = b->names_len;
+	e->kind = kind;
+	memcpy(b->names + b->names_len, name, len);
+	b->names_len += len;
+
+	pthread_mutex_lock(&m->lock);
+	++b->count;
+	if(kind == EK_FILE)
+	{
+		++m->estim->total_items;
+		m->estim->total_bytes += size;
+	}
+	if(m->waiters != 0)
+	{
+		pthread_cond_broadcast(&m->cond);
+	}
+	stop = (r->dropped || m->stop);
+	pthread_mutex_unlock(&m->lock);
+
+	return stop;
+}
+
+/* Replays entries of a directory at the path (len is its length), whose own
+ * entry was just read.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+replay_dir(manifest_t *m, root_t *r, int *pos, char path[], size_t len,
+		subtree_visitor visitor, void *param)
+{
+	int result = 0;
+	const VisitResult enter_result = visitor(path, VA_DIR_ENTER, param);
+	if(enter_result == VR_ERROR)
+	{
+		return 1;
+	}
+
+	while(result == 0)
+	{
+		uint64_t size;
+		const int kind = next_entry(m, r, pos, path, len, &size);
+		if(kind == EK_END)
+		{
+			break;
+		}
+
+		switch(kind)
+		{
+			case EK_FILE:
+				result = replay_file(m, path, size, visitor, param);
+				break;
+			case EK_DIR:
+				result = replay_dir(m, r, pos, path, strlen(path), visitor, param);
+				break;
+
+			default:
+				/* Failed directory or truncated manifest. */
+				result = 1;
+				break;
+		}
+		path[len] = '\0';
+	}
+
+	if(result == 0 && enter_result != VR_SKIP_DIR_LEAVE &&
+			enter_result != VR_CANCELLED)
+	{
+		result = visitor(path, VA_DIR_LEAVE, param);
+	}
+
+	return result;
+}
+
+/* Visits a file passing its known size to the estimation.  Returns visitor's
+ * result. */
+static int
+replay_file(manifest_t *m, const char path[], uint64_t size,
+		subtree_visitor visitor, void *param)
+{
+	ioeta_estim_t *const estim = m->estim;
+
+	/* Size is already known, don't make ioeta_update() query it again. */
+	estim->inspected_items = estim->current_item + 1;
+	estim->total_file_bytes = size;
+
+	return visitor(path, VA_FILE, param);
+}
+
+/* Reads next entry of the subtree waiting for it to be published if necessary
+ * and appends its name to the path of length len.  Returns kind of the entry
+ * or -1 if there are no more entries. */
+static int
+next_entry(manifest_t *m, root_t *r, int *pos, char path[], size_t len,
+		uint64_t *size)
+{
+	int kind = -1;
+
+	pthread_mutex_lock(&m->lock);
+	while(1)
+	{
+		block_t *const b = r->head;
+
+		if(b != NULL && *pos < b->count)
+		{
+			const entry_t *const e = &b->entries[(*pos)++];
+			const char *const name = &b->names[e->name];
+
+			kind = e->kind;
+			*size = e->size;
+			if(name[0] != '\0' &&
+					(size_t)snprintf(path + len, PATH_MAX - len, "/%s", name) >=
+					PATH_MAX - len)
+			{
+				/* Don't pass truncated path to the visitor. */
+				kind = EK_FAILED;
+			}
+			break;
+		}
+
+		if(b != NULL && b->next != NULL)
+		{
+			/* Scanner has moved on to the next block, so this one can be freed. */
+			r->head = b->next;
+			free(b);
+			*pos = 0;
+			continue;
+		}
+
+		if(r->done || m->stop)
+		{
+			break;
+		}
+
+		++m->waiters;
+		pthread_cond_wait(&m->cond, &m->lock);
+		--m->waiters;
+	}
+	pthread_mutex_unlock(&m->lock);
+
+	return kind;
+}
+
+/* Looks up subtree by path of its root and discards all subtrees queued before
+ * it.  Returns the subtree or NULL if it's not in the manifest. */
+static root_t *
+find_root(manifest_t *m, const char path[])
+{
+	root_t *r;
+
+	pthread_mutex_lock(&m->lock);
+
+	for(r = m->roots; r != NULL; r = r->next)
+	{
+		if(!r->dropped && !r->replaying && paths_are_equal(r->path, path))
+		{
+			break;
+		}
+	}
+
+	if(r != NULL)
+	{
+		/* Operations are performed in the same order as estimation, so skipped
+		 * subtrees won't be needed. */
+		root_t *p;
+		for(p = m->roots; p != r; p = p->next)
+		{
+			if(!p->replaying)
+			{
+				p->dropped = 1;
+			}
+		}
+		r->replaying = 1;
+	}
+
+	pthread_mutex_unlock(&m->lock);
+	return r;
+}
+
+/* Marks subtree as no longer needed and frees all dropped subtrees that aren't
+ * used by the scanner. */
+static void
+release_root(manifest_t *m, root_t *r)
+{
+	root_t **link;
+
+	pthread_mutex_lock(&m->lock);
+
+	r->dropped = 1;
+	r->replaying = 0;
+
+	link = &m->roots;
+	m->last = NULL;
+	while(*link != NULL)
+	{
+		root_t *const p = *link;
+		if(p->dropped && p->done && !p->replaying)
+		{
+			*link = p->next;
+			free_root(p);
+			continue;
+		}
+		m->last = p;
+		link = &p->next;
+	}
+
+	pthread_mutex_unlock(&m->lock);
+}
+
+/* Frees subtree along with all its blocks. */
+static void
+free_root(root_t *r)
+{
+	while(r->head != NULL)
+	{
+		block_t *const next = r->head->next;
+		free(r->head);
+		r->head = next;
+	}
+	free(r->path);
+	free(r);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,59 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__MANIFEST_H__
+#define VIFM__IO__PRIVATE__MANIFEST_H__
+
+#include "../ioeta.h"
+#include "traverser.h"
+
+/* manifest - list of subtree entries collected in background */
+
+/* Opaque declaration of manifest type. */
+typedef struct manifest_t manifest_t;
+
+/* Creates manifest that adds up scanned files to totals of the estim.  Returns
+ * the manifest or NULL on error. */
+manifest_t * manifest_create(ioeta_estim_t *estim);
+
+/* Stops scanning and frees the manifest.  The m can be NULL. */
+void manifest_free(manifest_t *m);
+
+/* Queues subtree rooted at the path for scanning in background.  Returns zero
+ * on success, otherwise non-zero is returned. */
+int manifest_add(manifest_t *m, const char path[]);
+
+/* Replays recorded subtree rooted at the path calling the visitor in the same
+ * order and with the same arguments as traverse() would, waiting for the
+ * scanner to record entries if necessary.  Subtrees queued before this one are
+ * discarded.  Returns non-zero and sets *result to the result of traversal if
+ * the subtree was found, otherwise zero is returned.  The m can be NULL. */
+int manifest_traverse(manifest_t *m, const char path[], subtree_visitor visitor,
+		void *param, int *result);
+
+/* Protects totals of estimation from concurrent updates by the scanner.  The m
+ * can be NULL. */
+void manifest_lock(manifest_t *m);
+
+/* Counterpart of manifest_lock().  The m can be NULL. */
+void manifest_unlock(manifest_t *m);
+
+#endif /* VIFM__IO__PRIVATE__MANIFEST_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
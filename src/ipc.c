@@ -45,6 +45,12 @@ ipc_check(void)
 {
 }
 
+int
+ipc_get_fd(void)
+{
+	return -1;
+}
+
 int
 ipc_send(const char whom[], char *data[])
 {
@@ -73,7 +79,7 @@ ipc_send(const char whom[], char *data[])
 #include <assert.h> /* assert() */
 #include <errno.h> /* EEXIST ENXIO errno */
 #include <stddef.h> /* NULL size_t ssize_t */
-#include <stdio.h> /* FILE fclose() fdopen() fread() fwrite() */
+#include <stdio.h> /* FILE clearerr() fclose() fdopen() fread() fwrite() setvbuf() */
 #include <stdlib.h> /* atexit() free() malloc() qsort() snprintf() */
 #include <string.h> /* strcmp() strcpy() strlen() */
 
@@ -121,6 +127,11 @@ static int initialized;
 static char pipe_path[PATH_MAX];
 /* Opened file of the pipe. */
 static FILE *pipe_file;
+#ifndef _WIN32
+/* Write end of our own pipe, which is never written to, but keeps reading end
+ * from reporting hang up after every client disconnects. */
+static int keepalive_fd = -1;
+#endif
 
 int
 ipc_enabled(void)
@@ -147,6 +158,18 @@ ipc_init(const char name[], ipc_callback callback_func)
 		return;
 	}
 
+	/* Buffering would hide data from select() and poll() on the descriptor. */
+	(void)setvbuf(pipe_file, NULL, _IONBF, 0U);
+
+#ifndef _WIN32
+	keepalive_fd = open(pipe_path, O_WRONLY | O_NONBLOCK);
+	if(keepalive_fd != -1)
+	{
+		(void)fcntl(keepalive_fd, F_SETFD, FD_CLOEXEC);
+	}
+	(void)fcntl(fileno(pipe_file), F_SETFD, FD_CLOEXEC);
+#endif
+
 	atexit(&clean_at_exit);
 	initialized = 1;
 }
@@ -156,6 +179,12 @@ static void
 clean_at_exit(void)
 {
 	fclose(pipe_file);
+#ifndef _WIN32
+	if(keepalive_fd != -1)
+	{
+		close(keepalive_fd);
+	}
+#endif
 	unlink(pipe_path);
 }
 
@@ -170,14 +199,24 @@ ipc_check(void)
 		return;
 	}
 
-	pkg = receive_pkg();
-	if(pkg == NULL)
+	/* Several messages might be buffered at once, process all of them, because
+	 * file descriptor won't signal about those that are already read. */
+	clearerr(pipe_file);
+	while((pkg = receive_pkg()) != NULL)
 	{
-		return;
+		handle_pkg(pkg);
+		free(pkg);
 	}
+}
 
-	handle_pkg(pkg);
-	free(pkg);
+int
+ipc_get_fd(void)
+{
+#ifndef _WIN32
+	return (initialized > 0) ? fileno(pipe_file) : -1;
+#else
+	return -1;
+#endif
 }
 
 /* Receives message addressed to this instance.  Returns NULL if there was no
@@ -39,6 +39,11 @@ void ipc_init(const char name[], ipc_callback callback_func);
 /* Checks for incoming messages.  Calls callback passed to ipc_init(). */
 void ipc_check(void);
 
+/* Retrieves file descriptor that becomes readable when a message arrives.
+ * Returns the descriptor or -1 if it's not available and ipc_check() should be
+ * called periodically. */
+int ipc_get_fd(void);
+
 /* Sends data to server.  The data array should end with NULL.  Returns zero on
  * successful send and non-zero otherwise. */
 int ipc_send(const char whom[], char *data[]);
@@ -23,8 +23,8 @@
 #include <ctype.h> /* tolower() */
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* snprintf() */
-#include <stdlib.h> /* realloc() free() calloc() */
-#include <string.h> /* memset() strncat() strcpy() strlen() strdup() */
+#include <stdlib.h> /* realloc() free() */
+#include <string.h> /* memcpy() memset() strchr() strlen() strdup() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -32,6 +32,7 @@
 #include "ui/ui.h"
 #include "utils/path.h"
 #include "utils/str.h"
+#include "utils/string_array.h"
 #include "utils/test_helpers.h"
 #include "utils/utils.h"
 #include "filelist.h"
@@ -48,6 +49,28 @@ typedef enum
 }
 PathType;
 
+/* String being built during expansion.  Memory is grown geometrically, so that
+ * appending is amortized linear in total length of the result. */
+typedef struct
+{
+	char *str;       /* Accumulated string or NULL after memory error. */
+	size_t len;      /* Length of the string. */
+	size_t capacity; /* Size of memory allocated for the string. */
+	int failed;      /* Whether memory error has occurred. */
+}
+expanded_t;
+
+/* State of splitting selected files of current view among several commands. */
+typedef struct
+{
+	int first;     /* Number of selected files to skip. */
+	int next;      /* Number of selected files processed so far. */
+	size_t budget; /* Maximum length of files part or zero for no limit. */
+	size_t used;   /* Length of expanded files part. */
+	int uses;      /* Number of expansions of selected files. */
+}
+batch_t;
+
 /* Should return the same character if processing of the macro is allowed or
  * '\0' if it's not allowed. */
 typedef char (*macro_filter_func)(int *quoted, char c, char data);
@@ -55,21 +78,26 @@ typedef char (*macro_filter_func)(int *quoted, char c, char data);
 static char filter_all(int *quoted, char c, char data);
 static char filter_single(int *quoted, char c, char data);
 static char * expand_macros_i(const char command[], const char args[],
-		MacroFlags *flags, int for_shell, macro_filter_func filter);
+		MacroFlags *flags, int for_shell, macro_filter_func filter,
+		batch_t *batch);
 static void set_flags(MacroFlags *flags, MacroFlags value);
 TSTATIC char * append_selected_files(FileView *view, char expanded[],
 		int under_cursor, int quotes, const char mod[], int for_shell);
-static char * append_entry(FileView *view, char expanded[], PathType type,
+static void append_selected(FileView *view, expanded_t *exp, int under_cursor,
+		int quotes, const char mod[], int for_shell, batch_t *batch);
+static void append_entry(FileView *view, expanded_t *exp, PathType type,
 		dir_entry_t *entry, int quotes, const char mod[], int for_shell);
-static char * expand_directory_path(FileView *view, char *expanded, int quotes,
+static void expand_directory_path(FileView *view, expanded_t *exp, int quotes,
 		const char *mod, int for_shell);
-static char * expand_register(const char curr_dir[], char expanded[],
-		int quotes, const char mod[], int key, int *well_formed, int for_shell);
-static char * expand_preview(char expanded[], int key, int *well_formed);
+static int expand_register(const char curr_dir[], expanded_t *exp, int quotes,
+		const char mod[], int key, int for_shell);
+static int expand_preview(expanded_t *exp, int key);
 static FileView * get_preview_view(FileView *view);
-static char * append_path_to_expanded(char expanded[], int quotes,
+static void append_path_to_expanded(expanded_t *exp, int quotes,
 		const char path[]);
-static char * append_to_expanded(char expanded[], const char str[]);
+static void append_to_expanded(expanded_t *exp, const char str[]);
+static void append_n_to_expanded(expanded_t *exp, const char str[],
+		size_t len);
 static char * add_missing_macros(char expanded[], size_t len, size_t nmacros,
 		custom_macro_t macros[]);
 
@@ -77,7 +105,62 @@ char *
 expand_macros(const char command[], const char args[], MacroFlags *flags,
 		int for_shell)
 {
-	return expand_macros_i(command, args, flags, for_shell, &filter_all);
+	return expand_macros_i(command, args, flags, for_shell, &filter_all, NULL);
+}
+
+char **
+ma_expand_batched(const char command[], const char args[], MacroFlags *flags,
+		int for_shell, size_t max_len, int *count)
+{
+	batch_t batch = { .first = 0, .next = 0, .budget = 0U, .used = 0U,
+	                  .uses = 0 };
+	char **cmds = NULL;
+	int total;
+	size_t len;
+	size_t fixed_len;
+
+	char *expanded = expand_macros_i(command, args, flags, for_shell,
+			&filter_all, &batch);
+	if(expanded == NULL)
+	{
+		*count = 0;
+		return NULL;
+	}
+
+	/* Splitting is possible only when selected files are listed once and the
+	 * rest of the command leaves some room for them. */
+	len = strlen(expanded);
+	fixed_len = len - batch.used;
+	if(len <= max_len || batch.uses != 1 || fixed_len >= max_len)
+	{
+		*count = put_into_string_array(&cmds, 0, expanded);
+		return cmds;
+	}
+	free(expanded);
+
+	total = batch.next;
+	batch.next = 0;
+	*count = 0;
+	while(batch.next < total)
+	{
+		batch.first = batch.next;
+		batch.budget = max_len - fixed_len;
+		batch.uses = 0;
+
+		expanded = expand_macros_i(command, args, NULL, for_shell, &filter_all,
+				&batch);
+		if(expanded == NULL || put_into_string_array(&cmds, *count, expanded) !=
+				*count + 1)
+		{
+			free(expanded);
+			free_string_array(cmds, *count);
+			*count = 0;
+			return NULL;
+		}
+		++*count;
+	}
+
+	return cmds;
 }
 
 /* macro_filter_func instantiation that allows all macros.  Returns the
@@ -91,7 +174,8 @@ filter_all(int *quoted, char c, char data)
 char *
 ma_expand_single(const char command[])
 {
-	char *const res = expand_macros_i(command, NULL, NULL, 0, &filter_single);
+	char *const res = expand_macros_i(command, NULL, NULL, 0, &filter_single,
+			NULL);
 	unescape(res, 0);
 	return res;
 }
@@ -129,22 +213,21 @@ filter_single(int *quoted, char c, char data)
 	return '\0';
 }
 
-/* args and flags parameters can equal NULL. The string returned needs to be
- * freed in the calling function. After executing flags is one of MF_*
- * values. */
+/* args and flags parameters can equal NULL.  batch can be NULL, otherwise
+ * expansion of %f is limited according to its state.  The string returned
+ * needs to be freed in the calling function.  After executing flags is one of
+ * MF_* values. */
 static char *
 expand_macros_i(const char command[], const char args[], MacroFlags *flags,
-		int for_shell, macro_filter_func filter)
+		int for_shell, macro_filter_func filter, batch_t *batch)
 {
 	/* TODO: refactor this function expand_macros() */
-	/* FIXME: repetitive len = strlen(expanded) could be optimized. */
 
 	static const char MACROS_WITH_QUOTING[] = "cCfFbdDr";
 
 	size_t cmd_len;
-	char *expanded;
+	expanded_t exp = { .str = NULL, .len = 0U, .capacity = 0U, .failed = 0 };
 	size_t x;
-	int len = 0;
 
 	set_flags(flags, MF_NONE);
 
@@ -159,15 +242,12 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 		return strdup(command);
 	}
 
-	expanded = calloc(cmd_len + 1, sizeof(char));
-	strncat(expanded, command, x);
+	append_n_to_expanded(&exp, command, x);
 	x++;
-	len = strlen(expanded);
 
 	do
 	{
 		size_t y;
-		char *p;
 
 		int quotes = 0;
 		if(command[x] == '"' && char_is_one_of(MACROS_WITH_QUOTING, command[x + 1]))
@@ -181,47 +261,39 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 			case 'a': /* user arguments */
 				if(args != NULL)
 				{
-					expanded = append_to_expanded(expanded, args);
-					len = strlen(expanded);
+					append_to_expanded(&exp, args);
 				}
 				break;
 			case 'b': /* selected files of both dirs */
-				expanded = append_selected_files(curr_view, expanded, 0, quotes,
-						command + x + 1, for_shell);
-				expanded = append_to_expanded(expanded, " ");
-				expanded = append_selected_files(other_view, expanded, 0, quotes,
-						command + x + 1, for_shell);
-				len = strlen(expanded);
+				append_selected(curr_view, &exp, 0, quotes, command + x + 1, for_shell,
+						NULL);
+				append_to_expanded(&exp, " ");
+				append_selected(other_view, &exp, 0, quotes, command + x + 1, for_shell,
+						NULL);
 				break;
 			case 'c': /* current dir file under the cursor */
-				expanded = append_selected_files(curr_view, expanded, 1, quotes,
-						command + x + 1, for_shell);
-				len = strlen(expanded);
+				append_selected(curr_view, &exp, 1, quotes, command + x + 1, for_shell,
+						NULL);
 				break;
 			case 'C': /* other dir file under the cursor */
-				expanded = append_selected_files(other_view, expanded, 1, quotes,
-						command + x + 1, for_shell);
-				len = strlen(expanded);
+				append_selected(other_view, &exp, 1, quotes, command + x + 1,
+						for_shell, NULL);
 				break;
 			case 'f': /* current dir selected files */
-				expanded = append_selected_files(curr_view, expanded, 0, quotes,
-						command + x + 1, for_shell);
-				len = strlen(expanded);
+				append_selected(curr_view, &exp, 0, quotes, command + x + 1, for_shell,
+						batch);
 				break;
 			case 'F': /* other dir selected files */
-				expanded = append_selected_files(other_view, expanded, 0, quotes,
-						command + x + 1, for_shell);
-				len = strlen(expanded);
+				append_selected(other_view, &exp, 0, quotes, command + x + 1,
+						for_shell, NULL);
 				break;
 			case 'd': /* current directory */
-				expanded = expand_directory_path(curr_view, expanded, quotes,
-						command + x + 1, for_shell);
-				len = strlen(expanded);
+				expand_directory_path(curr_view, &exp, quotes, command + x + 1,
+						for_shell);
 				break;
 			case 'D': /* Directory of the other view. */
-				expanded = expand_directory_path(other_view, expanded, quotes,
-						command + x + 1, for_shell);
-				len = strlen(expanded);
+				expand_directory_path(other_view, &exp, quotes, command + x + 1,
+						for_shell);
 				break;
 			case 'n': /* Forbid using of terminal multiplexer, even if active. */
 				set_flags(flags, MF_NO_TERM_MUX);
@@ -248,37 +320,24 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 				set_flags(flags, MF_IGNORE);
 				break;
 			case 'r': /* Registers' content. */
+				if(expand_register(flist_get_dir(curr_view), &exp, quotes,
+							command + x + 2, command[x + 1], for_shell))
 				{
-					int well_formed;
-					expanded = expand_register(flist_get_dir(curr_view), expanded, quotes,
-							command + x + 2, command[x + 1], &well_formed, for_shell);
-					len = strlen(expanded);
-					if(well_formed)
-					{
-						x++;
-					}
+					x++;
 				}
 				break;
 			case 'p': /* Preview pane properties. */
+				if(command[x + 1] == 'c')
 				{
-					int well_formed;
-					const char key = command[x + 1];
-					if(key == 'c')
-					{
-						return expanded;
-					}
-
-					expanded = expand_preview(expanded, key, &well_formed);
-					len = strlen(expanded);
-					if(well_formed)
-					{
-						++x;
-					}
+					return exp.str;
+				}
+				if(expand_preview(&exp, command[x + 1]))
+				{
+					++x;
 				}
 				break;
 			case '%':
-				expanded = append_to_expanded(expanded, "%");
-				len = strlen(expanded);
+				append_to_expanded(&exp, "%");
 				break;
 
 			case '\0':
@@ -314,21 +373,17 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 		assert(x >= y);
 		assert(y <= cmd_len);
 
-		p = realloc(expanded, len + (x - y) + 1);
-		if(p == NULL)
+		append_n_to_expanded(&exp, command + y, x - y);
+		if(exp.failed)
 		{
-			free(expanded);
 			return NULL;
 		}
-		expanded = p;
-		strncat(expanded, command + y, x - y);
-		len = strlen(expanded);
 
 		++x;
 	}
 	while(x < cmd_len);
 
-	return expanded;
+	return exp.str;
 }
 
 /* Sets *flags to the value, if flags isn't NULL. */
@@ -344,50 +399,83 @@ set_flags(MacroFlags *flags, MacroFlags value)
 TSTATIC char *
 append_selected_files(FileView *view, char expanded[], int under_cursor,
 		int quotes, const char mod[], int for_shell)
+{
+	const size_t len = strlen(expanded);
+	expanded_t exp = { .str = expanded, .len = len, .capacity = len + 1U,
+	                   .failed = 0 };
+	append_selected(view, &exp, under_cursor, quotes, mod, for_shell, NULL);
+	return exp.str;
+}
+
+/* Appends selected files of the view or file under cursor to the expanded
+ * string.  When batch isn't NULL, selected files that were already processed
+ * are skipped and no more files than fit into batch budget are appended. */
+static void
+append_selected(FileView *view, expanded_t *exp, int under_cursor, int quotes,
+		const char mod[], int for_shell, batch_t *batch)
 {
 	const PathType type = (view == other_view)
 	                    ? PT_FULL
 	                    : (flist_custom_active(view) ? PT_REL : PT_NAME);
-#ifdef _WIN32
-	size_t old_len = strlen(expanded);
-#endif
+	const size_t old_len = exp->len;
 
 	if(view->selected_files && !under_cursor)
 	{
 		int n = 0;
+		int appended = 0;
 		dir_entry_t *entry = NULL;
 		while(iter_selected_entries(view, &entry))
 		{
-			expanded = append_entry(view, expanded, type, entry, quotes, mod,
-					for_shell);
+			const size_t prev_len = exp->len;
 
-			if(++n != view->selected_files)
+			if(batch != NULL && n++ < batch->first)
 			{
-				expanded = append_to_expanded(expanded, " ");
+				continue;
+			}
+
+			if(appended != 0)
+			{
+				append_to_expanded(exp, " ");
+			}
+			append_entry(view, exp, type, entry, quotes, mod, for_shell);
+
+			if(batch != NULL && batch->budget != 0U && appended != 0 &&
+					!exp->failed && exp->len - old_len > batch->budget)
+			{
+				/* Leave this file for the next batch. */
+				exp->len = prev_len;
+				exp->str[prev_len] = '\0';
+				--n;
+				break;
 			}
+			++appended;
+		}
+
+		if(batch != NULL)
+		{
+			batch->next = n;
+			batch->used = exp->len - old_len;
+			++batch->uses;
 		}
 	}
 	else
 	{
-		expanded = append_entry(view, expanded, type, get_current_entry(view),
-				quotes, mod, for_shell);
+		append_entry(view, exp, type, get_current_entry(view), quotes, mod,
+				for_shell);
 	}
 
 #ifdef _WIN32
-	if(for_shell && curr_stats.shell_type == ST_CMD)
+	if(for_shell && curr_stats.shell_type == ST_CMD && !exp->failed)
 	{
-		to_back_slash(expanded + old_len);
+		to_back_slash(exp->str + old_len);
 	}
 #endif
-
-	return expanded;
 }
 
-/* Appends path to the entry to the expanded string.  Returns new value of
- * expanded string. */
-static char *
-append_entry(FileView *view, char expanded[], PathType type, dir_entry_t *entry,
-		int quotes, const char mod[], int for_shell)
+/* Appends path to the entry to the expanded string. */
+static void
+append_entry(FileView *view, expanded_t *exp, PathType type,
+		dir_entry_t *entry, int quotes, const char mod[], int for_shell)
 {
 	char path[PATH_MAX];
 	const char *modified;
@@ -411,44 +499,44 @@ append_entry(FileView *view, char expanded[], PathType type, dir_entry_t *entry,
 	}
 
 	modified = apply_mods(path, flist_get_dir(view), mod, for_shell);
-	expanded = append_path_to_expanded(expanded, quotes, modified);
-
-	return expanded;
+	append_path_to_expanded(exp, quotes, modified);
 }
 
-static char *
-expand_directory_path(FileView *view, char *expanded, int quotes,
+/* Appends path to current directory of the view to the expanded string. */
+static void
+expand_directory_path(FileView *view, expanded_t *exp, int quotes,
 		const char *mod, int for_shell)
 {
 	const char *const modified = apply_mods(flist_get_dir(view), "/", mod, for_shell);
-	char *const result = append_path_to_expanded(expanded, quotes, modified);
+#ifdef _WIN32
+	const size_t old_len = exp->len;
+#endif
+
+	append_path_to_expanded(exp, quotes, modified);
 
 #ifdef _WIN32
-	if(for_shell && curr_stats.shell_type == ST_CMD)
+	if(for_shell && curr_stats.shell_type == ST_CMD && !exp->failed)
 	{
-		to_back_slash(result);
+		to_back_slash(exp->str + old_len);
 	}
 #endif
-
-	return result;
 }
 
 /* Expands content of a register specified by the key argument considering
  * filename-modifiers.  If key is unknown, fallbacks to the default register.
- * Sets *well_formed to non-zero for valid value of the key.  Reallocates the
- * expanded string and returns result (possibly NULL). */
-static char *
-expand_register(const char curr_dir[], char expanded[], int quotes,
-		const char mod[], int key, int *well_formed, int for_shell)
+ * Returns non-zero for valid value of the key, otherwise zero is returned. */
+static int
+expand_register(const char curr_dir[], expanded_t *exp, int quotes,
+		const char mod[], int key, int for_shell)
 {
 	int i;
+	int well_formed = 1;
 	registers_t *reg;
 
-	*well_formed = 1;
 	reg = find_register(tolower(key));
 	if(reg == NULL)
 	{
-		*well_formed = 0;
+		well_formed = 0;
 		reg = find_register(DEFAULT_REG_NAME);
 		assert(reg != NULL);
 		mod--;
@@ -458,29 +546,28 @@ expand_register(const char curr_dir[], char expanded[], int quotes,
 	{
 		const char *const modified = apply_mods(reg->files[i], curr_dir, mod,
 				for_shell);
-		expanded = append_path_to_expanded(expanded, quotes, modified);
+		append_path_to_expanded(exp, quotes, modified);
 		if(i != reg->num_files - 1)
 		{
-			expanded = append_to_expanded(expanded, " ");
+			append_to_expanded(exp, " ");
 		}
 	}
 
 #ifdef _WIN32
-	if(for_shell && curr_stats.shell_type == ST_CMD)
+	if(for_shell && curr_stats.shell_type == ST_CMD && !exp->failed)
 	{
-		to_back_slash(expanded);
+		to_back_slash(exp->str);
 	}
 #endif
 
-	return expanded;
+	return well_formed;
 }
 
 /* Expands preview parameter macros specified by the key argument.  If key is
- * unknown, skips the macro.  Sets *well_formed to non-zero for valid value of
- * the key.  Reallocates the expanded string and returns result (possibly
- * NULL). */
-static char *
-expand_preview(char expanded[], int key, int *well_formed)
+ * unknown, skips the macro.  Returns non-zero for valid value of the key,
+ * otherwise zero is returned. */
+static int
+expand_preview(expanded_t *exp, int key)
 {
 	FileView *view;
 	char num_str[32];
@@ -490,12 +577,9 @@ expand_preview(char expanded[], int key, int *well_formed)
 
 	if(!char_is_one_of("hwxy", key))
 	{
-		*well_formed = 0;
-		return expanded;
+		return 0;
 	}
 
-	*well_formed = 1;
-
 	view = get_preview_view(curr_view);
 
 	getbegyx(view->win, y, x);
@@ -515,8 +599,9 @@ expand_preview(char expanded[], int key, int *well_formed)
 	}
 
 	snprintf(num_str, sizeof(num_str), "%d", param);
+	append_to_expanded(exp, num_str);
 
-	return append_to_expanded(expanded, num_str);
+	return 1;
 }
 
 /* Applies heuristics to determine which view is going to be used for preview.
@@ -542,14 +627,14 @@ get_preview_view(FileView *view)
 }
 
 /* Appends the path to the expanded string with either proper escaping or
- * quoting.  Returns NULL on not enough memory error. */
-static char *
-append_path_to_expanded(char expanded[], int quotes, const char path[])
+ * quoting. */
+static void
+append_path_to_expanded(expanded_t *exp, int quotes, const char path[])
 {
 	if(quotes)
 	{
 		const char *const dquoted = enclose_in_dquotes(path);
-		expanded = append_to_expanded(expanded, dquoted);
+		append_to_expanded(exp, dquoted);
 	}
 	else
 	{
@@ -557,34 +642,61 @@ append_path_to_expanded(char expanded[], int quotes, const char path[])
 		if(escaped == NULL)
 		{
 			show_error_msg("Memory Error", "Unable to allocate enough memory");
-			free(expanded);
-			return NULL;
+			free(exp->str);
+			exp->str = NULL;
+			exp->failed = 1;
+			return;
 		}
 
-		expanded = append_to_expanded(expanded, escaped);
+		append_to_expanded(exp, escaped);
 		free(escaped);
 	}
+}
 
-	return expanded;
+/* Appends str to the expanded string. */
+static void
+append_to_expanded(expanded_t *exp, const char str[])
+{
+	append_n_to_expanded(exp, str, strlen(str));
 }
 
-/* Appends str to expanded with reallocation.  Returns address of the new
- * string or NULL on reallocation error. */
-static char *
-append_to_expanded(char expanded[], const char str[])
+/* Appends first len characters of the str to the expanded string growing
+ * memory geometrically.  On memory error frees the string and sets it to
+ * NULL, further appends are ignored then. */
+static void
+append_n_to_expanded(expanded_t *exp, const char str[], size_t len)
 {
-	char *t;
-	const size_t len = strlen(expanded);
+	if(exp->failed)
+	{
+		return;
+	}
 
-	t = realloc(expanded, len + strlen(str) + 1);
-	if(t == NULL)
+	if(exp->len + len + 1U > exp->capacity)
 	{
-		show_error_msg("Memory Error", "Unable to allocate enough memory");
-		free(expanded);
-		return NULL;
+		size_t capacity = (exp->capacity == 0U) ? 64U : exp->capacity;
+		char *str_copy;
+
+		while(exp->len + len + 1U > capacity)
+		{
+			capacity *= 2U;
+		}
+
+		str_copy = realloc(exp->str, capacity);
+		if(str_copy == NULL)
+		{
+			show_error_msg("Memory Error", "Unable to allocate enough memory");
+			free(exp->str);
+			exp->str = NULL;
+			exp->failed = 1;
+			return;
+		}
+		exp->str = str_copy;
+		exp->capacity = capacity;
 	}
-	strcpy(t + len, str);
-	return t;
+
+	memcpy(exp->str + exp->len, str, len);
+	exp->len += len;
+	exp->str[exp->len] = '\0';
 }
 
 const char *
@@ -59,6 +59,15 @@ custom_macro_t;
 char * expand_macros(const char command[], const char args[], MacroFlags *flags,
 		int for_shell);
 
+/* Like expand_macros(), but when the result is longer than max_len and
+ * selected files of current view (%f) are listed only once, produces several
+ * commands each of which gets part of the files and fits into max_len (unless
+ * a single file doesn't fit).  Sets *count to number of elements in the
+ * returned array, which should be freed with free_string_array().  Returns
+ * NULL on error. */
+char ** ma_expand_batched(const char command[], const char args[],
+		MacroFlags *flags, int for_shell, size_t max_len, int *count);
+
 /* Like expand_macros(), but expands only single element macros and aims for
  * single string, so escaping is disabled. */
 char * ma_expand_single(const char command[]);
@@ -267,7 +267,7 @@ check_mark_directory(FileView *view, char m)
 		dir_entry_t *entry;
 		char path[PATH_MAX];
 		snprintf(path, sizeof(path), "%s/%s", mark->directory, mark->file);
-		entry = entry_from_path(view->dir_entry, view->list_rows, path);
+		entry = flist_entry_from_path(view, path);
 		if(entry != NULL)
 		{
 			return entry_to_pos(view, entry);
@@ -20,8 +20,12 @@
 #include "jobs_menu.h"
 
 #include <stdio.h> /* snprintf() */
-#include <string.h> /* strlen() strdup() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+#include <wchar.h> /* wcscmp() */
 
+#include "../compat/reallocarray.h"
+#include "../modes/dialogs/msg_dialog.h"
 #include "../modes/menu.h"
 #include "../ui/ui.h"
 #include "../utils/str.h"
@@ -29,8 +33,15 @@
 #include "../background.h"
 #include "menus.h"
 
+static char * format_job_item(job_t *job);
+static KHandlerResponse jobs_khandler(menu_info *m, const wchar_t keys[]);
+static job_t * get_current_job(const menu_info *m);
+static void update_job_items(menu_info *m);
 static int execute_jobs_cb(FileView *view, menu_info *m);
 
+/* Jobs that correspond to menu items, NULL for jobs that are gone. */
+static job_t **menu_jobs;
+
 int
 show_jobs_menu(FileView *view)
 {
@@ -38,44 +49,36 @@ show_jobs_menu(FileView *view)
 	int i;
 
 	static menu_info m;
-	init_menu_info(&m, strdup("Pid --- Command"),
+	init_menu_info(&m, strdup("Pid --- State --- Command"),
 			strdup("No jobs currently running"));
 	m.execute_handler = &execute_jobs_cb;
+	m.key_handler = &jobs_khandler;
 
 	check_background_jobs();
 
 	bg_jobs_freeze();
 
-	p = jobs;
+	free(menu_jobs);
+	menu_jobs = NULL;
 
 	i = 0;
-	while(p != NULL)
+	for(p = jobs; p != NULL; p = p->next)
 	{
 		if(p->running)
 		{
-			char info_buf[24];
-			char item_buf[sizeof(info_buf) + strlen(p->cmd)];
-
-			if(p->type == BJT_COMMAND)
+			job_t **const list = reallocarray(menu_jobs, i + 1, sizeof(*list));
+			char *const item = format_job_item(p);
+			if(list == NULL || item == NULL)
 			{
-				snprintf(info_buf, sizeof(info_buf), "%" PRINTF_ULL,
-						(unsigned long long)p->pid);
-			}
-			else if(p->bg_op.total == BG_UNDEFINED_TOTAL)
-			{
-				snprintf(info_buf, sizeof(info_buf), "n/a");
-			}
-			else
-			{
-				snprintf(info_buf, sizeof(info_buf), "%d/%d", p->bg_op.done + 1,
-						p->bg_op.total);
+				menu_jobs = (list == NULL) ? menu_jobs : list;
+				free(item);
+				break;
 			}
 
-			snprintf(item_buf, sizeof(item_buf), "%-8s  %s", info_buf, p->cmd);
-			i = add_to_string_array(&m.items, i, 1, item_buf);
+			menu_jobs = list;
+			menu_jobs[i] = p;
+			i = put_into_string_array(&m.items, i, item);
 		}
-
-		p = p->next;
 	}
 
 	bg_jobs_unfreeze();
@@ -85,6 +88,143 @@ show_jobs_menu(FileView *view)
 	return display_menu(&m, view);
 }
 
+/* Formats single menu item.  Returns pointer to newly allocated string or NULL
+ * on error. */
+static char *
+format_job_item(job_t *job)
+{
+	char info_buf[24];
+	char state_buf[16];
+	int pos;
+
+	if(job->type == BJT_COMMAND)
+	{
+		snprintf(info_buf, sizeof(info_buf), "%" PRINTF_ULL,
+				(unsigned long long)job->pid);
+	}
+	else if(job->bg_op.total == BG_UNDEFINED_TOTAL)
+	{
+		snprintf(info_buf, sizeof(info_buf), "n/a");
+	}
+	else
+	{
+		snprintf(info_buf, sizeof(info_buf), "%d/%d", job->bg_op.done + 1,
+				job->bg_op.total);
+	}
+
+	switch(bg_job_get_state(job, &pos))
+	{
+		case BJS_QUEUED:
+			snprintf(state_buf, sizeof(state_buf), "queued:%d", pos);
+			break;
+		case BJS_RUNNING:
+			copy_str(state_buf, sizeof(state_buf), "running");
+			break;
+		case BJS_PAUSED:
+			copy_str(state_buf, sizeof(state_buf), "paused");
+			break;
+	}
+
+	return format_str("%-8s  %-9s  %s", info_buf, state_buf, job->cmd);
+}
+
+/* Menu-specific shortcut handler.  Returns code that specifies both taken
+ * actions and what should be done next. */
+static KHandlerResponse
+jobs_khandler(menu_info *m, const wchar_t keys[])
+{
+	job_t *job;
+	int failed;
+
+	if(wcscmp(keys, L"p") != 0 && wcscmp(keys, L"J") != 0 &&
+			wcscmp(keys, L"K") != 0)
+	{
+		return KHR_UNHANDLED;
+	}
+
+	bg_jobs_freeze();
+
+	job = get_current_job(m);
+	if(keys[0] == L'p')
+	{
+		int pos;
+		failed = (job == NULL)
+		      || bg_job_set_paused(job, bg_job_get_state(job, &pos) != BJS_PAUSED);
+	}
+	else
+	{
+		failed = (job == NULL) || bg_job_move(job, (keys[0] == L'J') ? 1 : -1);
+	}
+
+	update_job_items(m);
+
+	bg_jobs_unfreeze();
+
+	if(failed)
+	{
+		show_error_msg("Job control", (keys[0] == L'p')
+				? "Only internal operations can be paused"
+				: "Only queued operations can be reordered");
+	}
+
+	draw_menu(m);
+	move_to_menu_pos(m->pos, m);
+	return KHR_REFRESH_WINDOW;
+}
+
+/* Retrieves job under the cursor.  Jobs list must be frozen.  Returns the job
+ * or NULL if it's gone. */
+static job_t *
+get_current_job(const menu_info *m)
+{
+	job_t *job;
+
+	if(m->len == 0 || menu_jobs[m->pos] == NULL)
+	{
+		return NULL;
+	}
+
+	for(job = jobs; job != NULL; job = job->next)
+	{
+		if(job == menu_jobs[m->pos] && job->running)
+		{
+			return job;
+		}
+	}
+
+	return NULL;
+}
+
+/* Updates state of jobs in menu items.  Jobs list must be frozen. */
+static void
+update_job_items(menu_info *m)
+{
+	int i;
+	for(i = 0; i < m->len; ++i)
+	{
+		job_t *job;
+
+		for(job = jobs; job != NULL; job = job->next)
+		{
+			if(job == menu_jobs[i] && job->running)
+			{
+				break;
+			}
+		}
+
+		menu_jobs[i] = job;
+		if(job != NULL)
+		{
+			char *const item = format_job_item(job);
+			if(item != NULL)
+			{
+				free(m->items[i]);
+				m->items[i] = item;
+			}
+		}
+	}
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
@@ -21,12 +21,19 @@
 
 #include <curses.h>
 
+#ifndef _WIN32
+#include <fcntl.h> /* F_GETFL F_SETFL O_NONBLOCK fcntl() */
+#include <unistd.h> /* read() */
+#endif
+
 #include <assert.h> /* assert() */
+#include <errno.h> /* EAGAIN EINTR EWOULDBLOCK errno */
+#include <signal.h> /* SIGINT kill() */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE */
-#include <stdlib.h> /* free() malloc() */
-#include <string.h> /* memmove() memset() strdup() strcat() strncat() strchr()
-                       strlen() strrchr() */
+#include <stdio.h> /* FILE fclose() fileno() */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memchr() memcpy() memmove() memset() strdup() strcat()
+                       strncat() strchr() strlen() strrchr() */
 #include <wchar.h> /* wchar_t wcscmp() */
 
 #include "../cfg/config.h"
@@ -60,12 +67,33 @@
 #include "../search.h"
 #include "../status.h"
 
+/* State of loading lines of output of an external command into a menu while
+ * the menu is already displayed. */
+struct menu_stream_t
+{
+	pid_t pid;          /* Process that produces the lines. */
+	FILE *out;          /* Output stream of the process. */
+	FILE *err;          /* Error stream of the process. */
+	char *title;        /* Title of the menu without loading indicator. */
+	char *partial;      /* Incomplete last line read so far. */
+	size_t partial_len; /* Length of the incomplete line. */
+	int capacity;       /* Number of elements allocated for items of the menu. */
+};
+
 static void draw_menu_item(menu_info *m, char buf[], int off,
 		const col_attr_t *col);
 static void open_selected_file(const char path[], int line_num);
 static void navigate_to_selected_file(FileView *view, const char path[]);
 static void normalize_top(menu_info *m);
+#ifdef _WIN32
 static void output_handler(const char line[], void *arg);
+#else
+static void append_output(menu_info *m, const char buf[], size_t len);
+static void append_line(menu_info *m, const char line[], size_t len);
+static void finish_loading(menu_info *m);
+static void stop_loading(menu_info *m, int interrupt);
+static void update_loading_title(menu_info *m);
+#endif
 static void append_to_string(char **str, const char suffix[]);
 static char * expand_tabulation_a(const char line[], size_t tab_stops);
 static size_t chars_in_str(const char s[], char c);
@@ -178,11 +206,16 @@ init_menu_info(menu_info *m, char title[], char empty_msg[])
 	m->extra_data = 0;
 	m->execute_handler = NULL;
 	m->empty_msg = empty_msg;
+	m->stream = NULL;
 }
 
 void
 reset_popup_menu(menu_info *m)
 {
+#ifndef _WIN32
+	stop_loading(m, 1);
+#endif
+
 	free(m->args);
 	/* Menu elements don't always have data associated with them.  That's why we
 	 * need this check. */
@@ -541,14 +574,39 @@ int
 capture_output_to_menu(FileView *view, const char cmd[], int user_sh,
 		menu_info *m)
 {
+#ifndef _WIN32
+	if(menu_start_loading(m, cmd, user_sh) != 0)
+#else
 	if(process_cmd_output("Loading menu", cmd, user_sh, &output_handler, m) != 0)
+#endif
 	{
 		show_error_msgf("Trouble running command", "Unable to run: %s", cmd);
 		return 0;
 	}
 
+#ifndef _WIN32
+	show_progress("", 0);
+
+	ui_cancellation_reset();
+	ui_cancellation_enable();
+
+	/* Wait for the first lines to know whether menu is empty.  The rest is loaded
+	 * while menu is displayed, unless there is no UI to display it yet. */
+	while(menu_is_loading(m) && (m->len == 0 || curr_stats.load_stage < 2))
+	{
+		wait_for_data_from(m->stream->pid, m->stream->out, 0);
+		(void)menu_load_more(m);
+		show_progress("Loading menu", 1000);
+	}
+
+	ui_cancellation_disable();
+#endif
+
 	if(ui_cancellation_requested())
 	{
+#ifndef _WIN32
+		stop_loading(m, 1);
+#endif
 		append_to_string(&m->title, "(cancelled)");
 		append_to_string(&m->empty_msg, " (cancelled)");
 	}
@@ -556,6 +614,8 @@ capture_output_to_menu(FileView *view, const char cmd[], int user_sh,
 	return display_menu(m, view);
 }
 
+#ifdef _WIN32
+
 /* Implements process_cmd_output() callback that loads lines to a menu. */
 static void
 output_handler(const char line[], void *arg)
@@ -571,6 +631,297 @@ output_handler(const char line[], void *arg)
 	}
 }
 
+int
+menu_start_loading(menu_info *m, const char cmd[], int user_sh)
+{
+	return 1;
+}
+
+int
+menu_is_loading(const menu_info *m)
+{
+	return 0;
+}
+
+int
+menu_load_more(menu_info *m)
+{
+	return 0;
+}
+
+int
+menu_get_fd(const menu_info *m)
+{
+	return -1;
+}
+
+void
+menu_cancel_loading(menu_info *m)
+{
+}
+
+#else
+
+int
+menu_start_loading(menu_info *m, const char cmd[], int user_sh)
+{
+	struct menu_stream_t *const stream = malloc(sizeof(*stream));
+	if(stream == NULL)
+	{
+		return 1;
+	}
+
+	LOG_INFO_MSG("Capturing output of the command: %s", cmd);
+
+	stream->pid = background_and_capture((char *)cmd, user_sh, &stream->out,
+			&stream->err);
+	if(stream->pid == (pid_t)-1)
+	{
+		free(stream);
+		return 1;
+	}
+
+	/* Reads shouldn't block the UI while the command is thinking. */
+	(void)fcntl(fileno(stream->out), F_SETFL,
+			fcntl(fileno(stream->out), F_GETFL) | O_NONBLOCK);
+
+	stream->title = m->title;
+	stream->partial = NULL;
+	stream->partial_len = 0U;
+	stream->capacity = m->len;
+
+	m->title = (stream->title == NULL) ? NULL : strdup(stream->title);
+	m->stream = stream;
+	return 0;
+}
+
+int
+menu_is_loading(const menu_info *m)
+{
+	return m->stream != NULL;
+}
+
+int
+menu_load_more(menu_info *m)
+{
+	/* Limit on amount of data processed per call to keep UI responsive. */
+	enum { MAX_CHUNK = 1024*1024 };
+
+	char buf[16*1024];
+	size_t total = 0U;
+	const int old_len = m->len;
+
+	if(m->stream == NULL)
+	{
+		return 0;
+	}
+
+	while(total < MAX_CHUNK)
+	{
+		const ssize_t nread = read(fileno(m->stream->out), buf, sizeof(buf));
+		if(nread < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(nread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			break;
+		}
+		if(nread <= 0)
+		{
+			finish_loading(m);
+			return 1;
+		}
+
+		append_output(m, buf, nread);
+		total += nread;
+	}
+
+	if(m->len == old_len)
+	{
+		return 0;
+	}
+
+	/* Newly added items don't match the last search. */
+	if(m->matches != NULL)
+	{
+		int *const matches = reallocarray(m->matches, m->len, sizeof(*matches));
+		if(matches == NULL)
+		{
+			free(m->matches);
+			m->matches = NULL;
+			m->matching_entries = 0;
+		}
+		else
+		{
+			memset(matches + old_len, 0, sizeof(*matches)*(m->len - old_len));
+			m->matches = matches;
+		}
+	}
+
+	update_loading_title(m);
+	return 1;
+}
+
+int
+menu_get_fd(const menu_info *m)
+{
+	return (m->stream == NULL) ? -1 : fileno(m->stream->out);
+}
+
+void
+menu_cancel_loading(menu_info *m)
+{
+	if(m->stream != NULL)
+	{
+		stop_loading(m, 1);
+		append_to_string(&m->title, "(cancelled)");
+	}
+}
+
+/* Splits piece of command output into lines and appends them to the menu. */
+static void
+append_output(menu_info *m, const char buf[], size_t len)
+{
+	struct menu_stream_t *const stream = m->stream;
+	const char *const end = buf + len;
+
+	while(buf != end)
+	{
+		const char *const eol = memchr(buf, '\n', end - buf);
+		const size_t part_len = ((eol == NULL) ? end : eol) - buf;
+
+		if(eol == NULL || stream->partial_len != 0U)
+		{
+			char *const partial = realloc(stream->partial,
+					stream->partial_len + part_len);
+			if(partial == NULL)
+			{
+				return;
+			}
+			memcpy(partial + stream->partial_len, buf, part_len);
+			stream->partial = partial;
+			stream->partial_len += part_len;
+		}
+
+		if(eol == NULL)
+		{
+			break;
+		}
+
+		if(stream->partial_len != 0U)
+		{
+			append_line(m, stream->partial, stream->partial_len);
+			stream->partial_len = 0U;
+		}
+		else
+		{
+			append_line(m, buf, part_len);
+		}
+
+		buf = eol + 1;
+	}
+}
+
+/* Appends single line of the specified length to the menu.  Storage for items
+ * grows geometrically. */
+static void
+append_line(menu_info *m, const char line[], size_t len)
+{
+	struct menu_stream_t *const stream = m->stream;
+	char *item;
+
+	if(m->len >= stream->capacity)
+	{
+		const int capacity = (stream->capacity < 64) ? 64 : stream->capacity*2;
+		char **const items = reallocarray(m->items, capacity, sizeof(*items));
+		if(items == NULL)
+		{
+			return;
+		}
+		m->items = items;
+		stream->capacity = capacity;
+	}
+
+	item = malloc(len + 1U);
+	if(item == NULL)
+	{
+		return;
+	}
+	memcpy(item, line, len);
+	item[len] = '\0';
+
+	if(memchr(line, '\t', len) != NULL)
+	{
+		char *const expanded_item = expand_tabulation_a(item, cfg.tab_stop);
+		free(item);
+		item = expanded_item;
+		if(item == NULL)
+		{
+			return;
+		}
+	}
+
+	m->items[m->len++] = item;
+}
+
+/* Handles end of command output. */
+static void
+finish_loading(menu_info *m)
+{
+	if(m->stream->partial_len != 0U)
+	{
+		append_line(m, m->stream->partial, m->stream->partial_len);
+	}
+	stop_loading(m, 0);
+}
+
+/* Frees resources associated with loading of menu items, if any.  Command is
+ * interrupted if interrupt flag is set, otherwise its errors are reported. */
+static void
+stop_loading(menu_info *m, int interrupt)
+{
+	struct menu_stream_t *const stream = m->stream;
+	if(stream == NULL)
+	{
+		return;
+	}
+
+	m->stream = NULL;
+
+	fclose(stream->out);
+	if(interrupt)
+	{
+		(void)kill(stream->pid, SIGINT);
+		fclose(stream->err);
+	}
+	else
+	{
+		show_errors_from_file(stream->err, "Loading menu");
+	}
+
+	free(m->title);
+	m->title = stream->title;
+
+	free(stream->partial);
+	free(stream);
+}
+
+/* Makes title of the menu display number of items loaded so far. */
+static void
+update_loading_title(menu_info *m)
+{
+	char *const title = format_str("%s (loading: %d)",
+			(m->stream->title == NULL) ? "" : m->stream->title, m->len);
+	if(title != NULL)
+	{
+		free(m->title);
+		m->title = title;
+	}
+}
+
+#endif
+
 /* Replaces *str with a copy of the with string extended by the suffix.  *str
  * can be NULL in which case it's treated as empty string. equal to the with (then function does nothing).  Returns non-zero if memory allocation
  * failed. */
@@ -681,7 +1032,8 @@ menu_to_custom_view(menu_info *m, FileView *view, int very)
 	int i;
 	char *current = NULL;
 
-	flist_custom_start(view, m->title);
+	/* Items that are still being loaded don't get into the view. */
+	flist_custom_start(view, (m->stream == NULL) ? m->title : m->stream->title);
 
 	for(i = 0; i < m->len; ++i)
 	{
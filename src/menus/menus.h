@@ -70,6 +70,9 @@ typedef struct menu_info
 	/* Text displayed by display_menu() function in case menu is empty, it can be
 	 * NULL if this cannot happen and will be freed by reset_popup_menu(). */
 	char *empty_msg;
+	/* State of loading items from output of an external command, NULL when all
+	 * items are already in the menu. */
+	struct menu_stream_t *stream;
 }
 menu_info;
 
@@ -113,6 +116,27 @@ char * prepare_targets(FileView *view);
 int capture_output_to_menu(FileView *view, const char cmd[], int user_sh,
 		menu_info *m);
 
+/* Runs external command in background and starts loading its output into the
+ * m menu.  Returns zero on success, otherwise non-zero is returned. */
+int menu_start_loading(menu_info *m, const char cmd[], int user_sh);
+
+/* Checks whether items of the menu are still being loaded.  Returns non-zero
+ * if so, otherwise zero is returned. */
+int menu_is_loading(const menu_info *m);
+
+/* Appends to the menu lines of command output that can be read without
+ * blocking.  Returns non-zero if menu has changed. */
+int menu_load_more(menu_info *m);
+
+/* Retrieves file descriptor that becomes readable when menu_load_more() has
+ * more lines to add.  Returns the descriptor or -1 if the menu isn't being
+ * loaded. */
+int menu_get_fd(const menu_info *m);
+
+/* Stops loading items of the menu by interrupting the command and marks menu
+ * as cancelled.  Does nothing if menu isn't being loaded. */
+void menu_cancel_loading(menu_info *m);
+
 /* Prepares menu, draws it and switches to the menu mode.  Returns non-zero if
  * status bar message should be saved. */
 int display_menu(menu_info *m, FileView *view);
@@ -42,9 +42,9 @@
 #include "../utils/fs.h"
 #include "../utils/macros.h"
 #include "../utils/str.h"
-#include "../utils/tree.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
+#include "../dcache.h"
 #include "../filelist.h"
 #include "../status.h"
 #include "../types.h"
@@ -140,7 +140,7 @@ redraw_file_info_dialog(void)
 	{
 		char full_path[PATH_MAX];
 		get_current_full_path(view, sizeof(full_path), full_path);
-		tree_get_data(curr_stats.dirsize_cache, full_path, &size);
+		(void)dcache_get(full_path, &size);
 	}
 
 	if(size == 0)
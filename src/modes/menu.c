@@ -64,6 +64,7 @@ static void leave_menu_mode(void);
 static void cmd_ctrl_b(key_info_t key_info, keys_info_t *keys_info);
 static int can_scroll_menu_up(const menu_info *menu);
 static void cmd_ctrl_c(key_info_t key_info, keys_info_t *keys_info);
+static void cmd_escape(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_d(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_e(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_f(key_info_t key_info, keys_info_t *keys_info);
@@ -132,7 +133,7 @@ static keys_add_info_t builtin_cmds[] = {
 	{L"\x15", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_ctrl_u}}},
 	{L"\x19", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_ctrl_y}}},
 	/* escape */
-	{L"\x1b", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_ctrl_c}}},
+	{L"\x1b", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_escape}}},
 	{L"/", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_slash}}},
 	{L":", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_colon}}},
 	{L"?", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_question}}},
@@ -142,8 +143,8 @@ static keys_add_info_t builtin_cmds[] = {
 	{L"L", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_L}}},
 	{L"M", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_M}}},
 	{L"N", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_N}}},
-	{L"ZZ", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_ctrl_c}}},
-	{L"ZQ", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_ctrl_c}}},
+	{L"ZZ", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_escape}}},
+	{L"ZQ", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_escape}}},
 	{L"b", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_b}}},
 	{L"dd", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_dd}}},
 	{L"gf", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_gf}}},
@@ -152,7 +153,7 @@ static keys_add_info_t builtin_cmds[] = {
 	{L"k", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_k}}},
 	{L"l", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_ctrl_m}}},
 	{L"n", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_n}}},
-	{L"q", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_ctrl_c}}},
+	{L"q", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_escape}}},
 	{L"zb", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_zb}}},
 	{L"zH", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_zH}}},
 	{L"zL", {BUILTIN_KEYS, FOLLOWED_BY_NONE, {.handler = cmd_zL}}},
@@ -311,6 +312,30 @@ menu_post(void)
 	status_bar_message(curr_stats.save_msg ? NULL : "");
 }
 
+void
+menu_check_for_updates(void)
+{
+	if(!menu_load_more(menu))
+	{
+		return;
+	}
+
+	if(vle_mode_is(MENU_MODE))
+	{
+		update_menu();
+	}
+	else
+	{
+		schedule_redraw();
+	}
+}
+
+int
+menu_get_loading_fd(void)
+{
+	return (menu == NULL) ? -1 : menu_get_fd(menu);
+}
+
 void
 menu_redraw(void)
 {
@@ -354,8 +379,23 @@ can_scroll_menu_up(const menu_info *menu)
 	return menu->top > 0;
 }
 
+/* Interrupts loading of menu items or leaves menu mode if there is nothing to
+ * interrupt. */
 static void
 cmd_ctrl_c(key_info_t key_info, keys_info_t *keys_info)
+{
+	if(menu_is_loading(menu))
+	{
+		menu_cancel_loading(menu);
+		update_menu();
+		return;
+	}
+
+	leave_menu_mode();
+}
+
+static void
+cmd_escape(key_info_t key_info, keys_info_t *keys_info)
 {
 	leave_menu_mode();
 }
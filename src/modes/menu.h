@@ -33,6 +33,14 @@ void menu_pre(void);
 /* Performs post-actions (at the end of input processing loop) for menus. */
 void menu_post(void);
 
+/* Loads more items into the menu if its output is still being read and
+ * redraws it if needed. */
+void menu_check_for_updates(void);
+
+/* Retrieves file descriptor that becomes readable when menu_check_for_updates()
+ * has something to do.  Returns the descriptor or -1 if there is none. */
+int menu_get_loading_fd(void);
+
 /* Redraws menu. */
 void menu_redraw(void);
 
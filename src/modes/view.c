@@ -24,6 +24,7 @@
 #include <unistd.h> /* usleep() */
 
 #include <assert.h> /* assert() */
+#include <limits.h> /* INT_MAX */
 #include <stddef.h> /* ptrdiff_t size_t */
 #include <string.h> /* memset() strdup() */
 #include <stdio.h>  /* fclose() snprintf() */
@@ -47,6 +48,7 @@
 #include "../utils/filemon.h"
 #include "../utils/fs.h"
 #include "../utils/macros.h"
+#include "../utils/mapped_lines.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
@@ -75,7 +77,8 @@ enum
 typedef struct
 {
 	/* Data of the view. */
-	char **lines;     /* List of real lines. */
+	char **lines;     /* List of real lines (NULL when ml is used). */
+	mlines_t *ml;     /* Memory mapped file, its lines are indexed on demand. */
 	int (*widths)[2]; /* (virtual line, screen width) pair per real line. */
 	int nlines;       /* Number of real lines. */
 	int nlinesv;      /* Number of virtual (possibly wrapped) lines. */
@@ -121,8 +124,13 @@ static void init_view_info(view_info_t *vi);
 static void free_view_info(view_info_t *vi);
 static void redraw(void);
 static void calc_vlines(void);
-static void calc_vlines_wrapped(view_info_t *vi);
-static void calc_vlines_non_wrapped(view_info_t *vi);
+static void calc_vlines_from(view_info_t *vi, int from);
+static void calc_vlines_wrapped(view_info_t *vi, int from);
+static int get_line_width(const char line[]);
+static void calc_vlines_non_wrapped(view_info_t *vi, int from);
+static void ensure_lines(view_info_t *vi, int count);
+static void check_mapped_file(view_info_t *vi);
+static const char * get_vi_line(view_info_t *vi, int n);
 static void draw(void);
 static int get_part(const char line[], int offset, size_t max_len, char part[]);
 static void display_error(const char error_msg[]);
@@ -412,7 +420,10 @@ void
 view_ruler_update(void)
 {
 	char buf[POS_WIN_MIN_WIDTH + 1];
-	snprintf(buf, sizeof(buf), "%d-%d ", vi->line + 1, vi->nlines);
+	/* Total number of lines of mapped file is unknown until it's indexed. */
+	const int partial = (vi->ml != NULL && !mlines_complete(vi->ml));
+	snprintf(buf, sizeof(buf), "%d-%d%s ", vi->line + 1, vi->nlines,
+			partial ? "+" : "");
 
 	ui_ruler_set(buf);
 }
@@ -511,7 +522,11 @@ init_view_info(view_info_t *vi)
 static void
 free_view_info(view_info_t *vi)
 {
-	free_string_array(vi->lines, vi->nlines);
+	if(vi->lines != NULL)
+	{
+		free_string_array(vi->lines, vi->nlines);
+	}
+	mlines_close(vi->ml);
 	free(vi->widths);
 	if(vi->last_search_backward != -1)
 	{
@@ -543,44 +558,134 @@ calc_vlines(void)
 	vi->width = vi->view->window_width - 1;
 	vi->wrap = cfg.wrap_quick_view;
 
+	check_mapped_file(vi);
+	calc_vlines_from(vi, 0);
+}
+
+/* Calculates virtual lines of a view starting with the specified real line.
+ * Virtual lines before it are assumed to be up to date. */
+static void
+calc_vlines_from(view_info_t *vi, int from)
+{
 	if(vi->wrap)
 	{
-		calc_vlines_wrapped(vi);
+		calc_vlines_wrapped(vi, from);
 	}
 	else
 	{
-		calc_vlines_non_wrapped(vi);
+		calc_vlines_non_wrapped(vi, from);
 	}
 }
 
 /* Recalculates virtual lines of a view with line wrapping. */
 static void
-calc_vlines_wrapped(view_info_t *vi)
+calc_vlines_wrapped(view_info_t *vi, int from)
 {
 	int i;
-	vi->nlinesv = 0;
-	for(i = 0; i < vi->nlines; i++)
+	if(from == 0)
+	{
+		vi->nlinesv = 0;
+	}
+	for(i = from; i < vi->nlines; i++)
 	{
 		vi->widths[i][0] = vi->nlinesv++;
-		vi->widths[i][1] = utf8_strsw_with_tabs(vi->lines[i], cfg.tab_stop) -
-			esc_str_overhead(vi->lines[i]);
+		vi->widths[i][1] = get_line_width(get_vi_line(vi, i));
 		vi->nlinesv += vi->widths[i][1]/vi->width;
 	}
 }
 
+/* Computes screen width of a line.  Returns the width. */
+static int
+get_line_width(const char line[])
+{
+	/* Fast path for lines of printable ASCII characters and tabulations, which
+	 * prevail in large files. */
+	int width = 0;
+	const char *p = line;
+	while((*p >= ' ' && *p < '\x7f') || *p == '\t')
+	{
+		width += (*p == '\t') ? cfg.tab_stop - width%cfg.tab_stop : 1;
+		++p;
+	}
+	if(*p == '\0')
+	{
+		return width;
+	}
+
+	return utf8_strsw_with_tabs(line, cfg.tab_stop) - esc_str_overhead(line);
+}
+
 /* Recalculates virtual lines of a view without line wrapping. */
 static void
-calc_vlines_non_wrapped(view_info_t *vi)
+calc_vlines_non_wrapped(view_info_t *vi, int from)
 {
 	int i;
 	vi->nlinesv = vi->nlines;
-	for(i = 0; i < vi->nlines; i++)
+	for(i = from; i < vi->nlines; i++)
 	{
 		vi->widths[i][0] = i;
 		vi->widths[i][1] = vi->width;
 	}
 }
 
+/* Extends lines of mapped file to contain at least count lines, if file has
+ * that many.  Does nothing for views that aren't backed by mapped files. */
+static void
+ensure_lines(view_info_t *vi, int count)
+{
+	int nlines;
+	int (*widths)[2];
+	int old_nlines;
+
+	if(vi->ml == NULL || count <= vi->nlines || mlines_complete(vi->ml))
+	{
+		return;
+	}
+
+	nlines = mlines_index(vi->ml, count);
+	if(nlines <= vi->nlines)
+	{
+		return;
+	}
+
+	widths = reallocarray(vi->widths, nlines, sizeof(*widths));
+	if(widths == NULL)
+	{
+		return;
+	}
+
+	old_nlines = vi->nlines;
+	vi->widths = widths;
+	vi->nlines = nlines;
+
+	/* Widths of new lines are computed here only if the rest are computed,
+	 * otherwise calc_vlines() will take care of all lines at once. */
+	if(vi->width > 0)
+	{
+		calc_vlines_from(vi, old_nlines);
+	}
+}
+
+/* Makes sure that lines of mapped file can be accessed safely. */
+static void
+check_mapped_file(view_info_t *vi)
+{
+	if(vi->ml != NULL)
+	{
+		mlines_check(vi->ml);
+	}
+}
+
+/* Retrieves text of a line.  For mapped files only the requested line is
+ * copied out of the mapping into a buffer, which is reused by subsequent
+ * calls.  Returns pointer to null terminated string. */
+static const char *
+get_vi_line(view_info_t *vi, int n)
+{
+	size_t len;
+	return (vi->ml == NULL) ? vi->lines[n] : mlines_get(vi->ml, n, &len);
+}
+
 static void
 draw(void)
 {
@@ -588,8 +693,8 @@ draw(void)
 	const col_scheme_t *cs = ui_view_get_cs(vi->view);
 	const int height = vi->view->window_rows - 1;
 	const int width = vi->view->window_width - 1;
-	const int max_l = MIN(vi->line + height, vi->nlines);
 	const int searched = (vi->last_search_backward != -1);
+	int max_l;
 	esc_state state;
 
 	if(vi->graphics)
@@ -603,6 +708,10 @@ draw(void)
 		return;
 	}
 
+	check_mapped_file(vi);
+	ensure_lines(vi, vi->line + height + 1);
+	max_l = MIN(vi->line + height, vi->nlines);
+
 	esc_state_init(&state, &cs->color[WIN_COLOR]);
 
 	ui_view_erase(vi->view);
@@ -611,8 +720,11 @@ draw(void)
 	{
 		int offset = 0;
 		int processed = 0;
-		char *const line = vi->lines[l];
-		char *p = searched ? esc_highlight_pattern(line, &vi->re) : line;
+		const char *const line = get_vi_line(vi, l);
+		char *const highlighted = searched
+		                        ? esc_highlight_pattern(line, &vi->re)
+		                        : NULL;
+		const char *const p = searched ? highlighted : line;
 		do
 		{
 			int printed;
@@ -624,10 +736,7 @@ draw(void)
 			++processed;
 		}
 		while(vi->wrap && p[offset] != '\0' && vl < height);
-		if(searched)
-		{
-			free(p);
-		}
+		free(highlighted);
 	}
 	refresh_view_win(vi->view);
 }
@@ -890,6 +999,8 @@ cmd_percent(key_info_t key_info, keys_info_t *keys_info)
 	if(key_info.count > 100)
 		key_info.count = 100;
 
+	ensure_lines(vi, INT_MAX);
+
 	vi->line = (key_info.count*vi->nlinesv)/100;
 	if(vi->line >= vi->nlines)
 		vi->line = vi->nlines - 1;
@@ -1020,8 +1131,13 @@ load_view_data(view_info_t *vi, const char action[], const char file_to_view[],
 	vi->widths = reallocarray(NULL, vi->nlines, sizeof(*vi->widths));
 	if(vi->widths == NULL)
 	{
-		free_string_array(vi->lines, vi->nlines);
-		vi->lines = NULL;
+		if(vi->lines != NULL)
+		{
+			free_string_array(vi->lines, vi->nlines);
+			vi->lines = NULL;
+		}
+		mlines_close(vi->ml);
+		vi->ml = NULL;
 		vi->nlines = 0;
 		show_error_msg(action, "Not enough memory");
 		return 1;
@@ -1046,6 +1162,14 @@ get_view_data(view_info_t *vi, const char file_to_view[])
 		}
 		else
 		{
+			/* Regular files are mapped to avoid reading them into memory. */
+			vi->ml = mlines_open(file_to_view);
+			if(vi->ml != NULL)
+			{
+				vi->nlines = mlines_index(vi->ml, 1);
+				return 0;
+			}
+
 			fp = os_fopen(file_to_view, "rb");
 		}
 
@@ -1162,6 +1286,8 @@ cmd_g(key_info_t key_info, keys_info_t *keys_info)
 	if(key_info.count == NO_COUNT_GIVEN)
 		key_info.count = 1;
 
+	ensure_lines(vi, MIN(key_info.count, INT_MAX/2) + vi->view->window_rows);
+
 	key_info.count = MIN(vi->nlinesv - (vi->view->window_rows - 1),
 			key_info.count);
 	key_info.count = MAX(1, key_info.count);
@@ -1176,6 +1302,9 @@ cmd_g(key_info_t key_info, keys_info_t *keys_info)
 static void
 cmd_j(key_info_t key_info, keys_info_t *keys_info)
 {
+	const int count = (key_info.count == NO_COUNT_GIVEN) ? 1 : key_info.count;
+	ensure_lines(vi, vi->line + MIN(count, INT_MAX/2) + vi->view->window_rows);
+
 	if(key_info.reg == NO_REG_GIVEN)
 	{
 		if((vi->linev + 1) + (vi->view->window_rows - 1) > vi->nlinesv)
@@ -1257,6 +1386,8 @@ search(int repeat_count, int backward)
 		repeat_count = 1;
 	}
 
+	check_mapped_file(vi);
+
 	while(repeat_count-- > 0 && curr_stats.save_msg == 0)
 	{
 		if(backward)
@@ -1270,12 +1401,16 @@ search(int repeat_count, int backward)
 	}
 }
 
+/* Searching works on copies of lines instead of mapped memory because pattern
+ * is matched against each screen line with escape sequences removed and
+ * tabulation expanded, which doesn't correspond to bytes of the file. */
 static void
 find_previous(int vline_offset)
 {
 	int i;
 	int offset = 0;
-	char buf[(vi->view->window_width - 1)*4];
+	const size_t max_len = vi->view->window_width - 1;
+	char buf[max_len*4];
 	int vl, l;
 
 	vl = vi->linev - vline_offset;
@@ -1285,7 +1420,7 @@ find_previous(int vline_offset)
 		l--;
 
 	for(i = 0; i <= vl - vi->widths[l][0]; i++)
-		offset = get_part(vi->lines[l], offset, vi->view->window_width - 1, buf);
+		offset = get_part(get_vi_line(vi, l), offset, max_len, buf);
 
 	/* Don't stop until we go above first virtual line of the first line. */
 	while(l >= 0 && vl >= 0)
@@ -1301,11 +1436,10 @@ find_previous(int vline_offset)
 			l--;
 			offset = 0;
 			for(i = 0; i <= vl - 1 - vi->widths[l][0]; i++)
-				offset = get_part(vi->lines[l], offset, vi->view->window_width - 1,
-						buf);
+				offset = get_part(get_vi_line(vi, l), offset, max_len, buf);
 		}
 		else
-			offset = get_part(vi->lines[l], offset, vi->view->window_width - 1, buf);
+			offset = get_part(get_vi_line(vi, l), offset, max_len, buf);
 		vl--;
 	}
 	draw();
@@ -1320,20 +1454,23 @@ find_next(void)
 {
 	int i;
 	int offset = 0;
-	char buf[(vi->view->window_width - 1)*4];
+	const size_t max_len = vi->view->window_width - 1;
+	char buf[max_len*4];
 	int vl, l;
 
 	vl = vi->linev + 1;
 	l = vi->line;
 
+	ensure_lines(vi, l + 2);
 	if(l < vi->nlines - 1 && vl == vi->widths[l + 1][0])
 		l++;
 
 	for(i = 0; i <= vl - vi->widths[l][0]; i++)
-		offset = get_part(vi->lines[l], offset, vi->view->window_width - 1, buf);
+		offset = get_part(get_vi_line(vi, l), offset, max_len, buf);
 
 	while(l < vi->nlines)
 	{
+		ensure_lines(vi, l + 2);
 		if(regexec(&vi->re, buf, 0, NULL, 0) == 0)
 		{
 			vi->linev = vl;
@@ -1348,7 +1485,7 @@ find_next(void)
 			l++;
 			offset = 0;
 		}
-		offset = get_part(vi->lines[l], offset, vi->view->window_width - 1, buf);
+		offset = get_part(get_vi_line(vi, l), offset, max_len, buf);
 		vl++;
 	}
 	draw();
@@ -1546,6 +1683,14 @@ view_check_for_updates(void)
 	}
 }
 
+int
+view_is_forwarding(void)
+{
+	return view_info[VI_QV].auto_forward
+	    || view_info[VI_LWIN].auto_forward
+	    || view_info[VI_RWIN].auto_forward;
+}
+
 /* Forwards the view if underlying file changed.  Returns non-zero if reload
  * occurred, otherwise zero is returned. */
 static int
@@ -1578,6 +1723,8 @@ forward_if_changed(view_info_t *vi)
 static int
 scroll_to_bottom(view_info_t *vi)
 {
+	ensure_lines(vi, INT_MAX);
+
 	if(vi->linev + 1 + vi->view->window_rows - 1 > vi->nlinesv)
 	{
 		return 0;
@@ -60,6 +60,11 @@ int draw_abandoned_view_mode(void);
 /* Checks whether contents of either view should be updated. */
 void view_check_for_updates(void);
 
+/* Checks whether any of the views follows changes of its file, which requires
+ * calling view_check_for_updates() periodically.  Returns non-zero if so,
+ * otherwise zero is returned. */
+int view_is_forwarding(void);
+
 #endif /* VIFM__MODES__VIEW_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -30,6 +30,7 @@
                        strstr() */
 
 #include "cfg/config.h"
+#include "cfg/info.h"
 #include "engine/options.h"
 #include "engine/text_buffer.h"
 #include "modes/view.h"
@@ -43,6 +44,7 @@
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/utils.h"
+#include "background.h"
 #include "filelist.h"
 #include "search.h"
 #include "sort.h"
@@ -104,6 +106,7 @@ static const char * pick_out_decoration(const char classify_item[],
 static void columns_handler(OPT_OP op, optval_t val);
 static void confirm_handler(OPT_OP op, optval_t val);
 static void cpoptions_handler(OPT_OP op, optval_t val);
+static void cvquickreload_handler(OPT_OP op, optval_t val);
 static void dotdirs_handler(OPT_OP op, optval_t val);
 static void fastrun_handler(OPT_OP op, optval_t val);
 static void fillchars_handler(OPT_OP op, optval_t val);
@@ -118,6 +121,7 @@ static void hlsearch_handler(OPT_OP op, optval_t val);
 static void iec_handler(OPT_OP op, optval_t val);
 static void ignorecase_handler(OPT_OP op, optval_t val);
 static void incsearch_handler(OPT_OP op, optval_t val);
+static void iojobs_handler(OPT_OP op, optval_t val);
 static int parse_range(const char range[], int *from, int *to);
 static int parse_endpoint(const char **str, int *endpoint);
 static void laststatus_handler(OPT_OP op, optval_t val);
@@ -161,6 +165,7 @@ static void set_view_columns_option(FileView *view, const char value[],
 static void add_column(columns_t columns, column_info_t column_info);
 static int map_name(const char name[], void *arg);
 static void resort_view(FileView * view);
+static void statthreads_handler(OPT_OP op, optval_t val);
 static void statusline_handler(OPT_OP op, optval_t val);
 static void syscalls_handler(OPT_OP op, optval_t val);
 static void tabstop_handler(OPT_OP op, optval_t val);
@@ -278,6 +283,7 @@ static const char *vifminfo_set[] = {
 	"registers",
 	"phistory",
 	"fhistory",
+	"undo",
 };
 
 /* Empty value to satisfy default initializer. */
@@ -330,6 +336,10 @@ options[] = {
 	  OPT_CHARSET, cpoptions_count, &cpoptions_vals, &cpoptions_handler, NULL,
 	  { .init = &init_cpoptions },
 	},
+	{ "cvquickreload", "",
+	  OPT_BOOL, 0, NULL, &cvquickreload_handler, NULL,
+	  { .ref.bool_val = &cfg.cv_quick_reload },
+	},
 	{ "dotdirs", "",
 	  OPT_SET, ARRAY_LEN(dotdirs_vals), dotdirs_vals, &dotdirs_handler, NULL,
 	  { .ref.set_items = &cfg.dot_dirs },
@@ -383,6 +393,10 @@ options[] = {
 	  OPT_BOOL, 0, NULL, &incsearch_handler , NULL,
 	  { .ref.bool_val = &cfg.inc_search },
 	},
+	{ "iojobs", "",
+	  OPT_INT, 0, NULL, &iojobs_handler, NULL,
+	  { .ref.int_val = &cfg.io_jobs },
+	},
 	{ "laststatus", "ls",
 	  OPT_BOOL, 0, NULL, &laststatus_handler, NULL,
 	  { .ref.bool_val = &cfg.display_statusline },
@@ -437,6 +451,10 @@ options[] = {
 	  OPT_BOOL, 0, NULL, &sortnumbers_handler, NULL,
 	  { .ref.bool_val = &cfg.sort_numbers },
 	},
+	{ "statthreads", "",
+	  OPT_INT, 0, NULL, &statthreads_handler, NULL,
+	  { .ref.int_val = &cfg.stat_threads },
+	},
 	{ "statusline", "stl",
 	  OPT_STR, 0, NULL, &statusline_handler, NULL,
 	  { .ref.str_val = &cfg.status_line },
@@ -1148,6 +1166,14 @@ cpoptions_handler(OPT_OP op, optval_t val)
 	}
 }
 
+/* Toggles checking only files of changed directories on reloading custom
+ * views. */
+static void
+cvquickreload_handler(OPT_OP op, optval_t val)
+{
+	cfg.cv_quick_reload = val.bool_val;
+}
+
 static void
 dotdirs_handler(OPT_OP op, optval_t val)
 {
@@ -1288,6 +1314,23 @@ incsearch_handler(OPT_OP op, optval_t val)
 	cfg.inc_search = val.bool_val;
 }
 
+/* Sets maximum number of background operations run on the same devices at the
+ * same time. */
+static void
+iojobs_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val <= 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be positive: %d", val.int_val);
+		error = 1;
+		reset_option_to_default("iojobs", OPT_GLOBAL);
+		return;
+	}
+
+	cfg.io_jobs = val.int_val;
+	bg_limits_changed();
+}
+
 /* Parses range, which can be shortened to single endpoint if first element
  * matches last one.  Returns non-zero on error, otherwise zero is returned. */
 static int
@@ -1905,6 +1948,22 @@ resort_view(FileView * view)
 	refresh_view_win(view);
 }
 
+/* Sets number of threads used to query information about files on loading
+ * directories. */
+static void
+statthreads_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val <= 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be positive: %d", val.int_val);
+		error = 1;
+		reset_option_to_default("statthreads", OPT_GLOBAL);
+		return;
+	}
+
+	cfg.stat_threads = val.int_val;
+}
+
 static void
 statusline_handler(OPT_OP op, optval_t val)
 {
@@ -2039,6 +2098,12 @@ static void
 vifminfo_handler(OPT_OP op, optval_t val)
 {
 	cfg.vifm_info = val.set_items;
+
+	/* Journal is opened on startup after undo levels are set up. */
+	if(curr_stats.load_stage >= 2)
+	{
+		update_undo_journal();
+	}
 }
 
 static void
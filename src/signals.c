@@ -41,8 +41,8 @@ static void _gnuc_noreturn shutdown_nicely(int sig, const char descr[]);
 
 #ifndef _WIN32
 
-#include <sys/types.h> /* pid_t */
-#include <sys/wait.h> /* WEXITSTATUS() WIFEXITED() waitpid() */
+#include <fcntl.h> /* FD_CLOEXEC F_GETFL F_SETFD F_SETFL O_NONBLOCK fcntl() */
+#include <unistd.h> /* pipe() read() write() */
 
 #include <stdlib.h> /* EXIT_FAILURE _Exit() */
 
@@ -50,6 +50,14 @@ static void _gnuc_noreturn shutdown_nicely(int sig, const char descr[]);
 #include "background.h"
 #include "status.h"
 
+/* Self-pipe, which is written to on signals that schedule updates.  Wakes up
+ * the event loop, which otherwise could miss a signal that arrived right before
+ * it started waiting. */
+static int wakeup_pipe[2] = { -1, -1 };
+
+static void wake_up_event_loop(void);
+static void make_wakeup_pipe(void);
+
 /* Handle term resizing in X */
 static void
 received_sigwinch(void)
@@ -65,6 +73,8 @@ received_sigwinch(void)
 	{
 		curr_stats.need_update = UT_FULL;
 	}
+
+	wake_up_event_loop();
 }
 
 static void
@@ -72,24 +82,28 @@ received_sigcont(void)
 {
 	reset_prog_mode();
 	schedule_redraw();
+	wake_up_event_loop();
 }
 
+/* Makes wakeup pipe readable, should be called after updating state. */
 static void
-received_sigchld(void)
+wake_up_event_loop(void)
 {
-	int status;
-	pid_t pid;
-
-	/* This needs to be a loop in case of multiple blocked signals. */
-	while((pid = waitpid(-1, &status, WNOHANG)) > 0)
+	if(wakeup_pipe[1] >= 0)
 	{
-		if(WIFEXITED(status))
-		{
-			add_finished_job(pid, WEXITSTATUS(status));
-		}
+		const char c = '\0';
+		/* Failure means that pipe is full, so event loop will wake up anyway. */
+		(void)write(wakeup_pipe[1], &c, 1);
 	}
 }
 
+static void
+received_sigchld(void)
+{
+	/* Processes are reaped by the main loop, which is woken up here. */
+	bg_sigchld_received();
+}
+
 static void
 handle_signal(int sig)
 {
@@ -121,6 +135,27 @@ handle_signal(int sig)
 	errno = saved_errno;
 }
 
+/* Creates non-blocking self-pipe to be written to by signal handlers. */
+static void
+make_wakeup_pipe(void)
+{
+	int i;
+
+	if(pipe(wakeup_pipe) != 0)
+	{
+		wakeup_pipe[0] = -1;
+		wakeup_pipe[1] = -1;
+		return;
+	}
+
+	for(i = 0; i < 2; ++i)
+	{
+		(void)fcntl(wakeup_pipe[i], F_SETFL,
+				fcntl(wakeup_pipe[i], F_GETFL) | O_NONBLOCK);
+		(void)fcntl(wakeup_pipe[i], F_SETFD, FD_CLOEXEC);
+	}
+}
+
 #else
 BOOL WINAPI
 ctrl_handler(DWORD dwCtrlType)
@@ -174,6 +209,8 @@ setup_signals(void)
 #ifndef _WIN32
 	struct sigaction handle_signal_action;
 
+	make_wakeup_pipe();
+
 	handle_signal_action.sa_handler = &handle_signal;
 	sigemptyset(&handle_signal_action.sa_mask);
 	handle_signal_action.sa_flags = SA_RESTART;
@@ -198,5 +235,33 @@ setup_signals(void)
 #endif
 }
 
+int
+signals_get_wakeup_fd(void)
+{
+#ifndef _WIN32
+	return wakeup_pipe[0];
+#else
+	return -1;
+#endif
+}
+
+void
+signals_clear_wakeup(void)
+{
+#ifndef _WIN32
+	char buf[64];
+
+	if(wakeup_pipe[0] < 0)
+	{
+		return;
+	}
+
+	while(read(wakeup_pipe[0], buf, sizeof(buf)) > 0)
+	{
+		/* Do nothing, the state was updated by signal handlers. */
+	}
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -22,6 +22,15 @@
 
 void setup_signals(void);
 
+/* Retrieves file descriptor that becomes readable when a signal that schedules
+ * updates (e.g., of terminal size) is received.  Returns the descriptor or -1
+ * if there is none. */
+int signals_get_wakeup_fd(void);
+
+/* Resets state of the descriptor returned by signals_get_wakeup_fd().  Should
+ * be called before processing scheduled updates. */
+void signals_clear_wakeup(void);
+
 #endif /* VIFM__SIGNALS_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
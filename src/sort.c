@@ -21,46 +21,81 @@
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() qsort() */
-#include <string.h> /* strcmp() strrchr() */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* abs() free() */
+#include <string.h> /* memcpy() strchr() strcmp() strdup() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
 #include "ui/ui.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/test_helpers.h"
-#include "utils/tree.h"
 #include "utils/utils.h"
+#include "dcache.h"
 #include "filelist.h"
 #include "status.h"
 #include "types.h"
 
-/* View which is being sorted. */
-static FileView* view;
-/* Whether the view displays custom file list. */
-static int custom_view;
-static int sort_descending;
-/* Key used to sort entries in current sorting round. */
-static SortingKey sort_type;
+/* Precomputed per-entry data used during sorting. */
+typedef struct
+{
+	dir_entry_t *entry; /* Entry being sorted. */
+	int index;          /* Original position of the entry (to keep sort stable). */
+	int is_parent;      /* Whether this is "..". */
+	int is_dir;         /* Whether entry is a directory or link to one. */
+	const char *name;   /* Name to sort by (short path for custom views). */
+	char *iname;        /* Lowercased name or NULL if it's not needed. */
+	const char *ext;    /* Last dot in the name of the entry or NULL. */
+	uint64_t perms;     /* Rank of permissions string, preserves strcmp() order. */
+	char *path_buf;     /* Storage for short path or NULL. */
+}
+sort_item_t;
+
+/* Description of sorting keys shared by all comparisons of a single sort. */
+typedef struct
+{
+	signed char keys[SK_COUNT + 1]; /* Signed keys from the most significant. */
+	int count;                      /* Number of elements in keys. */
+	int custom_view;                /* Whether the view is a custom one. */
+}
+sort_spec_t;
 
-static void sort_by_key(char key);
-static int sort_dir_list(const void *one, const void *two);
+static void make_sort_spec(const FileView *view, sort_spec_t *spec);
+static int spec_has_key(const sort_spec_t *spec, SortingKey key);
+static void init_sort_item(const FileView *view, const sort_spec_t *spec,
+		dir_entry_t *entry, int index, sort_item_t *item);
+static void free_sort_item(sort_item_t *item);
+#ifndef _WIN32
+static uint64_t rank_permissions(const dir_entry_t *entry);
+#endif
+static void merge_sort(sort_item_t *items[], sort_item_t *tmp[], size_t count,
+		const sort_spec_t *spec);
+static int compare_items(const sort_item_t *a, const sort_item_t *b,
+		const sort_spec_t *spec);
+static int compare_by_key(const sort_item_t *a, const sort_item_t *b,
+		SortingKey key);
+static int compare_by_extension(const sort_item_t *a, const sort_item_t *b,
+		SortingKey key);
 TSTATIC int strnumcmp(const char s[], const char t[]);
 #if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
 static int vercmp(const char s[], const char t[]);
 #else
 static char * skip_leading_zeros(const char str[]);
 #endif
-static int compare_entry_names(const dir_entry_t *a, const dir_entry_t *b,
-		int ignore_case);
-static int compare_full_file_names(const char s[], const char t[],
+static int compare_names(const sort_item_t *a, const sort_item_t *b,
 		int ignore_case);
-static int compare_file_names(const char s[], const char t[], int ignore_case);
+static int compare_file_names(const char s[], const char t[]);
 
 void
 sort_view(FileView *v)
 {
+	sort_spec_t spec;
+	sort_item_t *items;
+	sort_item_t **order, **tmp;
+	dir_entry_t *sorted;
+	const int count = v->list_rows;
 	int i;
 
 	if(v->sort[0] > SK_LAST)
@@ -69,280 +104,440 @@ sort_view(FileView *v)
 		return;
 	}
 
-	view = v;
-	custom_view = flist_custom_active(v);
+	if(count < 2)
+	{
+		return;
+	}
 
-	i = SK_COUNT;
-	while(--i >= 0)
+	items = reallocarray(NULL, count, sizeof(*items));
+	order = reallocarray(NULL, count, sizeof(*order));
+	tmp = reallocarray(NULL, count, sizeof(*tmp));
+	sorted = reallocarray(NULL, count, sizeof(*sorted));
+	if(items == NULL || order == NULL || tmp == NULL || sorted == NULL)
 	{
-		const char sorting_key = view->sort[i];
+		free(items);
+		free(order);
+		free(tmp);
+		free(sorted);
+		return;
+	}
 
-		if(abs(sorting_key) > SK_LAST)
-		{
-			continue;
-		}
+	make_sort_spec(v, &spec);
 
-		sort_by_key(sorting_key);
+	/* Keys are computed once per entry rather than on each comparison. */
+	for(i = 0; i < count; ++i)
+	{
+		v->dir_entry[i].list_num = i;
+		init_sort_item(v, &spec, &v->dir_entry[i], i, &items[i]);
+		order[i] = &items[i];
 	}
 
-	if(!ui_view_sort_list_contains(v->sort, SK_BY_DIR))
+	merge_sort(order, tmp, count, &spec);
+
+	for(i = 0; i < count; ++i)
 	{
-		sort_by_key(SK_BY_DIR);
+		sorted[i] = *order[i]->entry;
+		free_sort_item(&items[i]);
 	}
+	memcpy(v->dir_entry, sorted, count*sizeof(*sorted));
+	flist_invalidate_index(v);
+
+	free(sorted);
+	free(tmp);
+	free(order);
+	free(items);
 }
 
-/* Sorts view by the key in a stable way. */
+int
+sort_compare_entries(FileView *v, dir_entry_t *a, dir_entry_t *b)
+{
+	sort_spec_t spec;
+	sort_item_t a_item, b_item;
+	int retval;
+
+	make_sort_spec(v, &spec);
+	init_sort_item(v, &spec, a, 0, &a_item);
+	init_sort_item(v, &spec, b, 0, &b_item);
+
+	retval = compare_items(&a_item, &b_item, &spec);
+
+	free_sort_item(&a_item);
+	free_sort_item(&b_item);
+	return retval;
+}
+
+/* Fills sorting specification for the view.  Keys are listed from the most
+ * significant one to the least significant one. */
 static void
-sort_by_key(char key)
+make_sort_spec(const FileView *view, sort_spec_t *spec)
 {
-	int j;
+	int i;
 
-	sort_descending = (key < 0);
-	sort_type = (SortingKey)abs(key);
+	spec->count = 0;
+	spec->custom_view = flist_custom_active(view);
 
-	for(j = 0; j < view->list_rows; j++)
+	if(!ui_view_sort_list_contains(view->sort, SK_BY_DIR))
 	{
-		view->dir_entry[j].list_num = j;
+		spec->keys[spec->count++] = SK_BY_DIR;
 	}
 
-	qsort(view->dir_entry, view->list_rows, sizeof(dir_entry_t), sort_dir_list);
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		const char sorting_key = view->sort[i];
+		if(abs(sorting_key) <= SK_LAST)
+		{
+			spec->keys[spec->count++] = sorting_key;
+		}
+	}
 }
 
-/* Compares file names containing numbers correctly. */
-TSTATIC int
-strnumcmp(const char s[], const char t[])
+/* Checks whether sorting specification includes the key in either direction.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+spec_has_key(const sort_spec_t *spec, SortingKey key)
 {
-#if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
-	return vercmp(s, t);
-#else
-	const char *new_s = skip_leading_zeros(s);
-	const char *new_t = skip_leading_zeros(t);
-	return strverscmp(new_s, new_t);
-#endif
+	int i;
+	for(i = 0; i < spec->count; ++i)
+	{
+		if(abs(spec->keys[i]) == (int)key)
+		{
+			return 1;
+		}
+	}
+	return 0;
 }
 
-#if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
-static int
-vercmp(const char s[], const char t[])
+/* Precomputes data of the entry that is needed by keys of the
+ * specification. */
+static void
+init_sort_item(const FileView *view, const sort_spec_t *spec,
+		dir_entry_t *entry, int index, sort_item_t *item)
 {
-	while(*s != '\0' && *t != '\0')
+	const int by_name = spec_has_key(spec, SK_BY_NAME);
+	const int by_iname = spec_has_key(spec, SK_BY_INAME);
+
+	item->entry = entry;
+	item->index = index;
+	item->is_parent = is_parent_dir(entry->name);
+	item->is_dir = is_directory_entry(entry);
+	item->name = entry->name;
+	item->iname = NULL;
+	item->ext = strrchr(entry->name, '.');
+	item->perms = 0U;
+	item->path_buf = NULL;
+
+	if(spec->custom_view && (by_name || by_iname))
 	{
-		if(isdigit(*s) && isdigit(*t))
+		char short_path[PATH_MAX];
+		get_short_path_of(view, entry, 0, sizeof(short_path), short_path);
+		item->path_buf = strdup(short_path);
+		if(item->path_buf != NULL)
 		{
-			int num_a, num_b;
-			const char *os = s, *ot = t;
-			char *p;
+			item->name = item->path_buf;
+		}
+	}
 
-			num_a = strtol(s, &p, 10);
-			s = p;
+	if(by_iname)
+	{
+		char lowered[NAME_MAX];
+		/* Ignore too small buffer errors by not caring about part that didn't
+		 * fit. */
+		(void)str_to_lower(item->name, lowered, sizeof(lowered));
+		item->iname = strdup(lowered);
+	}
 
-			num_b = strtol(t, &p, 10);
-			t = p;
+	if(item->is_dir && spec_has_key(spec, SK_BY_SIZE))
+	{
+		char full_path[PATH_MAX];
+		get_full_path_of(entry, sizeof(full_path), full_path);
+		(void)dcache_get(full_path, &entry->size);
+	}
 
-			if(num_a != num_b)
-				return num_a - num_b;
-			else if(*os != *ot)
-				return *os - *ot;
-		}
-		else if(*s == *t)
-		{
-			s++;
-			t++;
-		}
-		else
-			break;
+#ifndef _WIN32
+	if(spec_has_key(spec, SK_BY_PERMISSIONS))
+	{
+		item->perms = rank_permissions(entry);
 	}
+#endif
+}
 
-	return *s - *t;
+/* Frees resources allocated by init_sort_item(). */
+static void
+free_sort_item(sort_item_t *item)
+{
+	free(item->iname);
+	free(item->path_buf);
 }
-#else
-/* Skips all zeros in front of numbers (correctly handles zero).  Returns str, a
- * pointer to '0' or a pointer to non-zero digit. */
-static char *
-skip_leading_zeros(const char str[])
+
+#ifndef _WIN32
+/* Converts permissions string of the entry to a number that compares the same
+ * way as strings do.  Returns the rank. */
+static uint64_t
+rank_permissions(const dir_entry_t *entry)
 {
-	while(str[0] == '0' && isdigit(str[1]))
+	/* Characters that can appear after the type in ascending order. */
+	static const char perm_chars[] = "-STrstwx";
+
+	char perms[11];
+	uint64_t rank;
+	int i;
+
+	get_perm_string(perms, sizeof(perms), entry->mode);
+
+	rank = (unsigned char)perms[0];
+	for(i = 1; i < 10; ++i)
 	{
-		str++;
+		const char *const c = strchr(perm_chars, perms[i]);
+		rank = (rank << 3) | (c == NULL ? 0U : (uint64_t)(c - perm_chars));
 	}
-	return (char *)str;
+	return rank;
 }
 #endif
 
+/* Sorts array of items in a stable way using tmp as a temporary storage of the
+ * same size. */
+static void
+merge_sort(sort_item_t *items[], sort_item_t *tmp[], size_t count,
+		const sort_spec_t *spec)
+{
+	const size_t half = count/2;
+	size_t i, j, k;
+
+	if(count < 2)
+	{
+		return;
+	}
+
+	merge_sort(items, tmp, half, spec);
+	merge_sort(items + half, tmp, count - half, spec);
+
+	/* Skip merging if halves are already in order. */
+	if(compare_items(items[half - 1], items[half], spec) <= 0)
+	{
+		return;
+	}
+
+	memcpy(tmp, items, half*sizeof(*tmp));
+
+	i = 0U;
+	j = half;
+	k = 0U;
+	while(i < half && j < count)
+	{
+		if(compare_items(items[j], tmp[i], spec) < 0)
+		{
+			items[k++] = items[j++];
+		}
+		else
+		{
+			items[k++] = tmp[i++];
+		}
+	}
+	while(i < half)
+	{
+		items[k++] = tmp[i++];
+	}
+}
+
+/* Compares two items by all keys of the specification.  Returns positive value
+ * if a goes after b, zero if they are equal, otherwise negative value is
+ * returned. */
 static int
-sort_dir_list(const void *one, const void *two)
+compare_items(const sort_item_t *a, const sort_item_t *b,
+		const sort_spec_t *spec)
 {
-	int retval;
-	char *pfirst, *psecond;
-	dir_entry_t *const first = (dir_entry_t *)one;
-	dir_entry_t *const second = (dir_entry_t *)two;
-	int first_is_dir;
-	int second_is_dir;
+	int i;
 
-	if(is_parent_dir(first->name))
+	if(a->is_parent)
 	{
 		return -1;
 	}
-	else if(is_parent_dir(second->name))
+	else if(b->is_parent)
 	{
 		return 1;
 	}
 
-	first_is_dir = is_directory_entry(first);
-	second_is_dir = is_directory_entry(second);
+	for(i = 0; i < spec->count; ++i)
+	{
+		const int key = spec->keys[i];
+		const int retval = compare_by_key(a, b, (SortingKey)abs(key));
+		if(retval != 0)
+		{
+			return (key < 0) ? -retval : retval;
+		}
+	}
+
+	return a->index - b->index;
+}
+
+/* Compares two items by a single key.  Returns positive value if a is greater
+ * than b, zero if they are equal, otherwise negative value is returned. */
+static int
+compare_by_key(const sort_item_t *a, const sort_item_t *b, SortingKey key)
+{
+	const dir_entry_t *const first = a->entry;
+	const dir_entry_t *const second = b->entry;
 
-	retval = 0;
-	switch(sort_type)
+	switch(key)
 	{
 		case SK_BY_NAME:
 		case SK_BY_INAME:
-			if(custom_view)
-			{
-				retval = compare_entry_names(first, second, sort_type == SK_BY_INAME);
-			}
-			else
-			{
-				retval = compare_full_file_names(first->name, second->name,
-						sort_type == SK_BY_INAME);
-			}
-			break;
+			return compare_names(a, b, key == SK_BY_INAME);
 
 		case SK_BY_DIR:
-			if(first_is_dir != second_is_dir)
-			{
-				retval = first_is_dir ? -1 : 1;
-			}
-			break;
+			return (a->is_dir == b->is_dir) ? 0 : (a->is_dir ? -1 : 1);
 
 		case SK_BY_TYPE:
-			retval = strcmp(get_type_str(first->type), get_type_str(second->type));
-			break;
+			return strcmp(get_type_str(first->type), get_type_str(second->type));
 
 		case SK_BY_FILEEXT:
 		case SK_BY_EXTENSION:
-			pfirst = strrchr(first->name,  '.');
-			psecond = strrchr(second->name, '.');
-
-			if(first_is_dir && second_is_dir && sort_type == SK_BY_FILEEXT)
-			{
-				retval = compare_file_names(first->name, second->name, 0);
-			}
-			else if(first_is_dir != second_is_dir && sort_type == SK_BY_FILEEXT)
-			{
-				retval = first_is_dir ? -1 : 1;
-			}
-			else if(pfirst && psecond)
-			{
-				if(pfirst == first->name && psecond != second->name)
-				{
-					retval = -1;
-				}
-				else if(pfirst != first->name && psecond == second->name)
-				{
-					retval = 1;
-				}
-				else
-				{
-					retval = compare_file_names(++pfirst, ++psecond, 0);
-				}
-			}
-			else if(pfirst || psecond)
-				retval = pfirst ? -1 : 1;
-			else
-				retval = compare_file_names(first->name, second->name, 0);
-			break;
+			return compare_by_extension(a, b, key);
 
 		case SK_BY_SIZE:
-			{
-				if(first_is_dir)
-				{
-					char full_path[PATH_MAX];
-					get_full_path_of(first, sizeof(full_path), full_path);
-					tree_get_data(curr_stats.dirsize_cache, full_path, &first->size);
-				}
-
-				if(second_is_dir)
-				{
-					char full_path[PATH_MAX];
-					get_full_path_of(second, sizeof(full_path), full_path);
-					tree_get_data(curr_stats.dirsize_cache, full_path, &second->size);
-				}
-
-				retval = (first->size < second->size)
-				       ? -1
-				       : (first->size > second->size);
-			}
-			break;
+			return (first->size < second->size) ? -1 : (first->size > second->size);
 
 		case SK_BY_TIME_MODIFIED:
-			retval = first->mtime - second->mtime;
-			break;
+			return first->mtime - second->mtime;
 
 		case SK_BY_TIME_ACCESSED:
-			retval = first->atime - second->atime;
-			break;
+			return first->atime - second->atime;
 
 		case SK_BY_TIME_CHANGED:
-			retval = first->ctime - second->ctime;
-			break;
+			return first->ctime - second->ctime;
 #ifndef _WIN32
 		case SK_BY_MODE:
-			retval = first->mode - second->mode;
-			break;
+			return first->mode - second->mode;
 
 		case SK_BY_OWNER_NAME: /* FIXME */
 		case SK_BY_OWNER_ID:
-			retval = first->uid - second->uid;
-			break;
+			return first->uid - second->uid;
 
 		case SK_BY_GROUP_NAME: /* FIXME */
 		case SK_BY_GROUP_ID:
-			retval = first->gid - second->gid;
-			break;
+			return first->gid - second->gid;
 
 		case SK_BY_PERMISSIONS:
-			{
-				char first_perm[11], second_perm[11];
-				get_perm_string(first_perm, sizeof(first_perm), first->mode);
-				get_perm_string(second_perm, sizeof(second_perm), second->mode);
-				retval = strcmp(first_perm, second_perm);
-			}
-			break;
+			return (a->perms < b->perms) ? -1 : (a->perms > b->perms);
 #endif
 	}
 
-	if(retval == 0)
+	return 0;
+}
+
+/* Compares two items by extension.  Returns positive value if a is greater
+ * than b, zero if they are equal, otherwise negative value is returned. */
+static int
+compare_by_extension(const sort_item_t *a, const sort_item_t *b,
+		SortingKey key)
+{
+	const char *const a_name = a->entry->name;
+	const char *const b_name = b->entry->name;
+
+	if(key == SK_BY_FILEEXT)
+	{
+		if(a->is_dir && b->is_dir)
+		{
+			return compare_file_names(a_name, b_name);
+		}
+		if(a->is_dir != b->is_dir)
+		{
+			return a->is_dir ? -1 : 1;
+		}
+	}
+
+	if(a->ext != NULL && b->ext != NULL)
 	{
-		retval = first->list_num - second->list_num;
+		if(a->ext == a_name && b->ext != b_name)
+		{
+			return -1;
+		}
+		if(a->ext != a_name && b->ext == b_name)
+		{
+			return 1;
+		}
+		return compare_file_names(a->ext + 1, b->ext + 1);
 	}
-	else if(sort_descending)
+
+	if(a->ext != NULL || b->ext != NULL)
 	{
-		retval = -retval;
+		return (a->ext != NULL) ? -1 : 1;
 	}
 
-	return retval;
+	return compare_file_names(a_name, b_name);
 }
 
-/* Compares names of two file entries.  Returns positive value if a is greater
- * than b, zero if they are equal, otherwise negative value is returned. */
+/* Compares file names containing numbers correctly. */
+TSTATIC int
+strnumcmp(const char s[], const char t[])
+{
+#if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
+	return vercmp(s, t);
+#else
+	const char *new_s = skip_leading_zeros(s);
+	const char *new_t = skip_leading_zeros(t);
+	return strverscmp(new_s, new_t);
+#endif
+}
+
+#if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
 static int
-compare_entry_names(const dir_entry_t *a, const dir_entry_t *b, int ignore_case)
+vercmp(const char s[], const char t[])
 {
-	char a_short_path[PATH_MAX];
-	char b_short_path[PATH_MAX];
+	while(*s != '\0' && *t != '\0')
+	{
+		if(isdigit(*s) && isdigit(*t))
+		{
+			int num_a, num_b;
+			const char *os = s, *ot = t;
+			char *p;
+
+			num_a = strtol(s, &p, 10);
+			s = p;
 
-	get_short_path_of(view, a, 0, sizeof(a_short_path), a_short_path);
-	get_short_path_of(view, b, 0, sizeof(b_short_path), b_short_path);
+			num_b = strtol(t, &p, 10);
+			t = p;
 
-	return compare_full_file_names(a_short_path, b_short_path, ignore_case);
+			if(num_a != num_b)
+				return num_a - num_b;
+			else if(*os != *ot)
+				return *os - *ot;
+		}
+		else if(*s == *t)
+		{
+			s++;
+			t++;
+		}
+		else
+			break;
+	}
+
+	return *s - *t;
+}
+#else
+/* Skips all zeros in front of numbers (correctly handles zero).  Returns str, a
+ * pointer to '0' or a pointer to non-zero digit. */
+static char *
+skip_leading_zeros(const char str[])
+{
+	while(str[0] == '0' && isdigit(str[1]))
+	{
+		str++;
+	}
+	return (char *)str;
 }
+#endif
 
-/* Compares two full filenames and assumes that dot character is smaller than
- * any other character.  Returns positive value if s is greater than t, zero if
+/* Compares names of two items and assumes that dot character is smaller than
+ * any other character.  Returns positive value if a is greater than b, zero if
  * they are equal, otherwise negative value is returned. */
 static int
-compare_full_file_names(const char s[], const char t[], int ignore_case)
+compare_names(const sort_item_t *a, const sort_item_t *b, int ignore_case)
 {
+	const char *const s = a->name;
+	const char *const t = b->name;
+	int result;
+
 	if(s[0] == '.' && t[0] != '.')
 	{
 		return -1;
@@ -351,36 +546,14 @@ compare_full_file_names(const char s[], const char t[], int ignore_case)
 	{
 		return 1;
 	}
-	else
-	{
-		return compare_file_names(s, t, ignore_case);
-	}
-}
 
-/* Compares two file names or their parts (e.g. extensions).  Returns positive
- * value if s is greater than t, zero if they are equal, otherwise negative
- * value is returned. */
-static int
-compare_file_names(const char s[], const char t[], int ignore_case)
-{
-	const char *s_val = s, *t_val = t;
-	char s_buf[NAME_MAX];
-	char t_buf[NAME_MAX];
-	int result;
-
-	if(ignore_case)
+	if(!ignore_case || a->iname == NULL || b->iname == NULL)
 	{
-		/* Ignore too small buffer errors by not caring about part that didn't
-		 * fit. */
-		(void)str_to_lower(s, s_buf, sizeof(s_buf));
-		(void)str_to_lower(t, t_buf, sizeof(t_buf));
-
-		s_val = s_buf;
-		t_val = t_buf;
+		return compare_file_names(s, t);
 	}
 
-	result = cfg.sort_numbers ? strnumcmp(s_val, t_val) : strcmp(s_val, t_val);
-	if(result == 0 && ignore_case)
+	result = compare_file_names(a->iname, b->iname);
+	if(result == 0)
 	{
 		/* Resort to comparing original names when their normalized versions match
 		 * to always solve ties in deterministic way. */
@@ -389,6 +562,15 @@ compare_file_names(const char s[], const char t[], int ignore_case)
 	return result;
 }
 
+/* Compares two file names or their parts (e.g. extensions).  Returns positive
+ * value if s is greater than t, zero if they are equal, otherwise negative
+ * value is returned. */
+static int
+compare_file_names(const char s[], const char t[])
+{
+	return cfg.sort_numbers ? strnumcmp(s, t) : strcmp(s, t);
+}
+
 SortingKey
 get_secondary_key(SortingKey primary_key)
 {
@@ -25,6 +25,11 @@
 
 void sort_view(FileView *view);
 
+/* Compares two entries of the view according to its sorting keys in the same
+ * way sort_view() orders them.  Returns positive value if a goes after b,
+ * zero if they are equal, otherwise negative value is returned. */
+int sort_compare_entries(FileView *view, dir_entry_t *a, dir_entry_t *b);
+
 /* Maps primary sort key to second column type.  Returns secondary key that
  * corresponds to the primary one. */
 SortingKey get_secondary_key(SortingKey primary_key);
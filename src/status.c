@@ -40,9 +40,9 @@
 #include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
-#include "utils/tree.h"
 #include "utils/utils.h"
 #include "commands_completion.h"
+#include "dcache.h"
 
 /* Environment variables by which application hosted by terminal multiplexer can
  * identify the host. */
@@ -52,7 +52,6 @@
 static void load_def_values(status_t *stats, config_t *config);
 static void determine_fuse_umount_cmd(status_t *stats);
 static void set_gtk_available(status_t *stats);
-static int reset_dircache(status_t *stats);
 static void set_last_cmdline_command(const char cmd[]);
 
 status_t curr_stats;
@@ -94,7 +93,6 @@ load_def_values(status_t *stats, config_t *config)
 	stats->drop_new_dir_hist = 0;
 	stats->load_stage = 0;
 	stats->term_state = TS_NORMAL;
-	stats->dirsize_cache = NULL_TREE;
 	stats->ch_pos = 1;
 	stats->confirmed = 0;
 	stats->skip_shellout_redraw = 0;
@@ -185,16 +183,7 @@ reset_status(const config_t *config)
 	curr_stats.initial_lines = config->lines;
 	curr_stats.initial_columns = config->columns;
 
-	return reset_dircache(&curr_stats);
-}
-
-/* Returns non-zero on error. */
-static int
-reset_dircache(status_t *stats)
-{
-	tree_free(stats->dirsize_cache);
-	stats->dirsize_cache = tree_create(0, 0);
-	return stats->dirsize_cache == NULL_TREE;
+	return dcache_reset();
 }
 
 void
@@ -41,6 +41,7 @@ const char *tags[] = {
 	"vifm-'confirm'",
 	"vifm-'cpo'",
 	"vifm-'cpoptions'",
+	"vifm-'cvquickreload'",
 	"vifm-'dotdirs'",
 	"vifm-'fastrun'",
 	"vifm-'fcs'",
@@ -59,6 +60,7 @@ const char *tags[] = {
 	"vifm-'iec'",
 	"vifm-'ignorecase'",
 	"vifm-'incsearch'",
+	"vifm-'iojobs'",
 	"vifm-'is'",
 	"vifm-'laststatus'",
 	"vifm-'lines'",
@@ -89,6 +91,7 @@ const char *tags[] = {
 	"vifm-'sort'",
 	"vifm-'sortnumbers'",
 	"vifm-'sortorder'",
+	"vifm-'statthreads'",
 	"vifm-'statusline'",
 	"vifm-'stl'",
 	"vifm-'syscalls'",
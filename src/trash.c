@@ -19,13 +19,17 @@
 #include "trash.h"
 
 #include <sys/stat.h> /* stat */
+#include <dirent.h> /* DIR dirent */
+#include <pthread.h> /* PTHREAD_* pthread_*() */
+#include <unistd.h> /* _SC_NPROCESSORS_ONLN rmdir() sysconf() */
 
 #include <assert.h> /* assert() */
+#include <ctype.h> /* tolower() */
 #include <errno.h> /* errno */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* snprintf() */
-#include <stdlib.h> /* free() realloc() */
-#include <string.h> /* strchr() strcmp() strdup() strlen() strspn() */
+#include <stdio.h> /* remove() snprintf() */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memmove() strchr() strcmp() strdup() strlen() strspn() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -35,6 +39,7 @@
 #include "modes/dialogs/msg_dialog.h"
 #include "utils/fs.h"
 #include "utils/log.h"
+#include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
@@ -70,6 +75,26 @@ typedef struct
 }
 trashes_list;
 
+/* Directory that is being emptied by several threads. */
+typedef struct rm_node_t
+{
+	char *path;               /* Path to the directory. */
+	struct rm_node_t *parent; /* Parent directory or NULL for the root. */
+	struct rm_node_t *next;   /* Next directory in the queue. */
+	int pending;              /* Number of unfinished subdirectories + 1. */
+}
+rm_node_t;
+
+/* State shared by threads that remove contents of a directory. */
+typedef struct
+{
+	rm_node_t *queue;     /* Directories waiting to be listed. */
+	int done;             /* Whether whole tree has been processed. */
+	pthread_mutex_t lock; /* Protects all fields of the structure. */
+	pthread_cond_t cond;  /* Signals changes of the queue and done flag. */
+}
+rm_walk_t;
+
 /* State for get_list_of_trashes() traverser. */
 typedef struct
 {
@@ -83,7 +108,19 @@ static int create_trash_dir(const char trash_dir[]);
 static void empty_trash_dirs(void);
 static void empty_trash_dir(const char trash_dir[]);
 static void empty_trash_in_bg(bg_op_t *bg_op, void *arg);
+TSTATIC void remove_tree_content(const char path[]);
+static int get_rm_threads(void);
+static void * rm_worker(void *arg);
+static rm_node_t * take_rm_node(rm_walk_t *walk);
+static void process_rm_node(rm_walk_t *walk, rm_node_t *node);
+static void add_rm_node(rm_walk_t *walk, rm_node_t *parent, const char path[]);
+static void finish_rm_node(rm_walk_t *walk, rm_node_t *node);
 static void remove_trash_entries(const char trash_dir[]);
+static int find_in_trash(const char trash_name[]);
+static int add_to_index(int pos);
+static void remove_from_index(int pos);
+static int rebuild_index(int size, int count);
+static unsigned int hash_trash_name(const char trash_name[]);
 static trashes_list get_list_of_trashes(void);
 static int get_list_of_trashes_traverser(struct mntent *entry, void *arg);
 static int is_trash_valid(const char trash_dir[]);
@@ -103,6 +140,14 @@ static char * format_root_spec(const char spec[], const char mount_point[]);
 static char **specs;
 static int nspecs;
 
+/* Number of elements trash_list has memory for. */
+static int trash_capacity;
+/* Hash table of positions in trash_list keyed by trash names.  Empty slots
+ * contain -1. */
+static int *trash_index;
+/* Number of slots in trash_index, which is zero or a power of two. */
+static int index_size;
+
 int
 set_trash_dir(const char new_specs[])
 {
@@ -251,8 +296,8 @@ empty_trash_dir(const char trash_dir[])
 
 	char *const trash_dir_copy = strdup(trash_dir);
 
-	if(bg_execute(task_desc, op_desc, BG_UNDEFINED_TOTAL, 1, &empty_trash_in_bg,
-			trash_dir_copy) != 0)
+	if(bg_execute(task_desc, op_desc, BG_UNDEFINED_TOTAL, 1, trash_dir, NULL,
+			&empty_trash_in_bg, trash_dir_copy) != 0)
 	{
 		free(trash_dir_copy);
 	}
@@ -268,11 +313,210 @@ empty_trash_in_bg(bg_op_t *bg_op, void *arg)
 {
 	char *const trash_dir = arg;
 
-	remove_dir_content(trash_dir);
+	remove_tree_content(trash_dir);
 
 	free(trash_dir);
 }
 
+/* Removes contents of the directory leaving directory itself in place.  The
+ * tree is processed by several threads, which take directories to list from a
+ * shared queue.  Directories are removed once all their subdirectories are
+ * removed. */
+TSTATIC void
+remove_tree_content(const char path[])
+{
+	enum { MAX_THREADS = 4 };
+
+	pthread_t threads[MAX_THREADS];
+	int nthreads;
+	int i;
+	rm_walk_t walk = { .queue = NULL, .done = 0 };
+
+	pthread_mutex_init(&walk.lock, NULL);
+	pthread_cond_init(&walk.cond, NULL);
+
+	add_rm_node(&walk, NULL, path);
+
+	if(walk.queue != NULL)
+	{
+		/* Current thread is a worker as well. */
+		nthreads = MIN(get_rm_threads(), MAX_THREADS) - 1;
+		for(i = 0; i < nthreads; ++i)
+		{
+			if(pthread_create(&threads[i], NULL, &rm_worker, &walk) != 0)
+			{
+				nthreads = i;
+				break;
+			}
+		}
+
+		(void)rm_worker(&walk);
+
+		for(i = 0; i < nthreads; ++i)
+		{
+			(void)pthread_join(threads[i], NULL);
+		}
+	}
+
+	pthread_cond_destroy(&walk.cond);
+	pthread_mutex_destroy(&walk.lock);
+}
+
+/* Determines how many threads should remove files.  Returns the number. */
+static int
+get_rm_threads(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	const long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return (ncpus > 0) ? ncpus : 1;
+#else
+	return 1;
+#endif
+}
+
+/* Entry point of a thread that empties directories until whole tree is
+ * processed.  Returns NULL. */
+static void *
+rm_worker(void *arg)
+{
+	rm_walk_t *const walk = arg;
+	rm_node_t *node;
+
+	while((node = take_rm_node(walk)) != NULL)
+	{
+		process_rm_node(walk, node);
+	}
+
+	return NULL;
+}
+
+/* Waits for a directory to empty.  Returns the directory or NULL when there is
+ * nothing more to do. */
+static rm_node_t *
+take_rm_node(rm_walk_t *walk)
+{
+	rm_node_t *node = NULL;
+
+	pthread_mutex_lock(&walk->lock);
+	while(walk->queue == NULL && !walk->done)
+	{
+		pthread_cond_wait(&walk->cond, &walk->lock);
+	}
+	if(walk->queue != NULL)
+	{
+		node = walk->queue;
+		walk->queue = node->next;
+	}
+	pthread_mutex_unlock(&walk->lock);
+
+	return node;
+}
+
+/* Removes files of the directory and queues its subdirectories. */
+static void
+process_rm_node(rm_walk_t *walk, rm_node_t *node)
+{
+	struct dirent *d;
+
+	DIR *const dir = os_opendir(node->path);
+	if(dir != NULL)
+	{
+		while((d = os_readdir(dir)) != NULL)
+		{
+			char *full_path;
+
+			if(is_builtin_dir(d->d_name))
+			{
+				continue;
+			}
+
+			full_path = format_str("%s/%s", node->path, d->d_name);
+			if(full_path == NULL)
+			{
+				continue;
+			}
+
+			if(entry_is_dir(full_path, d))
+			{
+				add_rm_node(walk, node, full_path);
+			}
+			else
+			{
+				(void)remove(full_path);
+			}
+			free(full_path);
+		}
+		os_closedir(dir);
+	}
+
+	finish_rm_node(walk, node);
+}
+
+/* Queues directory for emptying.  parent can be NULL for the root. */
+static void
+add_rm_node(rm_walk_t *walk, rm_node_t *parent, const char path[])
+{
+	rm_node_t *const node = malloc(sizeof(*node));
+	if(node == NULL)
+	{
+		return;
+	}
+
+	node->path = strdup(path);
+	if(node->path == NULL)
+	{
+		free(node);
+		return;
+	}
+
+	node->parent = parent;
+	node->pending = 1;
+
+	pthread_mutex_lock(&walk->lock);
+	if(parent != NULL)
+	{
+		++parent->pending;
+	}
+	node->next = walk->queue;
+	walk->queue = node;
+	pthread_cond_signal(&walk->cond);
+	pthread_mutex_unlock(&walk->lock);
+}
+
+/* Marks directory as listed and removes directories which became empty going
+ * up the tree.  The root directory is not removed. */
+static void
+finish_rm_node(rm_walk_t *walk, rm_node_t *node)
+{
+	pthread_mutex_lock(&walk->lock);
+
+	while(--node->pending == 0)
+	{
+		rm_node_t *const parent = node->parent;
+
+		if(parent == NULL)
+		{
+			walk->done = 1;
+			pthread_cond_broadcast(&walk->cond);
+		}
+		else
+		{
+			(void)rmdir(node->path);
+		}
+
+		free(node->path);
+		free(node);
+
+		if(parent == NULL)
+		{
+			break;
+		}
+		node = parent;
+	}
+
+	pthread_mutex_unlock(&walk->lock);
+}
+
 /* Removes entries that belong to specified trash directory.  Removes all if
  * trash_dir is NULL. */
 static void
@@ -299,7 +543,9 @@ remove_trash_entries(const char trash_dir[])
 	{
 		free(trash_list);
 		trash_list = NULL;
+		trash_capacity = 0;
 	}
+	(void)rebuild_index(index_size, nentries);
 }
 
 void
@@ -318,8 +564,6 @@ trash_file_moved(const char src[], const char dst[])
 int
 add_to_trash(const char path[], const char trash_name[])
 {
-	void *p;
-
 	if(!exists_in_trash(trash_name))
 	{
 		return -1;
@@ -330,17 +574,23 @@ add_to_trash(const char path[], const char trash_name[])
 		return 0;
 	}
 
-	p = reallocarray(trash_list, nentries + 1, sizeof(*trash_list));
-	if(p == NULL)
+	if(nentries == trash_capacity)
 	{
-		return -1;
+		const int capacity = (trash_capacity == 0) ? 64 : trash_capacity*2;
+		void *const p = reallocarray(trash_list, capacity, sizeof(*trash_list));
+		if(p == NULL)
+		{
+			return -1;
+		}
+		trash_list = p;
+		trash_capacity = capacity;
 	}
-	trash_list = p;
 
 	trash_list[nentries].path = strdup(path);
 	trash_list[nentries].trash_name = strdup(trash_name);
 	if(trash_list[nentries].path == NULL ||
-			trash_list[nentries].trash_name == NULL)
+			trash_list[nentries].trash_name == NULL ||
+			add_to_index(nentries) != 0)
 	{
 		free(trash_list[nentries].path);
 		free(trash_list[nentries].trash_name);
@@ -353,16 +603,161 @@ add_to_trash(const char path[], const char trash_name[])
 
 int
 is_in_trash(const char trash_name[])
+{
+	return find_in_trash(trash_name) >= 0;
+}
+
+/* Looks up entry of trash_list by its trash name.  Returns index of the entry
+ * or -1 if there is no such entry. */
+static int
+find_in_trash(const char trash_name[])
+{
+	unsigned int slot;
+
+	if(index_size == 0)
+	{
+		return -1;
+	}
+
+	slot = hash_trash_name(trash_name) & (index_size - 1);
+	while(trash_index[slot] != -1)
+	{
+		const int pos = trash_index[slot];
+		if(stroscmp(trash_list[pos].trash_name, trash_name) == 0)
+		{
+			return pos;
+		}
+		slot = (slot + 1) & (index_size - 1);
+	}
+	return -1;
+}
+
+/* Adds entry of trash_list at the position to the index growing it when
+ * needed.  Returns zero on success, otherwise non-zero is returned. */
+static int
+add_to_index(int pos)
+{
+	unsigned int slot;
+
+	/* Keep load factor at or below 0.5 to keep chains of collisions short. */
+	if(2*(nentries + 1) > index_size)
+	{
+		return rebuild_index(MAX(index_size*2, 128), pos + 1);
+	}
+
+	slot = hash_trash_name(trash_list[pos].trash_name) & (index_size - 1);
+	while(trash_index[slot] != -1)
+	{
+		slot = (slot + 1) & (index_size - 1);
+	}
+	trash_index[slot] = pos;
+	return 0;
+}
+
+/* Removes entry of trash_list at the position from the index and accounts for
+ * shift of entries after it.  Must be called before the entry is freed. */
+static void
+remove_from_index(int pos)
+{
+	const unsigned int mask = index_size - 1;
+	unsigned int slot;
+	unsigned int next;
+	int i;
+
+	slot = hash_trash_name(trash_list[pos].trash_name) & mask;
+	while(trash_index[slot] != pos)
+	{
+		slot = (slot + 1) & mask;
+	}
+
+	/* Move entries of the chain that follow the removed one, so that lookups
+	 * don't stop at the freed slot. */
+	next = (slot + 1) & mask;
+	while(trash_index[next] != -1)
+	{
+		const unsigned int home =
+			hash_trash_name(trash_list[trash_index[next]].trash_name) & mask;
+		if(((next - home) & mask) >= ((next - slot) & mask))
+		{
+			trash_index[slot] = trash_index[next];
+			slot = next;
+		}
+		next = (next + 1) & mask;
+	}
+	trash_index[slot] = -1;
+
+	/* Entries after the removed one are going to move one position back, which
+	 * costs nothing when entries are removed in reverse order of addition. */
+	for(i = pos + 1; i < nentries; ++i)
+	{
+		slot = hash_trash_name(trash_list[i].trash_name) & mask;
+		while(trash_index[slot] != i)
+		{
+			slot = (slot + 1) & mask;
+		}
+		trash_index[slot] = i - 1;
+	}
+}
+
+/* Fills index of specified size with first count entries of trash_list.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+rebuild_index(int size, int count)
 {
 	int i;
-	for(i = 0; i < nentries; i++)
+
+	if(size == 0)
+	{
+		return 0;
+	}
+
+	if(size != index_size)
 	{
-		if(stroscmp(trash_list[i].trash_name, trash_name) == 0)
+		int *const index = reallocarray(trash_index, size, sizeof(*index));
+		if(index == NULL)
+		{
 			return 1;
+		}
+		trash_index = index;
+		index_size = size;
+	}
+
+	for(i = 0; i < index_size; ++i)
+	{
+		trash_index[i] = -1;
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		unsigned int slot =
+			hash_trash_name(trash_list[i].trash_name) & (index_size - 1);
+		while(trash_index[slot] != -1)
+		{
+			slot = (slot + 1) & (index_size - 1);
+		}
+		trash_index[slot] = i;
 	}
 	return 0;
 }
 
+/* Computes FNV-1a hash of the trash name respecting case sensitivity of file
+ * system.  Returns the hash. */
+static unsigned int
+hash_trash_name(const char trash_name[])
+{
+	unsigned int hash = 2166136261U;
+	while(*trash_name != '\0')
+	{
+#ifndef _WIN32
+		hash ^= (unsigned char)*trash_name++;
+#else
+		hash ^= (unsigned char)tolower(*trash_name++);
+#endif
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
 char **
 list_trashes(int *ntrashes)
 {
@@ -441,16 +836,11 @@ exists_in_trash(const char trash_name[])
 int
 restore_from_trash(const char trash_name[])
 {
-	int i;
 	char full[PATH_MAX];
 	char buf[PATH_MAX];
 
-	for(i = 0; i < nentries; i++)
-	{
-		if(stroscmp(trash_list[i].trash_name, trash_name) == 0)
-			break;
-	}
-	if(i >= nentries)
+	const int i = find_in_trash(trash_name);
+	if(i < 0)
 		return -1;
 
 	copy_str(buf, sizeof(buf), trash_list[i].path);
@@ -488,17 +878,14 @@ restore_from_trash(const char trash_name[])
 static void
 remove_from_trash(const char trash_name[])
 {
-	int i;
-	for(i = 0; i < nentries; i++)
-	{
-		if(stroscmp(trash_list[i].trash_name, trash_name) == 0)
-			break;
-	}
-	if(i >= nentries)
+	const int i = find_in_trash(trash_name);
+	if(i < 0)
 	{
 		return;
 	}
 
+	remove_from_index(i);
+
 	free(trash_list[i].path);
 	free(trash_list[i].trash_name);
 	memmove(trash_list + i, trash_list + i + 1,
@@ -728,7 +1115,12 @@ trash_prune_dead_entries(void)
 
 		trash_list[j++] = trash_list[i];
 	}
-	nentries = j;
+
+	if(j != nentries)
+	{
+		nentries = j;
+		(void)rebuild_index(index_size, nentries);
+	}
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -19,6 +19,8 @@
 #ifndef VIFM__TRASH_H__
 #define VIFM__TRASH_H__
 
+#include "utils/test_helpers.h"
+
 /* Description of a single trash item. */
 typedef struct
 {
@@ -100,6 +102,10 @@ const char * get_real_name_from_trash_name(const char trash_path[]);
 /* Removes entries that correspond to nonexistent files in trashes. */
 void trash_prune_dead_entries(void);
 
+TSTATIC_DEFS(
+	void remove_tree_content(const char path[]);
+)
+
 #endif /* VIFM__TRASH_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -19,7 +19,8 @@
 #include "color_manager.h"
 
 #include <assert.h> /* assert() */
-#include <stddef.h> /* NULL */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() */
 
 #include "../utils/macros.h"
 #include "colors.h"
@@ -27,10 +28,26 @@
 /* Number of color pairs preallocated by curses library. */
 #define PREALLOCATED_COUNT 1
 
+/* Initial number of slots in the table of pairs, must be a power of two. */
+#define INITIAL_TABLE_SIZE 64
+
+/* Entry of the table that maps colors to pairs. */
+typedef struct
+{
+	short int fg;   /* Foreground color. */
+	short int bg;   /* Background color. */
+	short int pair; /* Number of the pair or zero for unused slot. */
+}
+pair_slot_t;
+
 static int find_pair(int fg, int bg);
-static int color_pair_matches(int pair, int fg, int bg);
 static int allocate_pair(int fg, int bg);
 static int compress_pair_space(void);
+static void rebuild_table(void);
+static void clear_table(void);
+static void add_to_table(int fg, int bg, int pair);
+static int grow_table(void);
+static size_t hash_colors(int fg, int bg);
 
 /* Number of color pairs available. */
 static int avail_pairs;
@@ -41,6 +58,13 @@ static int used_pairs;
 /* Configuration data passed in during initialization. */
 static colmgr_conf_t conf;
 
+/* Open addressing hash table that maps (fg, bg) to number of allocated pair.
+ * It allows avoiding query of every pair on lookups. */
+static pair_slot_t *table;
+
+/* Number of slots in the table, zero or a power of two. */
+static size_t table_size;
+
 void
 colmgr_init(const colmgr_conf_t *conf_init)
 {
@@ -60,6 +84,8 @@ colmgr_reset(void)
 {
 	used_pairs = PREALLOCATED_COUNT;
 	avail_pairs = conf.max_color_pairs - used_pairs;
+
+	clear_table();
 }
 
 int
@@ -92,29 +118,24 @@ colmgr_get_pair(int fg, int bg)
 static int
 find_pair(int fg, int bg)
 {
-	int i;
+	size_t i;
 
-	for(i = PREALLOCATED_COUNT; i < used_pairs; ++i)
+	if(table_size == 0U)
+	{
+		return -1;
+	}
+
+	for(i = hash_colors(fg, bg); table[i].pair != 0; i = (i + 1U)%table_size)
 	{
-		if(color_pair_matches(i, fg, bg))
+		if(table[i].fg == fg && table[i].bg == bg)
 		{
-			return i;
+			return table[i].pair;
 		}
 	}
 
 	return -1;
 }
 
-/* Checks whether color pair number pair has specified foreground (fg) and
- * background (bg) colors. */
-static int
-color_pair_matches(int pair, int fg, int bg)
-{
-	short pair_fg, pair_bg;
-	conf.pair_content(pair, &pair_fg, &pair_bg);
-	return (pair_fg == fg && pair_bg == bg);
-}
-
 /* Allocates new color pair.  Returns new pair index, or -1 on failure. */
 static int
 allocate_pair(int fg, int bg)
@@ -129,6 +150,7 @@ allocate_pair(int fg, int bg)
 	}
 
 	conf.init_pair(used_pairs, fg, bg);
+	add_to_table(fg, bg, used_pairs);
 
 	--avail_pairs;
 	return used_pairs++;
@@ -186,8 +208,108 @@ compress_pair_space(void)
 	used_pairs = j;
 	avail_pairs = conf.max_color_pairs - used_pairs;
 
+	rebuild_table();
+
 	return 0;
 }
 
+/* Fills the table with pairs that are currently allocated. */
+static void
+rebuild_table(void)
+{
+	int i;
+
+	clear_table();
+
+	for(i = PREALLOCATED_COUNT; i < used_pairs; ++i)
+	{
+		short int fg, bg;
+		conf.pair_content(i, &fg, &bg);
+		add_to_table(fg, bg, i);
+	}
+}
+
+/* Removes all entries of the table. */
+static void
+clear_table(void)
+{
+	size_t i;
+	for(i = 0U; i < table_size; ++i)
+	{
+		table[i].pair = 0;
+	}
+}
+
+/* Registers pair in the table.  Failure to do so only affects performance, as
+ * the pair will be allocated once again. */
+static void
+add_to_table(int fg, int bg, int pair)
+{
+	size_t i;
+
+	/* Keep load factor below one half to make probe sequences short. */
+	if(2U*(size_t)(used_pairs + 1) > table_size && grow_table() != 0)
+	{
+		return;
+	}
+
+	i = hash_colors(fg, bg);
+	while(table[i].pair != 0)
+	{
+		i = (i + 1U)%table_size;
+	}
+
+	table[i].fg = fg;
+	table[i].bg = bg;
+	table[i].pair = pair;
+}
+
+/* Doubles size of the table preserving its contents.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+grow_table(void)
+{
+	const size_t new_size = (table_size == 0U)
+	                      ? INITIAL_TABLE_SIZE
+	                      : 2U*table_size;
+	pair_slot_t *const old_table = table;
+	const size_t old_size = table_size;
+	size_t i;
+
+	pair_slot_t *const new_table = calloc(new_size, sizeof(*new_table));
+	if(new_table == NULL)
+	{
+		return 1;
+	}
+
+	table = new_table;
+	table_size = new_size;
+
+	for(i = 0U; i < old_size; ++i)
+	{
+		if(old_table[i].pair != 0)
+		{
+			size_t j = hash_colors(old_table[i].fg, old_table[i].bg);
+			while(table[j].pair != 0)
+			{
+				j = (j + 1U)%table_size;
+			}
+			table[j] = old_table[i];
+		}
+	}
+
+	free(old_table);
+	return 0;
+}
+
+/* Computes position of colors in the table.  Returns the position. */
+static size_t
+hash_colors(int fg, int bg)
+{
+	/* Colors start at -1, so shift them to make the values non-negative. */
+	const size_t key = (size_t)(fg + 1)*0x9e3779b1U ^ (size_t)(bg + 1);
+	return (key ^ (key >> 16))%table_size;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
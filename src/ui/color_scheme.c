@@ -370,6 +370,7 @@ static void restore_primary_color_scheme(const col_scheme_t *cs);
 static void reset_to_default_color_scheme(col_scheme_t *cs);
 static void free_color_scheme_highlights(col_scheme_t *cs);
 static file_hi_t * clone_color_scheme_highlights(const col_scheme_t *from);
+static struct matchers_t * make_file_hi_matchers(const col_scheme_t *cs);
 static void reset_color_scheme_colors(col_scheme_t *cs);
 static int source_cs(const char name[]);
 static void get_cs_path(const char name[], char buf[], size_t buf_size);
@@ -679,6 +680,7 @@ assign_color_scheme(col_scheme_t *to, const col_scheme_t *from)
 	free_color_scheme_highlights(to);
 	*to = *from;
 	to->file_hi = clone_color_scheme_highlights(from);
+	to->file_hi_matchers = make_file_hi_matchers(to);
 }
 
 /* Resets color scheme to default builtin values. */
@@ -706,9 +708,11 @@ free_color_scheme_highlights(col_scheme_t *cs)
 	}
 
 	free(cs->file_hi);
+	matchers_free(cs->file_hi_matchers);
 
 	cs->file_hi = NULL;
 	cs->file_hi_count = 0;
+	cs->file_hi_matchers = NULL;
 }
 
 /* Clones filename specific highlight array of the *from color scheme and
@@ -730,6 +734,30 @@ clone_color_scheme_highlights(const col_scheme_t *from)
 	return file_hi;
 }
 
+/* Builds list of matchers of filename specific highlights for quick lookup.
+ * Returns the list or NULL on error. */
+static struct matchers_t *
+make_file_hi_matchers(const col_scheme_t *cs)
+{
+	int i;
+	matchers_t *const ms = matchers_alloc();
+	if(ms == NULL)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < cs->file_hi_count; ++i)
+	{
+		if(matchers_add(ms, cs->file_hi[i].matcher) != 0)
+		{
+			matchers_free(ms);
+			return NULL;
+		}
+	}
+
+	return ms;
+}
+
 int
 check_directory_for_color_scheme(int left, const char dir[])
 {
@@ -944,6 +972,19 @@ add_file_hi(struct matcher_t *matcher, const col_attr_t *hi)
 	file_hi->matcher = matcher;
 	file_hi->hi = *hi;
 
+	if(cs->file_hi_count == 0)
+	{
+		matchers_free(cs->file_hi_matchers);
+		cs->file_hi_matchers = matchers_alloc();
+	}
+	if(cs->file_hi_matchers != NULL &&
+			matchers_add(cs->file_hi_matchers, matcher) != 0)
+	{
+		/* Fallback to checking matchers one by one. */
+		matchers_free(cs->file_hi_matchers);
+		cs->file_hi_matchers = NULL;
+	}
+
 	++cs->file_hi_count;
 
 	return 0;
@@ -961,6 +1002,17 @@ get_file_hi(const col_scheme_t *cs, const char fname[], int *hi_hint)
 		return &cs->file_hi[*hi_hint].hi;
 	}
 
+	if(cs->file_hi_matchers != NULL)
+	{
+		i = matchers_find(cs->file_hi_matchers, fname);
+		if(i == -1)
+		{
+			return NULL;
+		}
+		*hi_hint = i;
+		return &cs->file_hi[i].hi;
+	}
+
 	for(i = 0; i < cs->file_hi_count; ++i)
 	{
 		const file_hi_t *const file_hi = &cs->file_hi[i];
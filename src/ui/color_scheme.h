@@ -41,6 +41,7 @@ typedef enum
 ColorSchemeState;
 
 struct matcher_t;
+struct matchers_t;
 
 /* Single file highlight description. */
 typedef struct
@@ -61,6 +62,9 @@ typedef struct
 
 	file_hi_t *file_hi; /* List of file highlight preferences. */
 	int file_hi_count;  /* Number of file highlight definitions. */
+	/* Matchers of file_hi for quick lookup or NULL if they should be checked one
+	 * by one. */
+	struct matchers_t *file_hi_matchers;
 }
 col_scheme_t;
 
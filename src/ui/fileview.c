@@ -26,12 +26,15 @@
 #include <grp.h>
 #endif
 
+#include <sys/stat.h> /* S_ISDIR() stat */
+
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
 #include <stdlib.h> /* abs() */
 #include <string.h> /* strcpy() strlen() */
 
 #include "../cfg/config.h"
+#include "../compat/os.h"
 #include "../utils/fs.h"
 #include "../utils/macros.h"
 #include "../utils/path.h"
@@ -68,6 +71,7 @@ static void calculate_number_width(FileView *view);
 static int count_digits(int num);
 static int calculate_top_position(FileView *view, int top);
 static int get_line_color(const FileView *view, int pos);
+static LinkStatus get_link_status(const FileView *view, int pos);
 static size_t calculate_print_width(const FileView *view, int i,
 		size_t max_width);
 static void draw_cell(const FileView *view, const column_data_t *cdt,
@@ -368,25 +372,9 @@ get_line_color(const FileView *view, int pos)
 			{
 				return LINK_COLOR;
 			}
-			else
-			{
-				char full[PATH_MAX];
-				get_full_path_at(view, pos, sizeof(full), full);
-				if(get_link_target_abs(full, view->dir_entry[pos].origin, full,
-							sizeof(full)) != 0)
-				{
-					return BROKEN_LINK_COLOR;
-				}
-
-				/* Assume that targets on slow file system are not broken as actual
-				 * check might take long time. */
-				if(is_on_slow_fs(full))
-				{
-					return LINK_COLOR;
-				}
-
-				return path_exists(full, DEREF) ? LINK_COLOR : BROKEN_LINK_COLOR;
-			}
+			return (get_link_status(view, pos) == LS_BROKEN)
+			     ? BROKEN_LINK_COLOR
+			     : LINK_COLOR;
 #ifndef _WIN32
 		case FT_SOCK:
 			return SOCKET_COLOR;
@@ -402,6 +390,44 @@ get_line_color(const FileView *view, int pos)
 	}
 }
 
+/* Retrieves status of symbolic link target, which is normally determined on
+ * loading file list.  Otherwise it's queried and stored for future use.
+ * Returns the status. */
+static LinkStatus
+get_link_status(const FileView *view, int pos)
+{
+	dir_entry_t *const entry = &view->dir_entry[pos];
+	char full[PATH_MAX];
+	struct stat s;
+
+	if(entry->link_status != LS_UNKNOWN)
+	{
+		return entry->link_status;
+	}
+
+	get_full_path_at(view, pos, sizeof(full), full);
+	if(get_link_target_abs(full, entry->origin, full, sizeof(full)) != 0)
+	{
+		entry->link_status = LS_BROKEN;
+	}
+	/* Assume that targets on slow file system are not broken as actual check
+	 * might take long time. */
+	else if(is_on_slow_fs(full))
+	{
+		entry->link_status = LS_SLOW;
+	}
+	else if(os_stat(full, &s) != 0)
+	{
+		entry->link_status = LS_BROKEN;
+	}
+	else
+	{
+		entry->link_status = S_ISDIR(s.st_mode) ? LS_DIR : LS_FILE;
+	}
+
+	return entry->link_status;
+}
+
 /* Calculates width of the column using entry and maximum width. */
 static size_t
 calculate_print_width(const FileView *view, int i, size_t max_width)
@@ -20,14 +20,24 @@
 #include "quickview.h"
 
 #include <curses.h> /* mvwaddstr() wattrset() */
-#include <unistd.h> /* usleep() */
+#include <pthread.h> /* PTHREAD_* pthread_*() */
+#ifndef _WIN32
+#include <poll.h> /* poll() */
+#endif
+#include <sys/stat.h> /* stat */
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <unistd.h> /* read() usleep() */
 
+#include <errno.h> /* EINTR ETIMEDOUT errno */
 #include <limits.h> /* INT_MAX */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE SEEK_SET fclose() fdopen() feof() fseek()
-                      tmpfile() */
-#include <stdlib.h> /* free() qsort() */
-#include <string.h> /* memmove() strcat() strlen() strncat() */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE SEEK_SET fclose() fdopen() feof() fread() fseek()
+                      fwrite() rewind() tmpfile() */
+#include <stdlib.h> /* free() qsort() realloc() */
+#include <string.h> /* memchr() memmove() strcat() strcmp() strdup() strlen()
+                       strncat() */
+#include <time.h> /* time_t timespec */
 
 #include "../cfg/config.h"
 #include "../compat/fs_limits.h"
@@ -38,6 +48,7 @@
 #include "../modes/view.h"
 #include "../utils/file_streams.h"
 #include "../utils/fs.h"
+#include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
@@ -63,6 +74,54 @@
 /* Size of buffer holding preview line (in characters). */
 #define PREVIEW_LINE_BUF_LEN 4096
 
+/* Number of rendered previews kept in memory. */
+#define PREVIEW_CACHE_SIZE 32
+
+/* Maximum number of bytes of viewer output that is stored. */
+#define MAX_PREVIEW_SIZE (512*1024)
+
+/* How long to wait for viewer to finish before displaying a placeholder (in
+ * milliseconds).  Makes fast viewers appear synchronous. */
+#define PREVIEW_SYNC_WAIT_MS 30
+
+/* Identifies output of a viewer for a specific state of a file. */
+typedef struct
+{
+	char *path;    /* Path to the file. */
+	char *viewer;  /* Viewer command. */
+	time_t mtime;  /* Modification time of the file. */
+	uint64_t size; /* Size of the file. */
+	int width;     /* Width of the preview pane. */
+	int height;    /* Height of the preview pane. */
+}
+preview_key_t;
+
+/* Entry of preview cache. */
+typedef struct
+{
+	preview_key_t key; /* What's cached here. */
+	char *text;        /* Output of the viewer, NULL for unused entry. */
+	size_t len;        /* Length of the text. */
+	uint64_t used;     /* Time of last use for LRU eviction. */
+}
+preview_cache_entry_t;
+
+/* State of a viewer run in background.  Unless cancelled, the job is owned by
+ * the main thread once it's done.  Cancelled job is freed by the worker. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects done and cancelled fields. */
+	pthread_cond_t cond;  /* Signaled when the job is done. */
+	FILE *fp;             /* Output of the viewer (owned by the worker). */
+	int max_lines;        /* Maximum number of lines to read. */
+	preview_key_t key;    /* Key to cache result by. */
+	char *text;           /* Collected output. */
+	size_t len;           /* Length of the output. */
+	int done;             /* Whether worker is done. */
+	int cancelled;        /* Whether result is no longer needed. */
+}
+preview_job_t;
+
 /* State fo directory tree print functions. */
 typedef struct
 {
@@ -74,6 +133,23 @@ typedef struct
 tree_print_state_t;
 
 static void view_file(const char path[]);
+static FILE * view_with_viewer(const char path[], const char viewer[],
+		int *pending);
+static int make_preview_key(const char path[], const char viewer[],
+		preview_key_t *key);
+static void free_preview_key(preview_key_t *key);
+static int preview_keys_equal(const preview_key_t *a, const preview_key_t *b);
+static preview_cache_entry_t * cache_lookup(const preview_key_t *key);
+static void cache_put(preview_key_t *key, char *text, size_t len);
+static FILE * text_to_stream(const char text[], size_t len);
+static int start_preview_job(FILE *fp, preview_key_t *key);
+static int wait_preview_job(preview_job_t *job, int ms);
+static void finish_preview_job(preview_job_t *job);
+static void cancel_preview_job(void);
+static void free_preview_job(preview_job_t *job);
+static void * preview_job_thread(void *arg);
+static int wait_for_output(FILE *fp, preview_job_t *job);
+static size_t read_output(FILE *fp, char buf[], size_t len);
 static FILE * view_dir(const char path[], int max_lines);
 static int print_dir_tree(tree_print_state_t *s, const char path[], int last);
 static int enter_dir(tree_print_state_t *s, const char path[], int last);
@@ -94,6 +170,15 @@ static void cleanup_for_text(void);
 static char * get_viewer_command(const char viewer[]);
 static char * get_typed_fname(const char path[]);
 
+/* Recently rendered previews. */
+static preview_cache_entry_t preview_cache[PREVIEW_CACHE_SIZE];
+/* Counter used to track order of use of cache entries. */
+static uint64_t preview_cache_clock;
+/* Viewer that is currently running in background or NULL. */
+static preview_job_t *current_job;
+/* Whether preview pane displays placeholder for result of current_job. */
+static int waiting_for_job;
+
 void
 toggle_quick_view(void)
 {
@@ -138,6 +223,7 @@ quick_view_file(FileView *view)
 	}
 
 	ui_view_erase(other_view);
+	waiting_for_job = 0;
 
 	entry = &view->dir_entry[view->list_pos];
 	get_full_path_of(entry, sizeof(path), path);
@@ -211,6 +297,8 @@ view_file(const char path[])
 	}
 	else
 	{
+		int pending = 0;
+
 		graphics = is_graphics_viewer(viewer);
 		/* If graphics will be displayed, clear the window and wait a bit to let
 		 * terminal emulator do actual refresh (at least some of them need this). */
@@ -218,8 +306,20 @@ view_file(const char path[])
 		{
 			qv_cleanup(other_view, curr_stats.preview_cleanup);
 			usleep(50000);
+			fp = use_info_prog(viewer);
+		}
+		else
+		{
+			fp = view_with_viewer(path, viewer, &pending);
 		}
-		fp = use_info_prog(viewer);
+
+		if(pending)
+		{
+			write_message("Loading preview...");
+			waiting_for_job = 1;
+			return;
+		}
+
 		if(fp == NULL)
 		{
 			write_message("Cannot read viewer output");
@@ -243,6 +343,474 @@ view_file(const char path[])
 	fclose(fp);
 }
 
+/* Obtains output of text viewer for the file from cache or by running the
+ * viewer in background.  Sets *pending and returns NULL if output isn't ready
+ * yet.  Returns stream with the output or NULL on error. */
+static FILE *
+view_with_viewer(const char path[], const char viewer[], int *pending)
+{
+	preview_key_t key;
+	preview_cache_entry_t *entry;
+	FILE *fp;
+
+	*pending = 0;
+
+	if(make_preview_key(path, viewer, &key) != 0)
+	{
+		return use_info_prog(viewer);
+	}
+
+	entry = cache_lookup(&key);
+	if(entry != NULL)
+	{
+		free_preview_key(&key);
+		return text_to_stream(entry->text, entry->len);
+	}
+
+	if(current_job != NULL && preview_keys_equal(&current_job->key, &key))
+	{
+		/* Same preview is already being generated. */
+		free_preview_key(&key);
+		*pending = 1;
+		return NULL;
+	}
+
+	cancel_preview_job();
+
+	fp = use_info_prog(viewer);
+	if(fp == NULL)
+	{
+		free_preview_key(&key);
+		return NULL;
+	}
+
+	if(start_preview_job(fp, &key) != 0)
+	{
+		/* Fallback to synchronous preview. */
+		free_preview_key(&key);
+		return fp;
+	}
+
+	if(!wait_preview_job(current_job, PREVIEW_SYNC_WAIT_MS))
+	{
+		*pending = 1;
+		return NULL;
+	}
+
+	finish_preview_job(current_job);
+	current_job = NULL;
+
+	entry = cache_lookup(&key);
+	free_preview_key(&key);
+	return (entry == NULL) ? NULL : text_to_stream(entry->text, entry->len);
+}
+
+/* Fills key of the preview.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+make_preview_key(const char path[], const char viewer[], preview_key_t *key)
+{
+	struct stat st;
+	if(os_stat(path, &st) != 0)
+	{
+		return 1;
+	}
+
+	key->path = strdup(path);
+	key->viewer = strdup(viewer);
+	key->mtime = st.st_mtime;
+	key->size = st.st_size;
+	key->width = other_view->window_width;
+	key->height = other_view->window_rows;
+
+	if(key->path == NULL || key->viewer == NULL)
+	{
+		free_preview_key(key);
+		return 1;
+	}
+	return 0;
+}
+
+/* Frees resources of the key. */
+static void
+free_preview_key(preview_key_t *key)
+{
+	free(key->path);
+	free(key->viewer);
+	key->path = NULL;
+	key->viewer = NULL;
+}
+
+/* Compares two preview keys.  Returns non-zero if they are equal, otherwise
+ * zero is returned. */
+static int
+preview_keys_equal(const preview_key_t *a, const preview_key_t *b)
+{
+	return a->mtime == b->mtime
+	    && a->size == b->size
+	    && a->width == b->width
+	    && a->height == b->height
+	    && strcmp(a->path, b->path) == 0
+	    && strcmp(a->viewer, b->viewer) == 0;
+}
+
+/* Looks up preview in the cache and marks it as recently used.  Returns the
+ * entry or NULL if there is no such preview. */
+static preview_cache_entry_t *
+cache_lookup(const preview_key_t *key)
+{
+	int i;
+	for(i = 0; i < PREVIEW_CACHE_SIZE; ++i)
+	{
+		preview_cache_entry_t *const entry = &preview_cache[i];
+		if(entry->text != NULL && preview_keys_equal(&entry->key, key))
+		{
+			entry->used = ++preview_cache_clock;
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/* Puts preview into the cache evicting least recently used entry if necessary.
+ * Takes ownership of the text and key data. */
+static void
+cache_put(preview_key_t *key, char *text, size_t len)
+{
+	preview_cache_entry_t *victim = &preview_cache[0];
+	int i;
+
+	for(i = 0; i < PREVIEW_CACHE_SIZE; ++i)
+	{
+		preview_cache_entry_t *const entry = &preview_cache[i];
+		if(entry->text == NULL)
+		{
+			victim = entry;
+			break;
+		}
+		if(entry->used < victim->used)
+		{
+			victim = entry;
+		}
+	}
+
+	free_preview_key(&victim->key);
+	free(victim->text);
+
+	victim->key = *key;
+	victim->text = text;
+	victim->len = len;
+	victim->used = ++preview_cache_clock;
+
+	key->path = NULL;
+	key->viewer = NULL;
+}
+
+/* Makes stream out of text.  Returns the stream or NULL on error. */
+static FILE *
+text_to_stream(const char text[], size_t len)
+{
+	FILE *const fp = os_tmpfile();
+	if(fp == NULL)
+	{
+		return NULL;
+	}
+
+	if(fwrite(text, 1, len, fp) != len)
+	{
+		fclose(fp);
+		return NULL;
+	}
+
+	rewind(fp);
+	return fp;
+}
+
+/* Starts reading output of a viewer in background as current_job.  Takes
+ * ownership of the fp and key data on success.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+start_preview_job(FILE *fp, preview_key_t *key)
+{
+	pthread_t id;
+	pthread_attr_t attr;
+	preview_job_t *const job = calloc(1, sizeof(*job));
+
+	if(job == NULL)
+	{
+		return 1;
+	}
+
+	if(pthread_mutex_init(&job->lock, NULL) != 0)
+	{
+		free(job);
+		return 1;
+	}
+	if(pthread_cond_init(&job->cond, NULL) != 0)
+	{
+		pthread_mutex_destroy(&job->lock);
+		free(job);
+		return 1;
+	}
+
+	job->fp = fp;
+	job->max_lines = key->height;
+	job->key = *key;
+
+	if(pthread_attr_init(&attr) != 0)
+	{
+		free_preview_job(job);
+		return 1;
+	}
+	(void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	if(pthread_create(&id, &attr, &preview_job_thread, job) != 0)
+	{
+		(void)pthread_attr_destroy(&attr);
+		free_preview_job(job);
+		return 1;
+	}
+	(void)pthread_attr_destroy(&attr);
+
+	key->path = NULL;
+	key->viewer = NULL;
+	current_job = job;
+	return 0;
+}
+
+/* Waits for the job to be done for at most ms milliseconds.  Returns non-zero
+ * if it's done, otherwise zero is returned. */
+static int
+wait_preview_job(preview_job_t *job, int ms)
+{
+	struct timeval now;
+	struct timespec deadline;
+	int done;
+
+	(void)gettimeofday(&now, NULL);
+	deadline.tv_sec = now.tv_sec + ms/1000;
+	deadline.tv_nsec = now.tv_usec*1000L + (ms%1000)*1000000L;
+	if(deadline.tv_nsec >= 1000000000L)
+	{
+		++deadline.tv_sec;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&job->lock);
+	while(!job->done)
+	{
+		if(pthread_cond_timedwait(&job->cond, &job->lock, &deadline) == ETIMEDOUT)
+		{
+			break;
+		}
+	}
+	done = job->done;
+	pthread_mutex_unlock(&job->lock);
+
+	return done;
+}
+
+/* Moves result of the job that is done into the cache and frees the job. */
+static void
+finish_preview_job(preview_job_t *job)
+{
+	cache_put(&job->key, job->text, job->len);
+	job->text = NULL;
+	free_preview_job(job);
+}
+
+/* Abandons current background job if there is one. */
+static void
+cancel_preview_job(void)
+{
+	preview_job_t *const job = current_job;
+	int done;
+
+	if(job == NULL)
+	{
+		return;
+	}
+	current_job = NULL;
+
+	pthread_mutex_lock(&job->lock);
+	done = job->done;
+	job->cancelled = 1;
+	pthread_mutex_unlock(&job->lock);
+
+	/* Worker frees job that is cancelled before being done. */
+	if(done)
+	{
+		free_preview_job(job);
+	}
+}
+
+/* Frees the job along with all its data. */
+static void
+free_preview_job(preview_job_t *job)
+{
+	if(job->fp != NULL)
+	{
+		fclose(job->fp);
+	}
+	free_preview_key(&job->key);
+	free(job->text);
+	pthread_cond_destroy(&job->cond);
+	pthread_mutex_destroy(&job->lock);
+	free(job);
+}
+
+/* Entry point of thread that collects output of a viewer.  Returns NULL. */
+static void *
+preview_job_thread(void *arg)
+{
+	preview_job_t *const job = arg;
+	int lines = 0;
+	int cancelled;
+
+	while(lines < job->max_lines && job->len < MAX_PREVIEW_SIZE)
+	{
+		char buf[4096];
+		const char *p;
+		size_t n;
+		char *text;
+
+		if(!wait_for_output(job->fp, job))
+		{
+			break;
+		}
+
+		n = read_output(job->fp, buf, MIN(sizeof(buf), MAX_PREVIEW_SIZE - job->len));
+		if(n == 0U)
+		{
+			break;
+		}
+
+		text = realloc(job->text, job->len + n + 1);
+		if(text == NULL)
+		{
+			break;
+		}
+		job->text = text;
+		memcpy(job->text + job->len, buf, n);
+		job->len += n;
+		job->text[job->len] = '\0';
+
+		for(p = buf; (p = memchr(p, '\n', buf + n - p)) != NULL; ++p)
+		{
+			++lines;
+		}
+	}
+
+	/* Closing the pipe early makes viewer terminate on next write. */
+	fclose(job->fp);
+	job->fp = NULL;
+
+	if(job->text == NULL)
+	{
+		job->text = strdup("");
+	}
+
+	pthread_mutex_lock(&job->lock);
+	cancelled = job->cancelled;
+	job->done = 1;
+	pthread_cond_signal(&job->cond);
+	pthread_mutex_unlock(&job->lock);
+
+	if(cancelled)
+	{
+		free_preview_job(job);
+	}
+	return NULL;
+}
+
+/* Waits for more output of the viewer checking for cancellation of the job
+ * once in a while.  Returns non-zero if there is something to read, otherwise
+ * zero is returned. */
+static int
+wait_for_output(FILE *fp, preview_job_t *job)
+{
+#ifndef _WIN32
+	struct pollfd pfd = { .fd = fileno(fp), .events = POLLIN };
+	while(1)
+	{
+		int cancelled;
+		int result;
+
+		pthread_mutex_lock(&job->lock);
+		cancelled = job->cancelled;
+		pthread_mutex_unlock(&job->lock);
+		if(cancelled)
+		{
+			return 0;
+		}
+
+		result = poll(&pfd, 1, 100);
+		if(result > 0 || (result < 0 && errno != EINTR))
+		{
+			return 1;
+		}
+	}
+#else
+	int cancelled;
+	pthread_mutex_lock(&job->lock);
+	cancelled = job->cancelled;
+	pthread_mutex_unlock(&job->lock);
+	return !cancelled;
+#endif
+}
+
+/* Reads whatever output of the viewer is available without waiting for the
+ * buffer to be filled.  Returns number of read bytes, zero on end of file or
+ * error. */
+static size_t
+read_output(FILE *fp, char buf[], size_t len)
+{
+#ifndef _WIN32
+	ssize_t n;
+	do
+	{
+		n = read(fileno(fp), buf, len);
+	}
+	while(n < 0 && errno == EINTR);
+	return (n < 0) ? 0U : (size_t)n;
+#else
+	return fread(buf, 1, len, fp);
+#endif
+}
+
+void
+qv_check_for_updates(void)
+{
+	int done;
+
+	if(current_job == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&current_job->lock);
+	done = current_job->done;
+	pthread_mutex_unlock(&current_job->lock);
+	if(!done)
+	{
+		return;
+	}
+
+	finish_preview_job(current_job);
+	current_job = NULL;
+
+	if(waiting_for_job && curr_stats.view)
+	{
+		quick_view_file(curr_view);
+	}
+}
+
+int
+qv_is_loading(void)
+{
+	return current_job != NULL;
+}
+
 FILE *
 qv_view_dir(const char path[])
 {
@@ -45,6 +45,15 @@ const char * qv_get_viewer(const char path[]);
  * Returns the stream or NULL on error. */
 FILE * qv_view_dir(const char path[]);
 
+/* Picks up output of a viewer that was running in background and redraws
+ * preview pane if it waits for that output. */
+void qv_check_for_updates(void);
+
+/* Checks whether output of a viewer is still being read in background, which
+ * requires calling qv_check_for_updates() periodically.  Returns non-zero if
+ * so, otherwise zero is returned. */
+int qv_is_loading(void);
+
 #endif /* VIFM__UI__QUICKVIEW_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -32,6 +32,7 @@
 #include "../compat/fs_limits.h"
 #include "../utils/filter.h"
 #include "../utils/fswatch.h"
+#include "../utils/string_pool.h"
 #include "../utils/trie.h"
 #include "../status.h"
 #include "../types.h"
@@ -132,10 +133,26 @@ typedef struct
 }
 history_t;
 
+/* Cached status of target of a symbolic link. */
+typedef enum
+{
+	LS_UNKNOWN, /* Status hasn't been determined yet. */
+	LS_BROKEN,  /* Target doesn't exist. */
+	LS_FILE,    /* Target exists and isn't a directory. */
+	LS_DIR,     /* Target is a directory. */
+	LS_SLOW,    /* Target is on slow file system and wasn't examined. */
+}
+LinkStatus;
+
 typedef struct
 {
+	/* Name of the file.  Allocated in string pool of the view if name_pooled is
+	 * set, otherwise on heap. */
 	char *name;
-	char *origin;     /* Location where this file comes from. */
+	/* Location where this file comes from.  Either points to curr_dir of the
+	 * view, is interned in its string pool if origin_pooled is set or is
+	 * allocated on heap. */
+	char *origin;
 	uint64_t size;
 #ifndef _WIN32
 	uid_t uid;
@@ -149,21 +166,36 @@ typedef struct
 	time_t ctime;
 	FileType type;
 
-	int selected;
-	int was_selected; /* Stores previous selection state in Visual mode. */
+	int list_num;     /* Used by sorting comparer to perform stable sort. */
+
+	int hi_num;       /* File highlighting parameters cache (initially -1). */
 
-	int search_match;      /* Whether the item matches last search. */
 	short int match_left;  /* Starting position of the match. */
 	short int match_right; /* Ending position of the match. */
 
-	int list_num;     /* Used by sorting comparer to perform stable sort. */
-
-	int marked;       /* Whether file should be processed. */
-
-	int hi_num;       /* File highlighting parameters cache (initially -1). */
+	/* Status of target for symbolic links, which saves querying file system on
+	 * every redraw. */
+	LinkStatus link_status;
+
+	/* Flags are packed to keep entries of large lists small. */
+	unsigned int search_match : 27; /* Number of the match of last search. */
+	unsigned int selected : 1;
+	unsigned int was_selected : 1;  /* Previous selection state in Visual mode. */
+	unsigned int marked : 1;        /* Whether file should be processed. */
+	unsigned int name_pooled : 1;   /* Whether name is in string pool. */
+	unsigned int origin_pooled : 1; /* Whether origin is in string pool. */
 }
 dir_entry_t;
 
+/* Directory of custom view entries. */
+typedef struct
+{
+	char *path;      /* Path to the directory. */
+	time_t mtime;    /* Modification time of the directory. */
+	int entry_count; /* Number of entries from the directory. */
+}
+cv_dir_t;
+
 typedef struct
 {
 	WINDOW *win;
@@ -193,6 +225,12 @@ typedef struct
 		/* Names of files in custom view while it's being composed.  Used for
 		 * duplicate elimination. */
 		trie_t paths_cache;
+
+		/* Directories of entries along with their modification times at the
+		 * moment of the last check sorted by path.  Used by 'cvquickreload'. */
+		cv_dir_t *dirs;
+		/* Number of elements in the dirs array. */
+		int dir_count;
 	}
 	custom;
 
@@ -200,6 +238,25 @@ typedef struct
 	fswatch_t *watch;
 	char watched_dir[PATH_MAX];
 
+	/* Changes reported by the monitor, which can be applied to the list of files
+	 * on the next reload instead of re-reading whole directory. */
+	struct
+	{
+		/* Names of changed entries. */
+		char **names;
+		/* Whether corresponding entry existed before the first change to it. */
+		char *existed;
+		/* Number of elements in the arrays above. */
+		int count;
+		/* Set of names for duplicate elimination. */
+		trie_t set;
+		/* Value of postponed_reload at the moment of the last change. */
+		uint64_t stamp;
+		/* Whether some changes couldn't be tracked per entry. */
+		int overflow;
+	}
+	watch_changes;
+
 	char last_dir[PATH_MAX];
 
 	/* Number of files that match current search pattern. */
@@ -221,6 +278,21 @@ typedef struct
 	int local_cs; /* Whether directory-specific color scheme is in use. */
 	dir_entry_t *dir_entry;
 
+	/* Storage for names and origins of entries of all lists of the view, created
+	 * on first use. */
+	strpool_t *strings;
+
+	/* Open-addressing hash index of dir_entry by file names, which is rebuilt on
+	 * the next lookup after it gets invalidated.  See flist_find_entry(). */
+	struct
+	{
+		struct name_slot_t *slots;  /* Slots of the table or NULL. */
+		int size;                   /* Number of slots, a power of two. */
+		const dir_entry_t *entries; /* Value of dir_entry at build time. */
+		int count;                  /* Value of list_rows at build time. */
+	}
+	name_index;
+
 	int nsaved_selection;   /* Number of items in saved_selection. */
 	char **saved_selection; /* Names of selected files. */
 
@@ -261,6 +333,15 @@ typedef struct
 		size_t unfiltered_count;
 		/* Number of entries filtered in other ways. */
 		size_t prefiltered_count;
+		/* Whether unfiltered entries are directories (computed once). */
+		char *is_dir;
+		/* Ascending indexes of unfiltered entries that match the filter (doesn't
+		 * include parent directory entry) or NULL if not computed yet. */
+		int *matches;
+		/* Number of elements in the matches array. */
+		size_t match_count;
+		/* Index of parent directory entry in unfiltered list or -1. */
+		int parent_pos;
 
 		/* List of previous cursor positions in the unfiltered array. */
 		int *poshist;
@@ -20,12 +20,16 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* size_t */
-#include <stdio.h>
-#include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strcpy() strdup() */
+#include <stdio.h> /* FILE fclose() fflush() fprintf() fputc() fputs() remove()
+                      snprintf() sprintf() */
+#include <stdlib.h> /* free() malloc() strtol() strtoull() */
+#include <string.h> /* memcpy() memset() strcmp() strcpy() strdup() strlen()
+                       strncmp() strrchr() */
 
 #include "compat/fs_limits.h"
+#include "compat/os.h"
 #include "compat/reallocarray.h"
+#include "utils/file_streams.h"
 #include "utils/fs.h"
 #include "utils/macros.h"
 #include "utils/path.h"
@@ -35,6 +39,22 @@
 #include "registers.h"
 #include "trash.h"
 
+/* Minimal size of a block of memory for strings of a group. */
+#define STR_BLOCK_SIZE 4096
+
+/* Number of commands allocated at once. */
+#define CMDS_PER_CHUNK 256
+
+/* Block of memory from which paths of a group are allocated. */
+typedef struct str_block_t
+{
+	struct str_block_t *next; /* Previously allocated block. */
+	size_t used;              /* Number of bytes in use. */
+	size_t size;              /* Size of the data array. */
+	char data[];              /* Storage for strings. */
+}
+str_block_t;
+
 typedef struct
 {
 	char *msg;
@@ -42,24 +62,30 @@ typedef struct
 	int balance;
 	int can_undone;
 	int incomplete;
+
+	str_block_t *strings; /* Storage of paths of commands of the group. */
+	const char *dirs[2];  /* Last interned directory of each operand. */
 }
 group_t;
 
 typedef struct
 {
 	OPS op;
-	const char *src;        /* NULL, buf1 or buf2 */
-	const char *dst;        /* NULL, buf1 or buf2 */
-	void *data;             /* for uid_t, gid_t and mode_t */
-	const char *exists;     /* NULL, buf1 or buf2 */
-	const char *dont_exist; /* NULL, buf1 or buf2 */
+	void *data; /* for uid_t, gid_t and mode_t */
 }
 op_t;
 
+/* Path split into interned directory and the rest of it. */
+typedef struct
+{
+	const char *dir;  /* Directory part with trailing slash or empty string. */
+	const char *name; /* Name part. */
+}
+path_t;
+
 typedef struct cmd_t
 {
-	char *buf1;
-	char *buf2;
+	path_t paths[2]; /* Two operands of operations (buf1 and buf2). */
 	op_t do_op;
 	op_t undo_op;
 
@@ -69,6 +95,23 @@ typedef struct cmd_t
 }
 cmd_t;
 
+/* Chunk of memory commands are allocated from. */
+typedef struct cmd_chunk_t
+{
+	struct cmd_chunk_t *next;    /* Previously allocated chunk. */
+	cmd_t cmds[CMDS_PER_CHUNK];  /* Storage for commands. */
+}
+cmd_chunk_t;
+
+/* Operands of an operation, indexes into rows of the opers table. */
+enum
+{
+	OPND_SRC,    /* Source path. */
+	OPND_DST,    /* Destination path. */
+	OPND_EXISTS, /* Path that must exist. */
+	OPND_ABSENT, /* Path that must not exist. */
+};
+
 static OPS undo_op[] = {
 	OP_NONE,     /* OP_NONE */
 	OP_NONE,     /* OP_USR */
@@ -218,18 +261,53 @@ static char *group_msg;
 
 static int command_count;
 
+/* Chunks of memory for commands and list of unused commands. */
+static cmd_chunk_t *cmd_chunks;
+static cmd_t *free_cmds;
+
+/* Journal of changes of the list, NULL when it's not maintained. */
+static FILE *journal;
+/* Path to the journal file. */
+static char *journal_path;
+/* Number of records appended to the journal since it was last rewritten. */
+static int journal_records;
+
 static int no_function(void);
-static void init_cmd(cmd_t *cmd, OPS op, void *do_data, void *undo_data);
-static void init_entry(cmd_t *cmd, const char **e, int type);
+static int init_cmd(cmd_t *cmd, OPS op, void *do_data, void *undo_data,
+		const char buf1[], const char buf2[]);
+static int set_path(group_t *group, path_t *path, int slot, const char full[]);
+static const char * intern_str(group_t *group, const char str[], size_t len);
+static cmd_t * alloc_cmd(void);
+static void free_cmd(cmd_t *cmd);
+static void free_cmd_chunks(void);
+static group_t * alloc_group(const char msg[]);
+static void free_group(group_t *group);
 static void remove_cmd(cmd_t *cmd);
+static void free_op_data(OPS op, void *do_data, void *undo_data);
+static const char * get_operand(const cmd_t *cmd, int undo, int operand,
+		char buf[]);
 static int is_undo_group_possible(void);
 static int is_redo_group_possible(void);
-static int is_op_possible(const op_t *op);
-static void change_filename_in_trash(cmd_t *cmd, const char *filename);
-static void update_entry(const char **e, const char old[], const char new[]);
+static int is_op_possible(cmd_t *cmd, int undo);
+static void change_filename_in_trash(cmd_t *cmd, const char filename[]);
 static char ** fill_undolist_detail(char **list);
-static const char * get_op_desc(op_t op);
+static const char * get_op_desc(const cmd_t *cmd, int undo);
 static char **fill_undolist_nondetail(char **list);
+static void load_journal(const char path[]);
+static void load_journal_cmd(char *fields[], int *new_group, int balance,
+		int error);
+static void * parse_op_data(OPS op, const char field[]);
+static void set_current_pos(int pos);
+static int count_cmds_after(const cmd_t *cmd);
+static cmd_t * cmd_from_end(int count);
+static int split_record(char line[], char *fields[], int max_fields);
+static void append_state_records(const cmd_t *group_cmd);
+static void flush_journal(void);
+static void rewrite_journal(void);
+static void write_group_record(FILE *fp, const group_t *group);
+static void write_cmd_record(FILE *fp, const cmd_t *cmd);
+static void write_op_data(FILE *fp, OPS op, const void *data);
+static void write_field(FILE *fp, const char str[]);
 
 void
 init_undo_list(perform_func exec_func, op_available_func op_avail,
@@ -262,6 +340,10 @@ reset_undo_list(void)
 	current = &cmds;
 	next_group = 0;
 	last_group = NULL;
+
+	free_cmd_chunks();
+
+	rewrite_journal();
 }
 
 void
@@ -295,6 +377,14 @@ replace_group_msg(const char msg[])
 	if(last_group != NULL && group_msg != NULL)
 	{
 		(void)replace_string(&last_group->msg, group_msg);
+
+		if(journal != NULL)
+		{
+			fputc('m', journal);
+			write_field(journal, group_msg);
+			fputc('\n', journal);
+			++journal_records;
+		}
 	}
 	return result;
 }
@@ -303,8 +393,8 @@ int
 add_operation(OPS op, void *do_data, void *undo_data, const char *buf1,
 		const char *buf2)
 {
-	int mem_error;
 	cmd_t *cmd;
+	group_t *group;
 
 	assert(group_opened);
 	assert(buf1 != NULL);
@@ -319,51 +409,48 @@ add_operation(OPS op, void *do_data, void *undo_data, const char *buf1,
 
 	if(*undo_levels <= 0)
 	{
-		if(data_is_ptr[op])
-		{
-			free(do_data);
-		}
-		if(data_is_ptr[undo_op[op]])
-		{
-			free(undo_data);
-		}
+		free_op_data(op, do_data, undo_data);
 		return 0;
 	}
 
-	command_count++;
-
-	/* add operation to the list */
-	cmd = calloc(1, sizeof(*cmd));
-	if(cmd == NULL)
-		return -1;
-
-	cmd->buf1 = strdup(buf1);
-	cmd->buf2 = strdup(buf2);
-	cmd->prev = current;
-	init_cmd(cmd, op, do_data, undo_data);
-	if(last_group != NULL)
+	group = (last_group != NULL) ? last_group : alloc_group(group_msg);
+	cmd = alloc_cmd();
+	if(group == NULL || cmd == NULL)
 	{
-		cmd->group = last_group;
+		if(group != last_group)
+			free_group(group);
+		if(cmd != NULL)
+			free_cmd(cmd);
+		free_op_data(op, do_data, undo_data);
+		return -1;
 	}
-	else if((cmd->group = malloc(sizeof(group_t))) != NULL)
+
+	cmd->group = group;
+	if(init_cmd(cmd, op, do_data, undo_data, buf1, buf2) != 0)
 	{
-		cmd->group->msg = strdup(group_msg);
-		cmd->group->error = 0;
-		cmd->group->balance = 0;
-		cmd->group->can_undone = 1;
-		cmd->group->incomplete = 0;
+		/* Strings that were already allocated are freed with the group. */
+		if(group != last_group)
+			free_group(group);
+		free_cmd(cmd);
+		free_op_data(op, do_data, undo_data);
+		return -1;
 	}
-	mem_error = cmd->group == NULL || cmd->buf1 == NULL || cmd->buf2 == NULL;
-	if(mem_error)
+
+	if(journal != NULL)
 	{
-		remove_cmd(cmd);
-		return -1;
+		if(group != last_group)
+			write_group_record(journal, group);
+		write_cmd_record(journal, cmd);
+		journal_records += 2;
 	}
-	last_group = cmd->group;
+
+	last_group = group;
+	command_count++;
 
 	if(undo_op[op] == OP_NONE)
 		cmd->group->can_undone = 0;
 
+	cmd->prev = current;
 	current->next = cmd;
 	current = cmd;
 	cmds.prev = cmd;
@@ -371,32 +458,183 @@ add_operation(OPS op, void *do_data, void *undo_data, const char *buf1,
 	return 0;
 }
 
-static void
-init_cmd(cmd_t *cmd, OPS op, void *do_data, void *undo_data)
+/* Fills command with operations and their operands.  Returns zero on success
+ * and non-zero on memory allocation error. */
+static int
+init_cmd(cmd_t *cmd, OPS op, void *do_data, void *undo_data, const char buf1[],
+		const char buf2[])
 {
 	cmd->do_op.op = op;
 	cmd->do_op.data = do_data;
 	cmd->undo_op.op = undo_op[op];
 	cmd->undo_op.data = undo_data;
-	init_entry(cmd, &cmd->do_op.src, opers[op][0]);
-	init_entry(cmd, &cmd->do_op.dst, opers[op][1]);
-	init_entry(cmd, &cmd->do_op.exists, opers[op][2]);
-	init_entry(cmd, &cmd->do_op.dont_exist, opers[op][3]);
-	init_entry(cmd, &cmd->undo_op.src, opers[op][4]);
-	init_entry(cmd, &cmd->undo_op.dst, opers[op][5]);
-	init_entry(cmd, &cmd->undo_op.exists, opers[op][6]);
-	init_entry(cmd, &cmd->undo_op.dont_exist, opers[op][7]);
+
+	return set_path(cmd->group, &cmd->paths[0], 0, buf1)
+	    || set_path(cmd->group, &cmd->paths[1], 1, buf2);
 }
 
+/* Stores path in memory of the group reusing directory part of previous path
+ * stored in the same slot if possible.  Returns zero on success and non-zero
+ * on memory allocation error. */
+static int
+set_path(group_t *group, path_t *path, int slot, const char full[])
+{
+	const char *const slash = strrchr(full, '/');
+	const char *const name = (slash == NULL) ? full : slash + 1;
+	const size_t dir_len = name - full;
+	const char *dir = group->dirs[slot];
+	const char *name_copy;
+
+	if(dir == NULL || strncmp(dir, full, dir_len) != 0 || dir[dir_len] != '\0')
+	{
+		dir = intern_str(group, full, dir_len);
+		if(dir == NULL)
+		{
+			return 1;
+		}
+		group->dirs[slot] = dir;
+	}
+
+	name_copy = intern_str(group, name, strlen(name));
+	if(name_copy == NULL)
+	{
+		return 1;
+	}
+
+	path->dir = dir;
+	path->name = name_copy;
+	return 0;
+}
+
+/* Copies first len characters of the str into memory of the group.  Returns
+ * the copy or NULL on memory allocation error. */
+static const char *
+intern_str(group_t *group, const char str[], size_t len)
+{
+	str_block_t *block = group->strings;
+	char *copy;
+
+	if(block == NULL || block->size - block->used < len + 1U)
+	{
+		const size_t size = MAX(STR_BLOCK_SIZE, len + 1U);
+		block = malloc(sizeof(*block) + size);
+		if(block == NULL)
+		{
+			return NULL;
+		}
+		block->next = group->strings;
+		block->used = 0U;
+		block->size = size;
+		group->strings = block;
+	}
+
+	copy = &block->data[block->used];
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+	block->used += len + 1U;
+	return copy;
+}
+
+/* Takes command from the pool allocating more memory if needed.  Returns the
+ * command with all fields zeroed or NULL on memory allocation error. */
+static cmd_t *
+alloc_cmd(void)
+{
+	cmd_t *cmd;
+
+	if(free_cmds == NULL)
+	{
+		int i;
+		cmd_chunk_t *const chunk = malloc(sizeof(*chunk));
+		if(chunk == NULL)
+		{
+			return NULL;
+		}
+
+		chunk->next = cmd_chunks;
+		cmd_chunks = chunk;
+
+		for(i = 0; i < CMDS_PER_CHUNK; ++i)
+		{
+			chunk->cmds[i].next = free_cmds;
+			free_cmds = &chunk->cmds[i];
+		}
+	}
+
+	cmd = free_cmds;
+	free_cmds = cmd->next;
+	memset(cmd, 0, sizeof(*cmd));
+	return cmd;
+}
+
+/* Returns command to the pool. */
 static void
-init_entry(cmd_t *cmd, const char **e, int type)
+free_cmd(cmd_t *cmd)
 {
-	if(type == OPER_NON)
-		*e = NULL;
-	else if(type == OPER_1ST)
-		*e = cmd->buf1;
-	else
-		*e = cmd->buf2;
+	cmd->next = free_cmds;
+	free_cmds = cmd;
+}
+
+/* Frees memory of commands, when none of them is in use. */
+static void
+free_cmd_chunks(void)
+{
+	if(command_count != 0)
+	{
+		return;
+	}
+
+	while(cmd_chunks != NULL)
+	{
+		cmd_chunk_t *const next = cmd_chunks->next;
+		free(cmd_chunks);
+		cmd_chunks = next;
+	}
+	free_cmds = NULL;
+}
+
+/* Allocates new group with the message.  Returns the group or NULL on memory
+ * allocation error. */
+static group_t *
+alloc_group(const char msg[])
+{
+	group_t *const group = malloc(sizeof(*group));
+	if(group == NULL)
+	{
+		return NULL;
+	}
+
+	group->msg = strdup(msg);
+	if(group->msg == NULL)
+	{
+		free(group);
+		return NULL;
+	}
+
+	group->error = 0;
+	group->balance = 0;
+	group->can_undone = 1;
+	group->incomplete = 0;
+	group->strings = NULL;
+	group->dirs[0] = NULL;
+	group->dirs[1] = NULL;
+	return group;
+}
+
+/* Frees group along with all paths of its commands. */
+static void
+free_group(group_t *group)
+{
+	str_block_t *block = group->strings;
+	while(block != NULL)
+	{
+		str_block_t *const next = block->next;
+		free(block);
+		block = next;
+	}
+
+	free(group->msg);
+	free(group);
 }
 
 static void
@@ -426,27 +664,50 @@ remove_cmd(cmd_t *cmd)
 
 	if(last_cmd_in_group)
 	{
-		free(cmd->group->msg);
-		free(cmd->group);
 		if(last_group == cmd->group)
 			last_group = NULL;
+		free_group(cmd->group);
 	}
 	else
 	{
 		cmd->group->incomplete = 1;
 	}
-	free(cmd->buf1);
-	free(cmd->buf2);
-	if(data_is_ptr[cmd->do_op.op])
-		free(cmd->do_op.data);
-	if(data_is_ptr[cmd->undo_op.op])
-		free(cmd->undo_op.data);
+	free_op_data(cmd->do_op.op, cmd->do_op.data, cmd->undo_op.data);
 
-	free(cmd);
+	free_cmd(cmd);
 
 	command_count--;
 }
 
+/* Frees data of operations if it's a pointer. */
+static void
+free_op_data(OPS op, void *do_data, void *undo_data)
+{
+	if(data_is_ptr[op])
+		free(do_data);
+	if(data_is_ptr[undo_op[op]])
+		free(undo_data);
+}
+
+/* Composes path for an operand (OPND_*) of either do or undo operation of the
+ * command.  The buf should be at least PATH_MAX characters long.  Returns NULL
+ * if the operation has no such operand, otherwise buf is returned. */
+static const char *
+get_operand(const cmd_t *cmd, int undo, int operand, char buf[])
+{
+	const int type = opers[cmd->do_op.op][(undo ? 4 : 0) + operand];
+	const path_t *path;
+
+	if(type == OPER_NON)
+	{
+		return NULL;
+	}
+
+	path = &cmd->paths[(type == OPER_1ST) ? 0 : 1];
+	snprintf(buf, PATH_MAX, "%s%s", path->dir, path->name);
+	return buf;
+}
+
 int
 last_cmd_group_empty(void)
 {
@@ -463,6 +724,8 @@ cmd_group_end(void)
 
 	while(cmds.next != NULL && cmds.next->group->incomplete)
 		remove_cmd(cmds.next);
+
+	flush_journal();
 }
 
 int
@@ -471,11 +734,14 @@ undo_group(void)
 	int errors, disbalance, cant_undone;
 	int skip;
 	int cancelled;
+	cmd_t *group_cmd;
 	assert(!group_opened);
 
 	if(current == &cmds)
 		return -1;
 
+	group_cmd = current;
+
 	errors = current->group->error != 0;
 	disbalance = current->group->balance != 0;
 	cant_undone = !current->group->can_undone;
@@ -484,6 +750,7 @@ undo_group(void)
 		do
 			current = current->prev;
 		while(current != &cmds && current->group == current->next->group);
+		append_state_records(group_cmd);
 		if(errors)
 			return 1;
 		else if(disbalance)
@@ -501,8 +768,10 @@ undo_group(void)
 	{
 		if(!skip)
 		{
+			char src[PATH_MAX], dst[PATH_MAX];
 			int err = do_func(current->undo_op.op, current->undo_op.data,
-					current->undo_op.src, current->undo_op.dst);
+					get_operand(current, 1, OPND_SRC, src),
+					get_operand(current, 1, OPND_DST, dst));
 			if(err == SKIP_UNDO_REDO_OPERATION)
 			{
 				skip = 1;
@@ -519,6 +788,8 @@ undo_group(void)
 	while(!(cancelled = cancel_func()) && current != &cmds &&
 			current->group == current->next->group);
 
+	append_state_records(group_cmd);
+
 	if(cancelled)
 	{
 		return -7;
@@ -539,12 +810,8 @@ is_undo_group_possible(void)
 	cmd_t *cmd = current;
 	do
 	{
-		int ret;
-		ret = is_op_possible(&cmd->undo_op);
-		if(ret == 0)
+		if(is_op_possible(cmd, 1) == 0)
 			return 0;
-		else if(ret < 0)
-			change_filename_in_trash(cmd, cmd->undo_op.dst);
 		cmd = cmd->prev;
 	}
 	while(cmd != &cmds && cmd->group == cmd->next->group);
@@ -557,11 +824,14 @@ redo_group(void)
 	int errors, disbalance;
 	int skip;
 	int cancelled;
+	cmd_t *group_cmd;
 	assert(!group_opened);
 
 	if(current->next == NULL)
 		return -1;
 
+	group_cmd = current->next;
+
 	errors = current->next->group->error != 0;
 	disbalance = current->next->group->balance == 0;
 	if(errors || disbalance || !is_redo_group_possible())
@@ -569,6 +839,7 @@ redo_group(void)
 		do
 			current = current->next;
 		while(current->next != NULL && current->group == current->next->group);
+		append_state_records(group_cmd);
 		if(errors)
 			return 1;
 		else if(disbalance)
@@ -585,8 +856,10 @@ redo_group(void)
 		current = current->next;
 		if(!skip)
 		{
+			char src[PATH_MAX], dst[PATH_MAX];
 			int err = do_func(current->do_op.op, current->do_op.data,
-					current->do_op.src, current->do_op.dst);
+					get_operand(current, 0, OPND_SRC, src),
+					get_operand(current, 0, OPND_DST, dst));
 			if(err == SKIP_UNDO_REDO_OPERATION)
 			{
 				current->next->group->balance--;
@@ -602,6 +875,8 @@ redo_group(void)
 	while(!(cancelled = cancel_func()) && current->next != NULL &&
 			current->group == current->next->group);
 
+	append_state_records(group_cmd);
+
 	if(cancelled)
 	{
 		return -7;
@@ -622,27 +897,24 @@ is_redo_group_possible(void)
 	cmd_t *cmd = current;
 	do
 	{
-		int ret;
 		cmd = cmd->next;
-		ret = is_op_possible(&cmd->do_op);
-		if(ret == 0)
+		if(is_op_possible(cmd, 0) == 0)
 			return 0;
-		else if(ret < 0)
-			change_filename_in_trash(cmd, cmd->do_op.dst);
 	}
 	while(cmd->next != NULL && cmd->group == cmd->next->group);
 	return 1;
 }
 
-/*
- * Return value:
- *   0 - impossible
- * < 0 - possible with renaming file in trash
- * > 0 - possible
- */
+/* Checks whether do or undo operation of the command can be performed and
+ * renames its destination in trash if that's necessary.  Returns zero if
+ * operation is impossible, otherwise non-zero is returned. */
 static int
-is_op_possible(const op_t *op)
+is_op_possible(cmd_t *cmd, int undo)
 {
+	const op_t *const op = undo ? &cmd->undo_op : &cmd->do_op;
+	char src[PATH_MAX], dst[PATH_MAX], path[PATH_MAX];
+	const char *exists, *dont_exist;
+
 	if(op_avail_func != NULL)
 	{
 		const int avail = op_avail_func(op->op);
@@ -652,24 +924,33 @@ is_op_possible(const op_t *op)
 		}
 	}
 
-	if(op->exists != NULL && !path_exists(op->exists, NODEREF))
+	exists = get_operand(cmd, undo, OPND_EXISTS, path);
+	if(exists != NULL && !path_exists(exists, NODEREF))
 	{
 		return 0;
 	}
-	if(op->dont_exist != NULL && path_exists(op->dont_exist, NODEREF) &&
-			!is_case_change(op->src, op->dst))
+
+	dont_exist = get_operand(cmd, undo, OPND_ABSENT, path);
+	if(dont_exist != NULL && path_exists(dont_exist, NODEREF) &&
+			!is_case_change(get_operand(cmd, undo, OPND_SRC, src),
+				get_operand(cmd, undo, OPND_DST, dst)))
 	{
-		return is_under_trash(op->dst) ? -1 : 0;
+		if(get_operand(cmd, undo, OPND_DST, dst) == NULL || !is_under_trash(dst))
+		{
+			return 0;
+		}
+		change_filename_in_trash(cmd, dst);
 	}
 	return 1;
 }
 
+/* Picks new name for the file in trash, which is the second operand of the
+ * command. */
 static void
-change_filename_in_trash(cmd_t *cmd, const char *filename)
+change_filename_in_trash(cmd_t *cmd, const char filename[])
 {
 	const char *name_tail;
 	char *new;
-	char *old;
 	char *const base_dir = strdup(filename);
 
 	remove_last_path_component(base_dir);
@@ -680,31 +961,13 @@ change_filename_in_trash(cmd_t *cmd, const char *filename)
 
 	free(base_dir);
 
-	old = cmd->buf2;
-	cmd->buf2 = new;
-
 	rename_in_registers(filename, new);
 
-	update_entry(&cmd->do_op.src, old, cmd->buf2);
-	update_entry(&cmd->do_op.dst, old, cmd->buf2);
-	update_entry(&cmd->do_op.exists, old, cmd->buf2);
-	update_entry(&cmd->do_op.dont_exist, old, cmd->buf2);
-	update_entry(&cmd->undo_op.src, old, cmd->buf2);
-	update_entry(&cmd->undo_op.dst, old, cmd->buf2);
-	update_entry(&cmd->undo_op.exists, old, cmd->buf2);
-	update_entry(&cmd->undo_op.dont_exist, old, cmd->buf2);
-
-	free(old);
-}
+	/* Old name stays in memory of the group until the group is freed.  On
+	 * error old name is kept and the operation will just fail. */
+	(void)set_path(cmd->group, &cmd->paths[1], 1, new);
 
-/* Checks whether *e equals old and updates it to new if so. */
-static void
-update_entry(const char **e, const char old[], const char new[])
-{
-	if(*e == old)
-	{
-		*e = new;
-	}
+	free(new);
 }
 
 char **
@@ -761,13 +1024,13 @@ fill_undolist_detail(char **list)
 		{
 			const char *p;
 
-			p = get_op_desc(cmd->do_op);
+			p = get_op_desc(cmd, 0);
 			if((*list = malloc(4 + strlen(p) + 1)) == NULL)
 				return list;
 			sprintf(*list, "do: %s", p);
 			list++;
 
-			p = get_op_desc(cmd->undo_op);
+			p = get_op_desc(cmd, 1);
 			if((*list = malloc(6 + strlen(p) + 1)) == NULL)
 				return list;
 			sprintf(*list, "undo: %s", p);
@@ -782,10 +1045,18 @@ fill_undolist_detail(char **list)
 	return list;
 }
 
+/* Formats description of do or undo operation of the command.  Returns pointer
+ * to a statically allocated buffer. */
 static const char *
-get_op_desc(op_t op)
+get_op_desc(const cmd_t *cmd, int undo)
 {
 	static char buf[64 + 2*PATH_MAX] = "";
+
+	const op_t op = undo ? cmd->undo_op : cmd->do_op;
+	char src_buf[PATH_MAX], dst_buf[PATH_MAX];
+	const char *const src = get_operand(cmd, undo, OPND_SRC, src_buf);
+	const char *const dst = get_operand(cmd, undo, OPND_DST, dst_buf);
+
 	switch(op.op)
 	{
 		case OP_NONE:
@@ -796,34 +1067,34 @@ get_op_desc(op_t op)
 			break;
 		case OP_REMOVE:
 		case OP_REMOVESL:
-			snprintf(buf, sizeof(buf), "rm %s", op.src);
+			snprintf(buf, sizeof(buf), "rm %s", src);
 			break;
 		case OP_COPY:
-			snprintf(buf, sizeof(buf), "cp %s to %s", op.src, op.dst);
+			snprintf(buf, sizeof(buf), "cp %s to %s", src, dst);
 			break;
 		case OP_COPYF:
-			snprintf(buf, sizeof(buf), "cp -f %s to %s", op.src, op.dst);
+			snprintf(buf, sizeof(buf), "cp -f %s to %s", src, dst);
 			break;
 		case OP_MOVE:
 		case OP_MOVETMP1:
 		case OP_MOVETMP2:
-			snprintf(buf, sizeof(buf), "mv %s to %s", op.src, op.dst);
+			snprintf(buf, sizeof(buf), "mv %s to %s", src, dst);
 			break;
 		case OP_MOVEF:
-			snprintf(buf, sizeof(buf), "mv -f %s to %s", op.src, op.dst);
+			snprintf(buf, sizeof(buf), "mv -f %s to %s", src, dst);
 			break;
 		case OP_CHOWN:
 			snprintf(buf, sizeof(buf), "chown %" PRINTF_ULL " %s",
-					(unsigned long long)(size_t)op.data, op.src);
+					(unsigned long long)(size_t)op.data, src);
 			break;
 		case OP_CHGRP:
 			snprintf(buf, sizeof(buf), "chown :%" PRINTF_ULL " %s",
-					(unsigned long long)(size_t)op.data, op.src);
+					(unsigned long long)(size_t)op.data, src);
 			break;
 #ifndef _WIN32
 		case OP_CHMOD:
 		case OP_CHMODR:
-			snprintf(buf, sizeof(buf), "chmod %s %s", (char *)op.data, op.src);
+			snprintf(buf, sizeof(buf), "chmod %s %s", (char *)op.data, src);
 			break;
 #else
 		case OP_ADDATTR:
@@ -835,17 +1106,17 @@ get_op_desc(op_t op)
 #endif
 		case OP_SYMLINK:
 		case OP_SYMLINK2:
-			snprintf(buf, sizeof(buf), "ln -s %s to %s", op.src, op.dst);
+			snprintf(buf, sizeof(buf), "ln -s %s to %s", src, dst);
 			break;
 		case OP_MKDIR:
-			snprintf(buf, sizeof(buf), "mkdir %s%s", op.src,
+			snprintf(buf, sizeof(buf), "mkdir %s%s", src,
 					(op.data == NULL) ? "" : "-p ");
 			break;
 		case OP_RMDIR:
-			snprintf(buf, sizeof(buf), "rmdir %s", op.src);
+			snprintf(buf, sizeof(buf), "rmdir %s", src);
 			break;
 		case OP_MKFILE:
-			snprintf(buf, sizeof(buf), "touch %s", op.src);
+			snprintf(buf, sizeof(buf), "touch %s", src);
 			break;
 
 		default:
@@ -903,30 +1174,449 @@ void
 clean_cmds_with_trash(const char trash_dir[])
 {
 	cmd_t *cur = cmds.prev;
+	int removed = 0;
 
 	assert(!group_opened);
 
 	while(cur != &cmds)
 	{
 		cmd_t *prev = cur->prev;
+		char path[PATH_MAX];
+		const char *const exists = get_operand(cur, cur->group->balance >= 0,
+				OPND_EXISTS, path);
+
+		if(exists != NULL && trash_contains(trash_dir, exists))
+		{
+			remove_cmd(cur);
+			removed = 1;
+		}
+		cur = prev;
+	}
+
+	if(removed)
+	{
+		rewrite_journal();
+	}
+}
+
+int
+undo_journal_open(const char path[])
+{
+	if(journal != NULL && strcmp(journal_path, path) == 0)
+	{
+		return 0;
+	}
+
+	undo_journal_close();
 
-		if(cur->group->balance < 0)
+	if(cmds.next == NULL)
+	{
+		load_journal(path);
+	}
+
+	journal_path = strdup(path);
+	if(journal_path == NULL)
+	{
+		return 1;
+	}
+
+	rewrite_journal();
+	if(journal == NULL)
+	{
+		undo_journal_close();
+		return 1;
+	}
+	return 0;
+}
+
+void
+undo_journal_close(void)
+{
+	if(journal != NULL)
+	{
+		fclose(journal);
+		journal = NULL;
+	}
+
+	free(journal_path);
+	journal_path = NULL;
+}
+
+/* Fills undo list with commands from the journal.  Commands are replayed, so
+ * the list is truncated according to current limit. */
+static void
+load_journal(const char path[])
+{
+	char *line = NULL;
+	int new_group = 0;
+	int balance = 0, error = 0;
+
+	FILE *const fp = os_fopen(path, "r");
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	while((line = read_line(fp, line)) != NULL)
+	{
+		char *fields[5];
+		const int nfields = split_record(line + (line[0] != '\0'), fields,
+				ARRAY_LEN(fields));
+
+		switch(line[0])
+		{
+			case 'g':
+				if(nfields == 3)
+				{
+					if(group_opened)
+					{
+						cmd_group_end();
+					}
+					cmd_group_begin(fields[2]);
+					balance = strtol(fields[0], NULL, 10);
+					error = strtol(fields[1], NULL, 10);
+					new_group = 1;
+				}
+				break;
+			case 'm':
+				if(nfields == 1 && last_group != NULL)
+				{
+					(void)replace_string(&last_group->msg, fields[0]);
+				}
+				break;
+			case 'o':
+				if(nfields == 5)
+				{
+					load_journal_cmd(fields, &new_group, balance, error);
+				}
+				break;
+			case 'c':
+				if(nfields == 1)
+				{
+					set_current_pos(strtol(fields[0], NULL, 10));
+				}
+				break;
+			case 's':
+				if(nfields == 3)
+				{
+					cmd_t *const cmd = cmd_from_end(strtol(fields[0], NULL, 10));
+					if(group_opened)
+					{
+						cmd_group_end();
+					}
+					if(cmd != &cmds)
+					{
+						cmd->group->balance = strtol(fields[1], NULL, 10);
+						cmd->group->error = strtol(fields[2], NULL, 10);
+					}
+				}
+				break;
+			case 'p':
+				if(nfields == 1)
+				{
+					if(group_opened)
+					{
+						cmd_group_end();
+					}
+					current = cmd_from_end(strtol(fields[0], NULL, 10));
+				}
+				break;
+		}
+	}
+
+	if(group_opened)
+	{
+		cmd_group_end();
+	}
+
+	fclose(fp);
+}
+
+/* Adds command described by fields of a journal record to the list.  Applies
+ * state of the group to newly created group. */
+static void
+load_journal_cmd(char *fields[], int *new_group, int balance, int error)
+{
+	const long op = strtol(fields[0], NULL, 10);
+	void *do_data, *undo_data;
+
+	if(op < 0 || op >= OP_COUNT)
+	{
+		return;
+	}
+
+	/* Commands that follow end of a group belong to that group. */
+	if(!group_opened)
+	{
+		if(last_group == NULL)
+		{
+			return;
+		}
+		group_opened = 1;
+		next_group--;
+	}
+
+	do_data = parse_op_data(op, fields[1]);
+	undo_data = parse_op_data(undo_op[op], fields[2]);
+	if(add_operation(op, do_data, undo_data, fields[3], fields[4]) == 0 &&
+			*new_group && last_group != NULL)
+	{
+		last_group->balance = balance;
+		last_group->error = error;
+		*new_group = 0;
+	}
+}
+
+/* Parses data of an operation written by write_op_data().  Returns the
+ * data. */
+static void *
+parse_op_data(OPS op, const char field[])
+{
+	if(field[0] == 's' && data_is_ptr[op])
+	{
+		return strdup(field + 1);
+	}
+	if(field[0] == 'n' && !data_is_ptr[op])
+	{
+		return (void *)(size_t)strtoull(field + 1, NULL, 10);
+	}
+	return NULL;
+}
+
+/* Makes command at specified position current.  Zero position corresponds to
+ * the state when everything is undone. */
+static void
+set_current_pos(int pos)
+{
+	current = &cmds;
+	while(pos-- > 0 && current->next != NULL)
+	{
+		current = current->next;
+	}
+}
+
+/* Counts commands that follow the command in the list.  Returns the count,
+ * which for the list head is the number of commands. */
+static int
+count_cmds_after(const cmd_t *cmd)
+{
+	int count = 0;
+	while(cmd->next != NULL)
+	{
+		cmd = cmd->next;
+		++count;
+	}
+	return count;
+}
+
+/* Finds command that is followed by specified number of commands.  Positions
+ * are counted from the end, because older commands can be dropped from the
+ * beginning of the list.  Returns the command or list head. */
+static cmd_t *
+cmd_from_end(int count)
+{
+	cmd_t *cmd = cmds.prev;
+	while(count-- > 0 && cmd != &cmds)
+	{
+		cmd = cmd->prev;
+	}
+	return cmd;
+}
+
+/* Splits record of the journal into tab-separated fields unescaping them in
+ * place.  Returns number of fields or max_fields + 1 if there are more of
+ * them. */
+static int
+split_record(char line[], char *fields[], int max_fields)
+{
+	int n = 0;
+	const char *r = line;
+	char *w = line;
+
+	fields[n++] = w;
+	while(*r != '\0')
+	{
+		if(*r == '\t')
 		{
-			if(cur->do_op.exists != NULL &&
-					trash_contains(trash_dir, cur->do_op.exists))
+			*w++ = '\0';
+			if(n == max_fields)
 			{
-				remove_cmd(cur);
+				return max_fields + 1;
 			}
+			fields[n++] = w;
+			++r;
+		}
+		else if(r[0] == '\\' && r[1] != '\0')
+		{
+			*w++ = (r[1] == 't') ? '\t' : (r[1] == 'n') ? '\n' : r[1];
+			r += 2;
 		}
 		else
 		{
-			if(cur->undo_op.exists != NULL &&
-					trash_contains(trash_dir, cur->undo_op.exists))
-			{
-				remove_cmd(cur);
-			}
+			*w++ = *r++;
+		}
+	}
+	*w = '\0';
+
+	return n;
+}
+
+/* Appends records with state of the group after it was undone or redone and
+ * with the new position in the list, which is much cheaper than rewriting the
+ * whole journal. */
+static void
+append_state_records(const cmd_t *group_cmd)
+{
+	if(journal == NULL)
+	{
+		return;
+	}
+
+	fprintf(journal, "s%d\t%d\t%d\n", count_cmds_after(group_cmd),
+			group_cmd->group->balance, group_cmd->group->error);
+	fprintf(journal, "p%d\n", count_cmds_after(current));
+	journal_records += 2;
+
+	flush_journal();
+}
+
+/* Writes out buffered records of the journal or rewrites it if it grew too
+ * large. */
+static void
+flush_journal(void)
+{
+	if(journal == NULL)
+	{
+		return;
+	}
+
+	/* Don't let the journal grow much larger than the list it describes. */
+	if(journal_records > 2*command_count + 1024)
+	{
+		rewrite_journal();
+	}
+	else
+	{
+		fflush(journal);
+	}
+}
+
+/* Replaces contents of the journal with current state of the list and reopens
+ * it for appending. */
+static void
+rewrite_journal(void)
+{
+	char tmp_path[PATH_MAX];
+	FILE *fp;
+	cmd_t *cmd;
+	int pos = 0, current_pos = 0;
+
+	if(journal_path == NULL)
+	{
+		return;
+	}
+
+	if(journal != NULL)
+	{
+		fclose(journal);
+		journal = NULL;
+	}
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", journal_path);
+	fp = os_fopen(tmp_path, "w");
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	for(cmd = cmds.next; cmd != NULL; cmd = cmd->next)
+	{
+		if(cmd->group != cmd->prev->group)
+		{
+			write_group_record(fp, cmd->group);
+		}
+		write_cmd_record(fp, cmd);
+
+		++pos;
+		if(cmd == current)
+		{
+			current_pos = pos;
+		}
+	}
+	fprintf(fp, "c%d\n", current_pos);
+
+	if(fclose(fp) != 0 || rename_file(tmp_path, journal_path) != 0)
+	{
+		(void)remove(tmp_path);
+		return;
+	}
+
+	journal = os_fopen(journal_path, "a");
+	journal_records = 0;
+}
+
+/* Writes record that starts new group. */
+static void
+write_group_record(FILE *fp, const group_t *group)
+{
+	fprintf(fp, "g%d\t%d\t", group->balance, group->error);
+	write_field(fp, group->msg);
+	fputc('\n', fp);
+}
+
+/* Writes record that describes single command. */
+static void
+write_cmd_record(FILE *fp, const cmd_t *cmd)
+{
+	fprintf(fp, "o%d\t", (int)cmd->do_op.op);
+	write_op_data(fp, cmd->do_op.op, cmd->do_op.data);
+	fputc('\t', fp);
+	write_op_data(fp, cmd->undo_op.op, cmd->undo_op.data);
+	fputc('\t', fp);
+	write_field(fp, cmd->paths[0].dir);
+	write_field(fp, cmd->paths[0].name);
+	fputc('\t', fp);
+	write_field(fp, cmd->paths[1].dir);
+	write_field(fp, cmd->paths[1].name);
+	fputc('\n', fp);
+}
+
+/* Writes data of an operation as either a string or a number. */
+static void
+write_op_data(FILE *fp, OPS op, const void *data)
+{
+	if(!data_is_ptr[op])
+	{
+		fprintf(fp, "n%" PRINTF_ULL, (unsigned long long)(size_t)data);
+	}
+	else if(data != NULL)
+	{
+		fputc('s', fp);
+		write_field(fp, data);
+	}
+	else
+	{
+		fputc('-', fp);
+	}
+}
+
+/* Writes string escaping characters that have special meaning in the
+ * journal. */
+static void
+write_field(FILE *fp, const char str[])
+{
+	for(; *str != '\0'; ++str)
+	{
+		switch(*str)
+		{
+			case '\\': fputs("\\\\", fp); break;
+			case '\t': fputs("\\t", fp); break;
+			case '\n': fputs("\\n", fp); break;
+
+			default:
+				fputc(*str, fp);
+				break;
 		}
-		cur = prev;
 	}
 }
 
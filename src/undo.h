@@ -110,6 +110,14 @@ int get_undolist_pos(int detail);
  * special value NULL means "all trash directories". */
 void clean_cmds_with_trash(const char trash_dir[]);
 
+/* Starts keeping the list in append-only journal file at the path.  Previous
+ * contents of the journal is loaded if the list is empty.  Returns zero on
+ * success, otherwise non-zero is returned. */
+int undo_journal_open(const char path[]);
+
+/* Stops keeping journal of the list. */
+void undo_journal_close(void);
+
 #endif /* VIFM__UNDO_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -27,7 +27,7 @@
 #include <assert.h> /* assert */
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strdup() strlen() */
+#include <string.h> /* strdup() strlen() strstr() */
 
 #include "str.h"
 
@@ -35,6 +35,9 @@ static int append_to_filter(filter_t *filter, const char value[]);
 static void reset_regex(filter_t *filter, const char value[]);
 static void free_regex(filter_t *filter);
 static void compile_regex(filter_t *filter, const char value[]);
+static int is_literal(const char value[], int ignore_case);
+static int contains_nocase(const char str[], const char substr[]);
+static int to_lower_ascii(int c);
 static char * escape_name_for_filter(const char string[]);
 
 int
@@ -47,6 +50,7 @@ filter_init(filter_t *filter, int case_sensitive)
 	}
 
 	filter->is_regex_valid = 0;
+	filter->is_literal = 0;
 
 	filter->cflags = REG_EXTENDED;
 
@@ -185,8 +189,12 @@ free_regex(filter_t *filter)
 {
 	if(filter->is_regex_valid)
 	{
-		regfree(&filter->regex);
+		if(!filter->is_literal)
+		{
+			regfree(&filter->regex);
+		}
 		filter->is_regex_valid = 0;
+		filter->is_literal = 0;
 	}
 }
 
@@ -197,10 +205,45 @@ compile_regex(filter_t *filter, const char value[])
 {
 	int comp_error;
 	assert(!filter->is_regex_valid && "Filter should have been freed.");
+
+	/* Plain strings don't need regular expression engine. */
+	if(is_literal(value, filter->cflags & REG_ICASE))
+	{
+		filter->is_literal = 1;
+		filter->is_regex_valid = 1;
+		return;
+	}
+
 	comp_error = regcomp(&filter->regex, value, filter->cflags);
 	filter->is_regex_valid = comp_error == 0;
 }
 
+/* Checks whether regular expression matches exactly strings that contain it.
+ * Case insensitive matching is emulated for ASCII characters only.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_literal(const char value[], int ignore_case)
+{
+	if(value[0] == '\0')
+	{
+		return 0;
+	}
+
+	while(*value != '\0')
+	{
+		if(char_is_one_of("\\[](){}+*^$.?|", *value))
+		{
+			return 0;
+		}
+		if(ignore_case && (unsigned char)*value >= 0x80)
+		{
+			return 0;
+		}
+		++value;
+	}
+	return 1;
+}
+
 /* Escapes the string for the purpose of using it in filter.  Returns new
  * string, caller should free it. */
 static char *
@@ -229,14 +272,61 @@ escape_name_for_filter(const char string[])
 int
 filter_matches(filter_t *filter, const char pattern[])
 {
-	if(filter->is_regex_valid)
+	if(!filter->is_regex_valid)
 	{
-		return regexec(&filter->regex, pattern, 0, NULL, 0) == 0;
+		return -1;
 	}
-	else
+
+	if(filter->is_literal)
 	{
-		return -1;
+		return (filter->cflags & REG_ICASE)
+		     ? contains_nocase(pattern, filter->raw)
+		     : strstr(pattern, filter->raw) != NULL;
+	}
+
+	return regexec(&filter->regex, pattern, 0, NULL, 0) == 0;
+}
+
+/* Checks whether the str contains the substr ignoring case of ASCII letters.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+contains_nocase(const char str[], const char substr[])
+{
+	const int first = to_lower_ascii((unsigned char)substr[0]);
+
+	for(; *str != '\0'; ++str)
+	{
+		size_t i;
+
+		if(to_lower_ascii((unsigned char)*str) != first)
+		{
+			continue;
+		}
+
+		for(i = 1U; substr[i] != '\0'; ++i)
+		{
+			if(to_lower_ascii((unsigned char)str[i]) !=
+					to_lower_ascii((unsigned char)substr[i]))
+			{
+				break;
+			}
+		}
+
+		if(substr[i] == '\0')
+		{
+			return 1;
+		}
 	}
+
+	return 0;
+}
+
+/* Converts ASCII letter to lower case leaving other characters intact, which
+ * doesn't depend on locale.  Returns the result of conversion. */
+static int
+to_lower_ascii(int c)
+{
+	return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -32,6 +32,10 @@ typedef struct
 	/* Whether raw regexp was successfully compiled. */
 	int is_regex_valid;
 
+	/* Whether raw regexp is a plain string, which is matched as a substring
+	 * without compiling it. */
+	int is_literal;
+
 	/* Compilation flags for the regular expression. */
 	int cflags;
 
@@ -24,6 +24,31 @@
 /* Opaque type of a watcher. */
 typedef struct fswatch_t fswatch_t;
 
+/* Kind of change that happened to an entry of watched directory. */
+typedef enum
+{
+	FSWE_CREATED,    /* Entry was created. */
+	FSWE_DELETED,    /* Entry was removed. */
+	FSWE_MOVED_FROM, /* Entry was moved away (e.g. renamed). */
+	FSWE_MOVED_TO,   /* Entry was moved into the directory (e.g. renamed). */
+	FSWE_CHANGED,    /* Contents or attributes of an entry were changed. */
+}
+FSWatchEvent;
+
+/* Result of polling a watcher for changes. */
+typedef enum
+{
+	FSWS_UNCHANGED, /* Nothing interesting happened. */
+	FSWS_CHANGED,   /* Changes were reported per entry via callback. */
+	FSWS_REPLACED,  /* Changes can't be expressed per entry (e.g. the directory
+	                   itself changed or events were lost), the whole directory
+	                   needs to be re-read. */
+}
+FSWatchState;
+
+/* Callback invoked by fswatch_poll() for each change of an entry. */
+typedef void (*fswatch_cb)(const char name[], FSWatchEvent event, void *arg);
+
 /* Creates new watcher for the specified path.  Returns the watcher or NULL on
  * error. */
 fswatch_t * fswatch_create(const char path[]);
@@ -36,6 +61,17 @@ void fswatch_free(fswatch_t *w);
  * non-zero if so, otherwise zero is returned. */
 int fswatch_changed(fswatch_t *w, int *error);
 
+/* Same as fswatch_changed(), but also reports names of changed entries by
+ * calling the cb (can be NULL) for each of them in order of events.  Sets
+ * *error to indicate whether any issues occurred.  Returns state of the
+ * watched directory. */
+FSWatchState fswatch_poll(fswatch_t *w, int *error, fswatch_cb cb, void *arg);
+
+/* Retrieves file descriptor that becomes readable when fswatch_poll() has
+ * something to report.  Returns the descriptor or -1 if watcher needs to be
+ * polled periodically (e.g., to report changes that were postponed). */
+int fswatch_get_fd(const fswatch_t *w);
+
 #endif /* VIFM__UTILS__FSWATCH_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
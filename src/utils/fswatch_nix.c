@@ -31,6 +31,7 @@
 #include <time.h> /* time_t time() */
 
 #include "../compat/fs_limits.h"
+#include "string_array.h"
 #include "trie.h"
 
 /* TODO: consider implementation that could reuse already available descriptor
@@ -39,8 +40,10 @@
 /* Watcher data. */
 struct fswatch_t
 {
-	int fd;       /* File descriptor for inotify. */
-	trie_t stats; /* Tree to keep track of per file frequency of notifications. */
+	int fd;        /* File descriptor for inotify. */
+	trie_t stats;  /* Tree to keep track of per file frequency of notifications. */
+	char **missed; /* Names of banned files that had their events ignored. */
+	int nmissed;   /* Number of elements in the missed array. */
 };
 
 /* Per file statistics information. */
@@ -51,11 +54,14 @@ typedef struct
 	uint32_t ban_mask;   /* Events right before the ban. */
 	int count;           /* How many times file changed continuously in the last
 	                        several seconds. */
+	int missed;          /* Whether some events were ignored due to the ban. */
 }
 notif_stat_t;
 
 static int update_file_stats(fswatch_t *w, const struct inotify_event *e,
 		time_t now);
+static FSWatchEvent event_from_mask(uint32_t mask);
+static int report_missed(fswatch_t *w, time_t now, fswatch_cb cb, void *arg);
 
 fswatch_t *
 fswatch_create(const char path[])
@@ -77,6 +83,9 @@ fswatch_create(const char path[])
 		return NULL;
 	}
 
+	w->missed = NULL;
+	w->nmissed = 0;
+
 	/* Create inotify instance. */
 	w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
 	if(w->fd == -1)
@@ -106,6 +115,7 @@ fswatch_free(fswatch_t *w)
 {
 	if(w != NULL)
 	{
+		free_string_array(w->missed, w->nmissed);
 		trie_free_with_data(w->stats);
 		close(w->fd);
 		free(w);
@@ -114,15 +124,21 @@ fswatch_free(fswatch_t *w)
 
 int
 fswatch_changed(fswatch_t *w, int *error)
+{
+	return fswatch_poll(w, error, NULL, NULL) != FSWS_UNCHANGED;
+}
+
+FSWatchState
+fswatch_poll(fswatch_t *w, int *error, fswatch_cb cb, void *arg)
 {
 	enum { BUF_LEN = (10 * (sizeof(struct inotify_event) + NAME_MAX + 1)) };
 
 	char buf[BUF_LEN];
 	int nread;
-	int changed;
+	FSWatchState state;
 	const time_t now = time(NULL);
 
-	changed = 0;
+	state = FSWS_UNCHANGED;
 	*error = 0;
 	do
 	{
@@ -146,15 +162,84 @@ fswatch_changed(fswatch_t *w, int *error)
 		for(p = buf; p < buf + nread; p += sizeof(struct inotify_event) + e->len)
 		{
 			e = (struct inotify_event *)p;
-			if(update_file_stats(w, e, now))
+			if(!update_file_stats(w, e, now) || state == FSWS_REPLACED)
+			{
+				continue;
+			}
+
+			/* Events without a name are about the directory itself or about the
+			 * event queue, both require full re-read. */
+			if(e->len == 0U || (e->mask & IN_Q_OVERFLOW))
 			{
-				changed = 1;
+				state = FSWS_REPLACED;
+				continue;
+			}
+
+			state = FSWS_CHANGED;
+			if(cb != NULL)
+			{
+				cb(e->name, event_from_mask(e->mask), arg);
 			}
 		}
 	}
 	while(nread != 0);
 
-	return changed;
+	if(state != FSWS_REPLACED && report_missed(w, now, cb, arg))
+	{
+		state = FSWS_CHANGED;
+	}
+
+	return state;
+}
+
+int
+fswatch_get_fd(const fswatch_t *w)
+{
+	/* Expiration of a ban doesn't make descriptor readable. */
+	return (w->nmissed == 0) ? w->fd : -1;
+}
+
+/* Reports files that had their events ignored and whose ban has expired since
+ * then.  Returns non-zero if anything was reported, otherwise zero is
+ * returned. */
+static int
+report_missed(fswatch_t *w, time_t now, fswatch_cb cb, void *arg)
+{
+	int reported = 0;
+	int i = 0;
+
+	while(i < w->nmissed)
+	{
+		void *data;
+		notif_stat_t *stats;
+
+		/* Entry was already reported on one of its later events. */
+		if(trie_get(w->stats, w->missed[i], &data) != 0 ||
+				!(stats = data)->missed)
+		{
+			remove_from_string_array(w->missed, w->nmissed, i);
+			--w->nmissed;
+			continue;
+		}
+
+		if(now < stats->banned_until)
+		{
+			++i;
+			continue;
+		}
+
+		stats->missed = 0;
+		reported = 1;
+		if(cb != NULL)
+		{
+			cb(w->missed[i], FSWE_CHANGED, arg);
+		}
+
+		remove_from_string_array(w->missed, w->nmissed, i);
+		--w->nmissed;
+	}
+
+	return reported;
 }
 
 /* Updates information about a file event is about.  Returns non-zero if this is
@@ -182,6 +267,7 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 			stats->last_update = now;
 			stats->banned_until = 0U;
 			stats->count = 1;
+			stats->missed = 0;
 			if(trie_set(w->stats, fname, stats) != 0)
 			{
 				free(stats);
@@ -200,12 +286,21 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 		stats->count = 1;
 	}
 
-	/* Ignore events during banned period, unless it's something new. */
+	/* Ignore events during banned period, unless it's something new, but
+	 * remember to report the file after the ban is over. */
 	if(now < stats->banned_until && !(e->mask & ~stats->ban_mask))
 	{
+		if(!stats->missed)
+		{
+			const int n = add_to_string_array(&w->missed, w->nmissed, 1, fname);
+			stats->missed = (n != w->nmissed);
+			w->nmissed = n;
+		}
 		return 0;
 	}
 
+	stats->missed = 0;
+
 	/* Treat events happened in the next second as a sequence. */
 	stats->count = (now - stats->last_update <= 1U) ? (stats->count + 1) : 1;
 
@@ -223,6 +318,29 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 	return 1;
 }
 
+/* Maps inotify event mask onto kind of change.  Returns the kind. */
+static FSWatchEvent
+event_from_mask(uint32_t mask)
+{
+	if(mask & IN_CREATE)
+	{
+		return FSWE_CREATED;
+	}
+	if(mask & IN_DELETE)
+	{
+		return FSWE_DELETED;
+	}
+	if(mask & IN_MOVED_FROM)
+	{
+		return FSWE_MOVED_FROM;
+	}
+	if(mask & IN_MOVED_TO)
+	{
+		return FSWE_MOVED_TO;
+	}
+	return FSWE_CHANGED;
+}
+
 #else
 
 #include "filemon.h"
@@ -291,6 +409,19 @@ fswatch_changed(fswatch_t *w, int *error)
 	return changed;
 }
 
+FSWatchState
+fswatch_poll(fswatch_t *w, int *error, fswatch_cb cb, void *arg)
+{
+	/* Polling can't tell which entries have changed. */
+	return fswatch_changed(w, error) ? FSWS_REPLACED : FSWS_UNCHANGED;
+}
+
+int
+fswatch_get_fd(const fswatch_t *w)
+{
+	return -1;
+}
+
 #endif
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -112,6 +112,21 @@ fswatch_changed(fswatch_t *w, int *error)
 	return changed;
 }
 
+FSWatchState
+fswatch_poll(fswatch_t *w, int *error, fswatch_cb cb, void *arg)
+{
+	/* Change notifications don't tell which entries have changed. */
+	return fswatch_changed(w, error) ? FSWS_REPLACED : FSWS_UNCHANGED;
+}
+
+int
+fswatch_get_fd(const fswatch_t *w)
+{
+	/* Change notification handles can't be waited on along with file
+	 * descriptors. */
+	return -1;
+}
+
 /* Gets last directory modification time.  Returns non-zero on error, otherwise
  * zero is returned. */
 static int
@@ -0,0 +1,465 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "mapped_lines.h"
+
+#ifndef _WIN32
+#include <sys/mman.h> /* MAP_* PROT_* mmap() munmap() */
+#include <sys/stat.h> /* fstat() stat */
+#include <fcntl.h> /* O_RDONLY open() */
+#include <unistd.h> /* close() pread() ssize_t */
+
+#include <setjmp.h> /* sigjmp_buf siglongjmp() sigsetjmp() */
+#include <signal.h> /* SA_NODEFER SIGBUS SIG_DFL sigaction sigaction()
+                       sigemptyset() signal() */
+#endif
+
+#include <errno.h> /* EINTR errno */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memcpy() */
+
+#include "dynarray.h"
+
+/* Number of lines by which index is extended at least. */
+#define INDEX_STEP 256
+
+/* Description of mapped file. */
+struct mlines_t
+{
+	int fd;           /* File descriptor of the file. */
+	const char *data; /* Beginning of the mapping or of data read into memory. */
+	size_t map_size;  /* Size of the mapping. */
+	size_t size;      /* Number of bytes that can be accessed. */
+	int mapped;       /* Whether data points to the mapping. */
+
+	size_t *offsets;  /* Offsets of beginnings of lines. */
+	int count;        /* Number of elements in offsets array. */
+	size_t indexed;   /* Position at which indexing should continue. */
+
+	char *line_buf;      /* Null terminated copy of the last requested line. */
+	size_t line_buf_len; /* Size of line_buf. */
+};
+
+/* Function that reads data of the file, see guarded_access(). */
+typedef void (*access_func)(mlines_t *ml, void *arg);
+
+/* Argument of copy_line(). */
+typedef struct
+{
+	int n;              /* Number of the line. */
+	size_t len;         /* Length of the line. */
+	const char *result; /* The copy or NULL on error. */
+}
+copy_line_args_t;
+
+static void index_lines(mlines_t *ml, void *arg);
+static void copy_line(mlines_t *ml, void *arg);
+static void guarded_access(mlines_t *ml, access_func func, void *arg);
+#ifndef _WIN32
+static void install_sigbus_handler(void);
+static void handle_sigbus(int sig);
+static void read_contents(mlines_t *ml);
+#endif
+static void check_size(mlines_t *ml);
+static void shrink(mlines_t *ml, size_t size);
+static size_t line_length(const mlines_t *ml, size_t offset);
+static size_t skip_line_end(const mlines_t *ml, size_t pos);
+
+#ifndef _WIN32
+/* Jump buffer of currently active guarded access to mapped memory or NULL. */
+static sigjmp_buf *volatile guard_env;
+#endif
+
+mlines_t *
+mlines_open(const char path[])
+{
+#ifndef _WIN32
+	struct stat st;
+	mlines_t *ml;
+	void *data;
+
+	const int fd = open(path, O_RDONLY);
+	if(fd == -1)
+	{
+		return NULL;
+	}
+
+	if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 ||
+			(unsigned long long)st.st_size > (size_t)-1)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if(data == MAP_FAILED)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	ml = malloc(sizeof(*ml));
+	if(ml == NULL)
+	{
+		munmap(data, st.st_size);
+		close(fd);
+		return NULL;
+	}
+
+	install_sigbus_handler();
+
+	ml->fd = fd;
+	ml->data = data;
+	ml->map_size = st.st_size;
+	ml->size = st.st_size;
+	ml->mapped = 1;
+	ml->offsets = NULL;
+	ml->count = 0;
+	ml->indexed = 0U;
+	ml->line_buf = NULL;
+	ml->line_buf_len = 0U;
+	return ml;
+#else
+	return NULL;
+#endif
+}
+
+void
+mlines_close(mlines_t *ml)
+{
+	if(ml == NULL)
+	{
+		return;
+	}
+
+#ifndef _WIN32
+	if(ml->mapped)
+	{
+		munmap((void *)ml->data, ml->map_size);
+	}
+	else
+	{
+		free((void *)ml->data);
+	}
+	close(ml->fd);
+#endif
+	dynarray_free(ml->offsets);
+	free(ml->line_buf);
+	free(ml);
+}
+
+int
+mlines_index(mlines_t *ml, int count)
+{
+	check_size(ml);
+
+	if(count <= ml->count || ml->indexed >= ml->size)
+	{
+		return ml->count;
+	}
+
+	/* Don't do small steps to not call this function too often. */
+	if(count < ml->count + INDEX_STEP)
+	{
+		count = ml->count + INDEX_STEP;
+	}
+
+	guarded_access(ml, &index_lines, &count);
+	return ml->count;
+}
+
+/* Extends index until it contains *arg lines or end of file is reached.  State
+ * of the index is consistent at any point to be able to restart indexing. */
+static void
+index_lines(mlines_t *ml, void *arg)
+{
+	const int count = *(int *)arg;
+	int capacity = ml->count;
+
+	while(ml->count < count && ml->indexed < ml->size)
+	{
+		size_t next;
+
+		if(ml->count == capacity)
+		{
+			const int more = (capacity < INDEX_STEP) ? INDEX_STEP : capacity;
+			size_t *const offsets = dynarray_extend(ml->offsets,
+					more*sizeof(*offsets));
+			if(offsets == NULL)
+			{
+				break;
+			}
+			ml->offsets = offsets;
+			capacity += more;
+		}
+
+		next = skip_line_end(ml, ml->indexed + line_length(ml, ml->indexed));
+		ml->offsets[ml->count++] = ml->indexed;
+		ml->indexed = next;
+	}
+}
+
+int
+mlines_count(const mlines_t *ml)
+{
+	return ml->count;
+}
+
+int
+mlines_complete(const mlines_t *ml)
+{
+	return ml->indexed >= ml->size;
+}
+
+void
+mlines_check(mlines_t *ml)
+{
+	check_size(ml);
+}
+
+const char *
+mlines_get(mlines_t *ml, int n, size_t *len)
+{
+	copy_line_args_t args = { .n = n };
+
+	if(n >= ml->count)
+	{
+		*len = 0U;
+		return "";
+	}
+
+	guarded_access(ml, &copy_line, &args);
+	if(args.result == NULL)
+	{
+		*len = 0U;
+		return "";
+	}
+
+	*len = args.len;
+	return args.result;
+}
+
+/* Copies line out of the file data into the buffer.  Line can be gone after
+ * reading of the file into memory. */
+static void
+copy_line(mlines_t *ml, void *arg)
+{
+	copy_line_args_t *const args = arg;
+	size_t len;
+
+	args->result = NULL;
+	if(args->n >= ml->count)
+	{
+		return;
+	}
+
+	len = line_length(ml, ml->offsets[args->n]);
+	if(len + 1U > ml->line_buf_len)
+	{
+		char *const buf = realloc(ml->line_buf, len + 1U);
+		if(buf == NULL)
+		{
+			return;
+		}
+		ml->line_buf = buf;
+		ml->line_buf_len = len + 1U;
+	}
+
+	memcpy(ml->line_buf, ml->data + ml->offsets[args->n], len);
+	ml->line_buf[len] = '\0';
+
+	args->len = len;
+	args->result = ml->line_buf;
+}
+
+/* Calls the function, which reads file data, in a way that survives truncation
+ * of the file between checking its size and accessing the mapping.  Accessing
+ * pages past the end of the file raises SIGBUS, in which case the mapping is
+ * replaced with contents of the file read into memory and the function is
+ * called once again.  The function must be restartable. */
+static void
+guarded_access(mlines_t *ml, access_func func, void *arg)
+{
+#ifndef _WIN32
+	sigjmp_buf env;
+
+	if(!ml->mapped)
+	{
+		func(ml, arg);
+		return;
+	}
+
+	if(sigsetjmp(env, 0) != 0)
+	{
+		guard_env = NULL;
+		read_contents(ml);
+		func(ml, arg);
+		return;
+	}
+
+	guard_env = &env;
+	func(ml, arg);
+	guard_env = NULL;
+#else
+	func(ml, arg);
+#endif
+}
+
+#ifndef _WIN32
+
+/* Installs SIGBUS handler that interrupts guarded accesses to the mapping. */
+static void
+install_sigbus_handler(void)
+{
+	static int installed;
+	struct sigaction action;
+
+	if(installed)
+	{
+		return;
+	}
+
+	action.sa_handler = &handle_sigbus;
+	sigemptyset(&action.sa_mask);
+	/* Jumping out of the handler shouldn't leave the signal blocked. */
+	action.sa_flags = SA_NODEFER;
+	installed = (sigaction(SIGBUS, &action, NULL) == 0);
+}
+
+/* Handles SIGBUS by jumping out of guarded access to mapped memory. */
+static void
+handle_sigbus(int sig)
+{
+	if(guard_env != NULL)
+	{
+		siglongjmp(*guard_env, 1);
+	}
+
+	/* Not caused by accessing the mapping, so let the fault terminate the
+	 * application as it would have otherwise. */
+	signal(SIGBUS, SIG_DFL);
+}
+
+/* Replaces mapping with what's left of the file read into memory.  At most the
+ * size of the mapping is read to keep the index valid. */
+static void
+read_contents(mlines_t *ml)
+{
+	char *const data = malloc(ml->size + 1U);
+	size_t size = 0U;
+
+	munmap((void *)ml->data, ml->map_size);
+	ml->mapped = 0;
+
+	while(data != NULL && size < ml->size)
+	{
+		const ssize_t n = pread(ml->fd, data + size, ml->size - size, size);
+		if(n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(n <= 0)
+		{
+			break;
+		}
+		size += n;
+	}
+
+	ml->data = data;
+	shrink(ml, (data == NULL) ? 0U : size);
+}
+
+#endif
+
+/* Accounts for file being truncated after it was mapped to avoid accessing
+ * memory that doesn't correspond to the file anymore. */
+static void
+check_size(mlines_t *ml)
+{
+#ifndef _WIN32
+	struct stat st;
+	if(!ml->mapped || fstat(ml->fd, &st) != 0 || (size_t)st.st_size >= ml->size)
+	{
+		return;
+	}
+
+	shrink(ml, st.st_size);
+#endif
+}
+
+/* Limits accessible data to the specified size dropping lines that are past
+ * it. */
+static void
+shrink(mlines_t *ml, size_t size)
+{
+	ml->size = size;
+	while(ml->count > 0 && ml->offsets[ml->count - 1] >= ml->size)
+	{
+		--ml->count;
+	}
+	if(ml->indexed > ml->size)
+	{
+		ml->indexed = ml->size;
+	}
+}
+
+/* Computes length of a line that starts at the offset.  Returns the length. */
+static size_t
+line_length(const mlines_t *ml, size_t offset)
+{
+	const char *const begin = ml->data + offset;
+	const char *const end = ml->data + ml->size;
+	const char *p = begin;
+	while(p < end && *p != '\n' && *p != '\r' && *p != '\0')
+	{
+		++p;
+	}
+	return p - begin;
+}
+
+/* Skips line terminator at the pos.  Returns position of the next line. */
+static size_t
+skip_line_end(const mlines_t *ml, size_t pos)
+{
+	const char *const data = ml->data;
+
+	if(pos >= ml->size)
+	{
+		return ml->size;
+	}
+
+	switch(data[pos])
+	{
+		case '\n':
+			return pos + 1;
+		case '\r':
+			return (pos + 1 < ml->size && data[pos + 1] == '\n') ? pos + 2 : pos + 1;
+
+		default:
+			/* Sequences of null characters are treated as single line break. */
+			while(pos < ml->size && data[pos] == '\0')
+			{
+				++pos;
+			}
+			return pos;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
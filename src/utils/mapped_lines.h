@@ -0,0 +1,65 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__MAPPED_LINES_H__
+#define VIFM__UTILS__MAPPED_LINES_H__
+
+#include <stddef.h> /* size_t */
+
+/* Memory mapped file split into lines on demand.  Lines are delimited in the
+ * same way as break_into_lines() does it and are copied out one at a time.
+ * Index of lines is built incrementally, so only part of a file that was
+ * requested is processed.  If the file is truncated right before an access to
+ * its mapping, what's left of it is read into memory instead of crashing. */
+
+/* Opaque declaration of structure describing mapped file. */
+typedef struct mlines_t mlines_t;
+
+/* Maps file into memory.  Returns NULL on error or if mapping isn't supported,
+ * otherwise returns handle that should be freed with mlines_close(). */
+mlines_t * mlines_open(const char path[]);
+
+/* Unmaps the file and frees all resources.  NULL argument is fine. */
+void mlines_close(mlines_t *ml);
+
+/* Extends index of lines until it contains at least count lines or end of file
+ * is reached.  Returns number of indexed lines. */
+int mlines_index(mlines_t *ml, int count);
+
+/* Retrieves number of lines indexed so far.  Returns the number. */
+int mlines_count(const mlines_t *ml);
+
+/* Checks whether whole file has been indexed.  Returns non-zero if so,
+ * otherwise zero is returned. */
+int mlines_complete(const mlines_t *ml);
+
+/* Accounts for the file being truncated since it was mapped, accessing such
+ * part of mapping would crash the application.  Should be called before
+ * accessing lines after the file could have been changed.  Index is extended
+ * only after this check. */
+void mlines_check(mlines_t *ml);
+
+/* Retrieves line by its number.  Returns pointer to null terminated copy of the
+ * line, which is valid until the next call, and sets *len to its length, for
+ * numbers out of range empty line is returned. */
+const char * mlines_get(mlines_t *ml, int n, size_t *len);
+
+#endif /* VIFM__UTILS__MAPPED_LINES_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
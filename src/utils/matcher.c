@@ -20,15 +20,37 @@
 
 #include <regex.h> /* regex_t regcomp() regexec() regfree() */
 
-#include <stddef.h> /* NULL */
-#include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strlen() strrchr() strspn() */
+#include <assert.h> /* assert() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* strchr() strcmp() strdup() strlen() strrchr() strspn()
+                       strstr() */
 
+#include "../compat/reallocarray.h"
 #include "globs.h"
 #include "path.h"
 #include "str.h"
 #include "utils.h"
 
+/* Kinds of globs that are matched without regular expression engine. */
+typedef enum
+{
+	GK_EXACT,  /* Literal, which must match whole string. */
+	GK_PREFIX, /* Literal followed by an asterisk. */
+	GK_SUFFIX, /* Asterisk followed by a literal. */
+	GK_ANY,    /* Single asterisk. */
+}
+GlobKind;
+
+/* Glob that is matched by comparing strings. */
+typedef struct
+{
+	GlobKind kind; /* Kind of the glob. */
+	char *lit;     /* Literal part of the glob in lower case. */
+	size_t len;    /* Length of the literal. */
+}
+simple_glob_t;
+
 /* Wrapper for a regular expression, its state and compiled form. */
 struct matcher_t
 {
@@ -38,13 +60,78 @@ struct matcher_t
 	int full_path; /* Matches full path instead of just file name. */
 	int cflags;    /* Regular expression compilation flags. */
 	regex_t regex; /* The expression in compiled form. */
+
+	/* Globs are split into simple ones and the rest, which is converted into
+	 * regular expression.  The regex field is valid only if has_regex is set. */
+	simple_glob_t *simple; /* Globs that are matched without regex. */
+	int simple_count;      /* Number of elements in simple array. */
+	char *rest;            /* Regexp for the other globs or NULL. */
+	int has_regex;         /* Whether regex field is compiled. */
+};
+
+/* Element of a hash table that maps literals to indexes of matchers. */
+typedef struct
+{
+	const char *lit; /* Literal in lower case (owned by a matcher). */
+	size_t len;      /* Length of the literal. */
+	int index;       /* The smallest index of a matcher with this literal. */
+}
+lit_entry_t;
+
+/* Hash table with open addressing, which maps literals to matchers. */
+typedef struct
+{
+	lit_entry_t *entries; /* Slots of the table. */
+	size_t size;          /* Number of slots (zero or power of two). */
+	size_t count;         /* Number of used slots. */
+}
+lit_table_t;
+
+/* Item of a list of matchers that is checked sequentially. */
+typedef struct
+{
+	int index;                 /* Index of the matcher. */
+	const matcher_t *m;        /* The matcher. */
+	const simple_glob_t *glob; /* Glob of the matcher or NULL for its regex. */
+}
+seq_entry_t;
+
+struct matchers_t
+{
+	lit_table_t names; /* Globs that match whole name. */
+	lit_table_t exts;  /* Globs that match by extension. */
+	seq_entry_t *seq;  /* Checks performed in order of indexes. */
+	int seq_count;     /* Number of elements in seq array. */
+	int count;         /* Number of matchers in the list. */
 };
 
 static int is_full_path(const char expr[], int re, int glob, int *strip);
 static int compile_expr(matcher_t *m, int strip, int cs_by_def, char **error);
 static int parse_glob(matcher_t *m, int strip, char **error);
+static int split_globs(matcher_t *m, const char globs[]);
+static int is_simple_glob(const char glob[]);
+static int add_simple_glob(matcher_t *m, const char glob[]);
 static int parse_re(matcher_t *m, int strip, int cs_by_def, char **error);
+static int clone_simple_globs(matcher_t *clone, const matcher_t *matcher);
 static void free_matcher_items(matcher_t *matcher);
+static void free_simple_globs(matcher_t *m);
+static int matches(const matcher_t *m, const char path[]);
+static int simple_glob_matches(const simple_glob_t *glob, const char str[],
+		size_t len);
+static int lit_equal(const char str[], const char lit[], size_t len);
+static int is_ext_glob(const simple_glob_t *glob);
+static int add_seq_entry(matchers_t *ms, const matcher_t *m,
+		const simple_glob_t *glob);
+static int seq_entry_matches(const seq_entry_t *entry, const char path[],
+		const char name[], size_t len);
+static int table_put(lit_table_t *table, const char lit[], size_t len,
+		int index);
+static int table_grow(lit_table_t *table);
+static lit_entry_t * table_find(const lit_table_t *table, const char str[],
+		size_t len);
+static int table_get(const lit_table_t *table, const char str[], size_t len);
+static size_t hash_lit(const char str[], size_t len);
+static char lower_ascii(char c);
 static int is_re_expr(const char expr[]);
 static int is_globs_expr(const char expr[]);
 
@@ -144,14 +231,21 @@ compile_expr(matcher_t *m, int strip, int cs_by_def, char **error)
 		}
 	}
 
-	err = regcomp(&m->regex, m->raw, m->cflags);
+	if(m->globs && m->rest == NULL)
+	{
+		return 0;
+	}
+
+	err = regcomp(&m->regex, m->globs ? m->rest : m->raw, m->cflags);
 	if(err != 0)
 	{
 		replace_string(error, get_regexp_error(err, &m->regex));
 		regfree(&m->regex);
+		free_simple_globs(m);
 		return 1;
 	}
 
+	m->has_regex = 1;
 	return 0;
 }
 
@@ -175,6 +269,13 @@ parse_glob(matcher_t *m, int strip, char **error)
 		return 1;
 	}
 
+	if(split_globs(m, m->raw) != 0)
+	{
+		replace_string(error, "Failed to process globs.");
+		free(re);
+		return 1;
+	}
+
 	free(m->raw);
 	m->raw = re;
 
@@ -182,6 +283,145 @@ parse_glob(matcher_t *m, int strip, char **error)
 	return 0;
 }
 
+/* Separates simple globs from the rest and converts the rest into regular
+ * expression.  Returns zero on success, otherwise non-zero is returned. */
+static int
+split_globs(matcher_t *m, const char globs[])
+{
+	char *rest = NULL;
+	size_t rest_len = 0U;
+	char *glob, *state = NULL;
+
+	char *const copy = strdup(globs);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	glob = copy;
+	while((glob = split_and_get(glob, ',', &state)) != NULL)
+	{
+		int err;
+		if(is_simple_glob(glob))
+		{
+			err = add_simple_glob(m, glob);
+		}
+		else
+		{
+			err = (rest_len != 0U && strappendch(&rest, &rest_len, ',') != 0)
+			   || strappend(&rest, &rest_len, glob) != 0;
+		}
+
+		if(err)
+		{
+			free(copy);
+			free(rest);
+			free_simple_globs(m);
+			return 1;
+		}
+	}
+	free(copy);
+
+	if(rest != NULL)
+	{
+		m->rest = globs_to_regex(rest);
+		free(rest);
+		if(m->rest == NULL)
+		{
+			free_simple_globs(m);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Checks whether glob can be matched without regular expression.  Such globs
+ * consist of ASCII characters that are taken literally and have at most one
+ * asterisk, which is at either end of the glob.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+is_simple_glob(const char glob[])
+{
+	const char *const star = strchr(glob, '*');
+	const size_t len = strlen(glob);
+	const char *p;
+
+	for(p = glob; *p != '\0'; ++p)
+	{
+		if((unsigned char)*p >= 0x80 || char_is_one_of("?[]\\", *p))
+		{
+			return 0;
+		}
+	}
+
+	if(star == NULL)
+	{
+		return 1;
+	}
+
+	return strchr(star + 1, '*') == NULL
+	    && (star == glob || star == glob + len - 1);
+}
+
+/* Appends simple glob to the list of matcher's simple globs.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+add_simple_glob(matcher_t *m, const char glob[])
+{
+	simple_glob_t *g;
+	const size_t len = strlen(glob);
+	char *p;
+
+	void *const ptr = reallocarray(m->simple, m->simple_count + 1,
+			sizeof(*m->simple));
+	if(ptr == NULL)
+	{
+		return 1;
+	}
+	m->simple = ptr;
+	g = &m->simple[m->simple_count];
+
+	if(strcmp(glob, "*") == 0)
+	{
+		g->kind = GK_ANY;
+		g->lit = strdup("");
+	}
+	else if(glob[0] == '*')
+	{
+		g->kind = GK_SUFFIX;
+		g->lit = strdup(glob + 1);
+	}
+	else if(glob[len - 1] == '*')
+	{
+		g->kind = GK_PREFIX;
+		g->lit = strdup(glob);
+		if(g->lit != NULL)
+		{
+			g->lit[len - 1] = '\0';
+		}
+	}
+	else
+	{
+		g->kind = GK_EXACT;
+		g->lit = strdup(glob);
+	}
+
+	if(g->lit == NULL)
+	{
+		return 1;
+	}
+
+	for(p = g->lit; *p != '\0'; ++p)
+	{
+		*p = lower_ascii(*p);
+	}
+	g->len = strlen(g->lit);
+
+	++m->simple_count;
+	return 0;
+}
+
 /* Parses regexp flags.  Returns zero on success or non-zero on error with
  * *error containing description of it. */
 static int
@@ -220,10 +460,19 @@ matcher_clone(const matcher_t *matcher)
 	clone->globs = matcher->globs;
 	clone->full_path = matcher->full_path;
 	clone->cflags = matcher->cflags;
+	clone->rest = (matcher->rest == NULL) ? NULL : strdup(matcher->rest);
+	clone->has_regex = 0;
+	err = clone_simple_globs(clone, matcher);
 
-	err = regcomp(&clone->regex, matcher->raw, matcher->cflags);
+	if(err == 0 && matcher->has_regex)
+	{
+		err = regcomp(&clone->regex, matcher->globs ? matcher->rest : matcher->raw,
+				matcher->cflags);
+		clone->has_regex = (err == 0);
+	}
 
-	if(err != 0 || clone->expr == NULL || clone->raw == NULL)
+	if(err != 0 || clone->expr == NULL || clone->raw == NULL ||
+			(matcher->rest != NULL && clone->rest == NULL))
 	{
 		matcher_free(clone);
 		return NULL;
@@ -232,6 +481,41 @@ matcher_clone(const matcher_t *matcher)
 	return clone;
 }
 
+/* Copies simple globs of the matcher into the clone.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+clone_simple_globs(matcher_t *clone, const matcher_t *matcher)
+{
+	int i;
+
+	clone->simple_count = 0;
+	clone->simple = NULL;
+	if(matcher->simple_count == 0)
+	{
+		return 0;
+	}
+
+	clone->simple = reallocarray(NULL, matcher->simple_count,
+			sizeof(*clone->simple));
+	if(clone->simple == NULL)
+	{
+		return 1;
+	}
+
+	for(i = 0; i < matcher->simple_count; ++i)
+	{
+		clone->simple[i] = matcher->simple[i];
+		clone->simple[i].lit = strdup(matcher->simple[i].lit);
+		if(clone->simple[i].lit == NULL)
+		{
+			return 1;
+		}
+		++clone->simple_count;
+	}
+
+	return 0;
+}
+
 void
 matcher_free(matcher_t *matcher)
 {
@@ -249,18 +533,101 @@ free_matcher_items(matcher_t *matcher)
 {
 	free(matcher->expr);
 	free(matcher->raw);
-	regfree(&matcher->regex);
+	free_simple_globs(matcher);
+	if(matcher->has_regex)
+	{
+		regfree(&matcher->regex);
+		matcher->has_regex = 0;
+	}
+}
+
+/* Frees simple globs of the matcher and regexp of the rest of globs. */
+static void
+free_simple_globs(matcher_t *m)
+{
+	int i;
+	for(i = 0; i < m->simple_count; ++i)
+	{
+		free(m->simple[i].lit);
+	}
+	free(m->simple);
+	m->simple = NULL;
+	m->simple_count = 0;
+
+	free(m->rest);
+	m->rest = NULL;
 }
 
 int
 matcher_matches(matcher_t *matcher, const char path[])
 {
-	if(!matcher->full_path)
+	return matches(matcher, path);
+}
+
+/* Checks whether given path/name matches.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+matches(const matcher_t *m, const char path[])
+{
+	int i;
+	size_t len;
+
+	if(!m->full_path)
 	{
 		path = get_last_path_component(path);
 	}
 
-	return (regexec(&matcher->regex, path, 0, NULL, 0) == 0);
+	len = strlen(path);
+	for(i = 0; i < m->simple_count; ++i)
+	{
+		if(simple_glob_matches(&m->simple[i], path, len))
+		{
+			return 1;
+		}
+	}
+
+	return m->has_regex && regexec(&m->regex, path, 0, NULL, 0) == 0;
+}
+
+/* Checks whether string of specified length matches simple glob in the same
+ * way as its regular expression would.  Returns non-zero if so, otherwise zero
+ * is returned. */
+static int
+simple_glob_matches(const simple_glob_t *glob, const char str[], size_t len)
+{
+	switch(glob->kind)
+	{
+		case GK_EXACT:
+			return len == glob->len && lit_equal(str, glob->lit, len);
+		case GK_PREFIX:
+			return len >= glob->len && lit_equal(str, glob->lit, glob->len);
+		case GK_SUFFIX:
+			/* Leading asterisk doesn't match dot files and empty strings. */
+			return len > glob->len && str[0] != '.'
+			    && lit_equal(str + (len - glob->len), glob->lit, glob->len);
+		case GK_ANY:
+			return len != 0U && str[0] != '.';
+	}
+
+	assert(0 && "Unexpected glob kind.");
+	return 0;
+}
+
+/* Compares beginning of the string with literal in lower case ignoring case of
+ * ASCII characters.  Returns non-zero if they are equal, otherwise zero is
+ * returned. */
+static int
+lit_equal(const char str[], const char lit[], size_t len)
+{
+	size_t i;
+	for(i = 0U; i < len; ++i)
+	{
+		if(lower_ascii(str[i]) != lit[i])
+		{
+			return 0;
+		}
+	}
+	return 1;
 }
 
 const char *
@@ -296,6 +663,285 @@ matcher_includes(const matcher_t *like, const matcher_t *m)
 	return 0;
 }
 
+matchers_t *
+matchers_alloc(void)
+{
+	return calloc(1U, sizeof(matchers_t));
+}
+
+void
+matchers_free(matchers_t *ms)
+{
+	if(ms != NULL)
+	{
+		free(ms->names.entries);
+		free(ms->exts.entries);
+		free(ms->seq);
+		free(ms);
+	}
+}
+
+int
+matchers_add(matchers_t *ms, const matcher_t *m)
+{
+	const int index = ms->count;
+	int i;
+
+	if(m->full_path || !m->globs)
+	{
+		/* Such matchers are checked as a whole. */
+		if(add_seq_entry(ms, m, NULL) != 0)
+		{
+			return 1;
+		}
+		++ms->count;
+		return 0;
+	}
+
+	for(i = 0; i < m->simple_count; ++i)
+	{
+		const simple_glob_t *const glob = &m->simple[i];
+		int err;
+
+		if(glob->kind == GK_EXACT)
+		{
+			err = table_put(&ms->names, glob->lit, glob->len, index);
+		}
+		else if(is_ext_glob(glob))
+		{
+			err = table_put(&ms->exts, glob->lit, glob->len, index);
+		}
+		else
+		{
+			err = add_seq_entry(ms, m, glob);
+		}
+
+		if(err != 0)
+		{
+			return 1;
+		}
+	}
+
+	if(m->has_regex && add_seq_entry(ms, m, NULL) != 0)
+	{
+		return 1;
+	}
+
+	++ms->count;
+	return 0;
+}
+
+/* Checks whether glob matches files by their extension (like "*.ext" does).
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_ext_glob(const simple_glob_t *glob)
+{
+	return glob->kind == GK_SUFFIX
+	    && glob->lit[0] == '.'
+	    && strchr(glob->lit + 1, '.') == NULL;
+}
+
+/* Appends entry to the list of checks performed sequentially.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+add_seq_entry(matchers_t *ms, const matcher_t *m, const simple_glob_t *glob)
+{
+	void *const p = reallocarray(ms->seq, ms->seq_count + 1, sizeof(*ms->seq));
+	if(p == NULL)
+	{
+		return 1;
+	}
+	ms->seq = p;
+
+	ms->seq[ms->seq_count].index = ms->count;
+	ms->seq[ms->seq_count].m = m;
+	ms->seq[ms->seq_count].glob = glob;
+	++ms->seq_count;
+	return 0;
+}
+
+int
+matchers_find(const matchers_t *ms, const char path[])
+{
+	const char *const name = get_last_path_component(path);
+	const size_t len = strlen(name);
+	int best = -1;
+	int i;
+
+	/* Leading asterisk of extension globs doesn't match dot files. */
+	if(ms->exts.count != 0U && name[0] != '.')
+	{
+		const char *const ext = strrchr(name, '.');
+		if(ext != NULL)
+		{
+			best = table_get(&ms->exts, ext, len - (ext - name));
+		}
+	}
+
+	if(ms->names.count != 0U)
+	{
+		const int index = table_get(&ms->names, name, len);
+		if(index != -1 && (best == -1 || index < best))
+		{
+			best = index;
+		}
+	}
+
+	for(i = 0; i < ms->seq_count; ++i)
+	{
+		const seq_entry_t *const entry = &ms->seq[i];
+		if(best != -1 && entry->index >= best)
+		{
+			break;
+		}
+
+		if(seq_entry_matches(entry, path, name, len))
+		{
+			best = entry->index;
+			break;
+		}
+	}
+
+	return best;
+}
+
+/* Checks whether entry of sequential list matches.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+seq_entry_matches(const seq_entry_t *entry, const char path[],
+		const char name[], size_t len)
+{
+	if(entry->glob != NULL)
+	{
+		return simple_glob_matches(entry->glob, name, len);
+	}
+
+	if(entry->m->full_path || !entry->m->globs)
+	{
+		return matches(entry->m, path);
+	}
+
+	/* Simple globs of this matcher are checked by other entries. */
+	return regexec(&entry->m->regex, name, 0, NULL, 0) == 0;
+}
+
+/* Adds literal to the table unless it's already there, in which case the
+ * smaller index is kept.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+table_put(lit_table_t *table, const char lit[], size_t len, int index)
+{
+	lit_entry_t *entry;
+
+	if(2U*(table->count + 1U) > table->size && table_grow(table) != 0)
+	{
+		return 1;
+	}
+
+	entry = table_find(table, lit, len);
+	if(entry->lit == NULL)
+	{
+		entry->lit = lit;
+		entry->len = len;
+		entry->index = index;
+		++table->count;
+	}
+
+	return 0;
+}
+
+/* Doubles size of the table.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+table_grow(lit_table_t *table)
+{
+	lit_entry_t *const old_entries = table->entries;
+	const size_t old_size = table->size;
+	const size_t new_size = (old_size == 0U) ? 16U : old_size*2U;
+	size_t i;
+
+	lit_entry_t *const new_entries = calloc(new_size, sizeof(*new_entries));
+	if(new_entries == NULL)
+	{
+		return 1;
+	}
+
+	table->entries = new_entries;
+	table->size = new_size;
+
+	for(i = 0U; i < old_size; ++i)
+	{
+		const lit_entry_t *const old = &old_entries[i];
+		if(old->lit != NULL)
+		{
+			*table_find(table, old->lit, old->len) = *old;
+		}
+	}
+
+	free(old_entries);
+	return 0;
+}
+
+/* Finds slot that either holds literal equal to the string ignoring case or is
+ * empty.  Returns the slot. */
+static lit_entry_t *
+table_find(const lit_table_t *table, const char str[], size_t len)
+{
+	const size_t mask = table->size - 1U;
+	size_t i = hash_lit(str, len) & mask;
+
+	while(table->entries[i].lit != NULL)
+	{
+		const lit_entry_t *const entry = &table->entries[i];
+		if(entry->len == len && lit_equal(str, entry->lit, len))
+		{
+			break;
+		}
+		i = (i + 1U) & mask;
+	}
+
+	return &table->entries[i];
+}
+
+/* Looks up string in the table ignoring case.  Returns index associated with
+ * it or -1 if there is no such string in the table. */
+static int
+table_get(const lit_table_t *table, const char str[], size_t len)
+{
+	const lit_entry_t *entry;
+
+	if(table->count == 0U)
+	{
+		return -1;
+	}
+
+	entry = table_find(table, str, len);
+	return (entry->lit == NULL) ? -1 : entry->index;
+}
+
+/* FNV-1a hash of a string with ASCII characters converted to lower case.
+ * Returns the hash. */
+static size_t
+hash_lit(const char str[], size_t len)
+{
+	size_t hash = 2166136261U;
+	size_t i;
+	for(i = 0U; i < len; ++i)
+	{
+		hash ^= (unsigned char)lower_ascii(str[i]);
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/* Converts ASCII character to lower case independently of current locale.
+ * Returns the converted character. */
+static char
+lower_ascii(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? (c - 'A' + 'a') : c;
+}
+
 int
 matcher_is_expr(const char str[])
 {
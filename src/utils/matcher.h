@@ -27,6 +27,9 @@
 /* Opaque matcher type. */
 typedef struct matcher_t matcher_t;
 
+/* Opaque type of an ordered list of matchers, which are checked all at once. */
+typedef struct matchers_t matchers_t;
+
 /* Parses matcher expression and allocates matcher.  Returns matcher on success,
  * otherwise NULL is returned and *error is initialized with newly allocated
  * string describing the error. */
@@ -54,6 +57,22 @@ int matcher_includes(const matcher_t *like, const matcher_t *m);
  * otherwise zero is returned. */
 int matcher_is_expr(const char str[]);
 
+/* Allocates empty list of matchers.  Returns the list or NULL on error. */
+matchers_t * matchers_alloc(void);
+
+/* Frees the list, but not matchers that were added to it.  ms can be NULL. */
+void matchers_free(matchers_t *ms);
+
+/* Appends matcher to the list.  Index of the matcher is the number of matchers
+ * added before it.  The matcher must outlive the list.  Returns zero on
+ * success, otherwise non-zero is returned and the list shouldn't be used. */
+int matchers_add(matchers_t *ms, const matcher_t *m);
+
+/* Finds first matcher of the list that matches given path/name.  Simple globs
+ * are looked up by name or extension instead of checking matchers one by one.
+ * Returns index of the matcher or -1 if none matches. */
+int matchers_find(const matchers_t *ms, const char path[]);
+
 #endif /* VIFM__UTILS__MATCHER_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -716,6 +716,14 @@ find_cmd_in_path(const char cmd[], size_t path_len, char path[])
 	for(i = 0; i < paths_count; i++)
 	{
 		char tmp_path[PATH_MAX];
+
+		/* Avoid querying file system when it's known that there is no such
+		 * file. */
+		if(path_dir_lacks(i, cmd))
+		{
+			continue;
+		}
+
 		snprintf(tmp_path, sizeof(tmp_path), "%s/%s", paths[i], cmd);
 
 		/* Need to check for executable, not just a file, as this additionally
@@ -341,7 +341,22 @@ static char **
 break_into_lines(char text[], size_t text_len, int *nlines)
 {
 	const char *const end = text + text_len;
-	char **list = NULL;
+	const char *p;
+	size_t max_lines = 1U;
+	char **list;
+
+	/* Allocate array once using number of line terminators as an upper bound of
+	 * number of lines. */
+	for(p = text; p < end; ++p)
+	{
+		max_lines += (*p == '\n' || *p == '\r' || *p == '\0');
+	}
+
+	list = reallocarray(NULL, max_lines, sizeof(*list));
+	if(list == NULL)
+	{
+		return NULL;
+	}
 
 	*nlines = 0;
 	while(text < end)
@@ -367,7 +382,12 @@ break_into_lines(char text[], size_t text_len, int *nlines)
 		}
 
 		text[line_len] = '\0';
-		*nlines = add_to_string_array(&list, *nlines, 1, text);
+		list[*nlines] = strdup(text);
+		if(list[*nlines] == NULL)
+		{
+			break;
+		}
+		++*nlines;
 
 		text = after_line;
 	}
@@ -0,0 +1,407 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "string_pool.h"
+
+#include <stddef.h> /* NULL offsetof() size_t */
+#include <stdint.h> /* uint32_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcpy() strcmp() strlen() */
+
+/* Size of data of regular chunks. */
+#define CHUNK_SIZE (64*1024)
+
+/* Strings longer than this get chunks of their own. */
+#define MAX_SHARED_SIZE (CHUNK_SIZE/8)
+
+/* Marks interned strings in reference counter. */
+#define INTERNED 0x80000000U
+
+/* Chunk of memory that holds strings. */
+typedef struct chunk_t
+{
+	strpool_t *pool;      /* Owner of the chunk or NULL if it was freed. */
+	struct chunk_t *prev; /* Previous chunk of the pool. */
+	struct chunk_t *next; /* Next chunk of the pool. */
+	size_t live;          /* Number of strings that weren't released. */
+	size_t size;          /* Size of the data. */
+	size_t used;          /* Used part of the data. */
+	char data[];          /* Headers followed by strings. */
+}
+chunk_t;
+
+/* Header that precedes each string. */
+typedef struct
+{
+	uint32_t offset; /* Offset of the header within data of its chunk. */
+	uint32_t refs;   /* Number of references and INTERNED flag. */
+}
+header_t;
+
+struct strpool_t
+{
+	chunk_t *chunks;   /* List of chunks of the pool. */
+	chunk_t *current;  /* Chunk in which strings are allocated. */
+	char **table;      /* Hash table of interned strings. */
+	size_t table_size; /* Number of slots in the table (power of two). */
+	size_t interned;   /* Number of interned strings. */
+};
+
+static char * alloc_str(strpool_t *pool, const char str[]);
+static chunk_t * add_chunk(strpool_t *pool, size_t size);
+static void free_chunk(chunk_t *chunk);
+static chunk_t * get_chunk(header_t *hdr);
+static header_t * get_header(const char str[]);
+static int grow_table(strpool_t *pool);
+static size_t find_slot(const strpool_t *pool, const char str[]);
+static void remove_from_table(strpool_t *pool, const char str[]);
+static size_t hash_str(const char str[]);
+
+strpool_t *
+strpool_create(void)
+{
+	return calloc(1U, sizeof(strpool_t));
+}
+
+void
+strpool_free(strpool_t *pool)
+{
+	if(pool == NULL)
+	{
+		return;
+	}
+
+	while(pool->chunks != NULL)
+	{
+		chunk_t *const chunk = pool->chunks;
+		pool->chunks = chunk->next;
+
+		if(chunk->live == 0U)
+		{
+			free(chunk);
+		}
+		else
+		{
+			/* Chunk will be freed when its last string is released. */
+			chunk->pool = NULL;
+			chunk->prev = NULL;
+			chunk->next = NULL;
+		}
+	}
+
+	free(pool->table);
+	free(pool);
+}
+
+char *
+strpool_dup(strpool_t *pool, const char str[])
+{
+	return alloc_str(pool, str);
+}
+
+char *
+strpool_intern(strpool_t *pool, const char str[])
+{
+	size_t slot;
+	char *copy;
+
+	if(2U*(pool->interned + 1U) > pool->table_size && grow_table(pool) != 0)
+	{
+		return NULL;
+	}
+
+	slot = find_slot(pool, str);
+	if(pool->table[slot] != NULL)
+	{
+		return strpool_ref(pool->table[slot]);
+	}
+
+	copy = alloc_str(pool, str);
+	if(copy == NULL)
+	{
+		return NULL;
+	}
+
+	get_header(copy)->refs |= INTERNED;
+	pool->table[slot] = copy;
+	++pool->interned;
+	return copy;
+}
+
+char *
+strpool_ref(const char str[])
+{
+	++get_header(str)->refs;
+	return (char *)str;
+}
+
+void
+strpool_release(char str[])
+{
+	header_t *hdr;
+	chunk_t *chunk;
+
+	if(str == NULL)
+	{
+		return;
+	}
+
+	hdr = get_header(str);
+	if(--hdr->refs != INTERNED && hdr->refs != 0U)
+	{
+		return;
+	}
+
+	chunk = get_chunk(hdr);
+	if((hdr->refs & INTERNED) && chunk->pool != NULL)
+	{
+		remove_from_table(chunk->pool, str);
+	}
+
+	if(--chunk->live != 0U)
+	{
+		return;
+	}
+
+	if(chunk->pool != NULL && chunk == chunk->pool->current)
+	{
+		/* Reuse memory of the current chunk. */
+		chunk->used = 0U;
+		return;
+	}
+
+	free_chunk(chunk);
+}
+
+/* Allocates copy of the string in the pool.  Returns the copy or NULL on
+ * error. */
+static char *
+alloc_str(strpool_t *pool, const char str[])
+{
+	const size_t len = strlen(str) + 1U;
+	const size_t align = sizeof(header_t) - 1U;
+	const size_t size = (sizeof(header_t) + len + align) & ~align;
+	chunk_t *chunk = pool->current;
+	header_t *hdr;
+
+	if(size > MAX_SHARED_SIZE)
+	{
+		chunk = add_chunk(pool, size);
+	}
+	else if(chunk == NULL || chunk->used + size > chunk->size)
+	{
+		chunk_t *const prev = chunk;
+		chunk = add_chunk(pool, CHUNK_SIZE);
+		if(chunk != NULL)
+		{
+			pool->current = chunk;
+			if(prev != NULL && prev->live == 0U)
+			{
+				free_chunk(prev);
+			}
+		}
+	}
+
+	if(chunk == NULL)
+	{
+		return NULL;
+	}
+
+	hdr = (header_t *)(chunk->data + chunk->used);
+	hdr->offset = chunk->used;
+	hdr->refs = 1U;
+	memcpy(hdr + 1, str, len);
+
+	chunk->used += size;
+	++chunk->live;
+
+	return (char *)(hdr + 1);
+}
+
+/* Allocates new chunk of the specified data size and adds it to the pool.
+ * Returns the chunk or NULL on error. */
+static chunk_t *
+add_chunk(strpool_t *pool, size_t size)
+{
+	chunk_t *const chunk = malloc(sizeof(*chunk) + size);
+	if(chunk == NULL)
+	{
+		return NULL;
+	}
+
+	chunk->pool = pool;
+	chunk->prev = NULL;
+	chunk->next = pool->chunks;
+	chunk->live = 0U;
+	chunk->size = size;
+	chunk->used = 0U;
+
+	if(pool->chunks != NULL)
+	{
+		pool->chunks->prev = chunk;
+	}
+	pool->chunks = chunk;
+
+	return chunk;
+}
+
+/* Removes chunk from its pool and frees it. */
+static void
+free_chunk(chunk_t *chunk)
+{
+	strpool_t *const pool = chunk->pool;
+
+	if(pool != NULL)
+	{
+		if(chunk->prev == NULL)
+		{
+			pool->chunks = chunk->next;
+		}
+		else
+		{
+			chunk->prev->next = chunk->next;
+		}
+		if(chunk->next != NULL)
+		{
+			chunk->next->prev = chunk->prev;
+		}
+		if(pool->current == chunk)
+		{
+			pool->current = NULL;
+		}
+	}
+
+	free(chunk);
+}
+
+/* Finds chunk that contains string with the header.  Returns the chunk. */
+static chunk_t *
+get_chunk(header_t *hdr)
+{
+	return (chunk_t *)((char *)hdr - hdr->offset - offsetof(chunk_t, data));
+}
+
+/* Retrieves header of a string.  Returns the header. */
+static header_t *
+get_header(const char str[])
+{
+	return (header_t *)str - 1;
+}
+
+/* Doubles size of hash table of interned strings.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+grow_table(strpool_t *pool)
+{
+	char **const old_table = pool->table;
+	const size_t old_size = pool->table_size;
+	const size_t new_size = (old_size == 0U) ? 64U : old_size*2U;
+	size_t i;
+
+	char **const new_table = calloc(new_size, sizeof(*new_table));
+	if(new_table == NULL)
+	{
+		return 1;
+	}
+
+	pool->table = new_table;
+	pool->table_size = new_size;
+
+	for(i = 0U; i < old_size; ++i)
+	{
+		if(old_table[i] != NULL)
+		{
+			pool->table[find_slot(pool, old_table[i])] = old_table[i];
+		}
+	}
+
+	free(old_table);
+	return 0;
+}
+
+/* Finds slot that either contains string equal to str or is empty and ends
+ * lookup.  Returns index of the slot. */
+static size_t
+find_slot(const strpool_t *pool, const char str[])
+{
+	const size_t mask = pool->table_size - 1U;
+	size_t i = hash_str(str) & mask;
+
+	while(pool->table[i] != NULL && strcmp(pool->table[i], str) != 0)
+	{
+		i = (i + 1U) & mask;
+	}
+
+	return i;
+}
+
+/* Removes interned string from the hash table of the pool preserving lookup
+ * chains of other strings. */
+static void
+remove_from_table(strpool_t *pool, const char str[])
+{
+	const size_t mask = pool->table_size - 1U;
+	size_t i = hash_str(str) & mask;
+	size_t j;
+
+	while(pool->table[i] != str)
+	{
+		i = (i + 1U) & mask;
+	}
+
+	pool->table[i] = NULL;
+	--pool->interned;
+
+	/* Move subsequent elements of the cluster into the hole if they belong to
+	 * it. */
+	j = i;
+	while(1)
+	{
+		size_t home;
+
+		j = (j + 1U) & mask;
+		if(pool->table[j] == NULL)
+		{
+			break;
+		}
+
+		home = hash_str(pool->table[j]) & mask;
+		if(((j - home) & mask) >= ((j - i) & mask))
+		{
+			pool->table[i] = pool->table[j];
+			pool->table[j] = NULL;
+			i = j;
+		}
+	}
+}
+
+/* FNV-1a hash of a string.  Returns the hash. */
+static size_t
+hash_str(const char str[])
+{
+	size_t hash = 2166136261U;
+	while(*str != '\0')
+	{
+		hash ^= (unsigned char)*str++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,56 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__STRING_POOL_H__
+#define VIFM__UTILS__STRING_POOL_H__
+
+/* string_pool - reference counted strings allocated in large chunks */
+
+/* Strings of a pool are packed into chunks, which are freed once all strings
+ * in them are released.  Interned strings are shared by all users that request
+ * equal strings.  Strings must not be modified and should be released by
+ * strpool_release() only. */
+
+/* Opaque declaration of string pool type. */
+typedef struct strpool_t strpool_t;
+
+/* Creates new empty pool.  Returns the pool or NULL on error. */
+strpool_t * strpool_create(void);
+
+/* Frees the pool.  Strings that are still alive stay valid until they are
+ * released, but aren't interned anymore.  The pool can be NULL. */
+void strpool_free(strpool_t *pool);
+
+/* Copies the str into the pool.  Returns the copy or NULL on error. */
+char * strpool_dup(strpool_t *pool, const char str[]);
+
+/* Looks up string equal to the str in the pool and shares it or copies the
+ * str into the pool for sharing.  Returns the string or NULL on error. */
+char * strpool_intern(strpool_t *pool, const char str[]);
+
+/* Adds reference to a string of a pool.  Returns the str. */
+char * strpool_ref(const char str[]);
+
+/* Drops reference to a string of a pool, which is freed along with the last
+ * reference.  The str can be NULL. */
+void strpool_release(char str[]);
+
+#endif /* VIFM__UTILS__STRING_POOL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -277,6 +277,8 @@ main(int argc, char *argv[])
 	check_path_for_file(&lwin, vifm_args.lwin_path, vifm_args.lwin_handle);
 	check_path_for_file(&rwin, vifm_args.rwin_path, vifm_args.rwin_handle);
 
+	update_undo_journal();
+
 	curr_stats.load_stage = 2;
 
 	exec_startup_commands(&vifm_args);
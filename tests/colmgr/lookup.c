@@ -0,0 +1,104 @@
+#include <stic.h>
+
+#include <sys/time.h> /* gettimeofday() timeval */
+
+#include <stdio.h> /* printf() */
+#include <stdlib.h> /* getenv() */
+
+#include "../../src/ui/color_manager.h"
+
+#include "test.h"
+
+static int bench_requested(void);
+
+SETUP()
+{
+	colmgr_reset();
+}
+
+TEST(same_colors_give_same_pair)
+{
+	int i;
+	int pairs[CUSTOM_COLOR_PAIRS];
+
+	for(i = 0; i < CUSTOM_COLOR_PAIRS; ++i)
+	{
+		pairs[i] = colmgr_get_pair(INUSE_SEED, i);
+		assert_true(pairs[i] > 0);
+	}
+
+	for(i = 0; i < CUSTOM_COLOR_PAIRS; ++i)
+	{
+		assert_int_equal(pairs[i], colmgr_get_pair(INUSE_SEED, i));
+	}
+}
+
+TEST(pairs_are_found_after_compression)
+{
+	enum { IN_USE = CUSTOM_COLOR_PAIRS/2 };
+
+	int i;
+	int pairs[IN_USE];
+
+	for(i = 0; i < CUSTOM_COLOR_PAIRS; ++i)
+	{
+		const int fg = (i%2 == 0) ? UNUSED_SEED : INUSE_SEED;
+		assert_true(colmgr_get_pair(fg, i/2) > 0);
+	}
+
+	/* This triggers compression. */
+	assert_true(colmgr_get_pair(INUSE_SEED, IN_USE) > 0);
+
+	for(i = 0; i < IN_USE; ++i)
+	{
+		int j;
+
+		pairs[i] = colmgr_get_pair(INUSE_SEED, i);
+		assert_true(pairs[i] > 0);
+
+		for(j = 0; j < i; ++j)
+		{
+			assert_true(pairs[j] != pairs[i]);
+		}
+	}
+
+	/* No new pairs should have been allocated for existing colors. */
+	for(i = IN_USE + 1; colmgr_get_pair(INUSE_SEED, i) != 0; ++i)
+	{
+	}
+	assert_int_equal(CUSTOM_COLOR_PAIRS, i);
+}
+
+/* Run with VIFM_BENCH environment variable set to see how long lookups of
+ * existing pairs take. */
+TEST(benchmark_of_pair_lookup, IF(bench_requested))
+{
+	enum { LOOKUPS = 10000000 };
+
+	struct timeval start, end;
+	int i;
+
+	for(i = 0; i < CUSTOM_COLOR_PAIRS; ++i)
+	{
+		(void)colmgr_get_pair(INUSE_SEED, i);
+	}
+
+	(void)gettimeofday(&start, NULL);
+	for(i = 0; i < LOOKUPS; ++i)
+	{
+		(void)colmgr_get_pair(INUSE_SEED, i%CUSTOM_COLOR_PAIRS);
+	}
+	(void)gettimeofday(&end, NULL);
+
+	printf("%d lookups among %d pairs: %.3f s\n", LOOKUPS, CUSTOM_COLOR_PAIRS,
+			(end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec)/1e6);
+}
+
+static int
+bench_requested(void)
+{
+	return getenv("VIFM_BENCH") != NULL;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,123 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* stat */
+#include <unistd.h> /* link() rmdir() unlink() */
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fopen() fputs() */
+
+#include "../../src/compat/os.h"
+#include "../../src/utils/utils.h"
+#include "../../src/dcache.h"
+#include "../../src/fileops.h"
+
+static void make_file(const char path[], const char contents[]);
+static int not_windows(void);
+
+SETUP()
+{
+	assert_success(dcache_reset());
+
+	assert_success(os_mkdir(SANDBOX_PATH "/top", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/top/sub", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/top/sub/subsub", 0700));
+	make_file(SANDBOX_PATH "/top/a", "12345");
+	make_file(SANDBOX_PATH "/top/sub/b", "123");
+	make_file(SANDBOX_PATH "/top/sub/subsub/c", "1");
+}
+
+TEARDOWN()
+{
+	assert_success(unlink(SANDBOX_PATH "/top/sub/subsub/c"));
+	assert_success(unlink(SANDBOX_PATH "/top/sub/b"));
+	assert_success(unlink(SANDBOX_PATH "/top/a"));
+	assert_success(rmdir(SANDBOX_PATH "/top/sub/subsub"));
+	assert_success(rmdir(SANDBOX_PATH "/top/sub"));
+	assert_success(rmdir(SANDBOX_PATH "/top"));
+
+	assert_success(dcache_reset());
+}
+
+TEST(sizes_of_subdirectories_are_summed_and_cached)
+{
+	uint64_t size = 0U;
+
+	assert_int_equal(9, calculate_dir_size(SANDBOX_PATH "/top", 0));
+
+	assert_success(dcache_get(SANDBOX_PATH "/top", &size));
+	assert_int_equal(9, size);
+	assert_success(dcache_get(SANDBOX_PATH "/top/sub", &size));
+	assert_int_equal(4, size);
+	assert_success(dcache_get(SANDBOX_PATH "/top/sub/subsub", &size));
+	assert_int_equal(1, size);
+}
+
+TEST(up_to_date_cache_entries_are_reused)
+{
+	struct stat st;
+	assert_success(os_stat(SANDBOX_PATH "/top/sub", &st));
+	assert_success(dcache_set_at(SANDBOX_PATH "/top/sub", st.st_mtime, 100,
+				100));
+
+	assert_int_equal(106, calculate_dir_size(SANDBOX_PATH "/top", 0));
+	assert_int_equal(9, calculate_dir_size(SANDBOX_PATH "/top", 1));
+}
+
+TEST(outdated_cache_entries_are_recalculated)
+{
+	struct stat st;
+	assert_success(os_stat(SANDBOX_PATH "/top/sub", &st));
+	assert_success(dcache_set_at(SANDBOX_PATH "/top/sub", st.st_mtime - 1, 100,
+				100));
+
+	assert_int_equal(9, calculate_dir_size(SANDBOX_PATH "/top", 0));
+}
+
+TEST(changes_in_subdirectories_are_noticed)
+{
+	uint64_t size = 0U;
+
+	assert_int_equal(9, calculate_dir_size(SANDBOX_PATH "/top", 0));
+
+	make_file(SANDBOX_PATH "/top/sub/subsub/d", "1234567");
+	assert_int_equal(16, calculate_dir_size(SANDBOX_PATH "/top", 0));
+	assert_success(dcache_get(SANDBOX_PATH "/top/sub", &size));
+	assert_int_equal(11, size);
+
+	assert_success(unlink(SANDBOX_PATH "/top/sub/subsub/d"));
+	assert_int_equal(9, calculate_dir_size(SANDBOX_PATH "/top", 0));
+}
+
+TEST(hard_links_are_counted_once, IF(not_windows))
+{
+	assert_success(link(SANDBOX_PATH "/top/a", SANDBOX_PATH "/top/sub/link"));
+
+	assert_int_equal(9, calculate_dir_size(SANDBOX_PATH "/top", 0));
+
+	assert_success(unlink(SANDBOX_PATH "/top/sub/link"));
+}
+
+TEST(missing_directory_has_zero_size)
+{
+	uint64_t size = 0U;
+	assert_int_equal(0, calculate_dir_size(SANDBOX_PATH "/no-such-dir", 0));
+	assert_failure(dcache_get(SANDBOX_PATH "/no-such-dir", &size));
+}
+
+static void
+make_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	fputs(contents, f);
+	fclose(f);
+}
+
+static int
+not_windows(void)
+{
+	return get_env_type() != ET_WIN;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -45,5 +45,43 @@ TEST(returns_negative_number_for_invalid_regexp)
 	filter_dispose(&filter);
 }
 
+TEST(plain_string_is_matched_as_substring)
+{
+	filter_t filter;
+	assert_int_equal(0, filter_init(&filter, 1));
+
+	assert_int_equal(0, filter_set(&filter, "bc"));
+	assert_true(filter.is_literal);
+	assert_true(filter_matches(&filter, "abcd") > 0);
+	assert_true(filter_matches(&filter, "aBcd") == 0);
+
+	filter_dispose(&filter);
+}
+
+TEST(plain_string_can_ignore_case)
+{
+	filter_t filter;
+	assert_int_equal(0, filter_init(&filter, 0));
+
+	assert_int_equal(0, filter_set(&filter, "bC"));
+	assert_true(filter.is_literal);
+	assert_true(filter_matches(&filter, "aBcd") > 0);
+	assert_true(filter_matches(&filter, "abd") == 0);
+
+	filter_dispose(&filter);
+}
+
+TEST(special_characters_are_not_plain)
+{
+	filter_t filter;
+	assert_int_equal(0, filter_init(&filter, 1));
+
+	assert_int_equal(0, filter_set(&filter, "a.c"));
+	assert_false(filter.is_literal);
+	assert_true(filter_matches(&filter, "abc") > 0);
+
+	filter_dispose(&filter);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -86,6 +86,19 @@ TEST(update_with_null_file_does_not_reset_paths)
 	assert_string_equal("x", estim->target);
 }
 
+TEST(update_with_same_path_keeps_buffers)
+{
+	const char *item, *target;
+
+	ioeta_update(estim, "a", "x", 0, 134);
+	item = estim->item;
+	target = estim->target;
+
+	ioeta_update(estim, "a", "x", 0, 134);
+	assert_true(item == estim->item);
+	assert_true(target == estim->target);
+}
+
 TEST(zero_update_changes_nothing)
 {
 	ioeta_estim_t e = *estim;
@@ -4,6 +4,7 @@
 
 #include <stddef.h> /* NULL */
 
+#include "../../src/io/private/ioeta.h"
 #include "../../src/io/ioeta.h"
 #include "../../src/io/ionotif.h"
 #include "../../src/io/iop.h"
@@ -159,5 +160,26 @@ TEST(rm_dir_invokes_ionotif)
 	assert_true(invoked_progress >= 1);
 }
 
+TEST(progress_notifications_are_rate_limited)
+{
+	int i;
+
+	ioeta_add_item(estim, "a");
+	ioeta_add_item(estim, "b");
+
+	for(i = 0; i < 1000; ++i)
+	{
+		ioeta_update(estim, "a", "x", 0, 1);
+	}
+	assert_int_equal(1, invoked_progress);
+
+	ioeta_update(estim, NULL, NULL, 1, 0);
+	assert_int_equal(1, invoked_progress);
+
+	/* Completion of the last item is always reported. */
+	ioeta_update(estim, "b", "y", 1, 0);
+	assert_int_equal(2, invoked_progress);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -4,7 +4,10 @@
 
 #include <sys/types.h> /* stat */
 #include <sys/stat.h> /* stat */
-#include <unistd.h> /* lstat() */
+#include <unistd.h> /* ftruncate() lseek() lstat() */
+
+#include <stdio.h> /* FILE fclose() fileno() fopen() fputc() fread() fseek() */
+#include <string.h> /* memcmp() */
 
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
@@ -15,8 +18,10 @@
 #include "utils.h"
 
 static void file_is_copied(const char original[]);
+static int same_contents(const char a[], const char b[]);
 
 static int not_windows(void);
+static int has_proc_version(void);
 
 TEST(dir_is_not_copied)
 {
@@ -473,13 +478,106 @@ TEST(socket_is_copied, IF(not_windows))
 	assert_int_equal(0, args.result.errors.error_count);
 }
 
+TEST(file_of_several_copy_blocks_is_copied)
+{
+	int i;
+	FILE *const f = fopen(SANDBOX_PATH "/big", "wb");
+	assert_non_null(f);
+	for(i = 0; i < 3*1024*1024 + 1; ++i)
+	{
+		fputc(i%251, f);
+	}
+	fclose(f);
+
+	clone_test_file(SANDBOX_PATH "/big", SANDBOX_PATH "/big-copy");
+	assert_true(same_contents(SANDBOX_PATH "/big", SANDBOX_PATH "/big-copy"));
+
+	delete_test_file(SANDBOX_PATH "/big");
+	delete_test_file(SANDBOX_PATH "/big-copy");
+}
+
+TEST(holes_of_sparse_file_are_preserved)
+{
+	struct stat src, dst;
+	FILE *const f = fopen(SANDBOX_PATH "/sparse", "wb");
+	assert_non_null(f);
+	fputc('a', f);
+	assert_success(fseek(f, 4*1024*1024, SEEK_SET));
+	fputc('b', f);
+	assert_success(fflush(f));
+	assert_success(ftruncate(fileno(f), 8*1024*1024));
+	fclose(f);
+
+	clone_test_file(SANDBOX_PATH "/sparse", SANDBOX_PATH "/sparse-copy");
+	assert_true(same_contents(SANDBOX_PATH "/sparse",
+				SANDBOX_PATH "/sparse-copy"));
+
+	assert_success(lstat(SANDBOX_PATH "/sparse", &src));
+	assert_success(lstat(SANDBOX_PATH "/sparse-copy", &dst));
+	assert_true(src.st_size == dst.st_size);
+	assert_true(dst.st_blocks <= src.st_blocks);
+
+	delete_test_file(SANDBOX_PATH "/sparse");
+	delete_test_file(SANDBOX_PATH "/sparse-copy");
+}
+
+TEST(pseudo_file_of_zero_size_is_copied, IF(has_proc_version))
+{
+	struct stat st;
+
+	clone_test_file("/proc/version", SANDBOX_PATH "/version");
+	assert_true(same_contents("/proc/version", SANDBOX_PATH "/version"));
+
+	assert_success(lstat(SANDBOX_PATH "/version", &st));
+	assert_true(st.st_size > 0);
+
+	delete_test_file(SANDBOX_PATH "/version");
+}
+
 #endif
 
+/* Compares contents of two files.  Returns non-zero if they are the same,
+ * otherwise zero is returned. */
+static int
+same_contents(const char a[], const char b[])
+{
+	char a_buf[4096], b_buf[4096];
+	size_t a_len, b_len;
+	int same;
+
+	FILE *const a_file = fopen(a, "rb");
+	FILE *const b_file = fopen(b, "rb");
+	assert_non_null(a_file);
+	assert_non_null(b_file);
+
+	do
+	{
+		a_len = fread(a_buf, 1, sizeof(a_buf), a_file);
+		b_len = fread(b_buf, 1, sizeof(b_buf), b_file);
+		same = (a_len == b_len && memcmp(a_buf, b_buf, a_len) == 0);
+	}
+	while(same && a_len != 0U);
+
+	fclose(b_file);
+	fclose(a_file);
+
+	return same;
+}
+
 static int
 not_windows(void)
 {
 	return get_env_type() != ET_WIN;
 }
 
+static int
+has_proc_version(void)
+{
+	struct stat st;
+	return not_windows()
+	    && os_stat("/proc/version", &st) == 0
+	    && st.st_size == 0;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,96 @@
+#include <stic.h>
+
+#include "../../src/io/ioeta.h"
+#include "../../src/io/ior.h"
+
+#include "utils.h"
+
+static ioeta_estim_t *estim;
+
+SETUP()
+{
+	estim = ioeta_alloc(NULL);
+	ioeta_use_manifest(estim);
+}
+
+TEARDOWN()
+{
+	ioeta_free(estim);
+}
+
+TEST(recorded_tree_is_copied)
+{
+	ioeta_calculate(estim, TEST_DATA_PATH "/various-sizes", 0);
+
+	{
+		io_args_t args = {
+			.arg1.src = TEST_DATA_PATH "/various-sizes",
+			.arg2.dst = SANDBOX_PATH "/various-sizes",
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_int_equal(7, estim->total_items);
+	assert_int_equal(7, estim->current_item);
+	assert_int_equal(73728, estim->total_bytes);
+	assert_int_equal(73728, estim->current_byte);
+
+	assert_true(file_exists(SANDBOX_PATH "/various-sizes/block-size-file"));
+	assert_true(file_exists(SANDBOX_PATH
+				"/various-sizes/double-block-size-file"));
+
+	delete_tree(SANDBOX_PATH "/various-sizes");
+}
+
+TEST(skipped_trees_do_not_prevent_copying)
+{
+	ioeta_calculate(estim, TEST_DATA_PATH "/existing-files", 0);
+	ioeta_calculate(estim, TEST_DATA_PATH "/various-sizes", 0);
+
+	{
+		io_args_t args = {
+			.arg1.src = TEST_DATA_PATH "/various-sizes",
+			.arg2.dst = SANDBOX_PATH "/various-sizes",
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	/* Skipped tree might not have been scanned. */
+	assert_true(estim->total_items >= 7);
+	assert_int_equal(7, estim->current_item);
+
+	delete_tree(SANDBOX_PATH "/various-sizes");
+}
+
+TEST(unrecorded_tree_is_traversed)
+{
+	ioeta_calculate(estim, TEST_DATA_PATH "/existing-files", 0);
+
+	{
+		io_args_t args = {
+			.arg1.src = TEST_DATA_PATH "/various-sizes",
+			.arg2.dst = SANDBOX_PATH "/various-sizes",
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_true(file_exists(SANDBOX_PATH
+				"/various-sizes/double-block-size-file"));
+
+	delete_tree(SANDBOX_PATH "/various-sizes");
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
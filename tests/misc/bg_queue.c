@@ -0,0 +1,287 @@
+#include <stic.h>
+
+#include <pthread.h> /* PTHREAD_* pthread_*() */
+#include <unistd.h> /* usleep() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/background.h"
+
+static void blocking_task(bg_op_t *bg_op, void *arg);
+static void progressing_task(bg_op_t *bg_op, void *arg);
+static job_t * start_task(const char src[], bg_task_func func, void *arg);
+static void wait_for_state(job_t *job, BgJobState state);
+static void wait_for_finish(job_t *job);
+static void release_tasks(void);
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int released;
+static int progress_made;
+
+SETUP()
+{
+	cfg.io_jobs = 1;
+	released = 0;
+	progress_made = 0;
+}
+
+TEARDOWN()
+{
+	release_tasks();
+	check_background_jobs();
+	cfg.io_jobs = 1;
+}
+
+TEST(tasks_on_the_same_device_are_serialized)
+{
+	int pos;
+	job_t *const a = start_task(SANDBOX_PATH, &blocking_task, NULL);
+	job_t *const b = start_task(SANDBOX_PATH, &blocking_task, NULL);
+
+	wait_for_state(a, BJS_RUNNING);
+	usleep(10000);
+	assert_int_equal(BJS_QUEUED, bg_job_get_state(b, &pos));
+	assert_int_equal(1, pos);
+
+	release_tasks();
+	wait_for_finish(a);
+	wait_for_finish(b);
+}
+
+TEST(tasks_on_different_devices_run_in_parallel)
+{
+	job_t *const a = start_task(SANDBOX_PATH, &blocking_task, NULL);
+	job_t *const b = start_task(NULL, &blocking_task, NULL);
+
+	wait_for_state(a, BJS_RUNNING);
+	wait_for_state(b, BJS_RUNNING);
+
+	release_tasks();
+	wait_for_finish(a);
+	wait_for_finish(b);
+}
+
+TEST(limit_of_tasks_per_device_is_configurable)
+{
+	job_t *a, *b;
+
+	cfg.io_jobs = 2;
+	a = start_task(SANDBOX_PATH, &blocking_task, NULL);
+	b = start_task(SANDBOX_PATH, &blocking_task, NULL);
+
+	wait_for_state(a, BJS_RUNNING);
+	wait_for_state(b, BJS_RUNNING);
+
+	release_tasks();
+	wait_for_finish(a);
+	wait_for_finish(b);
+}
+
+TEST(raising_limit_starts_queued_tasks)
+{
+	job_t *const a = start_task(SANDBOX_PATH, &blocking_task, NULL);
+	job_t *const b = start_task(SANDBOX_PATH, &blocking_task, NULL);
+
+	wait_for_state(a, BJS_RUNNING);
+
+	cfg.io_jobs = 2;
+	bg_limits_changed();
+	wait_for_state(b, BJS_RUNNING);
+
+	release_tasks();
+	wait_for_finish(a);
+	wait_for_finish(b);
+}
+
+TEST(queued_tasks_can_be_reordered)
+{
+	int pos;
+	job_t *const a = start_task(SANDBOX_PATH, &blocking_task, NULL);
+	job_t *const b = start_task(SANDBOX_PATH, &blocking_task, NULL);
+	job_t *const c = start_task(SANDBOX_PATH, &blocking_task, NULL);
+
+	wait_for_state(a, BJS_RUNNING);
+
+	assert_success(bg_job_move(c, -1));
+	assert_int_equal(BJS_QUEUED, bg_job_get_state(c, &pos));
+	assert_int_equal(1, pos);
+	assert_int_equal(BJS_QUEUED, bg_job_get_state(b, &pos));
+	assert_int_equal(2, pos);
+
+	assert_success(bg_job_move(c, 10));
+	assert_int_equal(BJS_QUEUED, bg_job_get_state(c, &pos));
+	assert_int_equal(2, pos);
+
+	assert_failure(bg_job_move(a, 1));
+
+	release_tasks();
+	wait_for_finish(a);
+	wait_for_finish(b);
+	wait_for_finish(c);
+}
+
+TEST(paused_queued_task_is_skipped)
+{
+	int pos;
+	job_t *const a = start_task(SANDBOX_PATH, &blocking_task, NULL);
+	job_t *const b = start_task(SANDBOX_PATH, &blocking_task, NULL);
+	job_t *const c = start_task(SANDBOX_PATH, &blocking_task, NULL);
+
+	wait_for_state(a, BJS_RUNNING);
+	assert_success(bg_job_set_paused(b, 1));
+	assert_int_equal(BJS_PAUSED, bg_job_get_state(b, &pos));
+
+	release_tasks();
+	wait_for_finish(a);
+	wait_for_finish(c);
+	assert_int_equal(BJS_PAUSED, bg_job_get_state(b, &pos));
+	assert_int_equal(1, pos);
+
+	assert_success(bg_job_set_paused(b, 0));
+	wait_for_finish(b);
+}
+
+TEST(running_task_is_paused_on_progress)
+{
+	int made;
+	job_t *const a = start_task(SANDBOX_PATH, &progressing_task, NULL);
+
+	wait_for_state(a, BJS_RUNNING);
+	assert_success(bg_job_set_paused(a, 1));
+
+	release_tasks();
+	usleep(10000);
+
+	pthread_mutex_lock(&lock);
+	made = progress_made;
+	pthread_mutex_unlock(&lock);
+	assert_int_equal(0, made);
+
+	assert_success(bg_job_set_paused(a, 0));
+	wait_for_finish(a);
+	assert_int_equal(1, progress_made);
+}
+
+TEST(paused_running_task_lets_queued_task_run)
+{
+	job_t *const a = start_task(SANDBOX_PATH, &progressing_task, NULL);
+	job_t *const b = start_task(SANDBOX_PATH, &blocking_task, NULL);
+
+	wait_for_state(a, BJS_RUNNING);
+	assert_success(bg_job_set_paused(a, 1));
+
+	release_tasks();
+	wait_for_finish(b);
+	assert_int_equal(0, progress_made);
+
+	assert_success(bg_job_set_paused(a, 0));
+	wait_for_finish(a);
+	assert_int_equal(1, progress_made);
+}
+
+TEST(resumed_task_waits_for_a_free_slot)
+{
+	int pos;
+	job_t *const a = start_task(SANDBOX_PATH, &progressing_task, NULL);
+	job_t *b;
+
+	wait_for_state(a, BJS_RUNNING);
+	assert_success(bg_job_set_paused(a, 1));
+
+	/* Make a reach the point where it gets paused. */
+	release_tasks();
+	usleep(10000);
+
+	pthread_mutex_lock(&lock);
+	released = 0;
+	pthread_mutex_unlock(&lock);
+
+	b = start_task(SANDBOX_PATH, &blocking_task, NULL);
+	wait_for_state(b, BJS_RUNNING);
+
+	assert_success(bg_job_set_paused(a, 0));
+	usleep(10000);
+	assert_int_equal(BJS_RUNNING, bg_job_get_state(a, &pos));
+	assert_int_equal(0, progress_made);
+
+	release_tasks();
+	wait_for_finish(b);
+	wait_for_finish(a);
+	assert_int_equal(1, progress_made);
+}
+
+/* Task that waits until tasks are released. */
+static void
+blocking_task(bg_op_t *bg_op, void *arg)
+{
+	pthread_mutex_lock(&lock);
+	while(!released)
+	{
+		pthread_cond_wait(&cond, &lock);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+/* Task that reports progress after tasks are released. */
+static void
+progressing_task(bg_op_t *bg_op, void *arg)
+{
+	blocking_task(bg_op, arg);
+	bg_op_changed(bg_op);
+
+	pthread_mutex_lock(&lock);
+	progress_made = 1;
+	pthread_mutex_unlock(&lock);
+}
+
+static job_t *
+start_task(const char src[], bg_task_func func, void *arg)
+{
+	job_t *job;
+
+	assert_success(bg_execute("task", "...", BG_UNDEFINED_TOTAL, 0, src, NULL,
+				func, arg));
+
+	bg_jobs_freeze();
+	job = jobs;
+	bg_jobs_unfreeze();
+
+	assert_non_null(job);
+	return job;
+}
+
+static void
+wait_for_state(job_t *job, BgJobState state)
+{
+	int i;
+	int pos;
+
+	for(i = 0; i < 1000 && bg_job_get_state(job, &pos) != state; ++i)
+	{
+		usleep(1000);
+	}
+	assert_int_equal(state, bg_job_get_state(job, &pos));
+}
+
+static void
+wait_for_finish(job_t *job)
+{
+	int i;
+	for(i = 0; i < 1000 && job->running; ++i)
+	{
+		usleep(1000);
+	}
+	assert_false(job->running);
+}
+
+static void
+release_tasks(void)
+{
+	pthread_mutex_lock(&lock);
+	released = 1;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
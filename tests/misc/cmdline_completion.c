@@ -14,10 +14,13 @@
 #include "../../src/engine/completion.h"
 #include "../../src/engine/functions.h"
 #include "../../src/engine/options.h"
+#include "../../src/int/path_env.h"
 #include "../../src/modes/cmdline.h"
+#include "../../src/utils/env.h"
 #include "../../src/utils/fs.h"
 #include "../../src/utils/path.h"
 #include "../../src/utils/str.h"
+#include "../../src/utils/utils.h"
 #include "../../src/bmarks.h"
 #include "../../src/builtin_functions.h"
 #include "../../src/commands.h"
@@ -32,7 +35,9 @@
 
 static void fusehome_handler(OPT_OP op, optval_t val);
 static void create_executable(const char file[]);
+static void create_file(const char file[]);
 static int dquotes_allowed_in_paths(void);
+static int not_windows(void);
 
 static line_stats_t stats;
 
@@ -453,6 +458,28 @@ TEST(bang_abs_path_completion)
 	assert_success(unlink("exec-for-completion" SUFFIX));
 }
 
+TEST(bang_completion_lists_executables_of_path, IF(not_windows))
+{
+	char *const saved_path = strdup(env_get("PATH"));
+	env_set("PATH", SANDBOX_PATH);
+	update_path_env(1);
+
+	create_executable(SANDBOX_PATH "/exec-in-path");
+	create_file(SANDBOX_PATH "/exec-file");
+
+	prepare_for_line_completion(L"!exec-");
+	assert_success(line_completion(&stats));
+	assert_wstring_equal(L"!exec-in-path", stats.line);
+	assert_int_equal(2, vle_compl_get_count());
+
+	assert_success(unlink(SANDBOX_PATH "/exec-in-path"));
+	assert_success(unlink(SANDBOX_PATH "/exec-file"));
+
+	env_set("PATH", saved_path);
+	update_path_env(1);
+	free(saved_path);
+}
+
 TEST(bmark_tags_are_completed)
 {
 	bmarks_clear();
@@ -484,6 +511,14 @@ TEST(bmark_path_is_completed)
 
 static void
 create_executable(const char file[])
+{
+	create_file(file);
+	chmod(file, 0755);
+	assert_success(access(file, X_OK));
+}
+
+static void
+create_file(const char file[])
 {
 	FILE *const f = fopen(file, "w");
 	if(f != NULL)
@@ -491,8 +526,6 @@ create_executable(const char file[])
 		fclose(f);
 	}
 	assert_success(access(file, F_OK));
-	chmod(file, 0755);
-	assert_success(access(file, X_OK));
 }
 
 static int
@@ -505,5 +538,11 @@ dquotes_allowed_in_paths(void)
 #endif
 }
 
+static int
+not_windows(void)
+{
+	return get_env_type() != ET_WIN;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
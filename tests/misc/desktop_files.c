@@ -0,0 +1,154 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* mkfifo() */
+#include <sys/time.h> /* timeval utimes() */
+#include <unistd.h> /* rmdir() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() */
+#include <string.h> /* strcmp() */
+
+#include "../../src/compat/os.h"
+#include "../../src/int/desktop.h"
+#include "../../src/int/file_magic.h"
+#include "../../src/utils/utils.h"
+#include "../../src/filetype.h"
+
+static const char * find_description(const assoc_records_t *records,
+		const char command[]);
+static void make_file(const char path[], const char contents[]);
+static void make_old(const char path[]);
+static int not_windows(void);
+
+SETUP()
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/apps", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/apps/sub", 0700));
+	make_file(SANDBOX_PATH "/apps/a.desktop",
+			"Name=Editor\nExec=editor %f\nMimeType=text/plain;image/png;\n");
+	make_file(SANDBOX_PATH "/apps/sub/b.desktop",
+			"Name=Viewer\nExec=viewer\nMimeType=text/plain;\n");
+	make_file(SANDBOX_PATH "/apps/c.txt", "MimeType=text/plain;\n");
+	make_old(SANDBOX_PATH "/apps");
+	make_old(SANDBOX_PATH "/apps/sub");
+}
+
+TEARDOWN()
+{
+	(void)unlink(SANDBOX_PATH "/apps/new.desktop");
+	assert_success(unlink(SANDBOX_PATH "/apps/c.txt"));
+	assert_success(unlink(SANDBOX_PATH "/apps/sub/b.desktop"));
+	assert_success(unlink(SANDBOX_PATH "/apps/a.desktop"));
+	assert_success(rmdir(SANDBOX_PATH "/apps/sub"));
+	assert_success(rmdir(SANDBOX_PATH "/apps"));
+}
+
+TEST(handlers_are_found_in_subdirectories, IF(not_windows))
+{
+	assoc_records_t records = parse_desktop_files(SANDBOX_PATH "/apps",
+			"text/plain");
+	assert_int_equal(2, records.count);
+	assert_string_equal("Editor", find_description(&records, "editor %f"));
+	assert_string_equal("Viewer", find_description(&records, "viewer %f"));
+	ft_assoc_records_free(&records);
+
+	records = parse_desktop_files(SANDBOX_PATH "/apps", "image/png");
+	assert_int_equal(1, records.count);
+	ft_assoc_records_free(&records);
+}
+
+TEST(mime_types_are_matched_exactly, IF(not_windows))
+{
+	assoc_records_t records = parse_desktop_files(SANDBOX_PATH "/apps", "text/");
+	assert_int_equal(0, records.count);
+	ft_assoc_records_free(&records);
+}
+
+TEST(index_is_updated_on_directory_change, IF(not_windows))
+{
+	assoc_records_t records = parse_desktop_files(SANDBOX_PATH "/apps",
+			"image/png");
+	assert_int_equal(1, records.count);
+	ft_assoc_records_free(&records);
+
+	make_file(SANDBOX_PATH "/apps/new.desktop",
+			"Name=New\nExec=new %u\nMimeType=image/png\n");
+
+	records = parse_desktop_files(SANDBOX_PATH "/apps", "image/png");
+	assert_int_equal(2, records.count);
+	ft_assoc_records_free(&records);
+}
+
+TEST(index_is_updated_on_file_change, IF(not_windows))
+{
+	assoc_records_t records;
+
+	make_old(SANDBOX_PATH "/apps/sub/b.desktop");
+	records = parse_desktop_files(SANDBOX_PATH "/apps", "image/png");
+	assert_int_equal(1, records.count);
+	ft_assoc_records_free(&records);
+
+	make_file(SANDBOX_PATH "/apps/sub/b.desktop",
+			"Name=Viewer\nExec=viewer\nMimeType=text/plain;image/png;\n");
+	make_old(SANDBOX_PATH "/apps/sub");
+
+	records = parse_desktop_files(SANDBOX_PATH "/apps", "image/png");
+	assert_int_equal(2, records.count);
+	ft_assoc_records_free(&records);
+}
+
+TEST(well_known_signatures_are_recognized)
+{
+	make_file(SANDBOX_PATH "/file", "%PDF-1.4\n");
+	assert_string_equal("application/pdf", get_mimetype(SANDBOX_PATH "/file"));
+	assert_string_equal("application/pdf", get_mimetype(SANDBOX_PATH "/file"));
+	assert_success(unlink(SANDBOX_PATH "/file"));
+}
+
+TEST(fifo_is_not_read, IF(not_windows))
+{
+	assert_success(mkfifo(SANDBOX_PATH "/fifo", 0600));
+	assert_string_equal("inode/fifo", get_mimetype(SANDBOX_PATH "/fifo"));
+	assert_success(unlink(SANDBOX_PATH "/fifo"));
+}
+
+/* Finds description of a record by its command.  Returns the description or
+ * NULL. */
+static const char *
+find_description(const assoc_records_t *records, const char command[])
+{
+	int i;
+	for(i = 0; i < records->count; ++i)
+	{
+		if(strcmp(records->list[i].command, command) == 0)
+		{
+			return records->list[i].description;
+		}
+	}
+	return NULL;
+}
+
+static void
+make_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	fputs(contents, f);
+	fclose(f);
+}
+
+/* Moves modification time of the path to the past. */
+static void
+make_old(const char path[])
+{
+	struct timeval tv[2] = { { .tv_sec = 100 }, { .tv_sec = 100 } };
+	assert_success(utimes(path, tv));
+}
+
+static int
+not_windows(void)
+{
+	return get_env_type() != ET_WIN;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
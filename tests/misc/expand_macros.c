@@ -9,6 +9,7 @@
 #include "../../src/ui/ui.h"
 #include "../../src/utils/dynarray.h"
 #include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
 #include "../../src/filelist.h"
 #include "../../src/macros.h"
 #include "../../src/registers.h"
@@ -451,5 +452,84 @@ TEST(singly_not_expanded_multiple_files_register)
 	clear_registers();
 }
 
+TEST(short_command_is_not_split)
+{
+	int count;
+	char **cmds;
+
+	curr_view = &rwin;
+	other_view = &lwin;
+
+	cmds = ma_expand_batched("cmd %f end", NULL, NULL, 1, 100, &count);
+	assert_int_equal(1, count);
+	assert_string_equal("cmd rfile1 rfile3 rfile5 end", cmds[0]);
+	free_string_array(cmds, count);
+}
+
+TEST(long_command_is_split_by_selected_files)
+{
+	int count;
+	char **cmds;
+
+	curr_view = &rwin;
+	other_view = &lwin;
+
+	cmds = ma_expand_batched("cmd %f end", NULL, NULL, 1, 21, &count);
+	assert_int_equal(2, count);
+	assert_string_equal("cmd rfile1 rfile3 end", cmds[0]);
+	assert_string_equal("cmd rfile5 end", cmds[1]);
+	free_string_array(cmds, count);
+
+	cmds = ma_expand_batched("cmd %f end", NULL, NULL, 1, 1, &count);
+	assert_int_equal(1, count);
+	free_string_array(cmds, count);
+
+	cmds = ma_expand_batched("cmd %f end", NULL, NULL, 1, 10, &count);
+	assert_int_equal(3, count);
+	assert_string_equal("cmd rfile1 end", cmds[0]);
+	assert_string_equal("cmd rfile3 end", cmds[1]);
+	assert_string_equal("cmd rfile5 end", cmds[2]);
+	free_string_array(cmds, count);
+}
+
+TEST(command_with_several_file_lists_is_not_split)
+{
+	int count;
+	char **cmds;
+
+	curr_view = &rwin;
+	other_view = &lwin;
+
+	cmds = ma_expand_batched("cmd %f %f", NULL, NULL, 1, 21, &count);
+	assert_int_equal(1, count);
+	assert_string_equal("cmd rfile1 rfile3 rfile5 rfile1 rfile3 rfile5",
+			cmds[0]);
+	free_string_array(cmds, count);
+}
+
+TEST(many_selected_files_are_expanded)
+{
+	enum { COUNT = 10000 };
+
+	int i;
+	char *expanded;
+
+	dynarray_free(lwin.dir_entry);
+	lwin.list_rows = COUNT;
+	lwin.dir_entry = dynarray_cextend(NULL,
+			lwin.list_rows*sizeof(*lwin.dir_entry));
+	for(i = 0; i < COUNT; ++i)
+	{
+		lwin.dir_entry[i].name = strdup("f");
+		lwin.dir_entry[i].origin = &lwin.curr_dir[0];
+		lwin.dir_entry[i].selected = 1;
+	}
+	lwin.selected_files = COUNT;
+
+	expanded = expand_macros("%f", "", NULL, 1);
+	assert_int_equal(COUNT*2 - 1, strlen(expanded));
+	free(expanded);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -1,7 +1,36 @@
 #include <stic.h>
 
+#include <sys/stat.h> /* chmod() */
+#include <unistd.h> /* access() rmdir() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() */
+#include <stdlib.h> /* free() */
+
+#include "../../src/int/path_env.h"
+#include "../../src/utils/env.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/utils.h"
 #include "../../src/commands_completion.h"
 
+static void create_executable(const char file[]);
+static void create_file(const char file[]);
+static int not_windows(void);
+
+static char *saved_path;
+
+SETUP()
+{
+	saved_path = NULL;
+	(void)replace_string(&saved_path, env_get("PATH"));
+}
+
+TEARDOWN()
+{
+	env_set("PATH", saved_path);
+	update_path_env(1);
+	free(saved_path);
+}
+
 TEST(system_shell_exists)
 {
 #ifdef _WIN32
@@ -13,5 +42,59 @@ TEST(system_shell_exists)
 	assert_true(exists);
 }
 
+TEST(changes_of_path_directories_are_noticed, IF(not_windows))
+{
+	env_set("PATH", SANDBOX_PATH);
+	update_path_env(1);
+
+	assert_false(external_command_exists("exe-in-path"));
+
+	create_executable(SANDBOX_PATH "/exe-in-path");
+	assert_true(external_command_exists("exe-in-path"));
+
+	assert_success(unlink(SANDBOX_PATH "/exe-in-path"));
+	assert_false(external_command_exists("exe-in-path"));
+}
+
+TEST(non_executables_do_not_count, IF(not_windows))
+{
+	env_set("PATH", SANDBOX_PATH);
+	update_path_env(1);
+
+	create_file(SANDBOX_PATH "/not-exe");
+	assert_false(external_command_exists("not-exe"));
+
+	assert_success(mkdir(SANDBOX_PATH "/dir-exe", 0700));
+	assert_false(external_command_exists("dir-exe"));
+
+	assert_success(unlink(SANDBOX_PATH "/not-exe"));
+	assert_success(rmdir(SANDBOX_PATH "/dir-exe"));
+}
+
+static void
+create_executable(const char file[])
+{
+	create_file(file);
+	chmod(file, 0755);
+	assert_success(access(file, X_OK));
+}
+
+static void
+create_file(const char file[])
+{
+	FILE *const f = fopen(file, "w");
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+	assert_success(access(file, F_OK));
+}
+
+static int
+not_windows(void)
+{
+	return get_env_type() != ET_WIN;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -100,5 +100,33 @@ TEST(wrong_flag)
 	assert_int_equal(1, exec_commands(COMMANDS, &lwin, CIT_COMMAND));
 }
 
+TEST(first_matching_highlight_is_used)
+{
+	const char *const COMMANDS = "highlight {*.sh} ctermfg=red"
+	                             " | highlight /^a/ ctermfg=blue"
+	                             " | highlight {*.SH,*.txt,b*} ctermfg=green";
+	col_scheme_t copy = {};
+	int hint;
+
+	assert_int_equal(0, exec_commands(COMMANDS, &lwin, CIT_COMMAND));
+	assert_int_equal(3, cfg.cs.file_hi_count);
+
+	hint = -1;
+	assert_true(get_file_hi(&cfg.cs, "a.sh", &hint) == &cfg.cs.file_hi[0].hi);
+	assert_int_equal(0, hint);
+	hint = -1;
+	assert_true(get_file_hi(&cfg.cs, "a.txt", &hint) == &cfg.cs.file_hi[1].hi);
+	hint = -1;
+	assert_true(get_file_hi(&cfg.cs, "b.txt", &hint) == &cfg.cs.file_hi[2].hi);
+	hint = -1;
+	assert_true(get_file_hi(&cfg.cs, "c", &hint) == NULL);
+	assert_int_equal(-1, hint);
+
+	assign_color_scheme(&copy, &cfg.cs);
+	hint = -1;
+	assert_true(get_file_hi(&copy, "bin", &hint) == &copy.file_hi[2].hi);
+	reset_color_scheme(&copy);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
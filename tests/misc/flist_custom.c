@@ -1,7 +1,9 @@
 #include <stic.h>
 
-#include <unistd.h> /* chdir() rmdir() symlink() */
+#include <sys/time.h> /* timeval utimes() */
+#include <unistd.h> /* chdir() rmdir() symlink() unlink() */
 
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
 #include <stdlib.h> /* free() */
 #include <string.h> /* memset() strcpy() */
 
@@ -19,6 +21,8 @@
 
 static void cleanup_view(FileView *view);
 static void setup_custom_view(FileView *view);
+static void write_file(const char path[], const char content[]);
+static void make_old(const char path[]);
 static int not_windows(void);
 
 SETUP()
@@ -44,6 +48,9 @@ TEARDOWN()
 	update_string(&cfg.slow_fs_list, NULL);
 	update_string(&cfg.fuse_home, NULL);
 
+	cfg.stat_threads = 1;
+	cfg.cv_quick_reload = 0;
+
 	cleanup_view(&lwin);
 }
 
@@ -221,6 +228,108 @@ TEST(files_are_sorted_undecorated)
 	assert_success(rmdir("foo0"));
 }
 
+TEST(parallel_reload_removes_files_of_many_directories)
+{
+	enum { COUNT = 600 };
+
+	char path[PATH_MAX];
+	int i;
+
+	assert_success(chdir(SANDBOX_PATH));
+	assert_success(os_mkdir("d1", 0700));
+	assert_success(os_mkdir("d2", 0700));
+
+	flist_custom_start(&lwin, "test");
+	for(i = 0; i < COUNT; ++i)
+	{
+		snprintf(path, sizeof(path), "d%d/f%d", 1 + i%2, i);
+		write_file(path, "");
+		flist_custom_add(&lwin, path);
+	}
+	assert_success(flist_custom_finish(&lwin, 0));
+	assert_int_equal(COUNT, lwin.list_rows);
+
+	for(i = 0; i < COUNT; i += 3)
+	{
+		snprintf(path, sizeof(path), "d%d/f%d", 1 + i%2, i);
+		assert_success(unlink(path));
+	}
+
+	cfg.stat_threads = 4;
+	load_dir_list(&lwin, 1);
+	assert_int_equal(COUNT - COUNT/3, lwin.list_rows);
+
+	for(i = 0; i < COUNT; ++i)
+	{
+		if(i%3 != 0)
+		{
+			snprintf(path, sizeof(path), "d%d/f%d", 1 + i%2, i);
+			assert_success(unlink(path));
+		}
+	}
+	assert_success(rmdir("d1"));
+	assert_success(rmdir("d2"));
+}
+
+TEST(quick_reload_skips_unchanged_directories, IF(not_windows))
+{
+	assert_success(chdir(SANDBOX_PATH));
+	assert_success(os_mkdir("dir", 0700));
+	write_file("dir/file", "a");
+	make_old("dir");
+
+	cfg.cv_quick_reload = 1;
+
+	flist_custom_start(&lwin, "test");
+	flist_custom_add(&lwin, "dir/file");
+	assert_success(flist_custom_finish(&lwin, 0));
+	assert_int_equal(1, lwin.list_rows);
+
+	/* This reload remembers state of the directory. */
+	load_dir_list(&lwin, 1);
+	assert_int_equal(1, lwin.dir_entry[0].size);
+
+	write_file("dir/file", "abc");
+
+	load_dir_list(&lwin, 1);
+	assert_int_equal(1, lwin.dir_entry[0].size);
+
+	cfg.cv_quick_reload = 0;
+	load_dir_list(&lwin, 1);
+	assert_int_equal(3, lwin.dir_entry[0].size);
+
+	assert_success(unlink("dir/file"));
+	assert_success(rmdir("dir"));
+}
+
+TEST(quick_reload_checks_changed_directories, IF(not_windows))
+{
+	assert_success(chdir(SANDBOX_PATH));
+	assert_success(os_mkdir("dir", 0700));
+	write_file("dir/a", "");
+	write_file("dir/b", "");
+	make_old("dir");
+
+	cfg.cv_quick_reload = 1;
+
+	flist_custom_start(&lwin, "test");
+	flist_custom_add(&lwin, "dir/a");
+	flist_custom_add(&lwin, "dir/b");
+	assert_success(flist_custom_finish(&lwin, 0));
+
+	load_dir_list(&lwin, 1);
+	assert_int_equal(2, lwin.list_rows);
+
+	assert_success(unlink("dir/b"));
+
+	load_dir_list(&lwin, 1);
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+
+	assert_success(unlink("dir/a"));
+	assert_success(rmdir("dir"));
+}
+
 static void
 setup_custom_view(FileView *view)
 {
@@ -230,6 +339,29 @@ setup_custom_view(FileView *view)
 	assert_true(flist_custom_finish(view, 0) == 0);
 }
 
+static void
+write_file(const char path[], const char content[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(content, f);
+		fclose(f);
+	}
+}
+
+/* Moves modification time of the file an hour into the past. */
+static void
+make_old(const char path[])
+{
+	struct timeval tv[2];
+	gettimeofday(&tv[0], NULL);
+	tv[0].tv_sec -= 60*60;
+	tv[1] = tv[0];
+	assert_success(utimes(path, tv));
+}
+
 static int
 not_windows(void)
 {
@@ -6,10 +6,14 @@
 #include "../../src/compat/os.h"
 #include "../../src/ui/ui.h"
 #include "../../src/utils/dynarray.h"
+#include "../../src/utils/filter.h"
 #include "../../src/utils/fs.h"
+#include "../../src/utils/fswatch.h"
 #include "../../src/utils/str.h"
 #include "../../src/filelist.h"
 
+static int using_inotify(void);
+
 static FileView *const view = &lwin;
 
 SETUP()
@@ -42,9 +46,12 @@ TEARDOWN()
 	int i;
 
 	for(i = 0; i < view->list_rows; i++)
-		free(view->dir_entry[i].name);
+		free_dir_entry(view, &view->dir_entry[i]);
 	dynarray_free(view->dir_entry);
 
+	fswatch_free(view->watch);
+	view->watch = NULL;
+
 	filter_dispose(&view->auto_filter);
 	filter_dispose(&view->manual_filter);
 	filter_dispose(&view->local_filter.filter);
@@ -102,5 +109,97 @@ TEST(selection_is_preserved)
 	assert_int_equal(2, view->selected_files);
 }
 
+TEST(watched_changes_are_applied_without_rereading, IF(using_inotify))
+{
+	/* Fake data to see whether unchanged entries were re-read. */
+	view->dir_entry[0].size = 12345;
+	view->list_pos = 2;
+
+	assert_success(os_mkdir("11", 0000));
+	check_if_filelist_have_changed(view);
+	assert_true(ui_view_query_scheduled_event(view) == UUE_RELOAD);
+	populate_dir_list(view, 1);
+
+	assert_int_equal(5, view->list_rows);
+	assert_string_equal("11", view->dir_entry[2].name);
+	assert_string_equal("2", view->dir_entry[view->list_pos].name);
+	assert_int_equal(12345, view->dir_entry[0].size);
+
+	(void)rmdir("11");
+}
+
+TEST(watched_removal_keeps_cursor_and_selection, IF(using_inotify))
+{
+	view->dir_entry[3].selected = 1;
+	view->selected_files = 1;
+	view->list_pos = 3;
+
+	(void)rmdir("1");
+	check_if_filelist_have_changed(view);
+	assert_true(ui_view_query_scheduled_event(view) == UUE_RELOAD);
+	populate_dir_list(view, 1);
+
+	assert_int_equal(3, view->list_rows);
+	assert_string_equal("3", view->dir_entry[view->list_pos].name);
+	assert_true(view->dir_entry[2].selected);
+	assert_int_equal(1, view->selected_files);
+}
+
+TEST(other_reload_requests_cause_full_reload, IF(using_inotify))
+{
+	view->dir_entry[0].size = 12345;
+
+	assert_success(os_mkdir("11", 0000));
+	check_if_filelist_have_changed(view);
+	ui_view_schedule_reload(view);
+	assert_true(ui_view_query_scheduled_event(view) == UUE_RELOAD);
+	populate_dir_list(view, 1);
+
+	assert_int_equal(5, view->list_rows);
+	assert_string_equal("11", view->dir_entry[2].name);
+	assert_false(view->dir_entry[0].size == 12345);
+
+	(void)rmdir("11");
+}
+
+TEST(watched_changes_update_number_of_filtered_files, IF(using_inotify))
+{
+	assert_success(filter_set(&view->auto_filter, "^1"));
+	populate_dir_list(view, 1);
+	assert_int_equal(3, view->list_rows);
+	assert_int_equal(1, view->filtered);
+
+	assert_success(os_mkdir("12", 0000));
+	check_if_filelist_have_changed(view);
+	assert_true(ui_view_query_scheduled_event(view) == UUE_RELOAD);
+	populate_dir_list(view, 1);
+	assert_int_equal(3, view->list_rows);
+	assert_int_equal(2, view->filtered);
+
+	assert_success(rmdir("12"));
+	check_if_filelist_have_changed(view);
+	assert_true(ui_view_query_scheduled_event(view) == UUE_RELOAD);
+	populate_dir_list(view, 1);
+	assert_int_equal(3, view->list_rows);
+	assert_int_equal(1, view->filtered);
+
+	assert_success(rmdir("1"));
+	check_if_filelist_have_changed(view);
+	assert_true(ui_view_query_scheduled_event(view) == UUE_RELOAD);
+	populate_dir_list(view, 1);
+	assert_int_equal(3, view->list_rows);
+	assert_int_equal(0, view->filtered);
+}
+
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
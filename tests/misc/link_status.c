@@ -0,0 +1,118 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() rmdir() symlink() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strcmp() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/fswatch.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+static const dir_entry_t * find_entry(const char name[]);
+
+SETUP()
+{
+	char cwd[PATH_MAX];
+
+	assert_success(chdir(SANDBOX_PATH));
+	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
+
+	cfg.slow_fs_list = strdup("");
+
+	assert_success(os_mkdir("dir", 0700));
+	{
+		FILE *const f = fopen("file", "w");
+		assert_non_null(f);
+		fclose(f);
+	}
+	assert_success(symlink("dir", "dir-link"));
+	assert_success(symlink("file", "file-link"));
+	assert_success(symlink("no-such-file", "broken-link"));
+
+	copy_str(lwin.curr_dir, sizeof(lwin.curr_dir), cwd);
+	filter_init(&lwin.local_filter.filter, 1);
+	filter_init(&lwin.manual_filter, 1);
+	filter_init(&lwin.auto_filter, 1);
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	lwin.dir_entry = NULL;
+	lwin.list_rows = 0;
+	populate_dir_list(&lwin, 0);
+}
+
+TEARDOWN()
+{
+	int i;
+
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		free_dir_entry(&lwin, &lwin.dir_entry[i]);
+	}
+	dynarray_free(lwin.dir_entry);
+	lwin.dir_entry = NULL;
+	lwin.list_rows = 0;
+
+	fswatch_free(lwin.watch);
+	lwin.watch = NULL;
+
+	filter_dispose(&lwin.auto_filter);
+	filter_dispose(&lwin.manual_filter);
+	filter_dispose(&lwin.local_filter.filter);
+
+	assert_success(unlink("broken-link"));
+	assert_success(unlink("file-link"));
+	assert_success(unlink("dir-link"));
+	assert_success(unlink("file"));
+	assert_success(rmdir("dir"));
+
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+}
+
+TEST(status_of_links_is_determined_on_loading)
+{
+	assert_int_equal(LS_DIR, find_entry("dir-link")->link_status);
+	assert_int_equal(LS_FILE, find_entry("file-link")->link_status);
+	assert_int_equal(LS_BROKEN, find_entry("broken-link")->link_status);
+}
+
+TEST(cached_status_is_used_to_detect_directories)
+{
+	assert_true(is_directory_entry(find_entry("dir-link")));
+	assert_false(is_directory_entry(find_entry("file-link")));
+	assert_false(is_directory_entry(find_entry("broken-link")));
+
+	/* Changes of the file system aren't seen until reload. */
+	assert_success(rmdir("dir"));
+	assert_true(is_directory_entry(find_entry("dir-link")));
+	assert_success(os_mkdir("dir", 0700));
+}
+
+static const dir_entry_t *
+find_entry(const char name[])
+{
+	int i;
+	const dir_entry_t *entry = NULL;
+
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		if(strcmp(lwin.dir_entry[i].name, name) == 0)
+		{
+			entry = &lwin.dir_entry[i];
+			break;
+		}
+	}
+
+	assert_non_null(entry);
+	return (entry == NULL) ? &lwin.dir_entry[0] : entry;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
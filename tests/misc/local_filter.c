@@ -0,0 +1,186 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strchr() strcpy() strdup() strlen() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/filter.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/filtering.h"
+
+static void add_entry(FileView *view, const char name[], FileType type);
+static void free_entries(FileView *view, dir_entry_t *entries, int count);
+
+SETUP()
+{
+	cfg.slow_fs_list = strdup("");
+
+	strcpy(lwin.curr_dir, "/path");
+	update_string(&lwin.custom.orig_dir, NULL);
+	lwin.custom.entries = NULL;
+	lwin.custom.entry_count = 0;
+
+	lwin.dir_entry = NULL;
+	lwin.list_rows = 0;
+	lwin.list_pos = 0;
+	lwin.filtered = 0;
+
+	filter_init(&lwin.manual_filter, 1);
+	filter_init(&lwin.auto_filter, 1);
+	filter_init(&lwin.local_filter.filter, 1);
+	filters_view_reset(&lwin);
+}
+
+TEARDOWN()
+{
+	free_entries(&lwin, lwin.dir_entry, lwin.list_rows);
+	lwin.dir_entry = NULL;
+	lwin.list_rows = 0;
+	lwin.filtered = 0;
+
+	free_entries(&lwin, lwin.custom.entries, lwin.custom.entry_count);
+	lwin.custom.entries = NULL;
+	lwin.custom.entry_count = 0;
+
+	filter_dispose(&lwin.manual_filter);
+	filter_dispose(&lwin.auto_filter);
+	filter_dispose(&lwin.local_filter.filter);
+
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+}
+
+TEST(filter_narrows_and_widens)
+{
+	add_entry(&lwin, "abc", FT_REG);
+	add_entry(&lwin, "abd", FT_REG);
+	add_entry(&lwin, "xbc", FT_REG);
+	add_entry(&lwin, "aBc", FT_REG);
+
+	local_filter_set(&lwin, "a");
+	assert_int_equal(3, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+
+	local_filter_set(&lwin, "aB");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("aBc", lwin.dir_entry[0].name);
+
+	local_filter_set(&lwin, "a");
+	assert_int_equal(3, lwin.list_rows);
+	assert_string_equal("abc", lwin.dir_entry[0].name);
+	assert_string_equal("abd", lwin.dir_entry[1].name);
+	assert_string_equal("aBc", lwin.dir_entry[2].name);
+
+	local_filter_set(&lwin, "a|x");
+	assert_int_equal(4, lwin.list_rows);
+
+	local_filter_set(&lwin, "a|xb");
+	assert_int_equal(4, lwin.list_rows);
+
+	local_filter_set(&lwin, "c$");
+	assert_int_equal(3, lwin.list_rows);
+
+	local_filter_accept(&lwin);
+	assert_int_equal(3, lwin.list_rows);
+	assert_string_equal("abc", lwin.dir_entry[0].name);
+	assert_string_equal("xbc", lwin.dir_entry[1].name);
+	assert_string_equal("aBc", lwin.dir_entry[2].name);
+}
+
+TEST(cancel_restores_the_list)
+{
+	add_entry(&lwin, "abc", FT_REG);
+	add_entry(&lwin, "xyz", FT_REG);
+
+	local_filter_set(&lwin, "x");
+	assert_int_equal(1, lwin.list_rows);
+
+	local_filter_cancel(&lwin);
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("abc", lwin.dir_entry[0].name);
+	assert_string_equal("xyz", lwin.dir_entry[1].name);
+}
+
+TEST(directories_are_matched_with_trailing_slash)
+{
+	add_entry(&lwin, "dir", FT_DIR);
+	add_entry(&lwin, "dirfile", FT_REG);
+
+	local_filter_set(&lwin, "r");
+	assert_int_equal(2, lwin.list_rows);
+
+	local_filter_set(&lwin, "r/");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("dir", lwin.dir_entry[0].name);
+
+	local_filter_accept(&lwin);
+}
+
+TEST(big_lists_are_filtered_correctly)
+{
+	enum { COUNT = 100000 };
+
+	char name[16];
+	int i;
+	int with_7 = 0, with_77 = 0, ending_with_7 = 0;
+
+	lwin.dir_entry = dynarray_cextend(NULL, COUNT*sizeof(*lwin.dir_entry));
+	for(i = 0; i < COUNT; ++i)
+	{
+		snprintf(name, sizeof(name), "%d", i);
+		lwin.dir_entry[i].name = strdup(name);
+		lwin.dir_entry[i].origin = &lwin.curr_dir[0];
+		lwin.dir_entry[i].type = FT_REG;
+
+		with_7 += (strchr(name, '7') != NULL);
+		with_77 += (strstr(name, "77") != NULL);
+		ending_with_7 += (name[strlen(name) - 1] == '7');
+	}
+	lwin.list_rows = COUNT;
+
+	local_filter_set(&lwin, "7");
+	assert_int_equal(with_7, lwin.list_rows);
+
+	local_filter_set(&lwin, "77");
+	assert_int_equal(with_77, lwin.list_rows);
+
+	local_filter_set(&lwin, "7$");
+	assert_int_equal(ending_with_7, lwin.list_rows);
+
+	local_filter_accept(&lwin);
+	assert_int_equal(ending_with_7, lwin.list_rows);
+	assert_string_equal("7", lwin.dir_entry[0].name);
+}
+
+static void
+add_entry(FileView *view, const char name[], FileType type)
+{
+	dir_entry_t *const entry = dynarray_extend(view->dir_entry,
+			sizeof(*view->dir_entry));
+	assert_non_null(entry);
+
+	view->dir_entry = entry;
+	memset(&view->dir_entry[view->list_rows], 0, sizeof(*view->dir_entry));
+	view->dir_entry[view->list_rows].name = strdup(name);
+	view->dir_entry[view->list_rows].origin = &view->curr_dir[0];
+	view->dir_entry[view->list_rows].type = type;
+	++view->list_rows;
+}
+
+static void
+free_entries(FileView *view, dir_entry_t *entries, int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free_dir_entry(view, &entries[i]);
+	}
+	dynarray_free(entries);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
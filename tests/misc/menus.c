@@ -1,9 +1,9 @@
 #include <stic.h>
 
-#include <unistd.h> /* chdir() symlink() */
+#include <unistd.h> /* chdir() symlink() usleep() */
 
-#include <stdlib.h> /* remove() */
-#include <string.h> /* strcpy() */
+#include <stdlib.h> /* free() remove() */
+#include <string.h> /* strcpy() strdup() */
 
 #include "../../src/menus/menus.h"
 
@@ -27,6 +27,54 @@ TEST(can_navigate_to_broken_symlink, IF(not_windows))
 	assert_success(remove("broken-link"));
 }
 
+TEST(output_is_loaded_incrementally, IF(not_windows))
+{
+	menu_info m;
+	init_menu_info(&m, strdup("title"), strdup("empty"));
+
+	assert_success(menu_start_loading(&m, "echo first; echo second; printf last",
+				0));
+	assert_true(menu_is_loading(&m));
+
+	while(menu_is_loading(&m))
+	{
+		usleep(1000);
+		(void)menu_load_more(&m);
+	}
+
+	assert_int_equal(3, m.len);
+	assert_string_equal("first", m.items[0]);
+	assert_string_equal("second", m.items[1]);
+	assert_string_equal("last", m.items[2]);
+	assert_string_equal("title", m.title);
+
+	reset_popup_menu(&m);
+}
+
+TEST(loading_can_be_cancelled, IF(not_windows))
+{
+	menu_info m;
+	init_menu_info(&m, strdup("title"), strdup("empty"));
+
+	assert_success(menu_start_loading(&m, "echo item; sleep 10", 0));
+
+	while(m.len == 0)
+	{
+		usleep(1000);
+		(void)menu_load_more(&m);
+	}
+
+	assert_true(menu_is_loading(&m));
+	assert_string_equal("title (loading: 1)", m.title);
+
+	menu_cancel_loading(&m);
+	assert_false(menu_is_loading(&m));
+	assert_int_equal(1, m.len);
+	assert_string_equal("title(cancelled)", m.title);
+
+	reset_popup_menu(&m);
+}
+
 static int
 not_windows(void)
 {
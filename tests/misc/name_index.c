@@ -0,0 +1,105 @@
+#include <stic.h>
+
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/filelist.h"
+#include "../../src/sort.h"
+
+static void add_entry(const char origin[], const char name[]);
+
+SETUP()
+{
+	lwin.list_rows = 0;
+	lwin.dir_entry = NULL;
+	flist_invalidate_index(&lwin);
+
+	add_entry("/a", "x");
+	add_entry("/a", "y");
+	add_entry("/b", "x");
+	add_entry("/b", "z");
+}
+
+TEARDOWN()
+{
+	int i;
+
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		free_dir_entry(&lwin, &lwin.dir_entry[i]);
+	}
+	dynarray_free(lwin.dir_entry);
+
+	lwin.dir_entry = NULL;
+	lwin.list_rows = 0;
+	flist_invalidate_index(&lwin);
+}
+
+TEST(first_entry_with_the_name_is_found)
+{
+	assert_int_equal(0, flist_find_entry(&lwin, "x", NULL));
+	assert_int_equal(1, flist_find_entry(&lwin, "y", NULL));
+	assert_int_equal(3, find_file_pos_in_list(&lwin, "z"));
+	assert_int_equal(-1, flist_find_entry(&lwin, "w", NULL));
+}
+
+TEST(directory_is_matched_when_specified)
+{
+	assert_int_equal(0, flist_find_entry(&lwin, "x", "/a"));
+	assert_int_equal(2, flist_find_entry(&lwin, "x", "/b"));
+	assert_int_equal(-1, flist_find_entry(&lwin, "y", "/b"));
+}
+
+TEST(entries_are_found_by_path)
+{
+	assert_true(flist_entry_from_path(&lwin, "/b/x") == &lwin.dir_entry[2]);
+	assert_true(flist_entry_from_path(&lwin, "/a/y") == &lwin.dir_entry[1]);
+	assert_null(flist_entry_from_path(&lwin, "/b/y"));
+}
+
+TEST(added_entries_are_found)
+{
+	assert_int_equal(-1, find_file_pos_in_list(&lwin, "new"));
+	add_entry("/c", "new");
+	assert_int_equal(4, find_file_pos_in_list(&lwin, "new"));
+}
+
+TEST(renamed_entries_are_found)
+{
+	assert_int_equal(1, find_file_pos_in_list(&lwin, "y"));
+	fentry_rename(&lwin, &lwin.dir_entry[1], "renamed");
+	assert_int_equal(-1, find_file_pos_in_list(&lwin, "y"));
+	assert_int_equal(1, find_file_pos_in_list(&lwin, "renamed"));
+}
+
+TEST(entries_are_found_after_sorting)
+{
+	assert_int_equal(3, find_file_pos_in_list(&lwin, "z"));
+
+	memset(&lwin.sort, SK_NONE, sizeof(lwin.sort));
+	lwin.sort[0] = -SK_BY_NAME;
+	sort_view(&lwin);
+
+	assert_int_equal(0, find_file_pos_in_list(&lwin, "z"));
+	assert_int_equal(1, find_file_pos_in_list(&lwin, "y"));
+	assert_int_equal(2, find_file_pos_in_list(&lwin, "x"));
+}
+
+static void
+add_entry(const char origin[], const char name[])
+{
+	dir_entry_t *entry;
+
+	lwin.dir_entry = dynarray_extend(lwin.dir_entry, sizeof(*lwin.dir_entry));
+	entry = &lwin.dir_entry[lwin.list_rows++];
+	memset(entry, 0, sizeof(*entry));
+	entry->name = strdup(name);
+	entry->origin = strdup(origin);
+	entry->type = FT_REG;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
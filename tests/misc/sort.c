@@ -1,5 +1,6 @@
 #include <stic.h>
 
+#include <sys/stat.h> /* S_IFREG S_ISUID */
 #include <unistd.h> /* chdir() unlink() */
 
 #include <locale.h> /* LC_ALL setlocale() */
@@ -320,5 +321,94 @@ TEST(extensions_of_dot_files_are_sorted_correctly)
 	assert_string_equal(".tmux.conf", lwin.dir_entry[2].name);
 }
 
+TEST(secondary_keys_are_applied_to_ties_of_primary_one)
+{
+	free_view(&lwin);
+
+	lwin.list_rows = 4;
+	lwin.dir_entry = dynarray_cextend(NULL,
+			lwin.list_rows*sizeof(*lwin.dir_entry));
+	lwin.dir_entry[0].name = strdup("b.txt");
+	lwin.dir_entry[0].type = FT_REG;
+	lwin.dir_entry[0].size = 1;
+	lwin.dir_entry[1].name = strdup("a.c");
+	lwin.dir_entry[1].type = FT_REG;
+	lwin.dir_entry[1].size = 2;
+	lwin.dir_entry[2].name = strdup("a.txt");
+	lwin.dir_entry[2].type = FT_REG;
+	lwin.dir_entry[2].size = 2;
+	lwin.dir_entry[3].name = strdup("c.c");
+	lwin.dir_entry[3].type = FT_REG;
+	lwin.dir_entry[3].size = 1;
+
+	lwin.sort[0] = -SK_BY_SIZE;
+	lwin.sort[1] = SK_BY_EXTENSION;
+	lwin.sort[2] = SK_BY_NAME;
+	memset(&lwin.sort[3], SK_NONE, sizeof(lwin.sort) - 3);
+
+	sort_view(&lwin);
+
+	assert_string_equal("a.c", lwin.dir_entry[0].name);
+	assert_string_equal("a.txt", lwin.dir_entry[1].name);
+	assert_string_equal("c.c", lwin.dir_entry[2].name);
+	assert_string_equal("b.txt", lwin.dir_entry[3].name);
+}
+
+TEST(sorting_is_stable)
+{
+	int i;
+
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		lwin.dir_entry[i].size = 10;
+	}
+
+	lwin.sort[0] = SK_BY_SIZE;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	sort_view(&lwin);
+
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_string_equal("_", lwin.dir_entry[1].name);
+	assert_string_equal("A", lwin.dir_entry[2].name);
+}
+
+TEST(parent_directory_is_always_first)
+{
+	free(lwin.dir_entry[2].name);
+	lwin.dir_entry[2].name = strdup("..");
+	lwin.dir_entry[2].type = FT_DIR;
+
+	lwin.sort[0] = -SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	sort_view(&lwin);
+
+	assert_string_equal("..", lwin.dir_entry[0].name);
+	assert_string_equal("a", lwin.dir_entry[1].name);
+	assert_string_equal("_", lwin.dir_entry[2].name);
+}
+
+#ifndef _WIN32
+
+TEST(permissions_are_compared_as_strings)
+{
+	lwin.dir_entry[0].mode = S_IFREG | 0644;
+	lwin.dir_entry[1].mode = S_IFREG | S_ISUID | 0644;
+	lwin.dir_entry[2].mode = S_IFREG | 0744;
+
+	lwin.sort[0] = SK_BY_PERMISSIONS;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	sort_view(&lwin);
+
+	/* "-rw-r--r--" < "-rwSr--r--" < "-rwxr--r--" */
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_string_equal("_", lwin.dir_entry[1].name);
+	assert_string_equal("A", lwin.dir_entry[2].name);
+}
+
+#endif
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,197 @@
+#include <stic.h>
+
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <unistd.h> /* chdir() rmdir() symlink() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() printf() snprintf() */
+#include <stdlib.h> /* free() getenv() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/fswatch.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+static void make_files(int count);
+static void remove_files(int count);
+static void load_view(FileView *view, int nthreads);
+static void free_view(FileView *view);
+static double time_load(FileView *view, int nthreads);
+static int bench_requested(void);
+
+SETUP()
+{
+	char cwd[PATH_MAX];
+
+	assert_success(chdir(SANDBOX_PATH));
+	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
+
+	cfg.slow_fs_list = strdup("");
+
+	copy_str(lwin.curr_dir, sizeof(lwin.curr_dir), cwd);
+	copy_str(rwin.curr_dir, sizeof(rwin.curr_dir), cwd);
+}
+
+TEARDOWN()
+{
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+
+	cfg.stat_threads = 1;
+}
+
+TEST(parallel_loading_produces_the_same_list)
+{
+	enum { COUNT = 1000 };
+
+	int i;
+
+	make_files(COUNT);
+	assert_success(symlink("f0", "link-to-file"));
+	assert_success(symlink("d", "link-to-dir"));
+	assert_success(os_mkdir("d", 0700));
+
+	load_view(&lwin, 1);
+	load_view(&rwin, 4);
+
+	/* Files, two symbolic links and a directory ("../" isn't shown). */
+	assert_int_equal(COUNT + 3, lwin.list_rows);
+	assert_int_equal(lwin.list_rows, rwin.list_rows);
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		const dir_entry_t *const a = &lwin.dir_entry[i];
+		const dir_entry_t *const b = &rwin.dir_entry[i];
+
+		assert_string_equal(a->name, b->name);
+		assert_int_equal(a->type, b->type);
+		assert_true(a->size == b->size);
+		assert_true(a->mode == b->mode);
+		assert_true(a->mtime == b->mtime);
+	}
+
+	free_view(&lwin);
+	free_view(&rwin);
+
+	assert_success(unlink("link-to-file"));
+	assert_success(unlink("link-to-dir"));
+	assert_success(rmdir("d"));
+	remove_files(COUNT);
+}
+
+TEST(empty_directory_is_handled)
+{
+	load_view(&lwin, 4);
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("..", lwin.dir_entry[0].name);
+	free_view(&lwin);
+}
+
+/* Run with VIFM_BENCH environment variable set to compare timings of loading a
+ * synthetic directory of 100k files. */
+TEST(benchmark_of_parallel_loading, IF(bench_requested))
+{
+	enum { COUNT = 100000, THREADS = 8 };
+
+	double serial, parallel;
+
+	make_files(COUNT);
+
+	serial = time_load(&lwin, 1);
+	parallel = time_load(&lwin, THREADS);
+	printf("statthreads=1: %.3f s, statthreads=%d: %.3f s\n", serial, THREADS,
+			parallel);
+
+	remove_files(COUNT);
+}
+
+static void
+make_files(int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char name[32];
+		FILE *f;
+
+		snprintf(name, sizeof(name), "f%d", i);
+		f = fopen(name, "w");
+		assert_non_null(f);
+		fclose(f);
+	}
+}
+
+static void
+remove_files(int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "f%d", i);
+		assert_success(unlink(name));
+	}
+}
+
+static void
+load_view(FileView *view, int nthreads)
+{
+	cfg.stat_threads = nthreads;
+
+	filter_init(&view->local_filter.filter, 1);
+	filter_init(&view->manual_filter, 1);
+	filter_init(&view->auto_filter, 1);
+	view->sort[0] = SK_BY_NAME;
+	memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+	populate_dir_list(view, 0);
+}
+
+static void
+free_view(FileView *view)
+{
+	int i;
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		free_dir_entry(view, &view->dir_entry[i]);
+	}
+	dynarray_free(view->dir_entry);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	fswatch_free(view->watch);
+	view->watch = NULL;
+
+	filter_dispose(&view->auto_filter);
+	filter_dispose(&view->manual_filter);
+	filter_dispose(&view->local_filter.filter);
+}
+
+/* Loads the view with specified number of threads.  Returns time it took in
+ * seconds. */
+static double
+time_load(FileView *view, int nthreads)
+{
+	struct timeval start, end;
+
+	(void)gettimeofday(&start, NULL);
+	load_view(view, nthreads);
+	(void)gettimeofday(&end, NULL);
+	free_view(view);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec)/1e6;
+}
+
+static int
+bench_requested(void)
+{
+	return getenv("VIFM_BENCH") != NULL;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
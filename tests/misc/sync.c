@@ -58,7 +58,7 @@ free_view(FileView *view)
 
 	for(i = 0; i < view->list_rows; ++i)
 	{
-		free(view->dir_entry[i].name);
+		free_dir_entry(view, &view->dir_entry[i]);
 	}
 	dynarray_free(view->dir_entry);
 }
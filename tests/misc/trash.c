@@ -0,0 +1,98 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() */
+
+#include <stdio.h> /* FILE fclose() fopen() remove() snprintf() */
+
+#include "../../src/compat/os.h"
+#include "../../src/utils/fs.h"
+#include "../../src/trash.h"
+
+static void make_file(const char path[]);
+
+TEARDOWN()
+{
+	trash_prune_dead_entries();
+}
+
+TEST(many_entries_are_found_and_keep_order)
+{
+	enum { COUNT = 300 };
+
+	char path[PATH_MAX];
+	int i;
+
+	for(i = 0; i < COUNT; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/%03d_file", SANDBOX_PATH, i);
+		make_file(path);
+		assert_success(add_to_trash("/orig", path));
+	}
+
+	/* Duplicates are not added. */
+	assert_success(add_to_trash("/orig", path));
+	assert_int_equal(COUNT, nentries);
+
+	for(i = 0; i < COUNT; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/%03d_file", SANDBOX_PATH, i);
+		assert_true(is_in_trash(path));
+		assert_string_equal(path, trash_list[i].trash_name);
+	}
+	assert_false(is_in_trash(SANDBOX_PATH "/no-such-file"));
+
+	/* Remove every other file to have entries removed from the middle. */
+	for(i = 0; i < COUNT; i += 2)
+	{
+		snprintf(path, sizeof(path), "%s/%03d_file", SANDBOX_PATH, i);
+		assert_success(remove(path));
+	}
+	trash_prune_dead_entries();
+	assert_int_equal(COUNT/2, nentries);
+
+	for(i = 0; i < COUNT; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/%03d_file", SANDBOX_PATH, i);
+		assert_int_equal(i%2 != 0, is_in_trash(path));
+		if(i%2 != 0)
+		{
+			assert_string_equal(path, trash_list[i/2].trash_name);
+			assert_success(remove(path));
+		}
+	}
+}
+
+TEST(missing_files_are_not_added)
+{
+	assert_failure(add_to_trash("/orig", SANDBOX_PATH "/no-such-file"));
+	assert_false(is_in_trash(SANDBOX_PATH "/no-such-file"));
+}
+
+TEST(tree_content_is_removed)
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/trash", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/trash/a", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/trash/a/b", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/trash/c", 0700));
+	make_file(SANDBOX_PATH "/trash/file");
+	make_file(SANDBOX_PATH "/trash/a/file");
+	make_file(SANDBOX_PATH "/trash/a/b/file");
+
+	remove_tree_content(SANDBOX_PATH "/trash");
+
+	assert_true(is_dir(SANDBOX_PATH "/trash"));
+	assert_true(is_dir_empty(SANDBOX_PATH "/trash"));
+
+	assert_success(rmdir(SANDBOX_PATH "/trash"));
+}
+
+static void
+make_file(const char path[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	fclose(f);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,198 @@
+#include <stic.h>
+
+#include <stdio.h> /* remove() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strcpy() strstr() */
+
+#include "../../src/utils/string_array.h"
+#include "../../src/ops.h"
+#include "../../src/undo.h"
+
+#include "test.h"
+
+#define JOURNAL SANDBOX_PATH "/undo-journal"
+
+static int execute(OPS op, void *data, const char *src, const char *dst);
+static void reopen_journal(void);
+
+static char last_src[256];
+static char last_dst[256];
+
+SETUP()
+{
+	static int undo_levels = 10;
+
+	reset_undo_list();
+	init_undo_list_for_tests(&execute, &undo_levels);
+	assert_success(undo_journal_open(JOURNAL));
+
+	cmd_group_begin("first\tgroup");
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/src/a", "/dst/a"));
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/src/b", "/dst/b"));
+	cmd_group_end();
+
+	cmd_group_begin("second\ngroup");
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/src/c\\d", "/dst/c"));
+	cmd_group_end();
+}
+
+TEARDOWN()
+{
+	undo_journal_close();
+	reset_undo_list();
+	assert_success(remove(JOURNAL));
+}
+
+static int
+execute(OPS op, void *data, const char *src, const char *dst)
+{
+	strcpy(last_src, src);
+	strcpy(last_dst, dst);
+	return 0;
+}
+
+TEST(list_is_restored_from_journal)
+{
+	char **list;
+
+	reopen_journal();
+
+	list = undolist(0);
+	assert_string_equal("second\ngroup", list[0]);
+	assert_string_equal("first\tgroup", list[1]);
+	assert_null(list[2]);
+	free_string_array(list, 2);
+
+	assert_success(undo_group());
+	assert_string_equal("/dst/c", last_src);
+	assert_string_equal("/src/c\\d", last_dst);
+
+	assert_success(undo_group());
+	assert_string_equal("/dst/a", last_src);
+	assert_string_equal("/src/a", last_dst);
+
+	assert_int_equal(-1, undo_group());
+}
+
+TEST(position_in_list_is_restored)
+{
+	assert_success(undo_group());
+	assert_int_equal(1, get_undolist_pos(0));
+
+	reopen_journal();
+	assert_int_equal(1, get_undolist_pos(0));
+
+	assert_success(redo_group());
+	assert_string_equal("/src/c\\d", last_src);
+	assert_string_equal("/dst/c", last_dst);
+	assert_int_equal(-1, redo_group());
+}
+
+TEST(appended_commands_are_restored)
+{
+	char **list;
+
+	cmd_group_continue();
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/src/e", "/dst/e"));
+	cmd_group_end();
+	free(replace_group_msg("renamed"));
+
+	reopen_journal();
+
+	list = undolist(0);
+	assert_string_equal("renamed", list[0]);
+	assert_string_equal("first\tgroup", list[1]);
+	assert_null(list[2]);
+	free_string_array(list, 2);
+
+	assert_success(undo_group());
+	assert_string_equal("/dst/c", last_src);
+}
+
+TEST(appended_records_are_written_on_group_end)
+{
+	char **lines;
+	int nlines;
+	int i;
+	int found = 0;
+
+	cmd_group_begin("third");
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/src/f", "/dst/f"));
+	cmd_group_end();
+
+	lines = read_file_of_lines(JOURNAL, &nlines);
+	for(i = 0; i < nlines; ++i)
+	{
+		found |= (strstr(lines[i], "/src/f") != NULL);
+	}
+	free_string_array(lines, nlines);
+
+	assert_true(found);
+}
+
+TEST(undo_and_redo_append_to_journal)
+{
+	char **lines;
+	int nlines;
+
+	assert_success(undo_group());
+	assert_success(redo_group());
+
+	lines = read_file_of_lines(JOURNAL, &nlines);
+	assert_true(nlines >= 4);
+	assert_string_equal("s0\t-1\t0", lines[nlines - 4]);
+	assert_string_equal("p1", lines[nlines - 3]);
+	assert_string_equal("s0\t0\t0", lines[nlines - 2]);
+	assert_string_equal("p0", lines[nlines - 1]);
+	free_string_array(lines, nlines);
+
+	reopen_journal();
+	assert_int_equal(0, get_undolist_pos(0));
+
+	assert_success(undo_group());
+	assert_string_equal("/dst/c", last_src);
+}
+
+TEST(state_of_groups_is_restored_after_list_is_truncated)
+{
+	assert_success(undo_group());
+	assert_success(undo_group());
+	assert_success(redo_group());
+
+	cmd_group_begin("third");
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/src/f", "/dst/f"));
+	cmd_group_end();
+
+	reopen_journal();
+
+	assert_success(undo_group());
+	assert_string_equal("/dst/f", last_src);
+	assert_success(undo_group());
+	assert_string_equal("/dst/a", last_src);
+	assert_int_equal(-1, undo_group());
+}
+
+TEST(journal_is_not_loaded_into_non_empty_list)
+{
+	char **list;
+
+	undo_journal_close();
+	assert_success(undo_journal_open(JOURNAL));
+
+	list = undolist(0);
+	assert_string_equal("second\ngroup", list[0]);
+	assert_string_equal("first\tgroup", list[1]);
+	assert_null(list[2]);
+	free_string_array(list, 2);
+}
+
+static void
+reopen_journal(void)
+{
+	undo_journal_close();
+	reset_undo_list();
+	assert_success(undo_journal_open(JOURNAL));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
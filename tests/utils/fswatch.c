@@ -1,12 +1,30 @@
 #include <stic.h>
 
+#include <sys/stat.h> /* stat */
+#include <poll.h> /* POLLIN poll() pollfd */
+
+#include <stdio.h> /* rename() */
 #include <stdlib.h> /* remove() */
 
 #include "../../src/compat/os.h"
 #include "../../src/utils/fswatch.h"
+#include "../../src/utils/macros.h"
+#include "../../src/utils/string_array.h"
 
+static void collect_changes(const char name[], FSWatchEvent event, void *arg);
 static int using_inotify(void);
 
+static char **names;
+static int nnames;
+static FSWatchEvent events[8];
+
+TEARDOWN()
+{
+	free_string_array(names, nnames);
+	names = NULL;
+	nnames = 0;
+}
+
 TEST(watch_is_created_for_existing_directory)
 {
 	fswatch_t *watch;
@@ -101,6 +119,34 @@ TEST(to_many_events_causes_banning_of_same_events, IF(using_inotify))
 	fswatch_free(watch);
 }
 
+TEST(ignored_events_require_periodic_polling, IF(using_inotify))
+{
+	fswatch_t *watch;
+	int error;
+	int i;
+
+	assert_non_null(watch = fswatch_create(SANDBOX_PATH));
+
+	os_mkdir(SANDBOX_PATH "/testdir", 0700);
+
+	for(i = 0; i < 100; ++i)
+	{
+		os_chmod(SANDBOX_PATH "/testdir", 0777);
+		os_chmod(SANDBOX_PATH "/testdir", 0000);
+		(void)fswatch_changed(watch, &error);
+	}
+	assert_int_equal(-1, fswatch_get_fd(watch));
+
+	/* Reporting changes of the file drops the need to poll. */
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+	assert_false(fswatch_changed(watch, &error));
+	assert_true(fswatch_get_fd(watch) >= 0);
+
+	fswatch_free(watch);
+}
+
 TEST(file_recreation_removes_ban, IF(using_inotify))
 {
 	fswatch_t *watch;
@@ -135,6 +181,112 @@ TEST(file_recreation_removes_ban, IF(using_inotify))
 	assert_success(remove(SANDBOX_PATH "/testdir"));
 }
 
+TEST(names_of_changed_entries_are_reported, IF(using_inotify))
+{
+	fswatch_t *watch;
+	int error;
+
+	assert_non_null(watch = fswatch_create(SANDBOX_PATH));
+
+	os_mkdir(SANDBOX_PATH "/testdir", 0700);
+	assert_int_equal(FSWS_CHANGED,
+			fswatch_poll(watch, &error, &collect_changes, NULL));
+	assert_false(error);
+	assert_int_equal(1, nnames);
+	assert_string_equal("testdir", names[0]);
+	assert_int_equal(FSWE_CREATED, events[0]);
+
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+	assert_int_equal(FSWS_CHANGED,
+			fswatch_poll(watch, &error, &collect_changes, NULL));
+	assert_false(error);
+	assert_int_equal(2, nnames);
+	assert_string_equal("testdir", names[1]);
+	assert_int_equal(FSWE_DELETED, events[1]);
+
+	assert_int_equal(FSWS_UNCHANGED,
+			fswatch_poll(watch, &error, &collect_changes, NULL));
+	assert_int_equal(2, nnames);
+
+	fswatch_free(watch);
+}
+
+TEST(renames_are_reported_as_moves, IF(using_inotify))
+{
+	fswatch_t *watch;
+	int error;
+
+	os_mkdir(SANDBOX_PATH "/from", 0700);
+	assert_non_null(watch = fswatch_create(SANDBOX_PATH));
+
+	assert_success(rename(SANDBOX_PATH "/from", SANDBOX_PATH "/to"));
+	assert_int_equal(FSWS_CHANGED,
+			fswatch_poll(watch, &error, &collect_changes, NULL));
+	assert_false(error);
+	assert_int_equal(2, nnames);
+	assert_string_equal("from", names[0]);
+	assert_int_equal(FSWE_MOVED_FROM, events[0]);
+	assert_string_equal("to", names[1]);
+	assert_int_equal(FSWE_MOVED_TO, events[1]);
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/to"));
+}
+
+TEST(changes_of_directory_itself_require_rereading, IF(using_inotify))
+{
+	fswatch_t *watch;
+	int error;
+	struct stat st;
+
+	assert_success(os_stat(SANDBOX_PATH, &st));
+	assert_non_null(watch = fswatch_create(SANDBOX_PATH));
+
+	assert_success(os_chmod(SANDBOX_PATH, st.st_mode & 0777));
+	assert_int_equal(FSWS_REPLACED,
+			fswatch_poll(watch, &error, &collect_changes, NULL));
+	assert_false(error);
+	assert_int_equal(0, nnames);
+
+	fswatch_free(watch);
+}
+
+TEST(descriptor_becomes_ready_on_changes, IF(using_inotify))
+{
+	fswatch_t *watch;
+	int error;
+	struct pollfd pfd = { .events = POLLIN };
+
+	assert_non_null(watch = fswatch_create(SANDBOX_PATH));
+	pfd.fd = fswatch_get_fd(watch);
+	assert_true(pfd.fd >= 0);
+
+	assert_int_equal(0, poll(&pfd, 1, 0));
+
+	os_mkdir(SANDBOX_PATH "/testdir", 0700);
+	assert_int_equal(1, poll(&pfd, 1, 0));
+
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(error);
+	assert_int_equal(0, poll(&pfd, 1, 0));
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+}
+
+/* fswatch_poll() callback that collects reported changes. */
+static void
+collect_changes(const char name[], FSWatchEvent event, void *arg)
+{
+	if(nnames < (int)ARRAY_LEN(events))
+	{
+		events[nnames] = event;
+		nnames = add_to_string_array(&names, nnames, 1, name);
+	}
+}
+
 static int
 using_inotify(void)
 {
@@ -0,0 +1,152 @@
+#include <stic.h>
+
+#include <unistd.h> /* truncate() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() remove() */
+#include <string.h> /* strncmp() */
+
+#include "../../src/utils/mapped_lines.h"
+#include "../../src/utils/string_array.h"
+
+static void check_same_as_read(const char path[]);
+
+TEST(missing_file_is_not_mapped)
+{
+	assert_null(mlines_open(TEST_DATA_PATH "/read/no-such-file"));
+}
+
+TEST(directory_is_not_mapped)
+{
+	assert_null(mlines_open(TEST_DATA_PATH "/read"));
+}
+
+TEST(lines_match_those_read_into_memory)
+{
+	check_same_as_read(TEST_DATA_PATH "/read/dos-line-endings");
+	check_same_as_read(TEST_DATA_PATH "/read/dos-eof");
+	check_same_as_read(TEST_DATA_PATH "/read/binary-data");
+	check_same_as_read(TEST_DATA_PATH "/read/two-lines");
+	check_same_as_read(TEST_DATA_PATH "/read/very-long-line");
+}
+
+TEST(index_is_built_lazily)
+{
+	enum { COUNT = 1000 };
+
+	int i;
+	FILE *const f = fopen(SANDBOX_PATH "/lines", "w");
+	mlines_t *ml;
+
+	assert_non_null(f);
+	for(i = 0; i < COUNT; ++i)
+	{
+		fputs("line\n", f);
+	}
+	fclose(f);
+
+	ml = mlines_open(SANDBOX_PATH "/lines");
+	assert_non_null(ml);
+
+	assert_int_equal(0, mlines_count(ml));
+	assert_true(mlines_index(ml, 1) < COUNT);
+	assert_false(mlines_complete(ml));
+
+	assert_int_equal(COUNT, mlines_index(ml, COUNT*2));
+	assert_true(mlines_complete(ml));
+
+	mlines_close(ml);
+	assert_success(remove(SANDBOX_PATH "/lines"));
+}
+
+TEST(truncation_of_file_is_handled)
+{
+	size_t len;
+	FILE *const f = fopen(SANDBOX_PATH "/lines", "w");
+	mlines_t *ml;
+
+	assert_non_null(f);
+	fputs("first\nsecond\nthird\n", f);
+	fclose(f);
+
+	ml = mlines_open(SANDBOX_PATH "/lines");
+	assert_non_null(ml);
+	assert_int_equal(3, mlines_index(ml, 3));
+
+	assert_success(truncate(SANDBOX_PATH "/lines", 3));
+
+	mlines_check(ml);
+	assert_int_equal(1, mlines_count(ml));
+	assert_int_equal(1, mlines_index(ml, 3));
+	assert_true(strncmp("fir", mlines_get(ml, 0, &len), len) == 0);
+	assert_int_equal(3, len);
+	mlines_get(ml, 2, &len);
+	assert_int_equal(0, len);
+
+	mlines_close(ml);
+	assert_success(remove(SANDBOX_PATH "/lines"));
+}
+
+TEST(truncation_right_before_access_is_handled)
+{
+	enum { COUNT = 10000 };
+
+	int i;
+	size_t len;
+	FILE *const f = fopen(SANDBOX_PATH "/lines", "w");
+	mlines_t *ml;
+
+	assert_non_null(f);
+	for(i = 0; i < COUNT; ++i)
+	{
+		fputs("line\n", f);
+	}
+	fclose(f);
+
+	ml = mlines_open(SANDBOX_PATH "/lines");
+	assert_non_null(ml);
+	assert_int_equal(COUNT/2, mlines_index(ml, COUNT/2));
+
+	/* Pages past the end of the file can't be accessed anymore. */
+	assert_success(truncate(SANDBOX_PATH "/lines", 10));
+
+	mlines_get(ml, COUNT/2 - 1, &len);
+	assert_int_equal(0, len);
+	assert_int_equal(2, mlines_count(ml));
+	assert_true(strncmp("line", mlines_get(ml, 1, &len), len) == 0);
+	assert_int_equal(4, len);
+
+	assert_int_equal(2, mlines_index(ml, COUNT));
+	assert_true(mlines_complete(ml));
+
+	mlines_close(ml);
+	assert_success(remove(SANDBOX_PATH "/lines"));
+}
+
+static void
+check_same_as_read(const char path[])
+{
+	int i;
+	int nlines;
+	char **const lines = read_file_of_lines(path, &nlines);
+	mlines_t *const ml = mlines_open(path);
+
+	assert_non_null(lines);
+	assert_non_null(ml);
+
+	assert_int_equal(nlines, mlines_index(ml, nlines + 1));
+	assert_true(mlines_complete(ml));
+
+	for(i = 0; i < nlines; ++i)
+	{
+		size_t len;
+		const char *const line = mlines_get(ml, i, &len);
+		assert_int_equal(strlen(lines[i]), len);
+		assert_true(strncmp(lines[i], line, len) == 0);
+	}
+
+	mlines_close(ml);
+	free_string_array(lines, nlines);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -1,5 +1,11 @@
 #include <stic.h>
 
+#include <regex.h> /* regcomp() regexec() regfree() */
+
+#include <stdlib.h> /* free() */
+
+#include "../../src/utils/globs.h"
+#include "../../src/utils/macros.h"
 #include "../../src/utils/matcher.h"
 
 static void check_glob(matcher_t *m);
@@ -95,6 +101,100 @@ TEST(full_path_regexp)
 	matcher_free(m);
 }
 
+TEST(simple_globs_match_as_their_regexps)
+{
+	static const char *const globs[] = {
+		"*.jpg", "*.tar.gz", "*", "abc", "abc*", "*/", ".*", "a*b", "a?c",
+		"[ab].jpg", "*.JPG,abc",
+	};
+	static const char *const names[] = {
+		"a.jpg", "A.JPG", ".jpg", "..jpg", "x.jpg.bak", "jpg", "x.tar.gz",
+		"x.gz", "abc", "ABCD", "xabc", "dir/", ".hidden", "ab", "abc.jpg",
+	};
+
+	size_t i, j;
+	for(i = 0U; i < ARRAY_LEN(globs); ++i)
+	{
+		char *error;
+		matcher_t *m;
+		regex_t re;
+		char *const raw = globs_to_regex(globs[i]);
+
+		assert_non_null(raw);
+		assert_success(regcomp(&re, raw, REG_EXTENDED | REG_ICASE));
+		assert_non_null(m = matcher_alloc(globs[i], 0, 1, &error));
+		assert_null(error);
+
+		for(j = 0U; j < ARRAY_LEN(names); ++j)
+		{
+			const int expected = (regexec(&re, names[j], 0, NULL, 0) == 0);
+			assert_int_equal(expected, matcher_matches(m, names[j]));
+		}
+
+		matcher_free(m);
+		regfree(&re);
+		free(raw);
+	}
+}
+
+TEST(clone_matches_the_same)
+{
+	char *error;
+	matcher_t *m, *clone;
+
+	assert_non_null(m = matcher_alloc("{*.ext,abc*,[xy]}", 0, 1, &error));
+	assert_null(error);
+
+	assert_non_null(clone = matcher_clone(m));
+	matcher_free(m);
+
+	assert_true(matcher_matches(clone, "name.ext"));
+	assert_true(matcher_matches(clone, "abcd"));
+	assert_true(matcher_matches(clone, "x"));
+	assert_false(matcher_matches(clone, "z"));
+
+	matcher_free(clone);
+}
+
+TEST(list_of_matchers_finds_first_match)
+{
+	static const char *const exprs[] = {
+		"{{/tmp/*.png}}", "{*.jpg,*.png}", "/^abc/I", "{README}", "{*.JPG,*.gz}",
+		"{*.tar.gz}", "{abc*}", "{[xy]*}", "{*}",
+	};
+
+	matcher_t *m[ARRAY_LEN(exprs)];
+	matchers_t *ms;
+	size_t i;
+
+	assert_non_null(ms = matchers_alloc());
+	for(i = 0U; i < ARRAY_LEN(exprs); ++i)
+	{
+		char *error;
+		assert_non_null(m[i] = matcher_alloc(exprs[i], 0, 1, &error));
+		assert_null(error);
+		assert_success(matchers_add(ms, m[i]));
+	}
+
+	assert_int_equal(0, matchers_find(ms, "/tmp/a.png"));
+	assert_int_equal(1, matchers_find(ms, "/home/a.png"));
+	assert_int_equal(1, matchers_find(ms, "a.JPG"));
+	assert_int_equal(2, matchers_find(ms, "abc.gz"));
+	assert_int_equal(3, matchers_find(ms, "readme"));
+	assert_int_equal(4, matchers_find(ms, "a.tar.gz"));
+	assert_int_equal(6, matchers_find(ms, "ABC"));
+	assert_int_equal(7, matchers_find(ms, "x.txt"));
+	assert_int_equal(8, matchers_find(ms, "file"));
+	assert_int_equal(-1, matchers_find(ms, ".jpg"));
+	assert_int_equal(-1, matchers_find(ms, ".hidden"));
+
+	matchers_free(ms);
+	for(i = 0U; i < ARRAY_LEN(exprs); ++i)
+	{
+		matcher_free(m[i]);
+	}
+}
+
 static void
 check_glob(matcher_t *m)
 {
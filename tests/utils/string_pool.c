@@ -0,0 +1,140 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memset() strcmp() */
+
+#include "../../src/utils/string_pool.h"
+
+static strpool_t *pool;
+
+SETUP()
+{
+	pool = strpool_create();
+	assert_non_null(pool);
+}
+
+TEARDOWN()
+{
+	strpool_free(pool);
+}
+
+TEST(strings_are_copied)
+{
+	char *const a = strpool_dup(pool, "abc");
+	char *const b = strpool_dup(pool, "abc");
+
+	assert_string_equal("abc", a);
+	assert_string_equal("abc", b);
+	assert_true(a != b);
+
+	strpool_release(a);
+	strpool_release(b);
+}
+
+TEST(interned_strings_are_shared)
+{
+	char *const a = strpool_intern(pool, "/some/dir");
+	char *const b = strpool_intern(pool, "/some/dir");
+	char *const c = strpool_intern(pool, "/other/dir");
+
+	assert_true(a == b);
+	assert_true(a != c);
+	assert_string_equal("/other/dir", c);
+
+	strpool_release(a);
+	strpool_release(b);
+	strpool_release(c);
+}
+
+TEST(released_interned_string_is_forgotten)
+{
+	char *a = strpool_intern(pool, "str");
+	char *b;
+
+	strpool_release(a);
+
+	b = strpool_intern(pool, "str");
+	assert_string_equal("str", b);
+	strpool_release(b);
+}
+
+TEST(reference_keeps_string_alive)
+{
+	char *const a = strpool_dup(pool, "str");
+	assert_true(strpool_ref(a) == a);
+
+	strpool_release(a);
+	assert_string_equal("str", a);
+	strpool_release(a);
+}
+
+TEST(many_strings_are_handled)
+{
+	enum { COUNT = 20000 };
+
+	static char *strs[COUNT];
+	char buf[32];
+	int i;
+
+	for(i = 0; i < COUNT; ++i)
+	{
+		snprintf(buf, sizeof(buf), "%d", i%(COUNT/2));
+		strs[i] = (i%2 == 0) ? strpool_intern(pool, buf) : strpool_dup(pool, buf);
+		assert_non_null(strs[i]);
+	}
+
+	/* Release every other string to make holes in lookup chains. */
+	for(i = 0; i < COUNT; i += 4)
+	{
+		strpool_release(strs[i]);
+		strs[i] = NULL;
+	}
+
+	for(i = 0; i < COUNT; ++i)
+	{
+		if(strs[i] != NULL)
+		{
+			snprintf(buf, sizeof(buf), "%d", i%(COUNT/2));
+			assert_string_equal(buf, strs[i]);
+			if(i%2 == 0)
+			{
+				char *const s = strpool_intern(pool, buf);
+				assert_true(s == strs[i]);
+				strpool_release(s);
+			}
+		}
+	}
+
+	for(i = 0; i < COUNT; ++i)
+	{
+		strpool_release(strs[i]);
+	}
+}
+
+TEST(long_strings_are_supported)
+{
+	static char buf[100000];
+	char *s;
+
+	memset(buf, 'x', sizeof(buf) - 1U);
+	s = strpool_dup(pool, buf);
+	assert_true(strcmp(buf, s) == 0);
+	strpool_release(s);
+}
+
+TEST(strings_outlive_pool)
+{
+	char *const a = strpool_intern(pool, "a");
+	char *const b = strpool_dup(pool, "b");
+
+	strpool_free(pool);
+	pool = NULL;
+
+	assert_string_equal("a", a);
+	assert_string_equal("b", b);
+	strpool_release(a);
+	strpool_release(b);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */